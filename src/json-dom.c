@@ -28,33 +28,36 @@
 #include <string.h>
 
 
+static void*
+json_dom_realloc(JSON_DOM_PARSER* dom_parser, void* ptr, size_t size)
+{
+    const VALUE_ALLOCATOR* allocator = dom_parser->allocator;
+
+    if(allocator != NULL)
+        return allocator->realloc_func(ptr, size, allocator->ctx);
+    return realloc(ptr, size);
+}
+
+static void
+json_dom_free(JSON_DOM_PARSER* dom_parser, void* ptr)
+{
+    const VALUE_ALLOCATOR* allocator = dom_parser->allocator;
+
+    if(allocator != NULL)
+        allocator->free_func(ptr, allocator->ctx);
+    else
+        free(ptr);
+}
+
 static int
-init_number(VALUE* v, const char* data, size_t data_size)
+init_number(VALUE* v, const JSON_NUMBER_INFO* info)
 {
-    int is_int32_compatible;
-    int is_uint32_compatible;
-    int is_int64_compatible;
-    int is_uint64_compatible;
-
-    json_analyze_number(data, data_size,
-            &is_int32_compatible, &is_uint32_compatible,
-            &is_int64_compatible, &is_uint64_compatible);
-
-    if(is_int32_compatible) {
-        return value_init_int32(v, json_number_to_int32(data, data_size));
-    } else if(is_uint32_compatible) {
-        return value_init_uint32(v, json_number_to_uint32(data, data_size));
-    } else if(is_int64_compatible) {
-        return value_init_int64(v, json_number_to_int64(data, data_size));
-    } else if(is_uint64_compatible) {
-        return value_init_uint64(v, json_number_to_uint64(data, data_size));
-    } else {
-        double d;
-        int err;
-        err = json_number_to_double(data, data_size, &d);
-        if(err != 0)
-            return err;
-        return value_init_double(v, d);
+    switch(info->num_class) {
+        case JSON_NUMBER_INT32:     return value_init_int32(v, info->value.i32);
+        case JSON_NUMBER_UINT32:    return value_init_uint32(v, info->value.u32);
+        case JSON_NUMBER_INT64:     return value_init_int64(v, info->value.i64);
+        case JSON_NUMBER_UINT64:    return value_init_uint64(v, info->value.u64);
+        default:                    return value_init_double(v, info->value.d);
     }
 }
 
@@ -65,6 +68,14 @@ json_dom_process(JSON_TYPE type, const char* data, size_t data_size, void* user_
     VALUE* new_value;
     int init_val_ret = 0;
 
+    if(type == JSON_DOCUMENT_END) {
+        /* Complete document (only with json_dom_init_multidoc()): Pass it to
+         * the application which takes it over. */
+        int ret = dom_parser->on_document(&dom_parser->root, dom_parser->user_data);
+        value_init_null(&dom_parser->root);
+        return ret;
+    }
+
     if(type == JSON_ARRAY_END || type == JSON_OBJECT_END) {
         /* Reached end of current array or object? Just pop-up in the path. */
         dom_parser->path_size--;
@@ -73,7 +84,7 @@ json_dom_process(JSON_TYPE type, const char* data, size_t data_size, void* user_
 
     if(type == JSON_KEY) {
         /* Object key: We just store it until we get the value to use it with. */
-        if(value_init_string_(&dom_parser->key, data, data_size) != 0)
+        if(value_init_string_alloc(&dom_parser->key, data, data_size, dom_parser->allocator) != 0)
             return JSON_ERR_OUTOFMEMORY;
         return 0;
     }
@@ -116,10 +127,10 @@ json_dom_process(JSON_TYPE type, const char* data, size_t data_size, void* user_
         case JSON_NULL:         value_init_null(new_value); break;
         case JSON_FALSE:        value_init_bool(new_value, 0); break;
         case JSON_TRUE:         value_init_bool(new_value, 1); break;
-        case JSON_NUMBER:       init_val_ret = init_number(new_value, data, data_size); break;
-        case JSON_STRING:       init_val_ret = value_init_string_(new_value, data, data_size); break;
-        case JSON_ARRAY_BEG:    init_val_ret = value_init_array(new_value); break;
-        case JSON_OBJECT_BEG:   init_val_ret = value_init_dict_ex(new_value, NULL, dom_parser->dict_flags); break;
+        case JSON_NUMBER:       init_val_ret = init_number(new_value, json_number_info(&dom_parser->parser)); break;
+        case JSON_STRING:       init_val_ret = value_init_string_alloc(new_value, data, data_size, dom_parser->allocator); break;
+        case JSON_ARRAY_BEG:    init_val_ret = value_init_array_alloc(new_value, dom_parser->allocator); break;
+        case JSON_OBJECT_BEG:   init_val_ret = value_init_dict_alloc(new_value, NULL, dom_parser->dict_flags, dom_parser->allocator); break;
         default:                return JSON_ERR_INTERNAL;
     }
 
@@ -135,7 +146,8 @@ json_dom_process(JSON_TYPE type, const char* data, size_t data_size, void* user_
 
             if(new_path_alloc == 0)
                 new_path_alloc = 32;
-            new_path = (VALUE**) realloc(dom_parser->path, new_path_alloc * sizeof(VALUE*));
+            new_path = (VALUE**) json_dom_realloc(dom_parser, dom_parser->path,
+                            new_path_alloc * sizeof(VALUE*));
             if(new_path == NULL)
                 return JSON_ERR_OUTOFMEMORY;
 
@@ -149,12 +161,25 @@ json_dom_process(JSON_TYPE type, const char* data, size_t data_size, void* user_
     return 0;
 }
 
-int
-json_dom_init(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config, unsigned dom_flags)
+static int
+json_dom_init_(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config, unsigned dom_flags,
+               JSON_DOM_DOCUMENT_CALLBACK on_document, void* user_data)
 {
     static const JSON_CALLBACKS callbacks = {
         json_dom_process
     };
+    JSON_CONFIG cfg;
+
+    if(config != NULL)
+        memcpy(&cfg, config, sizeof(JSON_CONFIG));
+    else
+        json_default_config(&cfg);
+
+    /* Without the callback, there would be nowhere to put the documents. */
+    if(on_document != NULL)
+        cfg.flags |= JSON_MULTIDOC;
+    else
+        cfg.flags &= ~JSON_MULTIDOC;
 
     dom_parser->path = NULL;
     dom_parser->path_size = 0;
@@ -163,8 +188,30 @@ json_dom_init(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config, unsigned d
     value_init_null(&dom_parser->key);
     dom_parser->flags = dom_flags;
     dom_parser->dict_flags = (dom_flags & JSON_DOM_MAINTAINDICTORDER) ? VALUE_DICT_MAINTAINORDER : 0;
+    dom_parser->on_document = on_document;
+    dom_parser->user_data = user_data;
+    dom_parser->allocator = cfg.allocator;
+
+    /* We need the strings whole and decoded anyway, and the numbers decoded
+     * too. */
+    cfg.flags &= ~(JSON_STRINGPARTS | JSON_RAWSTRINGS);
+    cfg.flags |= JSON_NUMBERINFO;
+
+    return json_init(&dom_parser->parser, &callbacks, &cfg, (void*) dom_parser);
+}
 
-    return json_init(&dom_parser->parser, &callbacks, config, (void*) dom_parser);
+int
+json_dom_init(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config, unsigned dom_flags)
+{
+    return json_dom_init_(dom_parser, config, dom_flags, NULL, NULL);
+}
+
+int
+json_dom_init_multidoc(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config,
+                       unsigned dom_flags, JSON_DOM_DOCUMENT_CALLBACK on_document,
+                       void* user_data)
+{
+    return json_dom_init_(dom_parser, config, dom_flags, on_document, user_data);
 }
 
 int
@@ -188,7 +235,38 @@ json_dom_fini(JSON_DOM_PARSER* dom_parser, VALUE* p_root, JSON_INPUT_POS* p_pos)
     }
 
     value_fini(&dom_parser->key);
-    free(dom_parser->path);
+    json_dom_free(dom_parser, dom_parser->path);
+
+    return ret;
+}
+
+int
+json_dom_reset(JSON_DOM_PARSER* dom_parser, VALUE* p_root, JSON_INPUT_POS* p_pos)
+{
+    size_t max_retained_size = dom_parser->parser.config.max_retained_size;
+    int ret;
+
+    ret = json_reset(&dom_parser->parser, p_pos);
+
+    if(ret == 0) {
+        memcpy(p_root, &dom_parser->root, sizeof(VALUE));
+    } else {
+        value_init_null(p_root);
+        value_fini(&dom_parser->root);
+    }
+    value_init_null(&dom_parser->root);
+
+    value_fini(&dom_parser->key);
+    value_init_null(&dom_parser->key);
+
+    dom_parser->path_size = 0;
+    if(max_retained_size != 0  &&
+       dom_parser->path_alloc * sizeof(VALUE*) > max_retained_size)
+    {
+        json_dom_free(dom_parser, dom_parser->path);
+        dom_parser->path = NULL;
+        dom_parser->path_alloc = 0;
+    }
 
     return ret;
 }
@@ -205,18 +283,66 @@ json_dom_parse(const char* input, size_t size, const JSON_CONFIG* config,
         return ret;
 
     /* We rely on propagation of any error code into json_fini(). */
-    json_dom_feed(&dom_parser, input, size);
+    json_feed_last(&dom_parser.parser, input, size);
 
     return json_dom_fini(&dom_parser, p_root, p_pos);
 }
 
+#define JSON_DOM_DUMP_BUFSIZE       4096
+
 typedef struct JSON_DOM_DUMP_PARAMS {
     JSON_DUMP_CALLBACK write_func;
     void* user_data;
     unsigned tab_width;
     unsigned flags;
+
+    /* All the output is collected here so the write_func() gets few large
+     * chunks instead of many tiny ones. */
+    char buffer[JSON_DOM_DUMP_BUFSIZE];
+    size_t buffer_used;
 } JSON_DOM_DUMP_PARAMS;
 
+static int
+json_dom_dump_flush(JSON_DOM_DUMP_PARAMS* params)
+{
+    int ret = 0;
+
+    if(params->buffer_used > 0) {
+        ret = params->write_func(params->buffer, params->buffer_used, params->user_data);
+        params->buffer_used = 0;
+    }
+
+    return ret;
+}
+
+/* Make sure there is at least `size` bytes free in the buffer. */
+static int
+json_dom_dump_reserve(JSON_DOM_DUMP_PARAMS* params, size_t size)
+{
+    if(params->buffer_used + size > sizeof(params->buffer))
+        return json_dom_dump_flush(params);
+    return 0;
+}
+
+/* (Compatible with JSON_DUMP_CALLBACK, with `params` as the user data.) */
+static int
+json_dom_dump_write(const char* str, size_t size, void* user_data)
+{
+    JSON_DOM_DUMP_PARAMS* params = (JSON_DOM_DUMP_PARAMS*) user_data;
+    int ret;
+
+    ret = json_dom_dump_reserve(params, size);
+    if(ret != 0)
+        return ret;
+
+    if(size > sizeof(params->buffer))
+        return params->write_func(str, size, params->user_data);
+
+    memcpy(params->buffer + params->buffer_used, str, size);
+    params->buffer_used += size;
+    return 0;
+}
+
 static int
 json_dom_dump_indent(unsigned nest_level, JSON_DOM_DUMP_PARAMS* params)
 {
@@ -244,7 +370,7 @@ json_dom_dump_indent(unsigned nest_level, JSON_DOM_DUMP_PARAMS* params)
     }
 
     for(i = 0; i < n; i += run) {
-        int ret = params->write_func(str, (run > n - i) ? n - i : run, params->user_data);
+        int ret = json_dom_dump_write(str, (run > n - i) ? n - i : run, params);
         if(ret != 0)
             return ret;
     }
@@ -259,9 +385,9 @@ json_dom_dump_newline(JSON_DOM_DUMP_PARAMS* params)
         return 0;
 
     if(params->flags & JSON_DOM_DUMP_FORCECLRF)
-        return params->write_func("\r\n", 2, params->user_data);
+        return json_dom_dump_write("\r\n", 2, params);
     else
-        return params->write_func("\n", 1, params->user_data);
+        return json_dom_dump_write("\n", 1, params);
 }
 
 static int
@@ -280,45 +406,67 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
 
     switch(value_type(node)) {
         case VALUE_NULL:
-            ret = params->write_func("null", 4, params->user_data);
+            ret = json_dom_dump_write("null", 4, params);
             break;
 
         case VALUE_BOOL:
             if(value_bool(node))
-                ret = params->write_func("true", 4, params->user_data);
+                ret = json_dom_dump_write("true", 4, params);
             else
-                ret = params->write_func("false", 5, params->user_data);
+                ret = json_dom_dump_write("false", 5, params);
             break;
 
         case VALUE_INT32:
-            ret = json_dump_int32(value_int32(node),
-                            params->write_func, params->user_data);
+            ret = json_dom_dump_reserve(params, JSON_FORMAT_BUFSIZE);
+            if(ret == 0) {
+                params->buffer_used += json_format_int32(
+                            params->buffer + params->buffer_used, value_int32(node));
+            }
             break;
 
         case VALUE_UINT32:
-            ret = json_dump_uint32(value_uint32(node),
-                            params->write_func, params->user_data);
+            ret = json_dom_dump_reserve(params, JSON_FORMAT_BUFSIZE);
+            if(ret == 0) {
+                params->buffer_used += json_format_uint32(
+                            params->buffer + params->buffer_used, value_uint32(node));
+            }
             break;
 
         case VALUE_INT64:
-            ret = json_dump_int64(value_int64(node),
-                            params->write_func, params->user_data);
+            ret = json_dom_dump_reserve(params, JSON_FORMAT_BUFSIZE);
+            if(ret == 0) {
+                params->buffer_used += json_format_int64(
+                            params->buffer + params->buffer_used, value_int64(node));
+            }
             break;
 
         case VALUE_UINT64:
-            ret = json_dump_uint64(value_uint64(node),
-                            params->write_func, params->user_data);
+            ret = json_dom_dump_reserve(params, JSON_FORMAT_BUFSIZE);
+            if(ret == 0) {
+                params->buffer_used += json_format_uint64(
+                            params->buffer + params->buffer_used, value_uint64(node));
+            }
             break;
 
         case VALUE_FLOAT:
+            ret = json_dom_dump_reserve(params, JSON_FORMAT_BUFSIZE);
+            if(ret == 0) {
+                params->buffer_used += json_format_float(
+                            params->buffer + params->buffer_used, value_float(node));
+            }
+            break;
+
         case VALUE_DOUBLE:
-            ret = json_dump_double(value_double(node),
-                            params->write_func, params->user_data);
+            ret = json_dom_dump_reserve(params, JSON_FORMAT_BUFSIZE);
+            if(ret == 0) {
+                params->buffer_used += json_format_double(
+                            params->buffer + params->buffer_used, value_double(node));
+            }
             break;
 
         case VALUE_STRING:
             ret = json_dump_string(value_string(node), value_string_length(node),
-                            params->write_func, params->user_data);
+                            json_dom_dump_write, params);
             break;
 
         case VALUE_ARRAY:
@@ -326,7 +474,7 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
             const VALUE* values;
             size_t i, n;
 
-            ret = params->write_func("[", 1, params->user_data);
+            ret = json_dom_dump_write("[", 1, params);
             if(ret != 0)
                 return ret;
 
@@ -342,7 +490,7 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
                     return ret;
 
                 if(i < n - 1) {
-                    ret = params->write_func(",", 1, params->user_data);
+                    ret = json_dom_dump_write(",", 1, params);
                     if(ret != 0)
                         return ret;
                 }
@@ -356,7 +504,7 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
             if(ret != 0)
                 return ret;
 
-            ret = params->write_func("]", 1, params->user_data);
+            ret = json_dom_dump_write("]", 1, params);
             break;
         }
 
@@ -365,7 +513,7 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
             const VALUE** keys;
             size_t i, n;
 
-            ret = params->write_func("{", 1, params->user_data);
+            ret = json_dom_dump_write("{", 1, params);
             if(ret != 0)
                 return ret;
 
@@ -392,9 +540,8 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
                     if(ret != 0)
                         break;
 
-                    ret = params->write_func(": ",
-                            (params->flags & JSON_DOM_DUMP_MINIMIZE) ? 1 : 2,
-                            params->user_data);
+                    ret = json_dom_dump_write(": ",
+                            (params->flags & JSON_DOM_DUMP_MINIMIZE) ? 1 : 2, params);
                     if(ret != 0)
                         break;
 
@@ -404,7 +551,7 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
                         break;
 
                     if(i < n - 1) {
-                        ret = params->write_func(",", 1, params->user_data);
+                        ret = json_dom_dump_write(",", 1, params);
                         if(ret != 0)
                             break;
                     }
@@ -423,7 +570,7 @@ json_dom_dump_helper(const VALUE* node, int nest_level,
             if(ret != 0)
                 return ret;
 
-            ret = params->write_func("}", 1, params->user_data);
+            ret = json_dom_dump_write("}", 1, params);
             break;
         }
     }
@@ -435,13 +582,22 @@ int
 json_dom_dump(const VALUE* root, JSON_DUMP_CALLBACK write_func,
               void* user_data, unsigned tab_width, unsigned flags)
 {
-    JSON_DOM_DUMP_PARAMS params = { write_func, user_data, tab_width, flags };
+    JSON_DOM_DUMP_PARAMS params;
     int ret;
 
+    params.write_func = write_func;
+    params.user_data = user_data;
+    params.tab_width = tab_width;
+    params.flags = flags;
+    params.buffer_used = 0;
+
     ret = json_dom_dump_helper(root, 0, &params);
     if(ret != 0)
         return ret;
 
     ret = json_dom_dump_newline(&params);
-    return ret;
+    if(ret != 0)
+        return ret;
+
+    return json_dom_dump_flush(&params);
 }
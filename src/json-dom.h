@@ -56,6 +56,11 @@ extern "C" {
 #define JSON_DOM_MAINTAINDICTORDER      0x0010
 
 
+/* Callback for json_dom_init_multidoc().
+ */
+typedef int (*JSON_DOM_DOCUMENT_CALLBACK)(VALUE* /*root*/, void* /*user_data*/);
+
+
 /* Structure holding parsing state. Do not access it directly.
  */
 typedef struct JSON_DOM_PARSER {
@@ -67,15 +72,39 @@ typedef struct JSON_DOM_PARSER {
     VALUE key;
     unsigned flags;
     unsigned dict_flags;
+    JSON_DOM_DOCUMENT_CALLBACK on_document;
+    void* user_data;
+    const VALUE_ALLOCATOR* allocator;
 } JSON_DOM_PARSER;
 
 
 /* Initialize the DOM parser structure.
  *
- * The parameter `config` is propagated into json_init().
+ * The parameter `config` is propagated into json_init(). (Flag JSON_MULTIDOC
+ * is ignored; use json_dom_init_multidoc() for that.)
+ *
+ * If JSON_CONFIG::allocator is set, it serves not only the underlying parser
+ * but all the values of the DOM are created with it too (so value_fini()
+ * releases them through it). The allocator structure then has to outlive all
+ * those values.
  */
 int json_dom_init(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config, unsigned dom_flags);
 
+/* Initialize the DOM parser structure for a stream of JSON documents (i.e.
+ * with JSON_MULTIDOC, whether it is set in `config` or not).
+ *
+ * Whenever a top-level value is complete, it is passed to the callback
+ * `on_document` as `root`. The callback takes over the ownership of it, i.e.
+ * it is responsible for calling value_fini() on it. If the callback returns
+ * non-zero, the parsing is aborted and the value is propagated to
+ * json_dom_feed() and json_dom_fini().
+ *
+ * Note json_dom_fini() then always provides VALUE_NULL as the root.
+ */
+int json_dom_init_multidoc(JSON_DOM_PARSER* dom_parser, const JSON_CONFIG* config,
+                           unsigned dom_flags, JSON_DOM_DOCUMENT_CALLBACK on_document,
+                           void* user_data);
+
 /* Feed the parser with more input.
  */
 int json_dom_feed(JSON_DOM_PARSER* dom_parser, const char* input, size_t size);
@@ -93,6 +122,13 @@ int json_dom_feed(JSON_DOM_PARSER* dom_parser, const char* input, size_t size);
  */
 int json_dom_fini(JSON_DOM_PARSER* dom_parser, VALUE* p_dom, JSON_INPUT_POS* p_pos);
 
+/* Same as json_dom_fini() but instead of releasing the resources, make the
+ * parser ready for another document (see json_reset()).
+ *
+ * Note json_dom_fini() still has to be called once the parser is not needed.
+ */
+int json_dom_reset(JSON_DOM_PARSER* dom_parser, VALUE* p_dom, JSON_INPUT_POS* p_pos);
+
 
 /* Simple wrapper for json_dom_init() + json_dom_feed() + json_dom_fini(),
  * usable when the provided input contains complete JSON document.
@@ -0,0 +1,972 @@
+/*
+ * CentiJSON
+ * <http://github.com/mity/centijson>
+ *
+ * Copyright (c) 2018 Martin Mitas
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "json-parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+
+/**************************
+ *** Threading wrappers ***
+ **************************/
+
+#ifdef _WIN32
+    typedef CRITICAL_SECTION    JSON_PAR_MUTEX;
+    typedef CONDITION_VARIABLE  JSON_PAR_COND;
+    typedef HANDLE              JSON_PAR_THREAD;
+
+    #define json_par_mutex_init(m)      InitializeCriticalSection(m)
+    #define json_par_mutex_fini(m)      DeleteCriticalSection(m)
+    #define json_par_lock(m)            EnterCriticalSection(m)
+    #define json_par_unlock(m)          LeaveCriticalSection(m)
+    #define json_par_cond_init(c)       InitializeConditionVariable(c)
+    #define json_par_cond_fini(c)       do { } while(0)
+    #define json_par_cond_wait(c, m)    SleepConditionVariableCS((c), (m), INFINITE)
+    #define json_par_cond_broadcast(c)  WakeAllConditionVariable(c)
+#else
+    typedef pthread_mutex_t     JSON_PAR_MUTEX;
+    typedef pthread_cond_t      JSON_PAR_COND;
+    typedef pthread_t           JSON_PAR_THREAD;
+
+    #define json_par_mutex_init(m)      pthread_mutex_init((m), NULL)
+    #define json_par_mutex_fini(m)      pthread_mutex_destroy(m)
+    #define json_par_lock(m)            pthread_mutex_lock(m)
+    #define json_par_unlock(m)          pthread_mutex_unlock(m)
+    #define json_par_cond_init(c)       pthread_cond_init((c), NULL)
+    #define json_par_cond_fini(c)       pthread_cond_destroy(c)
+    #define json_par_cond_wait(c, m)    pthread_cond_wait((c), (m))
+    #define json_par_cond_broadcast(c)  pthread_cond_broadcast(c)
+#endif
+
+static unsigned
+json_par_cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (unsigned) info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (unsigned) n : 1;
+#endif
+}
+
+typedef struct JSON_PAR_TASK {
+    void (*func)(void*);
+    void* arg;
+} JSON_PAR_TASK;
+
+#ifdef _WIN32
+static DWORD WINAPI
+json_par_thread_proc(LPVOID param)
+{
+    JSON_PAR_TASK* task = (JSON_PAR_TASK*) param;
+    task->func(task->arg);
+    return 0;
+}
+
+static int
+json_par_thread_create(JSON_PAR_THREAD* thread, JSON_PAR_TASK* task)
+{
+    *thread = CreateThread(NULL, 0, json_par_thread_proc, (LPVOID) task, 0, NULL);
+    return (*thread != NULL) ? 0 : -1;
+}
+
+static void
+json_par_thread_join(JSON_PAR_THREAD thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+#else
+static void*
+json_par_thread_proc(void* param)
+{
+    JSON_PAR_TASK* task = (JSON_PAR_TASK*) param;
+    task->func(task->arg);
+    return NULL;
+}
+
+static int
+json_par_thread_create(JSON_PAR_THREAD* thread, JSON_PAR_TASK* task)
+{
+    return pthread_create(thread, NULL, json_par_thread_proc, (void*) task);
+}
+
+static void
+json_par_thread_join(JSON_PAR_THREAD thread)
+{
+    pthread_join(thread, NULL);
+}
+#endif
+
+/* Run `func` on `n_threads` threads (the calling one included) and wait for
+ * all of them to finish. If we fail to start some threads, we just go on with
+ * those we have. */
+static void
+json_par_run(unsigned n_threads, void (*func)(void*), void* arg)
+{
+    JSON_PAR_TASK task = { func, arg };
+    JSON_PAR_THREAD* threads;
+    unsigned n_started = 0;
+    unsigned i;
+
+    threads = (JSON_PAR_THREAD*) malloc((n_threads - 1) * sizeof(JSON_PAR_THREAD));
+    if(threads != NULL) {
+        while(n_started < n_threads - 1) {
+            if(json_par_thread_create(&threads[n_started], &task) != 0)
+                break;
+            n_started++;
+        }
+    }
+
+    func(arg);
+
+    for(i = 0; i < n_started; i++)
+        json_par_thread_join(threads[i]);
+    free(threads);
+}
+
+
+/* Bounds of the chunk size. Smaller chunks balance the load among the threads
+ * better, but each chunk costs some overhead. */
+#define JSON_PAR_MIN_CHUNK          (64 * 1024)
+#define JSON_PAR_MAX_CHUNK          (4 * 1024 * 1024)
+
+static size_t
+json_par_chunk_size(size_t size, unsigned n_threads)
+{
+    size_t chunk_size = size / ((size_t) n_threads * 8);
+
+    if(chunk_size < JSON_PAR_MIN_CHUNK)
+        chunk_size = JSON_PAR_MIN_CHUNK;
+    if(chunk_size > JSON_PAR_MAX_CHUNK)
+        chunk_size = JSON_PAR_MAX_CHUNK;
+    return chunk_size;
+}
+
+
+/**********************
+ *** NDJSON parsing ***
+ **********************/
+
+/* With the in-order delivery, how many chunks (per thread) may be parsed
+ * ahead of the one we wait for. This bounds the memory consumption if some
+ * chunk takes long. */
+#define JSON_PAR_WINDOW             4
+
+/* With JSON_NDJSON_ASCOMPLETED, how many documents are passed to the
+ * application at once. Each batch costs a few locks, but the bigger it is,
+ * the colder in the cache the documents get before they are passed. */
+#define JSON_PAR_BATCH              256
+
+/* Returned by our callback to stop parsing of a chunk which does not matter
+ * anymore. (It never gets to the application.) */
+#define JSON_PAR_ABORT              JSON_ERR_INTERNAL
+
+/* (The parsed documents are kept in JSON_PAR_CTX::docs rather than here: VALUE
+ * has no alignment of its own, so in an array of this struct it would end up
+ * misaligned for the pointers value.c stores into it.) */
+typedef struct JSON_PAR_CHUNK {
+    unsigned n_lines;   /* Count of line breaks in the chunk. */
+    unsigned end_column;
+    int done;
+} JSON_PAR_CHUNK;
+
+typedef struct JSON_PAR_CTX {
+    const char* input;
+    size_t size;
+    size_t chunk_size;
+    size_t n_chunks;
+    size_t window;
+    JSON_CONFIG config;
+    unsigned dom_flags;
+    unsigned flags;
+    JSON_DOM_DOCUMENT_CALLBACK on_document;
+    void* user_data;
+
+    /* Serializes the calls of the application callback. (With the in-order
+     * delivery, JSON_PAR_CTX::delivering does that instead.) */
+    JSON_PAR_MUTEX deliver_mutex;
+
+    /* All below is guarded by the mutex. (Except that each thread owns the
+     * item in JSON_PAR_CTX::docs of the chunk it is parsing.) */
+    JSON_PAR_MUTEX mutex;
+    JSON_PAR_COND cond;
+    JSON_PAR_CHUNK* chunks;
+    VALUE* docs;            /* Per chunk array of the parsed documents (in-order delivery). */
+    size_t next_chunk;      /* Next chunk to be parsed. */
+    size_t next_deliver;    /* Next chunk to be delivered (in-order delivery). */
+    int delivering;         /* Some thread is delivering (in-order delivery). */
+    int errcode;
+    size_t err_chunk;
+    JSON_INPUT_POS err_pos;
+} JSON_PAR_CTX;
+
+/* Per-thread data. The DOM parser is reused for all the chunks the thread
+ * parses (see json_dom_reset()). */
+typedef struct JSON_PAR_WORK {
+    JSON_PAR_CTX* ctx;
+    size_t chunk_index;
+    JSON_DOM_PARSER dom_parser;
+    int has_parser;
+    VALUE* batch;           /* Documents to be delivered (JSON_NDJSON_ASCOMPLETED). */
+    size_t n_batch;
+} JSON_PAR_WORK;
+
+/* The chunks are nominally of the same size but each one (except the 1st one)
+ * starts just behind the first new line at or after its nominal start. */
+static size_t
+json_par_chunk_start(const JSON_PAR_CTX* ctx, size_t i)
+{
+    const char* nl;
+    size_t off;
+
+    if(i == 0)
+        return 0;
+
+    off = i * ctx->chunk_size;
+    if(off >= ctx->size)
+        return ctx->size;
+
+    nl = (const char*) memchr(ctx->input + off - 1, '\n', ctx->size - off + 1);
+    return (nl != NULL) ? (size_t) (nl - ctx->input) + 1 : ctx->size;
+}
+
+static void
+json_par_record_error(JSON_PAR_CTX* ctx, size_t chunk_index, int errcode,
+                      const JSON_INPUT_POS* pos)
+{
+    if(ctx->errcode == 0  ||  chunk_index < ctx->err_chunk) {
+        ctx->errcode = errcode;
+        ctx->err_chunk = chunk_index;
+        if(pos != NULL)
+            memcpy(&ctx->err_pos, pos, sizeof(JSON_INPUT_POS));
+        else
+            memset(&ctx->err_pos, 0, sizeof(JSON_INPUT_POS));
+    }
+}
+
+/* Record failure of the application callback. Called with the mutex locked. */
+static void
+json_par_record_callback_error(JSON_PAR_CTX* ctx, size_t chunk_index, int errcode)
+{
+    /* In the stream, this error precedes any error in this or any following
+     * chunk. */
+    if(ctx->errcode != 0  &&  ctx->err_chunk == chunk_index)
+        ctx->errcode = 0;
+    json_par_record_error(ctx, chunk_index, errcode, NULL);
+}
+
+/* Pass the documents to the application. Those which it has not taken over
+ * (because it has failed) are released. Called with the mutex unlocked. */
+static int
+json_par_deliver_docs(JSON_PAR_CTX* ctx, VALUE* docs, size_t n)
+{
+    size_t i;
+    int ret = 0;
+
+    for(i = 0; i < n; i++) {
+        VALUE doc;
+
+        /* The application takes the document over. */
+        memcpy(&doc, &docs[i], sizeof(VALUE));
+        value_init_null(&docs[i]);
+
+        ret = ctx->on_document(&doc, ctx->user_data);
+        if(ret != 0)
+            break;
+    }
+
+    for(i++; i < n; i++)
+        value_fini(&docs[i]);
+    return ret;
+}
+
+/* Pass the collected documents of the current chunk to the application (with
+ * JSON_NDJSON_ASCOMPLETED). Called with the mutex unlocked. */
+static int
+json_par_flush(JSON_PAR_WORK* work)
+{
+    JSON_PAR_CTX* ctx = work->ctx;
+    size_t n = work->n_batch;
+    size_t i;
+    int skip;
+    int ret;
+
+    if(n == 0)
+        return 0;
+    work->n_batch = 0;
+
+    json_par_lock(&ctx->mutex);
+    skip = (ctx->errcode != 0  &&  ctx->err_chunk < work->chunk_index);
+    json_par_unlock(&ctx->mutex);
+
+    if(skip) {
+        /* Some preceding chunk has failed. */
+        for(i = 0; i < n; i++)
+            value_fini(&work->batch[i]);
+        return JSON_PAR_ABORT;
+    }
+
+    json_par_lock(&ctx->deliver_mutex);
+    ret = json_par_deliver_docs(ctx, work->batch, n);
+    json_par_unlock(&ctx->deliver_mutex);
+
+    if(ret != 0) {
+        json_par_lock(&ctx->mutex);
+        json_par_record_callback_error(ctx, work->chunk_index, ret);
+        json_par_unlock(&ctx->mutex);
+        return JSON_PAR_ABORT;
+    }
+
+    return 0;
+}
+
+/* Collect the documents of the chunk. With the in-order delivery they wait
+ * for the preceding chunks (see json_par_deliver()), otherwise they are passed
+ * to the application in batches. */
+static int
+json_par_on_document(VALUE* root, void* user_data)
+{
+    JSON_PAR_WORK* work = (JSON_PAR_WORK*) user_data;
+    JSON_PAR_CTX* ctx = work->ctx;
+    VALUE* docs = &ctx->docs[work->chunk_index];
+    VALUE* v;
+
+    if(ctx->flags & JSON_NDJSON_ASCOMPLETED) {
+        memcpy(&work->batch[work->n_batch++], root, sizeof(VALUE));
+        if(work->n_batch >= JSON_PAR_BATCH)
+            return json_par_flush(work);
+        return 0;
+    }
+
+    if(value_type(docs) == VALUE_NULL  &&  value_init_array(docs) != 0) {
+        value_fini(root);
+        return JSON_ERR_OUTOFMEMORY;
+    }
+    v = value_array_append(docs);
+    if(v == NULL) {
+        value_fini(root);
+        return JSON_ERR_OUTOFMEMORY;
+    }
+    memcpy(v, root, sizeof(VALUE));
+    return 0;
+}
+
+/* Parse the chunk. The position of an error (if any) is relative to the
+ * chunk. */
+static int
+json_par_parse_chunk(JSON_PAR_WORK* work, size_t chunk_index, JSON_INPUT_POS* p_pos)
+{
+    JSON_PAR_CTX* ctx = work->ctx;
+    VALUE root;
+    size_t beg, end;
+    int ret;
+
+    beg = json_par_chunk_start(ctx, chunk_index);
+    end = json_par_chunk_start(ctx, chunk_index + 1);
+    if(beg >= end)
+        return 0;
+
+    work->chunk_index = chunk_index;
+    if(!work->has_parser) {
+        ret = json_dom_init_multidoc(&work->dom_parser, &ctx->config, ctx->dom_flags,
+                                     json_par_on_document, work);
+        if(ret != 0)
+            return ret;
+        work->has_parser = 1;
+    }
+
+    /* We rely on propagation of any error code into json_dom_reset(). */
+    json_dom_feed(&work->dom_parser, ctx->input + beg, end - beg);
+    ret = json_dom_reset(&work->dom_parser, &root, p_pos);
+
+    /* The documents preceding an error are delivered too. (If the chunk has
+     * been aborted, there is nothing to deliver.) */
+    if((ctx->flags & JSON_NDJSON_ASCOMPLETED)  &&  ret != JSON_PAR_ABORT)
+        json_par_flush(work);
+
+    /* Remember where the chunk ends so we can compute positions in the whole
+     * input without counting the lines again. */
+    if(ret == 0) {
+        ctx->chunks[chunk_index].n_lines = p_pos->line_number - 1;
+        ctx->chunks[chunk_index].end_column = p_pos->column_number;
+    }
+
+    return ret;
+}
+
+/* Pass all the documents we can to the application in the input order.
+ * Called with the mutex locked.
+ *
+ * The callback is called with the mutex unlocked so the other threads may go
+ * on with parsing. Only one thread delivers at a time; the others just leave
+ * their parsed chunks to it. */
+static void
+json_par_deliver(JSON_PAR_CTX* ctx)
+{
+    if(ctx->delivering)
+        return;
+    ctx->delivering = 1;
+
+    while(ctx->next_deliver < ctx->n_chunks  &&  ctx->chunks[ctx->next_deliver].done) {
+        size_t chunk_index = ctx->next_deliver;
+        VALUE docs;
+        int ret;
+
+        /* Nothing behind a failed chunk may be delivered. */
+        if(ctx->errcode != 0  &&  chunk_index > ctx->err_chunk)
+            break;
+
+        memcpy(&docs, &ctx->docs[chunk_index], sizeof(VALUE));
+        value_init_null(&ctx->docs[chunk_index]);
+
+        json_par_unlock(&ctx->mutex);
+        ret = json_par_deliver_docs(ctx, value_array_get_all(&docs), value_array_size(&docs));
+        value_fini(&docs);
+        json_par_lock(&ctx->mutex);
+
+        if(ret != 0)
+            json_par_record_callback_error(ctx, chunk_index, ret);
+        ctx->next_deliver++;
+        json_par_cond_broadcast(&ctx->cond);
+    }
+
+    ctx->delivering = 0;
+}
+
+static void
+json_par_worker(void* arg)
+{
+    JSON_PAR_CTX* ctx = (JSON_PAR_CTX*) arg;
+    int in_order = !(ctx->flags & JSON_NDJSON_ASCOMPLETED);
+    JSON_PAR_WORK work;
+
+    work.ctx = ctx;
+    work.has_parser = 0;
+    work.batch = NULL;
+    work.n_batch = 0;
+
+    if(!in_order) {
+        work.batch = (VALUE*) malloc(JSON_PAR_BATCH * sizeof(VALUE));
+        if(work.batch == NULL) {
+            json_par_lock(&ctx->mutex);
+            json_par_record_error(ctx, 0, JSON_ERR_OUTOFMEMORY, NULL);
+            json_par_unlock(&ctx->mutex);
+            return;
+        }
+    }
+
+    json_par_lock(&ctx->mutex);
+    while(1) {
+        JSON_INPUT_POS pos;
+        size_t i;
+        int ret;
+
+        if(in_order) {
+            while(ctx->errcode == 0  &&  ctx->next_chunk >= ctx->next_deliver + ctx->window)
+                json_par_cond_wait(&ctx->cond, &ctx->mutex);
+        }
+
+        if(ctx->next_chunk >= ctx->n_chunks)
+            break;
+        if(ctx->errcode != 0  &&  ctx->next_chunk > ctx->err_chunk)
+            break;
+
+        i = ctx->next_chunk++;
+        json_par_unlock(&ctx->mutex);
+
+        ret = json_par_parse_chunk(&work, i, &pos);
+
+        json_par_lock(&ctx->mutex);
+        if(ret != 0)
+            json_par_record_error(ctx, i, ret, &pos);
+        if(in_order) {
+            ctx->chunks[i].done = 1;
+            json_par_deliver(ctx);
+            json_par_cond_broadcast(&ctx->cond);
+        }
+    }
+    json_par_unlock(&ctx->mutex);
+
+    if(work.has_parser) {
+        VALUE root;
+        json_dom_fini(&work.dom_parser, &root, NULL);
+    }
+    free(work.batch);
+}
+
+int
+json_ndjson_parse_parallel(const char* input, size_t size,
+                           const JSON_CONFIG* config, unsigned dom_flags,
+                           unsigned n_threads, unsigned flags,
+                           JSON_DOM_DOCUMENT_CALLBACK on_document, void* user_data,
+                           JSON_INPUT_POS* p_pos)
+{
+    JSON_PAR_CTX ctx;
+    size_t i;
+
+    memset(&ctx, 0, sizeof(JSON_PAR_CTX));
+    ctx.input = input;
+    ctx.size = size;
+    ctx.dom_flags = dom_flags;
+    ctx.flags = flags;
+    ctx.on_document = on_document;
+    ctx.user_data = user_data;
+    if(config != NULL)
+        memcpy(&ctx.config, config, sizeof(JSON_CONFIG));
+    else
+        json_default_config(&ctx.config);
+
+    if(n_threads == 0)
+        n_threads = json_par_cpu_count();
+
+    ctx.chunk_size = json_par_chunk_size(size, n_threads);
+    ctx.n_chunks = (size + ctx.chunk_size - 1) / ctx.chunk_size;
+    if(n_threads > ctx.n_chunks)
+        n_threads = (unsigned) ctx.n_chunks;
+    ctx.window = (size_t) n_threads * JSON_PAR_WINDOW;
+
+    if(n_threads <= 1  ||
+       (ctx.config.max_total_len != 0  &&  size > ctx.config.max_total_len))
+    {
+        /* Leave it to the serial parser: Nothing to parallelize, or it knows
+         * how to report the exceeded limit. */
+        JSON_DOM_PARSER dom_parser;
+        VALUE root;
+        int ret;
+
+        ret = json_dom_init_multidoc(&dom_parser, &ctx.config, dom_flags, on_document, user_data);
+        if(ret != 0)
+            return ret;
+        json_dom_feed(&dom_parser, input, size);
+        return json_dom_fini(&dom_parser, &root, p_pos);
+    }
+
+    /* The limit is checked above for the whole input. */
+    ctx.config.max_total_len = 0;
+
+    ctx.chunks = (JSON_PAR_CHUNK*) malloc(ctx.n_chunks * sizeof(JSON_PAR_CHUNK));
+    ctx.docs = (VALUE*) malloc(ctx.n_chunks * sizeof(VALUE));
+    if(ctx.chunks == NULL  ||  ctx.docs == NULL) {
+        free(ctx.chunks);
+        free(ctx.docs);
+        return JSON_ERR_OUTOFMEMORY;
+    }
+    for(i = 0; i < ctx.n_chunks; i++) {
+        value_init_null(&ctx.docs[i]);
+        ctx.chunks[i].n_lines = 0;
+        ctx.chunks[i].end_column = 0;
+        ctx.chunks[i].done = 0;
+    }
+
+    json_par_mutex_init(&ctx.deliver_mutex);
+    json_par_mutex_init(&ctx.mutex);
+    json_par_cond_init(&ctx.cond);
+
+    json_par_run(n_threads, json_par_worker, &ctx);
+
+    json_par_cond_fini(&ctx.cond);
+    json_par_mutex_fini(&ctx.mutex);
+    json_par_mutex_fini(&ctx.deliver_mutex);
+
+    if(p_pos != NULL) {
+        if(ctx.errcode != 0) {
+            /* Make the position relative to the whole input. All the chunks
+             * before the failed one have been parsed. The chunk starts at the
+             * beginning of a line so the column is fine as it is. (Zero line
+             * number means the error has not been raised by the parser.) */
+            memcpy(p_pos, &ctx.err_pos, sizeof(JSON_INPUT_POS));
+            if(p_pos->line_number != 0) {
+                p_pos->offset += json_par_chunk_start(&ctx, ctx.err_chunk);
+                for(i = 0; i < ctx.err_chunk; i++)
+                    p_pos->line_number += ctx.chunks[i].n_lines;
+            }
+        } else {
+            p_pos->offset = size;
+            p_pos->line_number = 1;
+            for(i = 0; i < ctx.n_chunks; i++) {
+                p_pos->line_number += ctx.chunks[i].n_lines;
+                if(ctx.chunks[i].end_column != 0)
+                    p_pos->column_number = ctx.chunks[i].end_column;
+            }
+        }
+    }
+
+    /* Release whatever has not been delivered (i.e. behind an error). */
+    for(i = 0; i < ctx.n_chunks; i++)
+        value_fini(&ctx.docs[i]);
+    free(ctx.docs);
+    free(ctx.chunks);
+
+    return ctx.errcode;
+}
+
+
+
+/*********************************************
+ *** Parallel parsing of a top-level array ***
+ *********************************************/
+
+#define IS_WHITESPACE(ch)   ((ch) == ' ' || (ch) == '\t' || (ch) == '\r' || (ch) == '\n')
+
+/* The array contents is split into segments at commas which we guess to
+ * separate the top-level elements: Each segment is then parsed on its own, as
+ * if it were enclosed in its own brackets.
+ *
+ * The guess is verified by the parsing itself: The 1st segment starts at a
+ * known position, so if it parses fine up to the next guessed comma, that
+ * comma really is a top-level one. Any wrong guess (e.g. a comma inside a
+ * string or in a nested array) makes the preceding segment to fail because
+ * it ends inside the string or with unclosed brackets. A segment holding no
+ * element at all is treated as a failure too: Fed in its own brackets it would
+ * pass as an empty array, hiding e.g. a trailing comma or ",,". By induction,
+ * if all segments succeed, the result is right. Otherwise we resort to the
+ * serial parser which also provides exact error reporting.
+ *
+ * Note the guessing does not track the strings: A segment may start anywhere
+ * in the input, so we cannot know whether it starts inside a string or not.
+ * We only look at the neighbourhood of the comma and leave the rest to the
+ * verification above.
+ */
+
+typedef struct JSON_PAR_SEGMENT {
+    VALUE values;       /* Array of the parsed elements. */
+    size_t n_values;    /* All values in the segment (including the nested ones). */
+    unsigned n_lines;   /* Count of line breaks in the segment. */
+    unsigned n_tail;    /* Count of chars behind the last line break. */
+    int is_empty;
+} JSON_PAR_SEGMENT;
+
+typedef struct JSON_PAR_ARRAY_CTX {
+    const char* input;
+    size_t beg;         /* Offset of the opening '['. */
+    size_t end;         /* Offset of the closing ']'. */
+    size_t seg_size;
+    size_t n_segs;
+    char elem_opener;   /* 1st char of the 1st element if it is '{', '[' or '"'. */
+    char elem_closer;   /* Its closing counterpart. */
+    JSON_CONFIG config;
+    unsigned dom_flags;
+
+    /* All below is guarded by the mutex. */
+    JSON_PAR_MUTEX mutex;
+    JSON_PAR_SEGMENT* segs;
+    size_t next_seg;
+    int failed;
+} JSON_PAR_ARRAY_CTX;
+
+/* Is the comma at `off` likely a separator of top-level elements? We expect
+ * all elements to look alike the 1st one, e.g. "}, {" in an array of objects.
+ */
+static int
+json_par_is_separator(const JSON_PAR_ARRAY_CTX* ctx, size_t off)
+{
+    size_t prev = off - 1;
+    size_t next = off + 1;
+
+    if(ctx->elem_opener == 0)
+        return 1;
+
+    while(prev > ctx->beg  &&  IS_WHITESPACE(ctx->input[prev]))
+        prev--;
+    while(next < ctx->end  &&  IS_WHITESPACE(ctx->input[next]))
+        next++;
+
+    return (ctx->input[prev] == ctx->elem_closer  &&  ctx->input[next] == ctx->elem_opener);
+}
+
+/* Offset of the comma preceding the i-th segment. (Or of the opening/closing
+ * bracket for the 1st segment and behind the last one respectively.) */
+static size_t
+json_par_segment_start(const JSON_PAR_ARRAY_CTX* ctx, size_t i)
+{
+    size_t off;
+
+    if(i == 0)
+        return ctx->beg;
+
+    off = ctx->beg + i * ctx->seg_size;
+    while(off < ctx->end) {
+        const char* comma = (const char*) memchr(ctx->input + off, ',', ctx->end - off);
+        if(comma == NULL)
+            break;
+        off = (size_t) (comma - ctx->input);
+        if(json_par_is_separator(ctx, off))
+            return off;
+        off++;
+    }
+
+    return ctx->end;
+}
+
+static int
+json_par_parse_segment(JSON_PAR_ARRAY_CTX* ctx, JSON_DOM_PARSER* dom_parser, size_t i)
+{
+    JSON_PAR_SEGMENT* seg = &ctx->segs[i];
+    JSON_INPUT_POS pos;
+    size_t beg, end;
+    int ret;
+
+    beg = json_par_segment_start(ctx, i);
+    end = json_par_segment_start(ctx, i + 1);
+    if(beg >= end) {
+        /* Both segment starts have found the same comma. */
+        seg->is_empty = 1;
+        return 0;
+    }
+
+    /* We rely on propagation of any error code into json_dom_reset(). */
+    json_dom_feed(dom_parser, "[", 1);
+    json_dom_feed(dom_parser, ctx->input + beg + 1, end - beg - 1);
+    json_dom_feed(dom_parser, "]", 1);
+    seg->n_values = dom_parser->parser.value_counter - 1;
+    ret = json_dom_reset(dom_parser, &seg->values, &pos);
+
+    /* Only the whole array may be empty (see above). */
+    if(ret == 0  &&  value_array_size(&seg->values) == 0  &&  !(i == 0  &&  end == ctx->end))
+        ret = JSON_ERR_SYNTAX;
+
+    /* Remember where the segment ends (minus our brackets) so we can compute
+     * the final position without counting the lines again. */
+    if(ret == 0) {
+        seg->n_lines = pos.line_number - 1;
+        seg->n_tail = pos.column_number - ((seg->n_lines > 0) ? 2 : 3);
+    }
+
+    return ret;
+}
+
+static void
+json_par_array_worker(void* arg)
+{
+    JSON_PAR_ARRAY_CTX* ctx = (JSON_PAR_ARRAY_CTX*) arg;
+    JSON_DOM_PARSER dom_parser;
+    VALUE root;
+
+    /* The parser is reused for all the segments (see json_dom_reset()). */
+    json_dom_init(&dom_parser, &ctx->config, ctx->dom_flags);
+
+    json_par_lock(&ctx->mutex);
+    while(!ctx->failed  &&  ctx->next_seg < ctx->n_segs) {
+        size_t i = ctx->next_seg++;
+        int ret;
+
+        json_par_unlock(&ctx->mutex);
+        ret = json_par_parse_segment(ctx, &dom_parser, i);
+        json_par_lock(&ctx->mutex);
+
+        if(ret != 0)
+            ctx->failed = 1;
+    }
+    json_par_unlock(&ctx->mutex);
+
+    json_dom_fini(&dom_parser, &root, NULL);
+}
+
+/* Advance the position over the text, counting line breaks the same way as
+ * the parser does. */
+static void
+json_par_advance(JSON_INPUT_POS* pos, const char* text, size_t size)
+{
+    size_t off;
+
+    for(off = 0; off < size; off++) {
+        if(text[off] == '\r'  ||  text[off] == '\n') {
+            if(text[off] == '\r'  &&  off+1 < size  &&  text[off+1] == '\n')
+                off++;
+            pos->line_number++;
+            pos->column_number = 1;
+        } else {
+            pos->column_number++;
+        }
+    }
+
+    pos->offset += size;
+}
+
+/* Compute position at the end of the input, as the serial parser would
+ * report. Only the text outside of the segments has to be scanned. */
+static void
+json_par_array_end_pos(const JSON_PAR_ARRAY_CTX* ctx, size_t size, JSON_INPUT_POS* pos)
+{
+    size_t i;
+
+    pos->offset = 0;
+    pos->line_number = 1;
+    pos->column_number = 1;
+    json_par_advance(pos, ctx->input, ctx->beg + 1);
+
+    for(i = 0; i < ctx->n_segs; i++) {
+        const JSON_PAR_SEGMENT* seg = &ctx->segs[i];
+
+        if(seg->is_empty)
+            continue;
+
+        if(seg->n_lines > 0) {
+            pos->line_number += seg->n_lines;
+            pos->column_number = 1 + seg->n_tail;
+        } else {
+            pos->column_number += seg->n_tail;
+        }
+        /* The trailing ',' or ']'. */
+        pos->column_number++;
+    }
+
+    pos->offset = ctx->end + 1;
+    json_par_advance(pos, ctx->input + ctx->end + 1, size - ctx->end - 1);
+}
+
+/* Move all the elements of the segments into the root array. */
+static int
+json_par_splice(JSON_PAR_ARRAY_CTX* ctx, VALUE* root)
+{
+    size_t i, j, n;
+
+    if(value_init_array(root) != 0)
+        return JSON_ERR_OUTOFMEMORY;
+
+    for(i = 0; i < ctx->n_segs; i++) {
+        VALUE* values = &ctx->segs[i].values;
+
+        n = value_array_size(values);
+        for(j = 0; j < n; j++) {
+            VALUE* src = value_array_get(values, j);
+            VALUE* dst = value_array_append(root);
+
+            if(dst == NULL) {
+                value_fini(root);
+                return JSON_ERR_OUTOFMEMORY;
+            }
+            memcpy(dst, src, sizeof(VALUE));
+            value_init_null(src);
+        }
+    }
+
+    return 0;
+}
+
+int
+json_dom_parse_array_parallel(const char* input, size_t size,
+                              const JSON_CONFIG* config, unsigned dom_flags,
+                              unsigned n_threads, VALUE* p_root, JSON_INPUT_POS* p_pos)
+{
+    JSON_PAR_ARRAY_CTX ctx;
+    size_t first;
+    size_t n_values;
+    size_t i;
+    int ret = -1;
+
+    memset(&ctx, 0, sizeof(JSON_PAR_ARRAY_CTX));
+    ctx.input = input;
+    ctx.dom_flags = dom_flags;
+    if(config != NULL)
+        memcpy(&ctx.config, config, sizeof(JSON_CONFIG));
+    else
+        json_default_config(&ctx.config);
+
+    if(n_threads == 0)
+        n_threads = json_par_cpu_count();
+
+    /* Locate the brackets. */
+    ctx.beg = 0;
+    while(ctx.beg < size  &&  IS_WHITESPACE(input[ctx.beg]))
+        ctx.beg++;
+    ctx.end = size;
+    while(ctx.end > ctx.beg  &&  IS_WHITESPACE(input[ctx.end-1]))
+        ctx.end--;
+    ctx.end--;
+
+    ctx.seg_size = json_par_chunk_size(size, n_threads);
+    ctx.n_segs = (size + ctx.seg_size - 1) / ctx.seg_size;
+    if(n_threads > ctx.n_segs)
+        n_threads = (unsigned) ctx.n_segs;
+
+    if(n_threads <= 1  ||  ctx.end <= ctx.beg  ||
+       input[ctx.beg] != '['  ||  input[ctx.end] != ']'  ||
+       (ctx.config.flags & JSON_NOARRAYASROOT)  ||
+       (ctx.config.max_total_len != 0  &&  size > ctx.config.max_total_len))
+    {
+        goto serial;
+    }
+
+    first = ctx.beg + 1;
+    while(first < ctx.end  &&  IS_WHITESPACE(input[first]))
+        first++;
+    switch(input[first]) {
+        case '{':   ctx.elem_opener = '{'; ctx.elem_closer = '}'; break;
+        case '[':   ctx.elem_opener = '['; ctx.elem_closer = ']'; break;
+        case '"':   ctx.elem_opener = '"'; ctx.elem_closer = '"'; break;
+        default:    break;
+    }
+
+    /* The limits on the whole input are checked by us. */
+    ctx.config.max_total_len = 0;
+    ctx.config.max_total_values = 0;
+
+    ctx.segs = (JSON_PAR_SEGMENT*) malloc(ctx.n_segs * sizeof(JSON_PAR_SEGMENT));
+    if(ctx.segs == NULL)
+        goto serial;
+    memset(ctx.segs, 0, ctx.n_segs * sizeof(JSON_PAR_SEGMENT));
+    for(i = 0; i < ctx.n_segs; i++)
+        value_init_null(&ctx.segs[i].values);
+
+    json_par_mutex_init(&ctx.mutex);
+    json_par_run(n_threads, json_par_array_worker, &ctx);
+    json_par_mutex_fini(&ctx.mutex);
+
+    if(!ctx.failed) {
+        n_values = 1;
+        for(i = 0; i < ctx.n_segs; i++)
+            n_values += ctx.segs[i].n_values;
+
+        if(config == NULL  ||  config->max_total_values == 0  ||  n_values <= config->max_total_values) {
+            ret = json_par_splice(&ctx, p_root);
+            if(ret == 0  &&  p_pos != NULL)
+                json_par_array_end_pos(&ctx, size, p_pos);
+        }
+    }
+
+    for(i = 0; i < ctx.n_segs; i++)
+        value_fini(&ctx.segs[i].values);
+    free(ctx.segs);
+
+    if(ret == 0)
+        return 0;
+
+serial:
+    /* Either the guess has failed, or there is an error in the input, or we
+     * do not bother to handle some corner case. */
+    return json_dom_parse(input, size, config, dom_flags, p_root, p_pos);
+}
@@ -0,0 +1,104 @@
+/*
+ * CentiJSON
+ * <http://github.com/mity/centijson>
+ *
+ * Copyright (c) 2018 Martin Mitas
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef JSON_PARALLEL_H
+#define JSON_PARALLEL_H
+
+#include "json-dom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Flags for json_ndjson_parse_parallel()
+ */
+
+/* Pass the documents to the callback as soon as they are parsed, in no
+ * particular order. (By default, they are passed in the order of the input.)
+ */
+#define JSON_NDJSON_ASCOMPLETED         0x0001
+
+
+/* Parse a stream of newline-delimited JSON documents (NDJSON, JSON Lines) in
+ * a single buffer, using up to `n_threads` threads (zero means as many as
+ * there are CPUs). The calling thread is one of them.
+ *
+ * The input is split at new lines into chunks, and each chunk is parsed with
+ * the DOM parser (see json_dom_init_multidoc()) independently. Hence each
+ * document must be on its own line (a document spanning multiple lines may
+ * get split between two chunks). Otherwise `config` and `dom_flags` have the
+ * same meaning as with the DOM parser. (Note JSON_CONFIG::allocator, if set,
+ * is used from all the threads concurrently.)
+ *
+ * Each document is passed to `on_document` which takes over its ownership,
+ * as with json_dom_init_multidoc(). The calls are serialized, i.e. the
+ * callback is never called concurrently, but it may be called from any of the
+ * threads. The other threads go on parsing meanwhile. (The documents are
+ * passed in batches: with the in-order delivery, all documents of a chunk at
+ * once; with JSON_NDJSON_ASCOMPLETED, up to a few hundred documents.)
+ *
+ * On success, zero is returned. On failure, the error code is returned, and
+ * (if `p_pos` is not NULL) the position of the error in the whole input is
+ * filled in `p_pos`. If more chunks fail, the error of the first one is
+ * reported. If the callback fails, its error code is returned without the
+ * position (`p_pos` is then zeroed).
+ *
+ * With the default (in-order) delivery, the callback gets exactly the
+ * documents preceding the error (as a serial parser would provide). With
+ * JSON_NDJSON_ASCOMPLETED, some documents following the error may have been
+ * passed to the callback too.
+ */
+int json_ndjson_parse_parallel(const char* input, size_t size,
+                               const JSON_CONFIG* config, unsigned dom_flags,
+                               unsigned n_threads, unsigned flags,
+                               JSON_DOM_DOCUMENT_CALLBACK on_document, void* user_data,
+                               JSON_INPUT_POS* p_pos);
+
+
+/* Parse a JSON document in a single buffer, using up to `n_threads` threads
+ * (zero means as many as there are CPUs), if the root of the document is an
+ * array. The result, as well as the meaning of all the other parameters, is
+ * the same as with json_dom_parse(). (As with json_ndjson_parse_parallel(),
+ * JSON_CONFIG::allocator, if set, is used from all the threads concurrently.)
+ *
+ * The elements of the root array are parsed concurrently, in segments split
+ * at commas which are guessed to separate the elements. This works best if
+ * all the elements are of the same type (e.g. all objects).
+ *
+ * The guess is verified by the parsing. If it turns out wrong, or if the
+ * input is not valid, or if the root is not an array at all, the function
+ * falls back to the serial json_dom_parse(). Hence the error reporting is
+ * always exact (but an invalid input is parsed twice).
+ */
+int json_dom_parse_array_parallel(const char* input, size_t size,
+                                  const JSON_CONFIG* config, unsigned dom_flags,
+                                  unsigned n_threads, VALUE* p_root, JSON_INPUT_POS* p_pos);
+
+#ifdef __cplusplus
+}  /* extern "C" { */
+#endif
+
+#endif  /* JSON_PARALLEL_H */
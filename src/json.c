@@ -25,8 +25,6 @@
 
 #include "json.h"
 
-#include <locale.h>     /* localeconv() */
-#include <stdio.h>      /* snprintf() */
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,9 +35,6 @@
     #ifndef __cplusplus
         #define inline __inline
     #endif
-
-    /* Older MSVC versions do not have snprintf() but _snprintf(). */
-    #define snprintf _snprintf
 #endif
 
 
@@ -50,7 +45,9 @@ static const JSON_CONFIG json_defaults = {
     65536,                  /* max_string_len */
     512,                    /* max_key_len */
     512,                    /* max_nesting_level */
-    0                       /* flags */
+    0,                      /* flags */
+    0,                      /* max_retained_size */
+    NULL                    /* allocator */
 };
 
 
@@ -64,6 +61,33 @@ json_default_config(JSON_CONFIG* cfg)
 }
 
 
+/* Memory management (see JSON_CONFIG::allocator). */
+static void*
+json_malloc(const JSON_ALLOCATOR* allocator, size_t size)
+{
+    if(allocator != NULL)
+        return allocator->alloc_func(size, allocator->ctx);
+    return malloc(size);
+}
+
+static void*
+json_realloc(const JSON_ALLOCATOR* allocator, void* ptr, size_t size)
+{
+    if(allocator != NULL)
+        return allocator->realloc_func(ptr, size, allocator->ctx);
+    return realloc(ptr, size);
+}
+
+static void
+json_free(const JSON_ALLOCATOR* allocator, void* ptr)
+{
+    if(allocator != NULL)
+        allocator->free_func(ptr, allocator->ctx);
+    else
+        free(ptr);
+}
+
+
 #define FIRST_LINE_NUMBER       1
 #define FIRST_COLUMN_NUMBER     1
 
@@ -73,7 +97,8 @@ json_default_config(JSON_CONFIG* cfg)
 #define CAN_SEE_CLOSER          0x0004
 #define CAN_SEE_COMMA           0x0008
 #define CAN_SEE_COLON           0x0010
-#define CAN_SEE_EOF             0x8000
+#define CAN_SEE_EOF             0x0020
+#define CAN_SEE_MASK            0x003f  /* All the bits above. */
 
 /* For JSON_PARSER::automaton. */
 #define AUTOMATON_MAIN          0
@@ -84,6 +109,37 @@ json_default_config(JSON_CONFIG* cfg)
 #define AUTOMATON_STRING        6
 #define AUTOMATON_KEY           7
 
+/* Assuming ASCII compatibility here. */
+#define IS_IN(ch, ch_min, ch_max)   ((unsigned char)(ch_min) <= (unsigned char)(ch) && (unsigned char)(ch) <= (unsigned char)(ch_max))
+#define IS_WHITESPACE(ch)           ((ch) == ' ' || (ch) == '\t' || (ch) == '\r' || (ch) == '\n')
+#define IS_NEW_LINE(ch)             ((ch) == '\r' || (ch) == '\n')
+#define IS_CONTROL(ch)              ((unsigned char)(ch) <= 31)
+#define IS_PUNCT(ch)                (IS_IN(ch, 33, 47) || IS_IN(ch, 58, 64) || IS_IN(ch, 91, 96) || IS_IN(ch, 123, 126))
+#define IS_TOKEN_BOUNDARY(ch)       (IS_WHITESPACE(ch) || IS_CONTROL(ch) || IS_PUNCT(ch))
+#define IS_ASCII(ch)                ((unsigned char)(ch) <= 127)
+#define IS_DIGIT(ch)                (IS_IN(ch, '0', '9'))
+#define IS_XDIGIT(ch)               (IS_DIGIT(ch) || IS_IN(ch, 'a', 'f') || IS_IN(ch, 'A', 'F'))
+
+#define IS_HI_SURROGATE(codepoint)  (0xd800 <= (codepoint)  &&  (codepoint) <= 0xdbff)
+#define IS_LO_SURROGATE(codepoint)  (0xdc00 <= (codepoint)  &&  (codepoint) <= 0xdfff)
+
+
+/* Set up the state for the start of a document. Everything else is already
+ * zeroed. */
+static void
+json_init_state(JSON_PARSER* parser)
+{
+    parser->pos.line_number = FIRST_LINE_NUMBER;
+    parser->pos.column_number = FIRST_COLUMN_NUMBER;
+
+    parser->automaton = AUTOMATON_MAIN;
+    if(parser->config.flags & JSON_MULTIDOC)
+        parser->state = CAN_SEE_VALUE | CAN_SEE_EOF;
+    else
+        parser->state = CAN_SEE_VALUE;
+
+    parser->last_cl_offset = SIZE_MAX-1;
+}
 
 int
 json_init(JSON_PARSER* parser, const JSON_CALLBACKS* callbacks,
@@ -99,22 +155,30 @@ json_init(JSON_PARSER* parser, const JSON_CALLBACKS* callbacks,
 
     parser->user_data = user_data;
 
-    parser->pos.line_number = FIRST_LINE_NUMBER;
-    parser->pos.column_number = FIRST_COLUMN_NUMBER;
+    json_init_state(parser);
+    return 0;
+}
 
-    parser->automaton = AUTOMATON_MAIN;
-    parser->state = CAN_SEE_VALUE;
+int
+json_init_ex(JSON_PARSER* parser, const JSON_CALLBACKS_EX* callbacks,
+             const JSON_CONFIG* config, void* user_data)
+{
+    static const JSON_CALLBACKS no_callbacks = { NULL };
+    int ret;
 
-    parser->last_cl_offset = SIZE_MAX-1;
+    ret = json_init(parser, &no_callbacks, config, user_data);
+    if(ret != 0)
+        return ret;
 
+    memcpy(&parser->callbacks_ex, callbacks, sizeof(JSON_CALLBACKS_EX));
     return 0;
 }
 
 static void
 json_raise_(JSON_PARSER* parser, int errcode, JSON_INPUT_POS* pos)
 {
-    /* Keep the primary error. */
-    if(parser->errcode == 0) {
+    /* Keep the primary error. (A pending pause is not an error.) */
+    if(parser->errcode == 0  ||  parser->errcode == JSON_PAUSE) {
         parser->errcode = errcode;
         memcpy(&parser->err_pos, pos, sizeof(JSON_INPUT_POS));
     }
@@ -145,6 +209,7 @@ json_raise_unexpected(JSON_PARSER* parser)
         case CAN_SEE_COLON:                     err = JSON_ERR_EXPECTEDCOLON; break;
         case (CAN_SEE_COMMA | CAN_SEE_CLOSER):  err = JSON_ERR_EXPECTEDCOMMAORCLOSER; break;
         case CAN_SEE_EOF:                       err = JSON_ERR_EXPECTEDEOF; break;
+        case (CAN_SEE_VALUE | CAN_SEE_EOF):     err = JSON_ERR_EXPECTEDVALUE; break;
 
         /* Other combinations should never happen but lets be defensive. */
         default:                                err = JSON_ERR_SYNTAX; break;
@@ -161,14 +226,523 @@ json_switch_automaton(JSON_PARSER* parser, unsigned automaton)
     parser->automaton = automaton;
     parser->substate = 0;
     parser->buf_used = 0;
+    parser->str_has_escapes = 0;
+}
+
+static int
+json_call_ex(JSON_PARSER* parser, JSON_TYPE type, const char* data, size_t size)
+{
+    const JSON_CALLBACKS_EX* cb = &parser->callbacks_ex;
+    void* user_data = parser->user_data;
+
+    if(type == JSON_NUMBER  &&  cb->on_number_info != NULL)
+        return cb->on_number_info(data, size, &parser->num_info, user_data);
+
+    switch(type) {
+        case JSON_NULL:         return (cb->on_null != NULL) ? cb->on_null(user_data) : 0;
+        case JSON_FALSE:        return (cb->on_bool != NULL) ? cb->on_bool(0, user_data) : 0;
+        case JSON_TRUE:         return (cb->on_bool != NULL) ? cb->on_bool(1, user_data) : 0;
+        case JSON_NUMBER:       return (cb->on_number != NULL) ? cb->on_number(data, size, user_data) : 0;
+        case JSON_STRING:       return (cb->on_string != NULL) ? cb->on_string(data, size, user_data) : 0;
+        case JSON_STRING_PART:  return (cb->on_string_part != NULL) ? cb->on_string_part(data, size, user_data) : 0;
+        case JSON_KEY:          return (cb->on_key != NULL) ? cb->on_key(data, size, user_data) : 0;
+        case JSON_ARRAY_BEG:    return (cb->on_begin_array != NULL) ? cb->on_begin_array(user_data) : 0;
+        case JSON_ARRAY_END:    return (cb->on_end_array != NULL) ? cb->on_end_array(user_data) : 0;
+        case JSON_OBJECT_BEG:   return (cb->on_begin_object != NULL) ? cb->on_begin_object(user_data) : 0;
+        case JSON_OBJECT_END:   return (cb->on_end_object != NULL) ? cb->on_end_object(user_data) : 0;
+        case JSON_DOCUMENT_END: return (cb->on_document_end != NULL) ? cb->on_document_end(user_data) : 0;
+    }
+
+    return JSON_ERR_INTERNAL;
+}
+
+static inline int
+json_call(JSON_PARSER* parser, JSON_TYPE type, const char* data, size_t size)
+{
+    if(parser->callbacks.process != NULL)
+        return parser->callbacks.process(type, data, size, parser->user_data);
+    else
+        return json_call_ex(parser, type, data, size);
+}
+
+/* Projection (see json_set_projection()).
+ *
+ * The pointers are merged into a trie: Each node represents one path in the
+ * document, and terminal nodes are the paths to report whole. We maintain
+ * the current node for each nesting level of the arrays and objects on some
+ * path; anything out of the paths is skipped.
+ */
+typedef struct JSON_PROJ_NODE JSON_PROJ_NODE;
+struct JSON_PROJ_NODE {
+    JSON_PROJ_NODE* children;
+    JSON_PROJ_NODE* next;
+    char* key;              /* Object member; or NULL for array element. */
+    size_t key_size;
+    size_t index;           /* Array element index. */
+    int is_terminal;
+};
+
+typedef struct JSON_PROJ_LEVEL {
+    const JSON_PROJ_NODE* node;     /* Node of the array or object. */
+    const JSON_PROJ_NODE* child;    /* Node of the current object member. */
+    size_t index;                   /* Index of the next array element. */
+} JSON_PROJ_LEVEL;
+
+typedef struct JSON_PROJECTION JSON_PROJECTION;
+struct JSON_PROJECTION {
+    JSON_PROJ_NODE root;
+
+    JSON_PROJ_LEVEL* levels;        /* Indexed by the nesting level. */
+    size_t levels_alloced;
+
+    size_t all_level;       /* Non-zero inside a reported array or object. */
+
+    /* A key is reported only once we know its value is reported too. */
+    char* key;
+    size_t key_size;
+    size_t key_alloced;
+    int key_pending;
+};
+
+/* Array index which can never match. */
+#define JSON_PROJ_NO_INDEX      SIZE_MAX
+
+static void
+json_proj_free_nodes(const JSON_ALLOCATOR* allocator, JSON_PROJ_NODE* node)
+{
+    while(node != NULL) {
+        JSON_PROJ_NODE* next = node->next;
+
+        json_proj_free_nodes(allocator, node->children);
+        json_free(allocator, node->key);
+        json_free(allocator, node);
+        node = next;
+    }
+}
+
+static void
+json_proj_free(const JSON_ALLOCATOR* allocator, JSON_PROJECTION* proj)
+{
+    if(proj == NULL)
+        return;
+
+    json_proj_free_nodes(allocator, proj->root.children);
+    json_free(allocator, proj->levels);
+    json_free(allocator, proj->key);
+    json_free(allocator, proj);
+}
+
+static const JSON_PROJ_NODE*
+json_proj_find(const JSON_PROJ_NODE* node, const char* key, size_t key_size, size_t index)
+{
+    const JSON_PROJ_NODE* child;
+
+    for(child = node->children; child != NULL; child = child->next) {
+        if(key != NULL) {
+            if(child->key != NULL  &&  child->key_size == key_size  &&
+               memcmp(child->key, key, key_size) == 0)
+                return child;
+        } else {
+            if(child->key == NULL  &&  child->index == index)
+                return child;
+        }
+    }
+
+    return NULL;
+}
+
+/* Add a pointer into the trie. */
+static int
+json_proj_add(const JSON_ALLOCATOR* allocator, JSON_PROJECTION* proj, const char* pointer)
+{
+    JSON_PROJ_NODE* node = &proj->root;
+    const char* tok_beg = pointer;
+    const char* tok_end;
+
+    if(*tok_beg == '/')
+        tok_beg++;
+
+    while(*pointer != '\0') {
+        JSON_PROJ_NODE* child;
+        char* key = NULL;
+        size_t key_size = 0;
+        size_t index = 0;
+        const char* tok;
+
+        tok_end = tok_beg;
+        while(*tok_end != '\0'  &&  *tok_end != '/')
+            tok_end++;
+
+        /* Determine if the token is array index. (The same rules as in
+         * json-ptr.c.) */
+        tok = tok_beg;
+        if(tok < tok_end  &&  *tok == '-') {
+            index = JSON_PROJ_NO_INDEX;
+            tok++;
+        }
+        if(tok_end - tok_beg == 1  &&  *tok_beg == '-') {
+            /* "-" is index too. */
+        } else if(tok < tok_end  &&  (*tok != '0' || tok + 1 == tok_end)) {
+            size_t i = 0;
+            while(tok + i < tok_end  &&  IS_DIGIT(tok[i])) {
+                if(index != JSON_PROJ_NO_INDEX)
+                    index = index * 10 + (tok[i] - '0');
+                i++;
+            }
+            if(tok + i < tok_end)
+                key = (char*) tok_beg;  /* Not a number: Mark it is a key. */
+        } else {
+            key = (char*) tok_beg;
+        }
+
+        if(key != NULL) {
+            /* Resolve the escapes "~0" and "~1". */
+            key = (char*) json_malloc(allocator, tok_end - tok_beg + 1);
+            if(key == NULL)
+                return JSON_ERR_OUTOFMEMORY;
+            for(tok = tok_beg; tok < tok_end; tok++) {
+                if(*tok == '~') {
+                    if(tok+1 == tok_end  ||  (tok[1] != '0' && tok[1] != '1')) {
+                        json_free(allocator, key);
+                        return JSON_ERR_BADPOINTER;
+                    }
+                    key[key_size++] = (tok[1] == '0') ? '~' : '/';
+                    tok++;
+                } else {
+                    key[key_size++] = *tok;
+                }
+            }
+        }
+
+        child = (JSON_PROJ_NODE*) json_proj_find(node, key, key_size, index);
+        if(child == NULL) {
+            child = (JSON_PROJ_NODE*) json_malloc(allocator, sizeof(JSON_PROJ_NODE));
+            if(child == NULL) {
+                json_free(allocator, key);
+                return JSON_ERR_OUTOFMEMORY;
+            }
+            memset(child, 0, sizeof(JSON_PROJ_NODE));
+            child->key = key;
+            child->key_size = key_size;
+            child->index = index;
+            child->next = node->children;
+            node->children = child;
+        } else {
+            json_free(allocator, key);
+        }
+        node = child;
+
+        if(*tok_end == '\0')
+            break;
+        tok_beg = tok_end + 1;
+    }
+
+    node->is_terminal = 1;
+    return 0;
+}
+
+int
+json_set_projection(JSON_PARSER* parser, const char* const* pointers, size_t n_pointers)
+{
+    const JSON_ALLOCATOR* allocator = parser->config.allocator;
+    JSON_PROJECTION* proj;
+    size_t i;
+    int ret;
+
+    proj = (JSON_PROJECTION*) json_malloc(allocator, sizeof(JSON_PROJECTION));
+    if(proj == NULL)
+        return JSON_ERR_OUTOFMEMORY;
+    memset(proj, 0, sizeof(JSON_PROJECTION));
+
+    for(i = 0; i < n_pointers; i++) {
+        ret = json_proj_add(allocator, proj, pointers[i]);
+        if(ret != 0) {
+            json_proj_free(allocator, proj);
+            return ret;
+        }
+    }
+
+    json_proj_free(allocator, parser->projection);
+    parser->projection = proj;
+    return 0;
+}
+
+/* Get the node of a value living on the given nesting level (i.e. in the array
+ * or object on that level, or the root value if zero). */
+static const JSON_PROJ_NODE*
+json_proj_value_node(JSON_PARSER* parser, size_t level, int consume_index)
+{
+    JSON_PROJ_LEVEL* parent;
+
+    if(level == 0)
+        return &parser->projection->root;
+
+    parent = &parser->projection->levels[level];
+    if(parser->nesting_stack[level-1] == '}')
+        return parent->child;
+
+    return json_proj_find(parent->node, NULL, 0,
+                (consume_index ? parent->index++ : parent->index));
+}
+
+/* Is the scalar value just starting to be reported? */
+static int
+json_proj_wants_value(JSON_PARSER* parser)
+{
+    const JSON_PROJ_NODE* node;
+
+    if(parser->projection->all_level != 0)
+        return 1;
+
+    node = json_proj_value_node(parser, parser->nesting_level, 0);
+    return (node != NULL  &&  node->is_terminal);
+}
+
+/* Report the pending key (if any). */
+static int
+json_proj_report_key(JSON_PARSER* parser)
+{
+    JSON_PROJECTION* proj = parser->projection;
+
+    if(!proj->key_pending)
+        return 0;
+
+    proj->key_pending = 0;
+    return json_call(parser, JSON_KEY, proj->key, proj->key_size);
+}
+
+/* Decide whether the event is reported, and update the projection state.
+ * (Anything what is not, gets skipped.) */
+static int
+json_project(JSON_PARSER* parser, JSON_TYPE type, const char* data, size_t size)
+{
+    JSON_PROJECTION* proj = parser->projection;
+    const JSON_PROJ_NODE* node;
+    int is_beg;
+    size_t level;
+    int ret;
+
+    if(proj->all_level != 0) {
+        /* Inside a reported array/object; or its closer. */
+        if(parser->nesting_level < proj->all_level)
+            proj->all_level = 0;
+        return 1;
+    }
+
+    switch(type) {
+        case JSON_KEY:
+            node = json_proj_find(proj->levels[parser->nesting_level].node, data, size, 0);
+            proj->levels[parser->nesting_level].child = node;
+            if(node == NULL) {
+                parser->skip_level = parser->nesting_level + 1;
+                parser->skip_closer = 0;
+                return 0;
+            }
+
+            if(size > proj->key_alloced) {
+                char* new_key = (char*) json_realloc(parser->config.allocator, proj->key, size);
+                if(new_key == NULL) {
+                    json_raise(parser, JSON_ERR_OUTOFMEMORY);
+                    return 0;
+                }
+                proj->key = new_key;
+                proj->key_alloced = size;
+            }
+            if(size > 0)
+                memcpy(proj->key, data, size);
+            proj->key_size = size;
+            proj->key_pending = 1;
+            return 0;
+
+        case JSON_ARRAY_END:
+        case JSON_OBJECT_END:
+            /* Only arrays and objects on some path get here. */
+            return 1;
+
+        default:
+            break;
+    }
+
+    /* Start of a value. Note arrays and objects are already pushed. */
+    is_beg = (type == JSON_ARRAY_BEG  ||  type == JSON_OBJECT_BEG);
+    level = parser->nesting_level - (is_beg ? 1 : 0);
+    node = json_proj_value_node(parser, level, 1);
+    if(node != NULL  &&  (node->is_terminal || is_beg)) {
+        ret = json_proj_report_key(parser);
+        if(ret == JSON_SKIP) {
+            node = NULL;
+        } else if(ret == JSON_PAUSE) {
+            /* Pause only after the value is reported too. */
+            parser->errcode = ret;
+        } else if(ret != 0) {
+            parser->errcode = ret;
+            return 0;
+        }
+    } else {
+        node = NULL;
+    }
+    proj->key_pending = 0;
+
+    if(node == NULL) {
+        if(is_beg) {
+            parser->skip_level = parser->nesting_level;
+            parser->skip_closer = 0;
+        }
+        return 0;
+    }
+
+    if(is_beg) {
+        if(node->is_terminal) {
+            proj->all_level = parser->nesting_level;
+        } else {
+            if(parser->nesting_level >= proj->levels_alloced) {
+                JSON_PROJ_LEVEL* new_levels;
+                size_t new_levels_alloced = proj->levels_alloced * 2;
+
+                if(new_levels_alloced == 0)
+                    new_levels_alloced = 32;
+                new_levels = (JSON_PROJ_LEVEL*) json_realloc(parser->config.allocator, proj->levels,
+                            new_levels_alloced * sizeof(JSON_PROJ_LEVEL));
+                if(new_levels == NULL) {
+                    json_raise(parser, JSON_ERR_OUTOFMEMORY);
+                    return 0;
+                }
+                proj->levels = new_levels;
+                proj->levels_alloced = new_levels_alloced;
+            }
+
+            proj->levels[parser->nesting_level].node = node;
+            proj->levels[parser->nesting_level].child = NULL;
+            proj->levels[parser->nesting_level].index = 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Whether the application is interested in data of the given type. (It may
+ * be not when skipping, with projection, or with JSON_CALLBACKS_EX.) If not,
+ * the sub-automata do not need to collect them. */
+static inline int
+json_wants_data(JSON_PARSER* parser, JSON_TYPE type)
+{
+    if(parser->skip_level != 0)
+        return 0;
+    if(parser->projection != NULL) {
+        if(type == JSON_KEY)
+            return 1;   /* Needed for the matching. */
+        if(!json_proj_wants_value(parser))
+            return 0;
+    }
+    if(parser->callbacks.process != NULL)
+        return 1;
+
+    switch(type) {
+        case JSON_NUMBER:   return (parser->callbacks_ex.on_number != NULL  ||
+                                    parser->callbacks_ex.on_number_info != NULL);
+        case JSON_STRING:   return (parser->callbacks_ex.on_string != NULL  ||
+                                    parser->callbacks_ex.on_string_part != NULL);
+        case JSON_KEY:      return (parser->callbacks_ex.on_key != NULL);
+        default:            return 1;
+    }
+}
+
+/* With JSON_MULTIDOC, a top-level value has just been completed: Report it
+ * and get ready for the next document. */
+static void
+json_end_document(JSON_PARSER* parser)
+{
+    parser->state = CAN_SEE_VALUE | CAN_SEE_EOF;
+    parser->value_counter = 0;
+
+    /* (A pause requested for the last value of the document takes effect
+     * only after this.) */
+    if(parser->errcode == 0  ||  parser->errcode == JSON_PAUSE) {
+        int ret = json_call(parser, JSON_DOCUMENT_END, NULL, 0);
+        if(ret != 0  &&  ret != JSON_SKIP)
+            parser->errcode = ret;
+    }
+}
+
+/* Update what the main automaton may see next. */
+static inline void
+json_update_state(JSON_PARSER* parser, JSON_TYPE type)
+{
+    switch(type) {
+        case JSON_ARRAY_BEG:
+            parser->state = CAN_SEE_VALUE | CAN_SEE_CLOSER;
+            break;
+
+        case JSON_OBJECT_BEG:
+            parser->state = CAN_SEE_KEY | CAN_SEE_CLOSER;
+            break;
+
+        case JSON_KEY:
+            parser->state = CAN_SEE_COLON;
+            break;
+
+        default:
+            if(parser->nesting_level > 0)
+                parser->state = CAN_SEE_COMMA | CAN_SEE_CLOSER;
+            else if(parser->config.flags & JSON_MULTIDOC)
+                json_end_document(parser);
+            else
+                parser->state = CAN_SEE_EOF;
+            break;
+    }
+
+    json_switch_automaton(parser, AUTOMATON_MAIN);
+}
+
+/* Handle JSON_SKIP returned by the callback. */
+static inline int
+json_handle_skip(JSON_PARSER* parser, JSON_TYPE type)
+{
+    switch(type) {
+        case JSON_KEY:
+            /* Skip the upcoming value: It lives on the current nesting level
+             * (or it opens the next one). */
+            parser->skip_level = parser->nesting_level + 1;
+            parser->skip_closer = 0;
+            break;
+
+        case JSON_ARRAY_BEG:
+        case JSON_OBJECT_BEG:
+            /* Skip until the array/object (already pushed) is closed. */
+            parser->skip_level = parser->nesting_level;
+            parser->skip_closer = 1;
+            break;
+
+        default:
+            break;
+    }
+
+    return 0;
 }
 
 static inline void
 json_process(JSON_PARSER* parser, JSON_TYPE type, const char* data, size_t size)
 {
+    int ret;
+
     if(parser->errcode != 0)
         return;
 
+    if(parser->skip_level != 0) {
+        /* We are skipping: Only keep the state and validate the input. The
+         * skipping ends with the value (or closer) which gets us below the
+         * skip level. */
+        if(parser->nesting_level >= parser->skip_level  ||  !parser->skip_closer) {
+            if(parser->nesting_level < parser->skip_level)
+                parser->skip_level = 0;
+            json_update_state(parser, type);
+            return;
+        }
+
+        /* The closer ending the skipping is reported as usual. */
+        parser->skip_level = 0;
+    }
+
     if(type != JSON_ARRAY_END  &&  type != JSON_OBJECT_END) {
         if(parser->value_counter == 0) {
             switch(type) {
@@ -214,719 +788,4081 @@ json_process(JSON_PARSER* parser, JSON_TYPE type, const char* data, size_t size)
         parser->value_counter++;
     }
 
-    parser->errcode = parser->callbacks.process(type, data, size, parser->user_data);
+    if(parser->projection != NULL  &&  !json_project(parser, type, data, size)) {
+        json_update_state(parser, type);
+        return;
+    }
 
-    /* Update what the main automaton may see next. */
-    switch(type) {
-        case JSON_ARRAY_BEG:
-            parser->state = CAN_SEE_VALUE | CAN_SEE_CLOSER;
-            break;
+    ret = json_call(parser, type, data, size);
+    if(ret == JSON_SKIP)
+        ret = json_handle_skip(parser, type);
+    if(ret != 0)
+        parser->errcode = ret;  /* (Else keep a pause from json_project().) */
 
-        case JSON_OBJECT_BEG:
-            parser->state = CAN_SEE_KEY | CAN_SEE_CLOSER;
-            break;
+    json_update_state(parser, type);
+}
 
-        case JSON_KEY:
-            parser->state = CAN_SEE_COLON;
-            break;
+/* With JSON_STRINGPARTS, report what we have accumulated of the unfinished
+ * string so far, and flush it from the buffer. */
+static void
+json_process_string_part(JSON_PARSER* parser)
+{
+    size_t n = parser->buf_used;
 
-        default:
-            if(parser->nesting_level > 0)
-                parser->state = CAN_SEE_COMMA | CAN_SEE_CLOSER;
-            else
-                parser->state = CAN_SEE_EOF;
-            break;
+    if(n == 0)
+        return;     /* (E.g. nobody wants the string; see json_wants_data().) */
+
+    /* Keep the incomplete UTF-8 sequence (if any) in the buffer. We may still
+     * need to replace it with U+fffd as a whole. */
+    if(1 <= parser->substate  &&  parser->substate <= 7) {
+        while(((unsigned char)(parser->buf[n-1]) & 0xc0) == 0x80)
+            n--;
+        n--;
     }
 
-    json_switch_automaton(parser, AUTOMATON_MAIN);
-}
+    if(n == 0)
+        return;
 
-static int
-json_buf_append(JSON_PARSER* parser, const char* data, size_t size)
-{
-    if(parser->buf_used + size > parser->buf_alloced) {
-        char* new_buf;
-        size_t new_alloced = (parser->buf_used + size) * 2;
+    if(parser->skip_level == 0  &&
+       (parser->projection == NULL || json_proj_wants_value(parser)))
+    {
+        /* Before passing anything to the application, check whatever
+         * json_process() would check for the complete string. */
+        if(parser->value_counter == 0  &&  (parser->config.flags & JSON_NOSTRINGASROOT)) {
+            json_raise_for_value(parser, JSON_ERR_BADROOTTYPE);
+            return;
+        }
+        if(parser->config.max_total_values != 0  &&
+           parser->value_counter >= parser->config.max_total_values)
+        {
+            json_raise_for_value(parser, JSON_ERR_MAXTOTALVALUES);
+            return;
+        }
 
-        new_buf = (char *) realloc(parser->buf, new_alloced);
-        if(new_buf == NULL) {
-            json_raise(parser, JSON_ERR_OUTOFMEMORY);
-            return -1;
+        if(parser->projection != NULL) {
+            int ret = json_proj_report_key(parser);
+            if(ret == JSON_SKIP) {
+                /* Skip the rest of the string. */
+                parser->skip_level = parser->nesting_level + 1;
+                parser->skip_closer = 0;
+            } else if(ret != 0) {
+                parser->errcode = ret;
+            }
         }
 
-        parser->buf = new_buf;
-        parser->buf_alloced = new_alloced;
+        if(parser->skip_level == 0  &&
+           (parser->errcode == 0  ||  parser->errcode == JSON_PAUSE))
+        {
+            int ret = json_call(parser, JSON_STRING_PART, parser->buf, n);
+            if(ret != 0)
+                parser->errcode = ret;
+        }
     }
 
-    memcpy(parser->buf + parser->buf_used, data, size);
-    parser->buf_used += size;
-    return 0;
+    memmove(parser->buf, parser->buf + n, parser->buf_used - n);
+    parser->buf_used -= n;
 }
 
-static int
-json_buf_append_codepoint(JSON_PARSER* parser, uint32_t codepoint)
-{
-    char tmp[4];
-    size_t n;
 
-    if(codepoint <= 0x7f) {
-        tmp[0] = codepoint;
-        n = 1;
-    } else if(codepoint <= 0x7ff) {
-        tmp[0] = 0xc0 | ((codepoint >> 6) & 0x1f);
-        tmp[1] = 0x80 | ((codepoint >> 0) & 0x3f);
-        n = 2;
-    } else if(codepoint <= 0xffff) {
-        tmp[0] = 0xe0 | ((codepoint >> 12) & 0x0f);
-        tmp[1] = 0x80 | ((codepoint >> 6) & 0x3f);
-        tmp[2] = 0x80 | ((codepoint >> 0) & 0x3f);
-        n = 3;
-    } else {
-        tmp[0] = 0xf0 | ((codepoint >> 18) & 0x07);
-        tmp[1] = 0x80 | ((codepoint >> 12) & 0x3f);
-        tmp[2] = 0x80 | ((codepoint >> 6) & 0x3f);
-        tmp[3] = 0x80 | ((codepoint >> 0) & 0x3f);
-        n = 4;
-    }
+/*************************
+ *** Number conversion ***
+ *************************/
 
-    return json_buf_append(parser, tmp, n);
-}
+/* Conversion of a decimal number to double. The result is correctly rounded
+ * (i.e. the same as strtod() in the "C" locale gives) but we neither depend on
+ * the locale nor need any heap memory.
+ *
+ * Almost all numbers are handled by the Eisel-Lemire algorithm: The mantissa
+ * (up to 19 or 20 digits) is multiplied with a 128-bit approximation of 5^q
+ * from the table below, and the high bits of the product almost always decide
+ * the result. If they do not (or if the number has more digits), we fall back
+ * to the exact "simple decimal conversion" which works with the decimal digits
+ * of the number.
+ *
+ * See:
+ *   - Daniel Lemire: Number Parsing at a Gigabyte per Second
+ *     <https://arxiv.org/abs/2101.11408>
+ *   - Nigel Tao: The Simple Decimal Conversion Algorithm
+ *     <https://nigeltao.github.io/blog/2020/parse-number-f64-simple.html>
+ */
 
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
 
-/* Assuming ASCII compatibility here. */
-#define IS_IN(ch, ch_min, ch_max)   ((unsigned char)(ch_min) <= (unsigned char)(ch) && (unsigned char)(ch) <= (unsigned char)(ch_max))
-#define IS_WHITESPACE(ch)           ((ch) == ' ' || (ch) == '\t' || (ch) == '\r' || (ch) == '\n')
-#define IS_CONTROL(ch)              ((unsigned char)(ch) <= 31)
-#define IS_PUNCT(ch)                (IS_IN(ch, 33, 47) || IS_IN(ch, 58, 64) || IS_IN(ch, 91, 96) || IS_IN(ch, 123, 126))
-#define IS_TOKEN_BOUNDARY(ch)       (IS_WHITESPACE(ch) || IS_CONTROL(ch) || IS_PUNCT(ch))
-#define IS_ASCII(ch)                ((unsigned char)(ch) <= 127)
-#define IS_DIGIT(ch)                (IS_IN(ch, '0', '9'))
-#define IS_XDIGIT(ch)               (IS_DIGIT(ch) || IS_IN(ch, 'a', 'f') || IS_IN(ch, 'A', 'F'))
+#define DBL_MANTISSA_BITS       52
+#define DBL_EXP_BIAS            1023
+#define DBL_EXP_INF             0x7ff
+#define DBL_MANTISSA_MASK       (((uint64_t) 1 << DBL_MANTISSA_BITS) - 1)
+
+/* 128-bit approximations of 5^q for q in [POW5_MIN_EXP, POW5_MAX_EXP],
+ * normalized so the highest bit is set (truncated for q >= 0, rounded up for
+ * q < 0). Below and above the range, any double is zero or infinity. */
+#define POW5_MIN_EXP            (-342)
+#define POW5_MAX_EXP            308
+
+static const uint64_t json_pow5_table[POW5_MAX_EXP - POW5_MIN_EXP + 1][2] = {
+    { 0xeef453d6923bd65a, 0x113faa2906a13b3f },
+    { 0x9558b4661b6565f8, 0x4ac7ca59a424c507 },
+    { 0xbaaee17fa23ebf76, 0x5d79bcf00d2df649 },
+    { 0xe95a99df8ace6f53, 0xf4d82c2c107973dc },
+    { 0x91d8a02bb6c10594, 0x79071b9b8a4be869 },
+    { 0xb64ec836a47146f9, 0x9748e2826cdee284 },
+    { 0xe3e27a444d8d98b7, 0xfd1b1b2308169b25 },
+    { 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7 },
+    { 0xb208ef855c969f4f, 0xbdbd2d335e51a935 },
+    { 0xde8b2b66b3bc4723, 0xad2c788035e61382 },
+    { 0x8b16fb203055ac76, 0x4c3bcb5021afcc31 },
+    { 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d },
+    { 0xd953e8624b85dd78, 0xd71d6dad34a2af0d },
+    { 0x87d4713d6f33aa6b, 0x8672648c40e5ad68 },
+    { 0xa9c98d8ccb009506, 0x680efdaf511f18c2 },
+    { 0xd43bf0effdc0ba48, 0x0212bd1b2566def2 },
+    { 0x84a57695fe98746d, 0x014bb630f7604b57 },
+    { 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d },
+    { 0xcf42894a5dce35ea, 0x52064cac828675b9 },
+    { 0x818995ce7aa0e1b2, 0x7343efebd1940993 },
+    { 0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8 },
+    { 0xca66fa129f9b60a6, 0xd41a26e077774ef6 },
+    { 0xfd00b897478238d0, 0x8920b098955522b4 },
+    { 0x9e20735e8cb16382, 0x55b46e5f5d5535b0 },
+    { 0xc5a890362fddbc62, 0xeb2189f734aa831d },
+    { 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4 },
+    { 0x9a6bb0aa55653b2d, 0x47b233c92125366e },
+    { 0xc1069cd4eabe89f8, 0x999ec0bb696e840a },
+    { 0xf148440a256e2c76, 0xc00670ea43ca250d },
+    { 0x96cd2a865764dbca, 0x380406926a5e5728 },
+    { 0xbc807527ed3e12bc, 0xc605083704f5ecf2 },
+    { 0xeba09271e88d976b, 0xf7864a44c633682e },
+    { 0x93445b8731587ea3, 0x7ab3ee6afbe0211d },
+    { 0xb8157268fdae9e4c, 0x5960ea05bad82964 },
+    { 0xe61acf033d1a45df, 0x6fb92487298e33bd },
+    { 0x8fd0c16206306bab, 0xa5d3b6d479f8e056 },
+    { 0xb3c4f1ba87bc8696, 0x8f48a4899877186c },
+    { 0xe0b62e2929aba83c, 0x331acdabfe94de87 },
+    { 0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14 },
+    { 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9 },
+    { 0xdb71e91432b1a24a, 0xc9e82cd9f69d6150 },
+    { 0x892731ac9faf056e, 0xbe311c083a225cd2 },
+    { 0xab70fe17c79ac6ca, 0x6dbd630a48aaf406 },
+    { 0xd64d3d9db981787d, 0x092cbbccdad5b108 },
+    { 0x85f0468293f0eb4e, 0x25bbf56008c58ea5 },
+    { 0xa76c582338ed2621, 0xaf2af2b80af6f24e },
+    { 0xd1476e2c07286faa, 0x1af5af660db4aee1 },
+    { 0x82cca4db847945ca, 0x50d98d9fc890ed4d },
+    { 0xa37fce126597973c, 0xe50ff107bab528a0 },
+    { 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8 },
+    { 0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a },
+    { 0x9faacf3df73609b1, 0x77b191618c54e9ac },
+    { 0xc795830d75038c1d, 0xd59df5b9ef6a2417 },
+    { 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d },
+    { 0x9becce62836ac577, 0x4ee367f9430aec32 },
+    { 0xc2e801fb244576d5, 0x229c41f793cda73f },
+    { 0xf3a20279ed56d48a, 0x6b43527578c1110f },
+    { 0x9845418c345644d6, 0x830a13896b78aaa9 },
+    { 0xbe5691ef416bd60c, 0x23cc986bc656d553 },
+    { 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8 },
+    { 0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9 },
+    { 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53 },
+    { 0xe858ad248f5c22c9, 0xd1b3400f8f9cff68 },
+    { 0x91376c36d99995be, 0x23100809b9c21fa1 },
+    { 0xb58547448ffffb2d, 0xabd40a0c2832a78a },
+    { 0xe2e69915b3fff9f9, 0x16c90c8f323f516c },
+    { 0x8dd01fad907ffc3b, 0xae3da7d97f6792e3 },
+    { 0xb1442798f49ffb4a, 0x99cd11cfdf41779c },
+    { 0xdd95317f31c7fa1d, 0x40405643d711d583 },
+    { 0x8a7d3eef7f1cfc52, 0x482835ea666b2572 },
+    { 0xad1c8eab5ee43b66, 0xda3243650005eecf },
+    { 0xd863b256369d4a40, 0x90bed43e40076a82 },
+    { 0x873e4f75e2224e68, 0x5a7744a6e804a291 },
+    { 0xa90de3535aaae202, 0x711515d0a205cb36 },
+    { 0xd3515c2831559a83, 0x0d5a5b44ca873e03 },
+    { 0x8412d9991ed58091, 0xe858790afe9486c2 },
+    { 0xa5178fff668ae0b6, 0x626e974dbe39a872 },
+    { 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f },
+    { 0x80fa687f881c7f8e, 0x7ce66634bc9d0b99 },
+    { 0xa139029f6a239f72, 0x1c1fffc1ebc44e80 },
+    { 0xc987434744ac874e, 0xa327ffb266b56220 },
+    { 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8 },
+    { 0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9 },
+    { 0xc4ce17b399107c22, 0xcb550fb4384d21d3 },
+    { 0xf6019da07f549b2b, 0x7e2a53a146606a48 },
+    { 0x99c102844f94e0fb, 0x2eda7444cbfc426d },
+    { 0xc0314325637a1939, 0xfa911155fefb5308 },
+    { 0xf03d93eebc589f88, 0x793555ab7eba27ca },
+    { 0x96267c7535b763b5, 0x4bc1558b2f3458de },
+    { 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16 },
+    { 0xea9c227723ee8bcb, 0x465e15a979c1cadc },
+    { 0x92a1958a7675175f, 0x0bfacd89ec191ec9 },
+    { 0xb749faed14125d36, 0xcef980ec671f667b },
+    { 0xe51c79a85916f484, 0x82b7e12780e7401a },
+    { 0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810 },
+    { 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15 },
+    { 0xdfbdcece67006ac9, 0x67a791e093e1d49a },
+    { 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0 },
+    { 0xaecc49914078536d, 0x58fae9f773886e18 },
+    { 0xda7f5bf590966848, 0xaf39a475506a899e },
+    { 0x888f99797a5e012d, 0x6d8406c952429603 },
+    { 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83 },
+    { 0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64 },
+    { 0x855c3be0a17fcd26, 0x5cf2eea09a55067f },
+    { 0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e },
+    { 0xd0601d8efc57b08b, 0xf13b94daf124da26 },
+    { 0x823c12795db6ce57, 0x76c53d08d6b70858 },
+    { 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e },
+    { 0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09 },
+    { 0xfe5d54150b090b02, 0xd3f93b35435d7c4c },
+    { 0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf },
+    { 0xc6b8e9b0709f109a, 0x359ab6419ca1091b },
+    { 0xf867241c8cc6d4c0, 0xc30163d203c94b62 },
+    { 0x9b407691d7fc44f8, 0x79e0de63425dcf1d },
+    { 0xc21094364dfb5636, 0x985915fc12f542e4 },
+    { 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d },
+    { 0x979cf3ca6cec5b5a, 0xa705992ceecf9c42 },
+    { 0xbd8430bd08277231, 0x50c6ff782a838353 },
+    { 0xece53cec4a314ebd, 0xa4f8bf5635246428 },
+    { 0x940f4613ae5ed136, 0x871b7795e136be99 },
+    { 0xb913179899f68584, 0x28e2557b59846e3f },
+    { 0xe757dd7ec07426e5, 0x331aeada2fe589cf },
+    { 0x9096ea6f3848984f, 0x3ff0d2c85def7621 },
+    { 0xb4bca50b065abe63, 0x0fed077a756b53a9 },
+    { 0xe1ebce4dc7f16dfb, 0xd3e8495912c62894 },
+    { 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c },
+    { 0xb080392cc4349dec, 0xbd8d794d96aacfb3 },
+    { 0xdca04777f541c567, 0xecf0d7a0fc5583a0 },
+    { 0x89e42caaf9491b60, 0xf41686c49db57244 },
+    { 0xac5d37d5b79b6239, 0x311c2875c522ced5 },
+    { 0xd77485cb25823ac7, 0x7d633293366b828b },
+    { 0x86a8d39ef77164bc, 0xae5dff9c02033197 },
+    { 0xa8530886b54dbdeb, 0xd9f57f830283fdfc },
+    { 0xd267caa862a12d66, 0xd072df63c324fd7b },
+    { 0x8380dea93da4bc60, 0x4247cb9e59f71e6d },
+    { 0xa46116538d0deb78, 0x52d9be85f074e608 },
+    { 0xcd795be870516656, 0x67902e276c921f8b },
+    { 0x806bd9714632dff6, 0x00ba1cd8a3db53b6 },
+    { 0xa086cfcd97bf97f3, 0x80e8a40eccd228a4 },
+    { 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd },
+    { 0xfad2a4b13d1b5d6c, 0x796b805720085f81 },
+    { 0x9cc3a6eec6311a63, 0xcbe3303674053bb0 },
+    { 0xc3f490aa77bd60fc, 0xbedbfc4411068a9c },
+    { 0xf4f1b4d515acb93b, 0xee92fb5515482d44 },
+    { 0x991711052d8bf3c5, 0x751bdd152d4d1c4a },
+    { 0xbf5cd54678eef0b6, 0xd262d45a78a0635d },
+    { 0xef340a98172aace4, 0x86fb897116c87c34 },
+    { 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0 },
+    { 0xbae0a846d2195712, 0x8974836059cca109 },
+    { 0xe998d258869facd7, 0x2bd1a438703fc94b },
+    { 0x91ff83775423cc06, 0x7b6306a34627ddcf },
+    { 0xb67f6455292cbf08, 0x1a3bc84c17b1d542 },
+    { 0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93 },
+    { 0x8e938662882af53e, 0x547eb47b7282ee9c },
+    { 0xb23867fb2a35b28d, 0xe99e619a4f23aa43 },
+    { 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4 },
+    { 0x8b3c113c38f9f37e, 0xde83bc408dd3dd04 },
+    { 0xae0b158b4738705e, 0x9624ab50b148d445 },
+    { 0xd98ddaee19068c76, 0x3badd624dd9b0957 },
+    { 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6 },
+    { 0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c },
+    { 0xd47487cc8470652b, 0x7647c3200069671f },
+    { 0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073 },
+    { 0xa5fb0a17c777cf09, 0xf468107100525890 },
+    { 0xcf79cc9db955c2cc, 0x7182148d4066eeb4 },
+    { 0x81ac1fe293d599bf, 0xc6f14cd848405530 },
+    { 0xa21727db38cb002f, 0xb8ada00e5a506a7c },
+    { 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c },
+    { 0xfd442e4688bd304a, 0x908f4a166d1da663 },
+    { 0x9e4a9cec15763e2e, 0x9a598e4e043287fe },
+    { 0xc5dd44271ad3cdba, 0x40eff1e1853f29fd },
+    { 0xf7549530e188c128, 0xd12bee59e68ef47c },
+    { 0x9a94dd3e8cf578b9, 0x82bb74f8301958ce },
+    { 0xc13a148e3032d6e7, 0xe36a52363c1faf01 },
+    { 0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1 },
+    { 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9 },
+    { 0xbcb2b812db11a5de, 0x7415d448f6b6f0e7 },
+    { 0xebdf661791d60f56, 0x111b495b3464ad21 },
+    { 0x936b9fcebb25c995, 0xcab10dd900beec34 },
+    { 0xb84687c269ef3bfb, 0x3d5d514f40eea742 },
+    { 0xe65829b3046b0afa, 0x0cb4a5a3112a5112 },
+    { 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab },
+    { 0xb3f4e093db73a093, 0x59ed216765690f56 },
+    { 0xe0f218b8d25088b8, 0x306869c13ec3532c },
+    { 0x8c974f7383725573, 0x1e414218c73a13fb },
+    { 0xafbd2350644eeacf, 0xe5d1929ef90898fa },
+    { 0xdbac6c247d62a583, 0xdf45f746b74abf39 },
+    { 0x894bc396ce5da772, 0x6b8bba8c328eb783 },
+    { 0xab9eb47c81f5114f, 0x066ea92f3f326564 },
+    { 0xd686619ba27255a2, 0xc80a537b0efefebd },
+    { 0x8613fd0145877585, 0xbd06742ce95f5f36 },
+    { 0xa798fc4196e952e7, 0x2c48113823b73704 },
+    { 0xd17f3b51fca3a7a0, 0xf75a15862ca504c5 },
+    { 0x82ef85133de648c4, 0x9a984d73dbe722fb },
+    { 0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba },
+    { 0xcc963fee10b7d1b3, 0x318df905079926a8 },
+    { 0xffbbcfe994e5c61f, 0xfdf17746497f7052 },
+    { 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633 },
+    { 0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0 },
+    { 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0 },
+    { 0x9c1661a651213e2d, 0x06bea10ca65c084e },
+    { 0xc31bfa0fe5698db8, 0x486e494fcff30a62 },
+    { 0xf3e2f893dec3f126, 0x5a89dba3c3efccfa },
+    { 0x986ddb5c6b3a76b7, 0xf89629465a75e01c },
+    { 0xbe89523386091465, 0xf6bbb397f1135823 },
+    { 0xee2ba6c0678b597f, 0x746aa07ded582e2c },
+    { 0x94db483840b717ef, 0xa8c2a44eb4571cdc },
+    { 0xba121a4650e4ddeb, 0x92f34d62616ce413 },
+    { 0xe896a0d7e51e1566, 0x77b020baf9c81d17 },
+    { 0x915e2486ef32cd60, 0x0ace1474dc1d122e },
+    { 0xb5b5ada8aaff80b8, 0x0d819992132456ba },
+    { 0xe3231912d5bf60e6, 0x10e1fff697ed6c69 },
+    { 0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1 },
+    { 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2 },
+    { 0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde },
+    { 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b },
+    { 0xad4ab7112eb3929d, 0x86c16c98d2c953c6 },
+    { 0xd89d64d57a607744, 0xe871c7bf077ba8b7 },
+    { 0x87625f056c7c4a8b, 0x11471cd764ad4972 },
+    { 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf },
+    { 0xd389b47879823479, 0x4aff1d108d4ec2c3 },
+    { 0x843610cb4bf160cb, 0xcedf722a585139ba },
+    { 0xa54394fe1eedb8fe, 0xc2974eb4ee658828 },
+    { 0xce947a3da6a9273e, 0x733d226229feea32 },
+    { 0x811ccc668829b887, 0x0806357d5a3f525f },
+    { 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7 },
+    { 0xc9bcff6034c13052, 0xfc89b393dd02f0b5 },
+    { 0xfc2c3f3841f17c67, 0xbbac2078d443ace2 },
+    { 0x9d9ba7832936edc0, 0xd54b944b84aa4c0d },
+    { 0xc5029163f384a931, 0x0a9e795e65d4df11 },
+    { 0xf64335bcf065d37d, 0x4d4617b5ff4a16d5 },
+    { 0x99ea0196163fa42e, 0x504bced1bf8e4e45 },
+    { 0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6 },
+    { 0xf07da27a82c37088, 0x5d767327bb4e5a4c },
+    { 0x964e858c91ba2655, 0x3a6a07f8d510f86f },
+    { 0xbbe226efb628afea, 0x890489f70a55368b },
+    { 0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e },
+    { 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d },
+    { 0xb77ada0617e3bbcb, 0x09ce6ebb40173744 },
+    { 0xe55990879ddcaabd, 0xcc420a6a101d0515 },
+    { 0x8f57fa54c2a9eab6, 0x9fa946824a12232d },
+    { 0xb32df8e9f3546564, 0x47939822dc96abf9 },
+    { 0xdff9772470297ebd, 0x59787e2b93bc56f7 },
+    { 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a },
+    { 0xaefae51477a06b03, 0xede622920b6b23f1 },
+    { 0xdab99e59958885c4, 0xe95fab368e45eced },
+    { 0x88b402f7fd75539b, 0x11dbcb0218ebb414 },
+    { 0xaae103b5fcd2a881, 0xd652bdc29f26a119 },
+    { 0xd59944a37c0752a2, 0x4be76d3346f0495f },
+    { 0x857fcae62d8493a5, 0x6f70a4400c562ddb },
+    { 0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952 },
+    { 0xd097ad07a71f26b2, 0x7e2000a41346a7a7 },
+    { 0x825ecc24c873782f, 0x8ed400668c0c28c8 },
+    { 0xa2f67f2dfa90563b, 0x728900802f0f32fa },
+    { 0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9 },
+    { 0xfea126b7d78186bc, 0xe2f610c84987bfa8 },
+    { 0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9 },
+    { 0xc6ede63fa05d3143, 0x91503d1c79720dbb },
+    { 0xf8a95fcf88747d94, 0x75a44c6397ce912a },
+    { 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba },
+    { 0xc24452da229b021b, 0xfbe85badce996168 },
+    { 0xf2d56790ab41c2a2, 0xfae27299423fb9c3 },
+    { 0x97c560ba6b0919a5, 0xdccd879fc967d41a },
+    { 0xbdb6b8e905cb600f, 0x5400e987bbc1c920 },
+    { 0xed246723473e3813, 0x290123e9aab23b68 },
+    { 0x9436c0760c86e30b, 0xf9a0b6720aaf6521 },
+    { 0xb94470938fa89bce, 0xf808e40e8d5b3e69 },
+    { 0xe7958cb87392c2c2, 0xb60b1d1230b20e04 },
+    { 0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2 },
+    { 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3 },
+    { 0xe2280b6c20dd5232, 0x25c6da63c38de1b0 },
+    { 0x8d590723948a535f, 0x579c487e5a38ad0e },
+    { 0xb0af48ec79ace837, 0x2d835a9df0c6d851 },
+    { 0xdcdb1b2798182244, 0xf8e431456cf88e65 },
+    { 0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff },
+    { 0xac8b2d36eed2dac5, 0xe272467e3d222f3f },
+    { 0xd7adf884aa879177, 0x5b0ed81dcc6abb0f },
+    { 0x86ccbb52ea94baea, 0x98e947129fc2b4e9 },
+    { 0xa87fea27a539e9a5, 0x3f2398d747b36224 },
+    { 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad },
+    { 0x83a3eeeef9153e89, 0x1953cf68300424ac },
+    { 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7 },
+    { 0xcdb02555653131b6, 0x3792f412cb06794d },
+    { 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0 },
+    { 0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4 },
+    { 0xc8de047564d20a8b, 0xf245825a5a445275 },
+    { 0xfb158592be068d2e, 0xeed6e2f0f0d56712 },
+    { 0x9ced737bb6c4183d, 0x55464dd69685606b },
+    { 0xc428d05aa4751e4c, 0xaa97e14c3c26b886 },
+    { 0xf53304714d9265df, 0xd53dd99f4b3066a8 },
+    { 0x993fe2c6d07b7fab, 0xe546a8038efe4029 },
+    { 0xbf8fdb78849a5f96, 0xde98520472bdd033 },
+    { 0xef73d256a5c0f77c, 0x963e66858f6d4440 },
+    { 0x95a8637627989aad, 0xdde7001379a44aa8 },
+    { 0xbb127c53b17ec159, 0x5560c018580d5d52 },
+    { 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6 },
+    { 0x9226712162ab070d, 0xcab3961304ca70e8 },
+    { 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22 },
+    { 0xe45c10c42a2b3b05, 0x8cb89a7db77c506a },
+    { 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242 },
+    { 0xb267ed1940f1c61c, 0x55f038b237591ed3 },
+    { 0xdf01e85f912e37a3, 0x6b6c46dec52f6688 },
+    { 0x8b61313bbabce2c6, 0x2323ac4b3b3da015 },
+    { 0xae397d8aa96c1b77, 0xabec975e0a0d081a },
+    { 0xd9c7dced53c72255, 0x96e7bd358c904a21 },
+    { 0x881cea14545c7575, 0x7e50d64177da2e54 },
+    { 0xaa242499697392d2, 0xdde50bd1d5d0b9e9 },
+    { 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864 },
+    { 0x84ec3c97da624ab4, 0xbd5af13bef0b113e },
+    { 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e },
+    { 0xcfb11ead453994ba, 0x67de18eda5814af2 },
+    { 0x81ceb32c4b43fcf4, 0x80eacf948770ced7 },
+    { 0xa2425ff75e14fc31, 0xa1258379a94d028d },
+    { 0xcad2f7f5359a3b3e, 0x096ee45813a04330 },
+    { 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc },
+    { 0x9e74d1b791e07e48, 0x775ea264cf55347e },
+    { 0xc612062576589dda, 0x95364afe032a819e },
+    { 0xf79687aed3eec551, 0x3a83ddbd83f52205 },
+    { 0x9abe14cd44753b52, 0xc4926a9672793543 },
+    { 0xc16d9a0095928a27, 0x75b7053c0f178294 },
+    { 0xf1c90080baf72cb1, 0x5324c68b12dd6339 },
+    { 0x971da05074da7bee, 0xd3f6fc16ebca5e04 },
+    { 0xbce5086492111aea, 0x88f4bb1ca6bcf585 },
+    { 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6 },
+    { 0x9392ee8e921d5d07, 0x3aff322e62439fd0 },
+    { 0xb877aa3236a4b449, 0x09befeb9fad487c3 },
+    { 0xe69594bec44de15b, 0x4c2ebe687989a9b4 },
+    { 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11 },
+    { 0xb424dc35095cd80f, 0x538484c19ef38c95 },
+    { 0xe12e13424bb40e13, 0x2865a5f206b06fba },
+    { 0x8cbccc096f5088cb, 0xf93f87b7442e45d4 },
+    { 0xafebff0bcb24aafe, 0xf78f69a51539d749 },
+    { 0xdbe6fecebdedd5be, 0xb573440e5a884d1c },
+    { 0x89705f4136b4a597, 0x31680a88f8953031 },
+    { 0xabcc77118461cefc, 0xfdc20d2b36ba7c3e },
+    { 0xd6bf94d5e57a42bc, 0x3d32907604691b4d },
+    { 0x8637bd05af6c69b5, 0xa63f9a49c2c1b110 },
+    { 0xa7c5ac471b478423, 0x0fcf80dc33721d54 },
+    { 0xd1b71758e219652b, 0xd3c36113404ea4a9 },
+    { 0x83126e978d4fdf3b, 0x645a1cac083126ea },
+    { 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4 },
+    { 0xcccccccccccccccc, 0xcccccccccccccccd },
+    { 0x8000000000000000, 0x0000000000000000 },
+    { 0xa000000000000000, 0x0000000000000000 },
+    { 0xc800000000000000, 0x0000000000000000 },
+    { 0xfa00000000000000, 0x0000000000000000 },
+    { 0x9c40000000000000, 0x0000000000000000 },
+    { 0xc350000000000000, 0x0000000000000000 },
+    { 0xf424000000000000, 0x0000000000000000 },
+    { 0x9896800000000000, 0x0000000000000000 },
+    { 0xbebc200000000000, 0x0000000000000000 },
+    { 0xee6b280000000000, 0x0000000000000000 },
+    { 0x9502f90000000000, 0x0000000000000000 },
+    { 0xba43b74000000000, 0x0000000000000000 },
+    { 0xe8d4a51000000000, 0x0000000000000000 },
+    { 0x9184e72a00000000, 0x0000000000000000 },
+    { 0xb5e620f480000000, 0x0000000000000000 },
+    { 0xe35fa931a0000000, 0x0000000000000000 },
+    { 0x8e1bc9bf04000000, 0x0000000000000000 },
+    { 0xb1a2bc2ec5000000, 0x0000000000000000 },
+    { 0xde0b6b3a76400000, 0x0000000000000000 },
+    { 0x8ac7230489e80000, 0x0000000000000000 },
+    { 0xad78ebc5ac620000, 0x0000000000000000 },
+    { 0xd8d726b7177a8000, 0x0000000000000000 },
+    { 0x878678326eac9000, 0x0000000000000000 },
+    { 0xa968163f0a57b400, 0x0000000000000000 },
+    { 0xd3c21bcecceda100, 0x0000000000000000 },
+    { 0x84595161401484a0, 0x0000000000000000 },
+    { 0xa56fa5b99019a5c8, 0x0000000000000000 },
+    { 0xcecb8f27f4200f3a, 0x0000000000000000 },
+    { 0x813f3978f8940984, 0x4000000000000000 },
+    { 0xa18f07d736b90be5, 0x5000000000000000 },
+    { 0xc9f2c9cd04674ede, 0xa400000000000000 },
+    { 0xfc6f7c4045812296, 0x4d00000000000000 },
+    { 0x9dc5ada82b70b59d, 0xf020000000000000 },
+    { 0xc5371912364ce305, 0x6c28000000000000 },
+    { 0xf684df56c3e01bc6, 0xc732000000000000 },
+    { 0x9a130b963a6c115c, 0x3c7f400000000000 },
+    { 0xc097ce7bc90715b3, 0x4b9f100000000000 },
+    { 0xf0bdc21abb48db20, 0x1e86d40000000000 },
+    { 0x96769950b50d88f4, 0x1314448000000000 },
+    { 0xbc143fa4e250eb31, 0x17d955a000000000 },
+    { 0xeb194f8e1ae525fd, 0x5dcfab0800000000 },
+    { 0x92efd1b8d0cf37be, 0x5aa1cae500000000 },
+    { 0xb7abc627050305ad, 0xf14a3d9e40000000 },
+    { 0xe596b7b0c643c719, 0x6d9ccd05d0000000 },
+    { 0x8f7e32ce7bea5c6f, 0xe4820023a2000000 },
+    { 0xb35dbf821ae4f38b, 0xdda2802c8a800000 },
+    { 0xe0352f62a19e306e, 0xd50b2037ad200000 },
+    { 0x8c213d9da502de45, 0x4526f422cc340000 },
+    { 0xaf298d050e4395d6, 0x9670b12b7f410000 },
+    { 0xdaf3f04651d47b4c, 0x3c0cdd765f114000 },
+    { 0x88d8762bf324cd0f, 0xa5880a69fb6ac800 },
+    { 0xab0e93b6efee0053, 0x8eea0d047a457a00 },
+    { 0xd5d238a4abe98068, 0x72a4904598d6d880 },
+    { 0x85a36366eb71f041, 0x47a6da2b7f864750 },
+    { 0xa70c3c40a64e6c51, 0x999090b65f67d924 },
+    { 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d },
+    { 0x82818f1281ed449f, 0xbff8f10e7a8921a4 },
+    { 0xa321f2d7226895c7, 0xaff72d52192b6a0d },
+    { 0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490 },
+    { 0xfee50b7025c36a08, 0x02f236d04753d5b4 },
+    { 0x9f4f2726179a2245, 0x01d762422c946590 },
+    { 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5 },
+    { 0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2 },
+    { 0x9b934c3b330c8577, 0x63cc55f49f88eb2f },
+    { 0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb },
+    { 0xf316271c7fc3908a, 0x8bef464e3945ef7a },
+    { 0x97edd871cfda3a56, 0x97758bf0e3cbb5ac },
+    { 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317 },
+    { 0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd },
+    { 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a },
+    { 0xb975d6b6ee39e436, 0xb3e2fd538e122b44 },
+    { 0xe7d34c64a9c85d44, 0x60dbbca87196b616 },
+    { 0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd },
+    { 0xb51d13aea4a488dd, 0x6babab6398bdbe41 },
+    { 0xe264589a4dcdab14, 0xc696963c7eed2dd1 },
+    { 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2 },
+    { 0xb0de65388cc8ada8, 0x3b25a55f43294bcb },
+    { 0xdd15fe86affad912, 0x49ef0eb713f39ebe },
+    { 0x8a2dbf142dfcc7ab, 0x6e3569326c784337 },
+    { 0xacb92ed9397bf996, 0x49c2c37f07965404 },
+    { 0xd7e77a8f87daf7fb, 0xdc33745ec97be906 },
+    { 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3 },
+    { 0xa8acd7c0222311bc, 0xc40832ea0d68ce0c },
+    { 0xd2d80db02aabd62b, 0xf50a3fa490c30190 },
+    { 0x83c7088e1aab65db, 0x792667c6da79e0fa },
+    { 0xa4b8cab1a1563f52, 0x577001b891185938 },
+    { 0xcde6fd5e09abcf26, 0xed4c0226b55e6f86 },
+    { 0x80b05e5ac60b6178, 0x544f8158315b05b4 },
+    { 0xa0dc75f1778e39d6, 0x696361ae3db1c721 },
+    { 0xc913936dd571c84c, 0x03bc3a19cd1e38e9 },
+    { 0xfb5878494ace3a5f, 0x04ab48a04065c723 },
+    { 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76 },
+    { 0xc45d1df942711d9a, 0x3ba5d0bd324f8394 },
+    { 0xf5746577930d6500, 0xca8f44ec7ee36479 },
+    { 0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb },
+    { 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e },
+    { 0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e },
+    { 0x95d04aee3b80ece5, 0xbba1f1d158724a12 },
+    { 0xbb445da9ca61281f, 0x2a8a6e45ae8edc97 },
+    { 0xea1575143cf97226, 0xf52d09d71a3293bd },
+    { 0x924d692ca61be758, 0x593c2626705f9c56 },
+    { 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c },
+    { 0xe498f455c38b997a, 0x0b6dfb9c0f956447 },
+    { 0x8edf98b59a373fec, 0x4724bd4189bd5eac },
+    { 0xb2977ee300c50fe7, 0x58edec91ec2cb657 },
+    { 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed },
+    { 0x8b865b215899f46c, 0xbd79e0d20082ee74 },
+    { 0xae67f1e9aec07187, 0xecd8590680a3aa11 },
+    { 0xda01ee641a708de9, 0xe80e6f4820cc9495 },
+    { 0x884134fe908658b2, 0x3109058d147fdcdd },
+    { 0xaa51823e34a7eede, 0xbd4b46f0599fd415 },
+    { 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a },
+    { 0x850fadc09923329e, 0x03e2cf6bc604ddb0 },
+    { 0xa6539930bf6bff45, 0x84db8346b786151c },
+    { 0xcfe87f7cef46ff16, 0xe612641865679a63 },
+    { 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e },
+    { 0xa26da3999aef7749, 0xe3be5e330f38f09d },
+    { 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5 },
+    { 0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6 },
+    { 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa },
+    { 0xc646d63501a1511d, 0xb281e1fd541501b8 },
+    { 0xf7d88bc24209a565, 0x1f225a7ca91a4226 },
+    { 0x9ae757596946075f, 0x3375788de9b06958 },
+    { 0xc1a12d2fc3978937, 0x0052d6b1641c83ae },
+    { 0xf209787bb47d6b84, 0xc0678c5dbd23a49a },
+    { 0x9745eb4d50ce6332, 0xf840b7ba963646e0 },
+    { 0xbd176620a501fbff, 0xb650e5a93bc3d898 },
+    { 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe },
+    { 0x93ba47c980e98cdf, 0xc66f336c36b10137 },
+    { 0xb8a8d9bbe123f017, 0xb80b0047445d4184 },
+    { 0xe6d3102ad96cec1d, 0xa60dc059157491e5 },
+    { 0x9043ea1ac7e41392, 0x87c89837ad68db2f },
+    { 0xb454e4a179dd1877, 0x29babe4598c311fb },
+    { 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a },
+    { 0x8ce2529e2734bb1d, 0x1899e4a65f58660c },
+    { 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f },
+    { 0xdc21a1171d42645d, 0x76707543f4fa1f73 },
+    { 0x899504ae72497eba, 0x6a06494a791c53a8 },
+    { 0xabfa45da0edbde69, 0x0487db9d17636892 },
+    { 0xd6f8d7509292d603, 0x45a9d2845d3c42b6 },
+    { 0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2 },
+    { 0xa7f26836f282b732, 0x8e6cac7768d7141e },
+    { 0xd1ef0244af2364ff, 0x3207d795430cd926 },
+    { 0x8335616aed761f1f, 0x7f44e6bd49e807b8 },
+    { 0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6 },
+    { 0xcd036837130890a1, 0x36dba887c37a8c0f },
+    { 0x802221226be55a64, 0xc2494954da2c9789 },
+    { 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c },
+    { 0xc83553c5c8965d3d, 0x6f92829494e5acc7 },
+    { 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9 },
+    { 0x9c69a97284b578d7, 0xff2a760414536efb },
+    { 0xc38413cf25e2d70d, 0xfef5138519684aba },
+    { 0xf46518c2ef5b8cd1, 0x7eb258665fc25d69 },
+    { 0x98bf2f79d5993802, 0xef2f773ffbd97a61 },
+    { 0xbeeefb584aff8603, 0xaafb550ffacfd8fa },
+    { 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38 },
+    { 0x952ab45cfa97a0b2, 0xdd945a747bf26183 },
+    { 0xba756174393d88df, 0x94f971119aeef9e4 },
+    { 0xe912b9d1478ceb17, 0x7a37cd5601aab85d },
+    { 0x91abb422ccb812ee, 0xac62e055c10ab33a },
+    { 0xb616a12b7fe617aa, 0x577b986b314d6009 },
+    { 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b },
+    { 0x8e41ade9fbebc27d, 0x14588f13be847307 },
+    { 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8 },
+    { 0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb },
+    { 0x8aec23d680043bee, 0x25de7bb9480d5854 },
+    { 0xada72ccc20054ae9, 0xaf561aa79a10ae6a },
+    { 0xd910f7ff28069da4, 0x1b2ba1518094da04 },
+    { 0x87aa9aff79042286, 0x90fb44d2f05d0842 },
+    { 0xa99541bf57452b28, 0x353a1607ac744a53 },
+    { 0xd3fa922f2d1675f2, 0x42889b8997915ce8 },
+    { 0x847c9b5d7c2e09b7, 0x69956135febada11 },
+    { 0xa59bc234db398c25, 0x43fab9837e699095 },
+    { 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb },
+    { 0x8161afb94b44f57d, 0x1d1be0eebac278f5 },
+    { 0xa1ba1ba79e1632dc, 0x6462d92a69731732 },
+    { 0xca28a291859bbf93, 0x7d7b8f7503cfdcfe },
+    { 0xfcb2cb35e702af78, 0x5cda735244c3d43e },
+    { 0x9defbf01b061adab, 0x3a0888136afa64a7 },
+    { 0xc56baec21c7a1916, 0x088aaa1845b8fdd0 },
+    { 0xf6c69a72a3989f5b, 0x8aad549e57273d45 },
+    { 0x9a3c2087a63f6399, 0x36ac54e2f678864b },
+    { 0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd },
+    { 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5 },
+    { 0x969eb7c47859e743, 0x9f644ae5a4b1b325 },
+    { 0xbc4665b596706114, 0x873d5d9f0dde1fee },
+    { 0xeb57ff22fc0c7959, 0xa90cb506d155a7ea },
+    { 0x9316ff75dd87cbd8, 0x09a7f12442d588f2 },
+    { 0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f },
+    { 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa },
+    { 0x8fa475791a569d10, 0xf96e017d694487bc },
+    { 0xb38d92d760ec4455, 0x37c981dcc395a9ac },
+    { 0xe070f78d3927556a, 0x85bbe253f47b1417 },
+    { 0x8c469ab843b89562, 0x93956d7478ccec8e },
+    { 0xaf58416654a6babb, 0x387ac8d1970027b2 },
+    { 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e },
+    { 0x88fcf317f22241e2, 0x441fece3bdf81f03 },
+    { 0xab3c2fddeeaad25a, 0xd527e81cad7626c3 },
+    { 0xd60b3bd56a5586f1, 0x8a71e223d8d3b074 },
+    { 0x85c7056562757456, 0xf6872d5667844e49 },
+    { 0xa738c6bebb12d16c, 0xb428f8ac016561db },
+    { 0xd106f86e69d785c7, 0xe13336d701beba52 },
+    { 0x82a45b450226b39c, 0xecc0024661173473 },
+    { 0xa34d721642b06084, 0x27f002d7f95d0190 },
+    { 0xcc20ce9bd35c78a5, 0x31ec038df7b441f4 },
+    { 0xff290242c83396ce, 0x7e67047175a15271 },
+    { 0x9f79a169bd203e41, 0x0f0062c6e984d386 },
+    { 0xc75809c42c684dd1, 0x52c07b78a3e60868 },
+    { 0xf92e0c3537826145, 0xa7709a56ccdf8a82 },
+    { 0x9bbcc7a142b17ccb, 0x88a66076400bb691 },
+    { 0xc2abf989935ddbfe, 0x6acff893d00ea435 },
+    { 0xf356f7ebf83552fe, 0x0583f6b8c4124d43 },
+    { 0x98165af37b2153de, 0xc3727a337a8b704a },
+    { 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c },
+    { 0xeda2ee1c7064130c, 0x1162def06f79df73 },
+    { 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8 },
+    { 0xb9a74a0637ce2ee1, 0x6d953e2bd7173692 },
+    { 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437 },
+    { 0x910ab1d4db9914a0, 0x1d9c9892400a22a2 },
+    { 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b },
+    { 0xe2a0b5dc971f303a, 0x2e44ae64840fd61d },
+    { 0x8da471a9de737e24, 0x5ceaecfed289e5d2 },
+    { 0xb10d8e1456105dad, 0x7425a83e872c5f47 },
+    { 0xdd50f1996b947518, 0xd12f124e28f77719 },
+    { 0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f },
+    { 0xace73cbfdc0bfb7b, 0x636cc64d1001550b },
+    { 0xd8210befd30efa5a, 0x3c47f7e05401aa4e },
+    { 0x8714a775e3e95c78, 0x65acfaec34810a71 },
+    { 0xa8d9d1535ce3b396, 0x7f1839a741a14d0d },
+    { 0xd31045a8341ca07c, 0x1ede48111209a050 },
+    { 0x83ea2b892091e44d, 0x934aed0aab460432 },
+    { 0xa4e4b66b68b65d60, 0xf81da84d5617853f },
+    { 0xce1de40642e3f4b9, 0x36251260ab9d668e },
+    { 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019 },
+    { 0xa1075a24e4421730, 0xb24cf65b8612f81f },
+    { 0xc94930ae1d529cfc, 0xdee033f26797b627 },
+    { 0xfb9b7cd9a4a7443c, 0x169840ef017da3b1 },
+    { 0x9d412e0806e88aa5, 0x8e1f289560ee864e },
+    { 0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2 },
+    { 0xf5b5d7ec8acb58a2, 0xae10af696774b1db },
+    { 0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29 },
+    { 0xbff610b0cc6edd3f, 0x17fd090a58d32af3 },
+    { 0xeff394dcff8a948e, 0xddfc4b4cef07f5b0 },
+    { 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e },
+    { 0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1 },
+    { 0xea53df5fd18d5513, 0x84c86189216dc5ed },
+    { 0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4 },
+    { 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1 },
+    { 0xe4d5e82392a40515, 0x0fabaf3feaa5334a },
+    { 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e },
+    { 0xb2c71d5bca9023f8, 0x743e20e9ef511012 },
+    { 0xdf78e4b2bd342cf6, 0x914da9246b255416 },
+    { 0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e },
+    { 0xae9672aba3d0c320, 0xa184ac2473b529b1 },
+    { 0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e },
+    { 0x8865899617fb1871, 0x7e2fa67c7a658892 },
+    { 0xaa7eebfb9df9de8d, 0xddbb901b98feeab7 },
+    { 0xd51ea6fa85785631, 0x552a74227f3ea565 },
+    { 0x8533285c936b35de, 0xd53a88958f87275f },
+    { 0xa67ff273b8460356, 0x8a892abaf368f137 },
+    { 0xd01fef10a657842c, 0x2d2b7569b0432d85 },
+    { 0x8213f56a67f6b29b, 0x9c3b29620e29fc73 },
+    { 0xa298f2c501f45f42, 0x8349f3ba91b47b8f },
+    { 0xcb3f2f7642717713, 0x241c70a936219a73 },
+    { 0xfe0efb53d30dd4d7, 0xed238cd383aa0110 },
+    { 0x9ec95d1463e8a506, 0xf4363804324a40aa },
+    { 0xc67bb4597ce2ce48, 0xb143c6053edcd0d5 },
+    { 0xf81aa16fdc1b81da, 0xdd94b7868e94050a },
+    { 0x9b10a4e5e9913128, 0xca7cf2b4191c8326 },
+    { 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0 },
+    { 0xf24a01a73cf2dccf, 0xbc633b39673c8cec },
+    { 0x976e41088617ca01, 0xd5be0503e085d813 },
+    { 0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18 },
+    { 0xec9c459d51852ba2, 0xddf8e7d60ed1219e },
+    { 0x93e1ab8252f33b45, 0xcabb90e5c942b503 },
+    { 0xb8da1662e7b00a17, 0x3d6a751f3b936243 },
+    { 0xe7109bfba19c0c9d, 0x0cc512670a783ad4 },
+    { 0x906a617d450187e2, 0x27fb2b80668b24c5 },
+    { 0xb484f9dc9641e9da, 0xb1f9f660802dedf6 },
+    { 0xe1a63853bbd26451, 0x5e7873f8a0396973 },
+    { 0x8d07e33455637eb2, 0xdb0b487b6423e1e8 },
+    { 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62 },
+    { 0xdc5c5301c56b75f7, 0x7641a140cc7810fb },
+    { 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d },
+    { 0xac2820d9623bf429, 0x546345fa9fbdcd44 },
+    { 0xd732290fbacaf133, 0xa97c177947ad4095 },
+    { 0x867f59a9d4bed6c0, 0x49ed8eabcccc485d },
+    { 0xa81f301449ee8c70, 0x5c68f256bfff5a74 },
+    { 0xd226fc195c6a2f8c, 0x73832eec6fff3111 },
+    { 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab },
+    { 0xa42e74f3d032f525, 0xba3e7ca8b77f5e55 },
+    { 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb },
+    { 0x80444b5e7aa7cf85, 0x7980d163cf5b81b3 },
+    { 0xa0555e361951c366, 0xd7e105bcc332621f },
+    { 0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7 },
+    { 0xfa856334878fc150, 0xb14f98f6f0feb951 },
+    { 0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3 },
+    { 0xc3b8358109e84f07, 0x0a862f80ec4700c8 },
+    { 0xf4a642e14c6262c8, 0xcd27bb612758c0fa },
+    { 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c },
+    { 0xbf21e44003acdd2c, 0xe0470a63e6bd56c3 },
+    { 0xeeea5d5004981478, 0x1858ccfce06cac74 },
+    { 0x95527a5202df0ccb, 0x0f37801e0c43ebc8 },
+    { 0xbaa718e68396cffd, 0xd30560258f54e6ba },
+    { 0xe950df20247c83fd, 0x47c6b82ef32a2069 },
+    { 0x91d28b7416cdd27e, 0x4cdc331d57fa5441 },
+    { 0xb6472e511c81471d, 0xe0133fe4adf8e952 },
+    { 0xe3d8f9e563a198e5, 0x58180fddd97723a6 },
+    { 0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648 },
+};
 
-#define IS_HI_SURROGATE(codepoint)  (0xd800 <= (codepoint)  &&  (codepoint) <= 0xdbff)
-#define IS_LO_SURROGATE(codepoint)  (0xdc00 <= (codepoint)  &&  (codepoint) <= 0xdfff)
+static inline unsigned
+json_clz64(uint64_t x)
+{
+#if defined __GNUC__ || defined __clang__
+    return (unsigned) __builtin_clzll(x);
+#elif defined _MSC_VER && (defined _M_X64 || defined _M_ARM64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - (unsigned) index;
+#else
+    unsigned n = 0;
+
+    while(!(x & ((uint64_t) 1 << 63))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
 
+/* Full 64x64 -> 128 bit multiplication. */
+static inline void
+json_mul64(uint64_t a, uint64_t b, uint64_t* p_hi, uint64_t* p_lo)
+{
+#if defined __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128) a * b;
+    *p_hi = (uint64_t) (r >> 64);
+    *p_lo = (uint64_t) r;
+#elif defined _MSC_VER && defined _M_X64
+    *p_lo = _umul128(a, b, p_hi);
+#else
+    uint64_t a_lo = a & 0xffffffff;
+    uint64_t a_hi = a >> 32;
+    uint64_t b_lo = b & 0xffffffff;
+    uint64_t b_hi = b >> 32;
+    uint64_t p0 = a_lo * b_lo;
+    uint64_t p1 = a_lo * b_hi;
+    uint64_t p2 = a_hi * b_lo;
+    uint64_t p3 = a_hi * b_hi;
+    uint64_t mid = (p0 >> 32) + (p1 & 0xffffffff) + (p2 & 0xffffffff);
+
+    *p_lo = (mid << 32) | (p0 & 0xffffffff);
+    *p_hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
 
-static size_t
-json_literal_automaton(JSON_PARSER* parser, const char* input, size_t size,
-                       JSON_TYPE type, const char* literal, size_t literal_size)
+/* Compute bits of the double nearest to w * 10^q (w != 0, q in the range of
+ * json_pow5_table[]). Returns zero on success, or -1 if the approximation is
+ * not good enough to decide. */
+static int
+json_eisel_lemire(uint64_t w, int q, uint64_t* p_bits)
 {
-    size_t off = 0;
+    const uint64_t* pow5 = json_pow5_table[q - POW5_MIN_EXP];
+    uint64_t hi, lo;
+    uint64_t mantissa;
+    unsigned lz;
+    unsigned upper_bit;
+    unsigned shift;
+    int power2;
+
+    lz = json_clz64(w);
+    w <<= lz;
+
+    /* We need 55 good bits of the product: 53 for the mantissa, one more for
+     * the rounding and one because the product may have a leading zero. If
+     * all the bits below them are ones, an error of the approximation could
+     * carry into them so use also the lower half of the 5^q approximation. */
+    json_mul64(w, pow5[0], &hi, &lo);
+    if((hi & 0x1ff) == 0x1ff) {
+        uint64_t hi2, lo2;
+
+        json_mul64(w, pow5[1], &hi2, &lo2);
+        lo += hi2;
+        if(hi2 > lo)
+            hi++;
+    }
+    if(lo == UINT64_MAX  &&  (q < -27  ||  q > 55))
+        return -1;
 
-    /* In this automaton, we use substate as a character count of the literal
-     * we have already seen. */
-    while(parser->substate < literal_size  &&  off < size) {
-        int ch = input[off];
+    upper_bit = (unsigned) (hi >> 63);
+    shift = upper_bit + 64 - DBL_MANTISSA_BITS - 3;
+    mantissa = hi >> shift;
 
-        if(ch != literal[parser->substate]) {
-            json_raise_for_value(parser, JSON_ERR_SYNTAX);
+    /* (217706 / 2^16 approximates log2(10).) */
+    power2 = ((217706 * q) >> 16) + 63 + (int) upper_bit - (int) lz + DBL_EXP_BIAS;
+
+    if(power2 <= 0) {
+        /* Subnormal number (or zero). */
+        if(-power2 + 1 >= 64) {
+            *p_bits = 0;
             return 0;
         }
 
-        off++;
-        parser->pos.offset++;
-        parser->pos.column_number++;
-        parser->substate++;
+        mantissa >>= -power2 + 1;
+        mantissa += (mantissa & 1);
+        mantissa >>= 1;
+        /* It may have been rounded up to the smallest normal number. */
+        power2 = (mantissa < ((uint64_t) 1 << DBL_MANTISSA_BITS)) ? 0 : 1;
+        *p_bits = (mantissa & DBL_MANTISSA_MASK) | ((uint64_t) power2 << DBL_MANTISSA_BITS);
+        return 0;
     }
 
-    /* Check the literal is really complete and there is not some unexpected
-     * tail. (If so, we want to raise the problem for whole literal. */
-    if(off < size  &&  !IS_TOKEN_BOUNDARY(input[off])) {
-        memcpy(&parser->pos, &parser->value_pos, sizeof(JSON_INPUT_POS));
-        json_raise(parser, JSON_ERR_SYNTAX);
-    } else if(input == NULL  /* EOF */  ||
-       (off < size  &&  IS_TOKEN_BOUNDARY(input[off]))) {
-        json_process(parser, type, NULL, 0);
+    /* Exactly in the middle between two doubles? (Only possible for a small
+     * range of q.) Then round to even. */
+    if(lo <= 1  &&  q >= -4  &&  q <= 23  &&  (mantissa & 3) == 1) {
+        if((mantissa << shift) == hi)
+            mantissa &= ~(uint64_t) 1;
     }
-    return off;
+
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    if(mantissa >= ((uint64_t) 2 << DBL_MANTISSA_BITS)) {
+        mantissa = ((uint64_t) 1 << DBL_MANTISSA_BITS);
+        power2++;
+    }
+
+    if(power2 >= DBL_EXP_INF) {
+        *p_bits = (uint64_t) DBL_EXP_INF << DBL_MANTISSA_BITS;
+        return 0;
+    }
+
+    *p_bits = (mantissa & DBL_MANTISSA_MASK) | ((uint64_t) power2 << DBL_MANTISSA_BITS);
+    return 0;
 }
 
-static size_t
-json_number_automaton(JSON_PARSER* parser, const char* input, size_t size)
-{
-    static const unsigned can_see_m_sign        = 0x0001;   /* Mantissa */
-    static const unsigned can_see_m_first_digit = 0x0002;
-    static const unsigned can_see_m_digit       = 0x0004;
-    static const unsigned can_see_f_delimeter   = 0x0010;   /* Fraction */
-    static const unsigned can_see_f_digit       = 0x0020;
-    static const unsigned can_see_e_delim       = 0x0100;   /* Exponent */
-    static const unsigned can_see_e_sign        = 0x0200;
-    static const unsigned can_see_e_digit       = 0x0400;
-    static const unsigned can_see_end           = 0x1000;   /* End of number */
+/* The slow path: Arbitrary decimal number 0.d[0]d[1]...d[n-1] * 10^dp. Digits
+ * beyond the capacity are only recorded by the flag `truncated` (which is
+ * enough to round correctly). */
+#define DECIMAL_MAX_DIGITS      768
+#define DECIMAL_DP_RANGE        2047
 
-    size_t off = 0;
-    size_t max_len = parser->config.max_number_len;
+typedef struct JSON_DECIMAL {
+    unsigned n_digits;
+    int dp;
+    int truncated;
+    unsigned char digits[DECIMAL_MAX_DIGITS];
+} JSON_DECIMAL;
 
-    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset + size > max_len)
-        size = max_len - (parser->pos.offset - parser->value_pos.offset) + 1;
+static void
+json_decimal_init(JSON_DECIMAL* dec, const char* num, size_t num_size)
+{
+    size_t off = 0;
+    size_t first_frac_off;
+    unsigned n_trailing_zeros = 0;
+    size_t i;
 
-    if(parser->substate == 0)
-        parser->substate = can_see_m_sign | can_see_m_first_digit;
+    dec->n_digits = 0;
+    dec->dp = 0;
+    dec->truncated = 0;
 
-    while(off < size) {
-        int ch = input[off];
+    if(off < num_size  &&  num[off] == '-')
+        off++;
 
-        if((parser->substate & can_see_m_sign)  &&  ch == '-') {    /* '+' not allowed here. */
-            parser->substate = can_see_m_first_digit;
-        } else if((parser->substate & can_see_m_first_digit)  &&  IS_DIGIT(ch)) {
-            parser->substate = can_see_m_digit | can_see_f_delimeter | can_see_e_delim | can_see_end;
-            /* There cannot be any follow-up digit if mantissa begins with zero. */
-            if(ch == '0')
-                parser->substate &= ~can_see_m_digit;
-        } else if((parser->substate & can_see_m_digit)  &&  IS_DIGIT(ch)) {
-            parser->substate = can_see_m_digit | can_see_f_delimeter | can_see_e_delim | can_see_end;
-        } else if((parser->substate & can_see_f_delimeter)  &&  ch == '.') {
-            parser->substate = can_see_f_digit;
-        } else if((parser->substate & can_see_f_digit)  &&  IS_DIGIT(ch)) {
-            parser->substate = can_see_f_digit | can_see_e_delim | can_see_end;
-        } else if((parser->substate & can_see_e_delim)  &&  (ch == 'e' || ch == 'E')) {
-            parser->substate = can_see_e_sign | can_see_e_digit;
-        } else if((parser->substate & can_see_e_sign)  &&  (ch == '+' || ch == '-')) {
-            parser->substate = can_see_e_digit;
-        } else if((parser->substate & can_see_e_digit)  &&  IS_DIGIT(ch)) {
-            parser->substate = can_see_e_digit | can_see_end;
-        } else if((parser->substate & can_see_end)  &&  IS_TOKEN_BOUNDARY(ch)) {
-            /* Success. */
-            if(parser->buf_used == 0) {
-                json_process(parser, JSON_NUMBER, input, off);
-            } else {
-                if(json_buf_append(parser, input, off) != 0)
-                    return 0;
-                json_process(parser, JSON_NUMBER, parser->buf, parser->buf_used);
-            }
-            return off;
-        } else {
-            json_raise_for_value(parser, JSON_ERR_SYNTAX);
-            return 0;
-        }
+    /* Integer part. (Leading zeros do not count.) */
+    while(off < num_size  &&  num[off] == '0')
+        off++;
+    while(off < num_size  &&  IS_DIGIT(num[off])) {
+        if(dec->n_digits < DECIMAL_MAX_DIGITS)
+            dec->digits[dec->n_digits] = num[off] - '0';
+        else if(num[off] != '0')
+            dec->truncated = 1;
+        dec->n_digits++;
+        off++;
+    }
+    dec->dp = (int) dec->n_digits;
 
+    /* Fraction. */
+    if(off < num_size  &&  num[off] == '.') {
         off++;
-        parser->pos.offset++;
-        parser->pos.column_number++;
+        first_frac_off = off;
+        if(dec->n_digits == 0) {
+            while(off < num_size  &&  num[off] == '0')
+                off++;
+            dec->dp = -(int) (off - first_frac_off);
+        }
+        while(off < num_size  &&  IS_DIGIT(num[off])) {
+            if(dec->n_digits < DECIMAL_MAX_DIGITS)
+                dec->digits[dec->n_digits] = num[off] - '0';
+            else if(num[off] != '0')
+                dec->truncated = 1;
+            dec->n_digits++;
+            off++;
+        }
     }
 
-    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset > max_len)
-        json_raise_for_value(parser, JSON_ERR_MAXNUMBERLEN);
+    if(dec->n_digits > DECIMAL_MAX_DIGITS)
+        dec->n_digits = DECIMAL_MAX_DIGITS;
 
-    if(input == NULL) {       /* EOF */
-        if(parser->errcode == 0  &&  (parser->substate & can_see_end))
-            json_process(parser, JSON_NUMBER, parser->buf, parser->buf_used);
-        else
-            json_raise_for_value(parser, JSON_ERR_SYNTAX);
-    } else {
-        if(parser->errcode == 0) {
-            if(json_buf_append(parser, input, off) != 0)
-                return 0;
+    /* Trailing zeros do not count either. */
+    for(i = dec->n_digits; i > 0  &&  dec->digits[i-1] == 0; i--)
+        n_trailing_zeros++;
+    dec->n_digits -= n_trailing_zeros;
+
+    /* Exponent. */
+    if(off < num_size  &&  (num[off] == 'e' || num[off] == 'E')) {
+        int is_neg = 0;
+        int exp = 0;
+
+        off++;
+        if(off < num_size  &&  (num[off] == '+' || num[off] == '-')) {
+            is_neg = (num[off] == '-');
+            off++;
+        }
+        while(off < num_size  &&  IS_DIGIT(num[off])) {
+            if(exp < 0x10000)
+                exp = exp * 10 + (num[off] - '0');
+            off++;
         }
-    }
 
-    return off;
+        dec->dp += (is_neg ? -exp : exp);
+    }
 }
 
-static inline unsigned
-json_resolve_xdigit(char ch)
+static void
+json_decimal_trim(JSON_DECIMAL* dec)
 {
-    if(IS_DIGIT(ch))
-        return ch - '0';
-    else if(IS_IN(ch, 'a', 'f'))
-        return ch - 'a' + 10;
-    else
-        return ch - 'A' + 10;
+    while(dec->n_digits > 0  &&  dec->digits[dec->n_digits - 1] == 0)
+        dec->n_digits--;
 }
 
-/* U+fffd (Unicode replacement character), encoded in UTF-8.
- *
- * Note we sometimes need to use three, if we meet incorrect "\uABCD" escape
- * sequence corresponding to an orphan surrogate, due the "best practice" of
- * replacement character usage recommended in Unicode 10 standard:
+/* How many digits are added by multiplying with 2^shift: Either the count of
+ * digits of 2^shift, or one less if the digits are less than those of 5^shift.
  *
- * (Every orphan surrogate would be, in UTF-8, encoded as an 3-byte sequence.
- * The first (leading) byte forms longest good subsequence replaced by single
- * U+fffd. The two trailing bytes, who cannot really follow in well-formed
- * UTF-8, then are replaced with U+fffd each too.)
- */
-static const char fffd[9] = { '\xef', '\xbf', '\xbd', '\xef', '\xbf', '\xbd', '\xef', '\xbf', '\xbd' };
-static const size_t fffd_size = 3;
-
-static int
-json_handle_ill_surrogate(JSON_PARSER* parser, uint32_t codepoint, int ignore, int fix)
+ * The table has the count in the top 5 bits, and the offset into
+ * json_decimal_pow5_digits[] in the low 11 bits. */
+static unsigned
+json_decimal_new_digits(const JSON_DECIMAL* dec, unsigned shift)
 {
-    if(ignore)
-        return json_buf_append_codepoint(parser, codepoint);
-
-    if(fix)
-        return json_buf_append(parser, fffd, 3 * fffd_size);
-
-    json_raise(parser, JSON_ERR_INVALIDUTF8);
-    return -1;
+    static const uint16_t table[62] = {
+        0x0000, 0x0800, 0x0801, 0x0803, 0x1006, 0x1009, 0x100d, 0x1812,
+        0x1817, 0x181d, 0x2024, 0x202b, 0x2033, 0x203c, 0x2846, 0x2850,
+        0x285b, 0x3067, 0x3073, 0x3080, 0x388e, 0x389c, 0x38ab, 0x38bb,
+        0x40cc, 0x40dd, 0x40ef, 0x4902, 0x4915, 0x4929, 0x513e, 0x5153,
+        0x5169, 0x5180, 0x5998, 0x59b0, 0x59c9, 0x61e3, 0x61fd, 0x6218,
+        0x6a34, 0x6a50, 0x6a6d, 0x6a8b, 0x72aa, 0x72c9, 0x72e9, 0x7b0a,
+        0x7b2b, 0x7b4d, 0x8370, 0x8393, 0x83b7, 0x83dc, 0x8c02, 0x8c28,
+        0x8c4f, 0x9477, 0x949f, 0x94c8, 0x9cf2, 0x9d1c,
+    };
+    static const unsigned char pow5_digits[1308] = {
+        5, 2, 5, 1, 2, 5, 6, 2, 5, 3, 1, 2, 5, 1, 5, 6, 2, 5, 7, 8, 1, 2, 5, 3,
+        9, 0, 6, 2, 5, 1, 9, 5, 3, 1, 2, 5, 9, 7, 6, 5, 6, 2, 5, 4, 8, 8, 2, 8,
+        1, 2, 5, 2, 4, 4, 1, 4, 0, 6, 2, 5, 1, 2, 2, 0, 7, 0, 3, 1, 2, 5, 6, 1,
+        0, 3, 5, 1, 5, 6, 2, 5, 3, 0, 5, 1, 7, 5, 7, 8, 1, 2, 5, 1, 5, 2, 5, 8,
+        7, 8, 9, 0, 6, 2, 5, 7, 6, 2, 9, 3, 9, 4, 5, 3, 1, 2, 5, 3, 8, 1, 4, 6,
+        9, 7, 2, 6, 5, 6, 2, 5, 1, 9, 0, 7, 3, 4, 8, 6, 3, 2, 8, 1, 2, 5, 9, 5,
+        3, 6, 7, 4, 3, 1, 6, 4, 0, 6, 2, 5, 4, 7, 6, 8, 3, 7, 1, 5, 8, 2, 0, 3,
+        1, 2, 5, 2, 3, 8, 4, 1, 8, 5, 7, 9, 1, 0, 1, 5, 6, 2, 5, 1, 1, 9, 2, 0,
+        9, 2, 8, 9, 5, 5, 0, 7, 8, 1, 2, 5, 5, 9, 6, 0, 4, 6, 4, 4, 7, 7, 5, 3,
+        9, 0, 6, 2, 5, 2, 9, 8, 0, 2, 3, 2, 2, 3, 8, 7, 6, 9, 5, 3, 1, 2, 5, 1,
+        4, 9, 0, 1, 1, 6, 1, 1, 9, 3, 8, 4, 7, 6, 5, 6, 2, 5, 7, 4, 5, 0, 5, 8,
+        0, 5, 9, 6, 9, 2, 3, 8, 2, 8, 1, 2, 5, 3, 7, 2, 5, 2, 9, 0, 2, 9, 8, 4,
+        6, 1, 9, 1, 4, 0, 6, 2, 5, 1, 8, 6, 2, 6, 4, 5, 1, 4, 9, 2, 3, 0, 9, 5,
+        7, 0, 3, 1, 2, 5, 9, 3, 1, 3, 2, 2, 5, 7, 4, 6, 1, 5, 4, 7, 8, 5, 1, 5,
+        6, 2, 5, 4, 6, 5, 6, 6, 1, 2, 8, 7, 3, 0, 7, 7, 3, 9, 2, 5, 7, 8, 1, 2,
+        5, 2, 3, 2, 8, 3, 0, 6, 4, 3, 6, 5, 3, 8, 6, 9, 6, 2, 8, 9, 0, 6, 2, 5,
+        1, 1, 6, 4, 1, 5, 3, 2, 1, 8, 2, 6, 9, 3, 4, 8, 1, 4, 4, 5, 3, 1, 2, 5,
+        5, 8, 2, 0, 7, 6, 6, 0, 9, 1, 3, 4, 6, 7, 4, 0, 7, 2, 2, 6, 5, 6, 2, 5,
+        2, 9, 1, 0, 3, 8, 3, 0, 4, 5, 6, 7, 3, 3, 7, 0, 3, 6, 1, 3, 2, 8, 1, 2,
+        5, 1, 4, 5, 5, 1, 9, 1, 5, 2, 2, 8, 3, 6, 6, 8, 5, 1, 8, 0, 6, 6, 4, 0,
+        6, 2, 5, 7, 2, 7, 5, 9, 5, 7, 6, 1, 4, 1, 8, 3, 4, 2, 5, 9, 0, 3, 3, 2,
+        0, 3, 1, 2, 5, 3, 6, 3, 7, 9, 7, 8, 8, 0, 7, 0, 9, 1, 7, 1, 2, 9, 5, 1,
+        6, 6, 0, 1, 5, 6, 2, 5, 1, 8, 1, 8, 9, 8, 9, 4, 0, 3, 5, 4, 5, 8, 5, 6,
+        4, 7, 5, 8, 3, 0, 0, 7, 8, 1, 2, 5, 9, 0, 9, 4, 9, 4, 7, 0, 1, 7, 7, 2,
+        9, 2, 8, 2, 3, 7, 9, 1, 5, 0, 3, 9, 0, 6, 2, 5, 4, 5, 4, 7, 4, 7, 3, 5,
+        0, 8, 8, 6, 4, 6, 4, 1, 1, 8, 9, 5, 7, 5, 1, 9, 5, 3, 1, 2, 5, 2, 2, 7,
+        3, 7, 3, 6, 7, 5, 4, 4, 3, 2, 3, 2, 0, 5, 9, 4, 7, 8, 7, 5, 9, 7, 6, 5,
+        6, 2, 5, 1, 1, 3, 6, 8, 6, 8, 3, 7, 7, 2, 1, 6, 1, 6, 0, 2, 9, 7, 3, 9,
+        3, 7, 9, 8, 8, 2, 8, 1, 2, 5, 5, 6, 8, 4, 3, 4, 1, 8, 8, 6, 0, 8, 0, 8,
+        0, 1, 4, 8, 6, 9, 6, 8, 9, 9, 4, 1, 4, 0, 6, 2, 5, 2, 8, 4, 2, 1, 7, 0,
+        9, 4, 3, 0, 4, 0, 4, 0, 0, 7, 4, 3, 4, 8, 4, 4, 9, 7, 0, 7, 0, 3, 1, 2,
+        5, 1, 4, 2, 1, 0, 8, 5, 4, 7, 1, 5, 2, 0, 2, 0, 0, 3, 7, 1, 7, 4, 2, 2,
+        4, 8, 5, 3, 5, 1, 5, 6, 2, 5, 7, 1, 0, 5, 4, 2, 7, 3, 5, 7, 6, 0, 1, 0,
+        0, 1, 8, 5, 8, 7, 1, 1, 2, 4, 2, 6, 7, 5, 7, 8, 1, 2, 5, 3, 5, 5, 2, 7,
+        1, 3, 6, 7, 8, 8, 0, 0, 5, 0, 0, 9, 2, 9, 3, 5, 5, 6, 2, 1, 3, 3, 7, 8,
+        9, 0, 6, 2, 5, 1, 7, 7, 6, 3, 5, 6, 8, 3, 9, 4, 0, 0, 2, 5, 0, 4, 6, 4,
+        6, 7, 7, 8, 1, 0, 6, 6, 8, 9, 4, 5, 3, 1, 2, 5, 8, 8, 8, 1, 7, 8, 4, 1,
+        9, 7, 0, 0, 1, 2, 5, 2, 3, 2, 3, 3, 8, 9, 0, 5, 3, 3, 4, 4, 7, 2, 6, 5,
+        6, 2, 5, 4, 4, 4, 0, 8, 9, 2, 0, 9, 8, 5, 0, 0, 6, 2, 6, 1, 6, 1, 6, 9,
+        4, 5, 2, 6, 6, 7, 2, 3, 6, 3, 2, 8, 1, 2, 5, 2, 2, 2, 0, 4, 4, 6, 0, 4,
+        9, 2, 5, 0, 3, 1, 3, 0, 8, 0, 8, 4, 7, 2, 6, 3, 3, 3, 6, 1, 8, 1, 6, 4,
+        0, 6, 2, 5, 1, 1, 1, 0, 2, 2, 3, 0, 2, 4, 6, 2, 5, 1, 5, 6, 5, 4, 0, 4,
+        2, 3, 6, 3, 1, 6, 6, 8, 0, 9, 0, 8, 2, 0, 3, 1, 2, 5, 5, 5, 5, 1, 1, 1,
+        5, 1, 2, 3, 1, 2, 5, 7, 8, 2, 7, 0, 2, 1, 1, 8, 1, 5, 8, 3, 4, 0, 4, 5,
+        4, 1, 0, 1, 5, 6, 2, 5, 2, 7, 7, 5, 5, 5, 7, 5, 6, 1, 5, 6, 2, 8, 9, 1,
+        3, 5, 1, 0, 5, 9, 0, 7, 9, 1, 7, 0, 2, 2, 7, 0, 5, 0, 7, 8, 1, 2, 5, 1,
+        3, 8, 7, 7, 7, 8, 7, 8, 0, 7, 8, 1, 4, 4, 5, 6, 7, 5, 5, 2, 9, 5, 3, 9,
+        5, 8, 5, 1, 1, 3, 5, 2, 5, 3, 9, 0, 6, 2, 5, 6, 9, 3, 8, 8, 9, 3, 9, 0,
+        3, 9, 0, 7, 2, 2, 8, 3, 7, 7, 6, 4, 7, 6, 9, 7, 9, 2, 5, 5, 6, 7, 6, 2,
+        6, 9, 5, 3, 1, 2, 5, 3, 4, 6, 9, 4, 4, 6, 9, 5, 1, 9, 5, 3, 6, 1, 4, 1,
+        8, 8, 8, 2, 3, 8, 4, 8, 9, 6, 2, 7, 8, 3, 8, 1, 3, 4, 7, 6, 5, 6, 2, 5,
+        1, 7, 3, 4, 7, 2, 3, 4, 7, 5, 9, 7, 6, 8, 0, 7, 0, 9, 4, 4, 1, 1, 9, 2,
+        4, 4, 8, 1, 3, 9, 1, 9, 0, 6, 7, 3, 8, 2, 8, 1, 2, 5, 8, 6, 7, 3, 6, 1,
+        7, 3, 7, 9, 8, 8, 4, 0, 3, 5, 4, 7, 2, 0, 5, 9, 6, 2, 2, 4, 0, 6, 9, 5,
+        9, 5, 3, 3, 6, 9, 1, 4, 0, 6, 2, 5,
+    };
+    unsigned n_new_digits = (table[shift] >> 11);
+    unsigned pow5_beg = (table[shift] & 0x7ff);
+    unsigned pow5_end = (table[shift+1] & 0x7ff);
+    const unsigned char* pow5 = pow5_digits + pow5_beg;
+    unsigned i;
+
+    for(i = 0; i < pow5_end - pow5_beg; i++) {
+        if(i >= dec->n_digits  ||  dec->digits[i] < pow5[i])
+            return n_new_digits - 1;
+        if(dec->digits[i] > pow5[i])
+            return n_new_digits;
+    }
+    return n_new_digits;
 }
 
-static size_t
-json_string_automaton(JSON_PARSER* parser, const char* input, size_t size,
-                      JSON_TYPE type)
+/* Multiply by 2^shift (shift <= 60). */
+static void
+json_decimal_shl(JSON_DECIMAL* dec, unsigned shift)
 {
-    int ignore_ill_utf8;
-    int fix_ill_utf8;
-    size_t max_len;
-    size_t off = 0;
+    unsigned n_new_digits;
+    unsigned read_index;
+    unsigned write_index;
+    uint64_t n = 0;
 
-    if(type == JSON_KEY) {
-        ignore_ill_utf8 = (parser->config.flags & JSON_IGNOREILLUTF8KEY);
-        fix_ill_utf8 = (parser->config.flags & JSON_FIXILLUTF8KEY);
-        max_len = parser->config.max_key_len;
-    } else {
-        ignore_ill_utf8 = (parser->config.flags & JSON_IGNOREILLUTF8VALUE);
-        fix_ill_utf8 = (parser->config.flags & JSON_FIXILLUTF8VALUE);
-        max_len = parser->config.max_string_len;
+    if(dec->n_digits == 0)
+        return;
+
+    n_new_digits = json_decimal_new_digits(dec, shift);
+    read_index = dec->n_digits;
+    write_index = dec->n_digits + n_new_digits;
+
+    while(read_index > 0) {
+        uint64_t quotient, remainder;
+
+        n += (uint64_t) dec->digits[--read_index] << shift;
+        quotient = n / 10;
+        remainder = n - 10 * quotient;
+        write_index--;
+        if(write_index < DECIMAL_MAX_DIGITS)
+            dec->digits[write_index] = (unsigned char) remainder;
+        else if(remainder > 0)
+            dec->truncated = 1;
+        n = quotient;
     }
 
-    if(max_len > 0)
-        max_len++;  /* +1 for the final quotes. */
+    while(n > 0) {
+        uint64_t quotient, remainder;
+
+        quotient = n / 10;
+        remainder = n - 10 * quotient;
+        write_index--;
+        if(write_index < DECIMAL_MAX_DIGITS)
+            dec->digits[write_index] = (unsigned char) remainder;
+        else if(remainder > 0)
+            dec->truncated = 1;
+        n = quotient;
+    }
 
-    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset + size > max_len)
-        size = max_len - (parser->pos.offset - parser->value_pos.offset) + 1;
+    dec->n_digits += n_new_digits;
+    if(dec->n_digits > DECIMAL_MAX_DIGITS)
+        dec->n_digits = DECIMAL_MAX_DIGITS;
+    dec->dp += (int) n_new_digits;
+    json_decimal_trim(dec);
+}
+
+/* Divide by 2^shift (shift <= 60). */
+static void
+json_decimal_shr(JSON_DECIMAL* dec, unsigned shift)
+{
+    unsigned read_index = 0;
+    unsigned write_index = 0;
+    uint64_t mask = ((uint64_t) 1 << shift) - 1;
+    uint64_t n = 0;
+
+    while((n >> shift) == 0) {
+        if(read_index < dec->n_digits) {
+            n = 10 * n + dec->digits[read_index++];
+        } else if(n == 0) {
+            return;
+        } else {
+            while((n >> shift) == 0) {
+                n = 10 * n;
+                read_index++;
+            }
+            break;
+        }
+    }
+
+    dec->dp -= (int) read_index - 1;
+    if(dec->dp < -DECIMAL_DP_RANGE) {
+        /* Zero. */
+        dec->n_digits = 0;
+        dec->dp = 0;
+        dec->truncated = 0;
+        return;
+    }
+
+    while(read_index < dec->n_digits) {
+        unsigned char new_digit = (unsigned char) (n >> shift);
+        n = 10 * (n & mask) + dec->digits[read_index++];
+        dec->digits[write_index++] = new_digit;
+    }
+
+    while(n > 0) {
+        unsigned char new_digit = (unsigned char) (n >> shift);
+        n = 10 * (n & mask);
+        if(write_index < DECIMAL_MAX_DIGITS)
+            dec->digits[write_index++] = new_digit;
+        else if(new_digit > 0)
+            dec->truncated = 1;
+    }
+
+    dec->n_digits = write_index;
+    json_decimal_trim(dec);
+}
+
+/* Integer part of the decimal, rounded to nearest (ties to even). */
+static uint64_t
+json_decimal_round(const JSON_DECIMAL* dec)
+{
+    uint64_t n = 0;
+    unsigned dp;
+    unsigned i;
+    int round_up = 0;
+
+    if(dec->n_digits == 0  ||  dec->dp < 0)
+        return 0;
+    if(dec->dp > 18)
+        return UINT64_MAX;
+
+    dp = (unsigned) dec->dp;
+    for(i = 0; i < dp; i++)
+        n = 10 * n + ((i < dec->n_digits) ? dec->digits[i] : 0);
+
+    if(dp < dec->n_digits) {
+        round_up = (dec->digits[dp] >= 5);
+        if(dec->digits[dp] == 5  &&  dp + 1 == dec->n_digits)
+            round_up = (dec->truncated  ||  (dp > 0  &&  (dec->digits[dp-1] & 1)));
+    }
+
+    if(round_up)
+        n++;
+    return n;
+}
+
+/* Bits of the double nearest to the decimal number (w/o the sign). */
+static uint64_t
+json_decimal_to_bits(JSON_DECIMAL* dec)
+{
+    /* Shifts which keep the decimal point in the same place for the given
+     * count of digits. */
+    static const unsigned char shifts[19] = {
+        0, 3, 6, 9, 13, 16, 19, 23, 26, 29, 33, 36, 39, 43, 46, 49, 53, 56, 59
+    };
+    static const unsigned max_shift = 60;
+    static const uint64_t inf_bits = (uint64_t) DBL_EXP_INF << DBL_MANTISSA_BITS;
+    int exp2 = 0;
+    uint64_t mantissa;
+    unsigned shift;
+    unsigned n;
+
+    if(dec->n_digits == 0  ||  dec->dp < -324)
+        return 0;
+    if(dec->dp >= 310)
+        return inf_bits;
+
+    /* Divide by powers of 2 until the value is below 1. */
+    while(dec->dp > 0) {
+        n = (unsigned) dec->dp;
+        shift = (n < sizeof(shifts)) ? shifts[n] : max_shift;
+        json_decimal_shr(dec, shift);
+        if(dec->dp < -DECIMAL_DP_RANGE)
+            return 0;
+        exp2 += (int) shift;
+    }
+
+    /* Multiply by powers of 2 until the value is in [1/2, 1). */
+    while(dec->dp <= 0) {
+        if(dec->dp == 0) {
+            if(dec->digits[0] >= 5)
+                break;
+            shift = (dec->digits[0] < 2) ? 2 : 1;
+        } else {
+            n = (unsigned) -dec->dp;
+            shift = (n < sizeof(shifts)) ? shifts[n] : max_shift;
+        }
+        json_decimal_shl(dec, shift);
+        if(dec->dp > DECIMAL_DP_RANGE)
+            return inf_bits;
+        exp2 -= (int) shift;
+    }
+
+    /* Now, the value is in [1/2, 1) but the double wants [1, 2). */
+    exp2--;
+
+    /* Subnormal numbers: Denormalize. */
+    while(exp2 < -DBL_EXP_BIAS + 1) {
+        n = (unsigned) (-DBL_EXP_BIAS + 1 - exp2);
+        if(n > max_shift)
+            n = max_shift;
+        json_decimal_shr(dec, n);
+        exp2 += (int) n;
+    }
+
+    if(exp2 + DBL_EXP_BIAS >= DBL_EXP_INF)
+        return inf_bits;
+
+    /* Extract the mantissa (53 bits) and round it. */
+    json_decimal_shl(dec, DBL_MANTISSA_BITS + 1);
+    mantissa = json_decimal_round(dec);
+    if(mantissa >= ((uint64_t) 1 << (DBL_MANTISSA_BITS + 1))) {
+        /* Rounding overflowed into one more bit. */
+        json_decimal_shr(dec, 1);
+        exp2++;
+        mantissa = json_decimal_round(dec);
+        if(exp2 + DBL_EXP_BIAS >= DBL_EXP_INF)
+            return inf_bits;
+    }
+
+    exp2 += DBL_EXP_BIAS;
+    if(mantissa < ((uint64_t) 1 << DBL_MANTISSA_BITS))
+        exp2--;     /* Subnormal. */
+
+    return (mantissa & DBL_MANTISSA_MASK) | ((uint64_t) exp2 << DBL_MANTISSA_BITS);
+}
+
+/* Convert the number `num` (of the JSON syntax) to double. Caller has already
+ * decomposed it into w * 10^q where w holds the leading significant digits;
+ * `is_inexact` says whether any non-zero digit did not fit into w. */
+static double
+json_decimal_to_double(uint64_t w, int q, int is_neg, int is_inexact,
+                       const char* num, size_t num_size)
+{
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    uint64_t bits;
+    double d;
+
+    if(w == 0  ||  q < POW5_MIN_EXP) {
+        bits = 0;
+    } else if(q > POW5_MAX_EXP) {
+        bits = (uint64_t) DBL_EXP_INF << DBL_MANTISSA_BITS;
+    } else if(!is_inexact  &&  w <= ((uint64_t) 1 << 53)  &&  -22 <= q  &&  q <= 22) {
+        /* Both w and 10^q are exact so a single operation rounds correctly. */
+        d = (double) w;
+        if(q < 0)
+            d /= pow10[-q];
+        else
+            d *= pow10[q];
+        return (is_neg ? -d : d);
+    } else {
+        int ok = (json_eisel_lemire(w, q, &bits) == 0);
+
+        /* If some digits are missing, w * 10^q and (w+1) * 10^q have to end up
+         * on the same double. */
+        if(ok  &&  is_inexact) {
+            uint64_t bits2;
+
+            ok = (w < UINT64_MAX  &&  json_eisel_lemire(w + 1, q, &bits2) == 0  &&
+                  bits == bits2);
+        }
+
+        if(!ok) {
+            JSON_DECIMAL dec;
+
+            json_decimal_init(&dec, num, num_size);
+            bits = json_decimal_to_bits(&dec);
+        }
+    }
+
+    if(is_neg)
+        bits |= (uint64_t) 1 << 63;
+    memcpy(&d, &bits, sizeof(double));
+    return d;
+}
+
+
+/* Bits for JSON_PARSER::num_flags. */
+#define NUM_NEGATIVE        0x0001
+#define NUM_NOTINTEGER      0x0002  /* Has fraction and/or exponent */
+#define NUM_EXPNEGATIVE     0x0004
+#define NUM_DROPPED         0x0008  /* Some digits did not fit in num_mantissa */
+#define NUM_INEXACT         0x0010  /* ... and some of them were non-zero */
+
+static inline void
+json_number_reset(JSON_PARSER* parser)
+{
+    parser->num_mantissa = 0;
+    parser->num_exp_adjust = 0;
+    parser->num_exp = 0;
+    parser->num_flags = 0;
+}
+
+/* Accumulate a digit of the mantissa. Once it does not fit into the uint64_t
+ * anymore, we just count the digits to get the exponent right. */
+static inline void
+json_number_digit(JSON_PARSER* parser, int ch, int is_fraction)
+{
+    unsigned digit = ch - '0';
+
+    if(!(parser->num_flags & NUM_DROPPED)  &&
+       parser->num_mantissa <= (UINT64_MAX - digit) / 10)
+    {
+        parser->num_mantissa = parser->num_mantissa * 10 + digit;
+        if(is_fraction)
+            parser->num_exp_adjust--;
+    } else {
+        parser->num_flags |= NUM_DROPPED;
+        if(digit != 0)
+            parser->num_flags |= NUM_INEXACT;
+        if(!is_fraction)
+            parser->num_exp_adjust++;
+    }
+}
+
+static inline void
+json_number_exp_digit(JSON_PARSER* parser, int ch)
+{
+    /* Anything above this is out of range of double anyway. */
+    if(parser->num_exp < 100000000)
+        parser->num_exp = parser->num_exp * 10 + (ch - '0');
+}
+
+/* Build JSON_PARSER::num_info from what the number automaton (or scanner)
+ * has accumulated. */
+static void
+json_number_finish(JSON_PARSER* parser, const char* data, size_t size)
+{
+    JSON_NUMBER_INFO* info = &parser->num_info;
+    uint64_t m = parser->num_mantissa;
+    int is_neg = (parser->num_flags & NUM_NEGATIVE);
+    int64_t exp;
+
+    if(!(parser->num_flags & (NUM_NOTINTEGER | NUM_DROPPED))) {
+        if(!is_neg) {
+            if(m <= INT32_MAX) {
+                info->num_class = JSON_NUMBER_INT32;
+                info->value.i32 = (int32_t) m;
+                return;
+            } else if(m <= UINT32_MAX) {
+                info->num_class = JSON_NUMBER_UINT32;
+                info->value.u32 = (uint32_t) m;
+                return;
+            } else if(m <= INT64_MAX) {
+                info->num_class = JSON_NUMBER_INT64;
+                info->value.i64 = (int64_t) m;
+                return;
+            } else {
+                info->num_class = JSON_NUMBER_UINT64;
+                info->value.u64 = m;
+                return;
+            }
+        } else {
+            /* (Note "-0" ends here as 0.) */
+            if(m <= (uint64_t) INT32_MAX + 1) {
+                info->num_class = JSON_NUMBER_INT32;
+                info->value.i32 = (m != 0) ? -(int32_t)(m - 1) - 1 : 0;
+                return;
+            } else if(m <= (uint64_t) INT64_MAX + 1) {
+                info->num_class = JSON_NUMBER_INT64;
+                info->value.i64 = -(int64_t)(m - 1) - 1;
+                return;
+            }
+        }
+    }
+
+    info->num_class = JSON_NUMBER_DOUBLE;
+
+    exp = parser->num_exp_adjust;
+    if(parser->num_flags & NUM_EXPNEGATIVE)
+        exp -= parser->num_exp;
+    else
+        exp += parser->num_exp;
+
+    /* (Out of this range, the double is zero or infinity anyway.) */
+    if(exp < POW5_MIN_EXP - 1)
+        exp = POW5_MIN_EXP - 1;
+    else if(exp > POW5_MAX_EXP + 1)
+        exp = POW5_MAX_EXP + 1;
+
+    info->value.d = json_decimal_to_double(m, (int) exp, is_neg,
+                (parser->num_flags & NUM_INEXACT), data, size);
+}
+
+/* Report a complete number. */
+static void
+json_process_number(JSON_PARSER* parser, const char* data, size_t size)
+{
+    if(parser->errcode != 0)
+        return;
+
+    /* Decode the number only if anyone asked for it (see JSON_NUMBERINFO). */
+    if(((parser->config.flags & JSON_NUMBERINFO)  ||
+        (parser->callbacks.process == NULL  &&  parser->callbacks_ex.on_number_info != NULL))  &&
+       json_wants_data(parser, JSON_NUMBER))
+    {
+        json_number_finish(parser, data, size);
+    }
+
+    json_process(parser, JSON_NUMBER, data, size);
+}
+
+const JSON_NUMBER_INFO*
+json_number_info(const JSON_PARSER* parser)
+{
+    return &parser->num_info;
+}
+
+static int
+json_buf_append(JSON_PARSER* parser, const char* data, size_t size)
+{
+    if(parser->buf_used + size > parser->buf_alloced) {
+        char* new_buf;
+        size_t new_alloced = (parser->buf_used + size) * 2;
+
+        new_buf = (char *) json_realloc(parser->config.allocator, parser->buf, new_alloced);
+        if(new_buf == NULL) {
+            json_raise(parser, JSON_ERR_OUTOFMEMORY);
+            return -1;
+        }
+
+        parser->buf = new_buf;
+        parser->buf_alloced = new_alloced;
+    }
+
+    memcpy(parser->buf + parser->buf_used, data, size);
+    parser->buf_used += size;
+    return 0;
+}
+
+/* Encode the codepoint into UTF-8. The buffer has to have room for 4 bytes.
+ * Returns the count of bytes written. */
+static size_t
+json_encode_utf8(uint32_t codepoint, char* buffer)
+{
+    if(codepoint <= 0x7f) {
+        buffer[0] = codepoint;
+        return 1;
+    } else if(codepoint <= 0x7ff) {
+        buffer[0] = 0xc0 | ((codepoint >> 6) & 0x1f);
+        buffer[1] = 0x80 | ((codepoint >> 0) & 0x3f);
+        return 2;
+    } else if(codepoint <= 0xffff) {
+        buffer[0] = 0xe0 | ((codepoint >> 12) & 0x0f);
+        buffer[1] = 0x80 | ((codepoint >> 6) & 0x3f);
+        buffer[2] = 0x80 | ((codepoint >> 0) & 0x3f);
+        return 3;
+    } else {
+        buffer[0] = 0xf0 | ((codepoint >> 18) & 0x07);
+        buffer[1] = 0x80 | ((codepoint >> 12) & 0x3f);
+        buffer[2] = 0x80 | ((codepoint >> 6) & 0x3f);
+        buffer[3] = 0x80 | ((codepoint >> 0) & 0x3f);
+        return 4;
+    }
+}
+
+static int
+json_buf_append_codepoint(JSON_PARSER* parser, uint32_t codepoint)
+{
+    char tmp[4];
+    size_t n;
+
+    n = json_encode_utf8(codepoint, tmp);
+    return json_buf_append(parser, tmp, n);
+}
+
+
+/*************************
+ *** SIMD acceleration ***
+ *************************/
+
+/* On x86 and x86_64, some hot loops below scan the input in 16-byte (SSE2)
+ * or 32-byte (AVX2) blocks. SSE2 is assumed whenever the compiler targets it
+ * (always true for x86_64); AVX2 is used only if detected at run time.
+ *
+ * Everything has a portable fallback, so this is purely a speed thing. Define
+ * JSON_NO_SIMD to disable it altogether.
+ */
+#ifndef JSON_NO_SIMD
+    #if defined __SSE2__  ||  defined _M_X64  ||  (defined _M_IX86_FP && _M_IX86_FP >= 2)
+        #define JSON_SSE2       1
+        #include <emmintrin.h>
+    #endif
+
+    #if defined JSON_SSE2  &&  (defined __GNUC__ || defined __clang__ || defined _MSC_VER)
+        #define JSON_AVX2       1
+        #include <immintrin.h>
+        #ifdef _MSC_VER
+            #include <intrin.h>
+            #define JSON_TARGET_AVX2
+        #else
+            #define JSON_TARGET_AVX2    __attribute__((target("avx2")))
+        #endif
+    #endif
+#endif
+
+#ifdef JSON_SSE2
+
+/* Index of the lowest set bit. (`mask` must not be zero.) */
+static inline unsigned
+json_ctz(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned) index;
+#else
+    return (unsigned) __builtin_ctz(mask);
+#endif
+}
+
+/* Index of the highest set bit. (`mask` must not be zero.) */
+static inline unsigned
+json_bsr(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return (unsigned) index;
+#else
+    return 31 - (unsigned) __builtin_clz(mask);
+#endif
+}
+
+/* Returns offset of the first byte which is neither ' ' nor '\t', or offset
+ * of the incomplete tail block (shorter then 16 bytes). */
+static size_t
+json_sse2_span_blanks(const char* str, size_t size, int new_lines)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8(new_lines ? '\r' : ' ');
+    const __m128i lf = _mm_set1_epi8(new_lines ? '\n' : ' ');
+    size_t off = 0;
+
+    while(off + 16 <= size) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(str + off));
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab)),
+                    _mm_or_si128(_mm_cmpeq_epi8(x, cr), _mm_cmpeq_epi8(x, lf))));
+
+        if(mask != 0xffff)
+            return off + json_ctz(~mask);
+        off += 16;
+    }
+
+    return off;
+}
+
+/* Returns offset of the first byte in a string body which needs special care
+ * (i.e. '"', '\\', control char or non-ASCII byte), or offset of the incomplete
+ * tail block. */
+static size_t
+json_sse2_span_plain(const char* str, size_t size)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(' ');
+    size_t off = 0;
+
+    while(off + 16 <= size) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(str + off));
+        /* Signed comparison: Both controls and non-ASCII bytes are less
+         * then ' '. */
+        __m128i special = _mm_or_si128(_mm_cmplt_epi8(x, space),
+                    _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)));
+        unsigned mask = (unsigned) _mm_movemask_epi8(special);
+
+        if(mask != 0)
+            return off + json_ctz(mask);
+        off += 16;
+    }
+
+    return off;
+}
+
+#endif  /* JSON_SSE2 */
+
+#ifdef JSON_AVX2
+
+static int
+json_cpu_has_avx2(void)
+{
+    /* -1 means "not detected yet". (Concurrent detection from more threads
+     * is harmless as they all come to the same conclusion.) */
+    static int has_avx2 = -1;
+
+    if(has_avx2 < 0) {
+#ifdef _MSC_VER
+        int info[4];
+        int res = 0;
+
+        __cpuid(info, 0);
+        if(info[0] >= 7) {
+            __cpuid(info, 1);
+            /* The OS has to support saving the YMM registers too (OSXSAVE). */
+            if((info[2] & (1 << 27))  &&  (info[2] & (1 << 28))  &&
+               (_xgetbv(0) & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                res = ((info[1] & (1 << 5)) != 0);
+            }
+        }
+        has_avx2 = res;
+#else
+        __builtin_cpu_init();
+        has_avx2 = (__builtin_cpu_supports("avx2") ? 1 : 0);
+#endif
+    }
+
+    return has_avx2;
+}
+
+JSON_TARGET_AVX2 static size_t
+json_avx2_span_blanks(const char* str, size_t size, int new_lines)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8(new_lines ? '\r' : ' ');
+    const __m256i lf = _mm256_set1_epi8(new_lines ? '\n' : ' ');
+    size_t off = 0;
+
+    while(off + 32 <= size) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(str + off));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(_mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(x, space), _mm256_cmpeq_epi8(x, tab)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(x, cr), _mm256_cmpeq_epi8(x, lf))));
+
+        if(mask != 0xffffffff)
+            return off + json_ctz(~mask);
+        off += 32;
+    }
+
+    return off;
+}
+
+JSON_TARGET_AVX2 static size_t
+json_avx2_span_plain(const char* str, size_t size)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(' ');
+    size_t off = 0;
+
+    while(off + 32 <= size) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(str + off));
+        __m256i special = _mm256_or_si256(_mm256_cmpgt_epi8(space, x),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, backslash)));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(special);
+
+        if(mask != 0)
+            return off + json_ctz(mask);
+        off += 32;
+    }
+
+    return off;
+}
+
+/* UTF-8 validation using the lookup-table approach by John Keiser and Daniel
+ * Lemire ("Validating UTF-8 In Less Than One Instruction Per Byte", 2020).
+ *
+ * Each byte is classified by three 16-entry tables (indexed by the high and
+ * low nibble of the previous byte, and by the high nibble of the current
+ * byte). Every bit in the tables stands for one kind of error, so the byte is
+ * ill-formed iff the three lookups have some bit in common. The only errors
+ * not caught this way (missing 3rd or 4th byte of a sequence) are checked
+ * separately from the bytes two and three positions back.
+ */
+#define UTF8_TOO_SHORT      0x01    /* 11______ 0_______  or  11______ 11______ */
+#define UTF8_TOO_LONG       0x02    /* 0_______ 10______ */
+#define UTF8_OVERLONG_3     0x04    /* 11100000 100_____ */
+#define UTF8_TOO_LARGE      0x08    /* 11110100 1001____  ...etc. */
+#define UTF8_SURROGATE      0x10    /* 11101101 101_____ */
+#define UTF8_OVERLONG_2     0x20    /* 1100000_ 10______ */
+#define UTF8_TOO_LARGE_1000 0x40    /* 11110101 1000____  ...etc. */
+#define UTF8_OVERLONG_4     0x40    /* 11110000 1000____ */
+#define UTF8_TWO_CONTS      0x80    /* 10______ 10______ */
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static const char json_utf8_byte1_high[16] = {
+    /* 0_______ (ASCII) */
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    /* 10______ (continuation) */
+    (char) UTF8_TWO_CONTS, (char) UTF8_TWO_CONTS, (char) UTF8_TWO_CONTS, (char) UTF8_TWO_CONTS,
+    /* 1100____ */
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    /* 1101____ */
+    UTF8_TOO_SHORT,
+    /* 1110____ */
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    /* 1111____ */
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+static const char json_utf8_byte1_low[16] = {
+    /* ____0000 */
+    (char) (UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+    /* ____0001 */
+    (char) (UTF8_CARRY | UTF8_OVERLONG_2),
+    /* ____001_ */
+    (char) UTF8_CARRY,
+    (char) UTF8_CARRY,
+    /* ____0100 */
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE),
+    /* ____0101 ... ____1111 */
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    /* ____1101 */
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char) (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000)
+};
+
+static const char json_utf8_byte2_high[16] = {
+    /* 0_______ (ASCII) */
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    /* 1000____ */
+    (char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4),
+    /* 1001____ */
+    (char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+    /* 101_____ */
+    (char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+    (char) (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+    /* 11______ */
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+/* Returns offset of the first byte which is '"', '\\', control char, or where
+ * the UTF-8 gets ill-formed. (Note the last character before that offset may
+ * be incomplete.) */
+JSON_TARGET_AVX2 static size_t
+json_avx2_span_utf8(const char* str, size_t size)
+{
+    const __m256i byte1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) json_utf8_byte1_high));
+    const __m256i byte1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) json_utf8_byte1_low));
+    const __m256i byte2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) json_utf8_byte2_high));
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i max_control = _mm256_set1_epi8(0x1f);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i prev = zero;
+    char tail[32];
+    size_t off = 0;
 
     while(off < size) {
-        char ch = input[off];
+        __m256i x, prev1, prev2, prev3, tmp, special, err;
+        unsigned mask;
+
+        if(off + 32 <= size) {
+            x = _mm256_loadu_si256((const __m256i*)(str + off));
+        } else {
+            /* Pad the incomplete tail block with quotes so it stops us. */
+            memset(tail, '\"', sizeof(tail));
+            memcpy(tail, str + off, size - off);
+            x = _mm256_loadu_si256((const __m256i*) tail);
+        }
+
+        /* Vector of the preceding bytes (shifted by 1, 2 and 3 positions). */
+        tmp = _mm256_permute2x128_si256(prev, x, 0x21);
+        prev1 = _mm256_alignr_epi8(x, tmp, 16 - 1);
+        prev2 = _mm256_alignr_epi8(x, tmp, 16 - 2);
+        prev3 = _mm256_alignr_epi8(x, tmp, 16 - 3);
+
+        err = _mm256_and_si256(
+                _mm256_and_si256(
+                    _mm256_shuffle_epi8(byte1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask)),
+                    _mm256_shuffle_epi8(byte1_low, _mm256_and_si256(prev1, nibble_mask))),
+                _mm256_shuffle_epi8(byte2_high, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble_mask)));
+
+        /* Bytes which must be 3rd or 4th byte of a multi-byte sequence. Note
+         * the table lookup above has set 0x80 (TWO_CONTS) for all
+         * continuation bytes following another one, so the XOR cancels the
+         * bit where it is expected and sets it where it is missing. */
+        tmp = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8((char) (0xe0 - 0x80))),
+                              _mm256_subs_epu8(prev3, _mm256_set1_epi8((char) (0xf0 - 0x80))));
+        err = _mm256_xor_si256(err, _mm256_and_si256(tmp, _mm256_set1_epi8((char) 0x80)));
+
+        special = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(x, max_control), x),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, backslash)));
+        special = _mm256_or_si256(special, _mm256_xor_si256(_mm256_cmpeq_epi8(err, zero), _mm256_set1_epi8(-1)));
+        mask = (unsigned) _mm256_movemask_epi8(special);
+
+        if(mask != 0)
+            return off + json_ctz(mask);
+        prev = x;
+        off += 32;
+    }
+
+    return size;
+}
+
+#endif  /* JSON_AVX2 */
+
+/* Get length of the run of blanks (' ' or '\t') at the start of `str`. If
+ * `new_lines` is non-zero, '\r' and '\n' are eaten too. */
+#define IS_SPAN_BLANK(ch, new_lines)                                        \
+            ((ch) == ' ' || (ch) == '\t' ||                                 \
+             ((new_lines) && ((ch) == '\r' || (ch) == '\n')))
+
+static size_t
+json_span_blanks(const char* str, size_t size, int new_lines)
+{
+    size_t off = 0;
+
+    /* Short runs are common (e.g. a space after ':'). Do not bother SIMD
+     * with them. */
+    while(off < size  &&  IS_SPAN_BLANK(str[off], new_lines)) {
+        off++;
+        if(off == 8)
+            break;
+    }
+    if(off < 8)
+        return off;
+
+#ifdef JSON_AVX2
+    if(size - off >= 32  &&  json_cpu_has_avx2()) {
+        off += json_avx2_span_blanks(str + off, size - off, new_lines);
+        if(off + 32 <= size)
+            return off;
+    }
+#endif
+#ifdef JSON_SSE2
+    if(size - off >= 16) {
+        off += json_sse2_span_blanks(str + off, size - off, new_lines);
+        if(off + 16 <= size)
+            return off;
+    }
+#endif
+
+    while(off < size  &&  IS_SPAN_BLANK(str[off], new_lines))
+        off++;
+    return off;
+}
+
+/* Get length of the run of bytes at the start of `str` which need no special
+ * care when inside a string, i.e. ASCII chars except controls, '"' and '\\'. */
+static size_t
+json_span_plain(const char* str, size_t size)
+{
+    size_t off = 0;
+
+    /* Short runs are common (e.g. object keys). Do not bother SIMD with
+     * them. */
+    while(off < size  &&  IS_ASCII(str[off])  &&  !IS_CONTROL(str[off])
+             &&  str[off] != '\\'  &&  str[off] != '\"')
+    {
+        off++;
+        if(off == 16)
+            break;
+    }
+    if(off < 16)
+        return off;
+
+#ifdef JSON_AVX2
+    if(size - off >= 32  &&  json_cpu_has_avx2()) {
+        off += json_avx2_span_plain(str + off, size - off);
+        if(off + 32 <= size)
+            return off;
+    }
+#endif
+#ifdef JSON_SSE2
+    if(size - off >= 16) {
+        off += json_sse2_span_plain(str + off, size - off);
+        if(off + 16 <= size)
+            return off;
+    }
+#endif
+
+    while(off < size  &&  IS_ASCII(str[off])  &&  !IS_CONTROL(str[off])
+             &&  str[off] != '\\'  &&  str[off] != '\"')
+        off++;
+    return off;
+}
+
+/* Get length of the run of complete and well-formed UTF-8 characters at the
+ * start of `str` which need no special care when inside a string, i.e. any
+ * but controls, '"' and '\\'.
+ *
+ * (See the table in json_string_automaton() for what is well-formed.) */
+static size_t
+json_span_utf8(const char* str, size_t size)
+{
+    size_t off = 0;
+
+#ifdef JSON_AVX2
+    if(json_cpu_has_avx2()) {
+        size_t i;
+
+        off = json_avx2_span_utf8(str, size);
+
+        /* Do not end in the middle of a multi-byte character. */
+        i = off;
+        while(i > 0  &&  off - i < 3  &&  ((unsigned char) str[i-1] & 0xc0) == 0x80)
+            i--;
+        if(i > 0  &&  (unsigned char) str[i-1] >= 0xc0) {
+            unsigned char lead = (unsigned char) str[i-1];
+            size_t len = (lead >= 0xf0 ? 4 : (lead >= 0xe0 ? 3 : 2));
+            if(off - (i-1) < len)
+                off = i-1;
+        }
+        return off;
+    }
+#endif
+
+    while(off < size) {
+        unsigned char ch = (unsigned char) str[off];
+        unsigned char lo = 0x80, hi = 0xbf;
+        size_t len, i;
+
+        if(ch < 0x80) {
+            if(IS_CONTROL(ch)  ||  ch == '\\'  ||  ch == '\"')
+                break;
+            off++;
+            continue;
+        }
+
+        if(IS_IN(ch, 0xc2, 0xdf))       len = 2;
+        else if(ch == 0xe0)             { len = 3; lo = 0xa0; }
+        else if(IS_IN(ch, 0xe1, 0xec))  len = 3;
+        else if(ch == 0xed)             { len = 3; hi = 0x9f; }
+        else if(IS_IN(ch, 0xee, 0xef))  len = 3;
+        else if(ch == 0xf0)             { len = 4; lo = 0x90; }
+        else if(IS_IN(ch, 0xf1, 0xf3))  len = 4;
+        else if(ch == 0xf4)             { len = 4; hi = 0x8f; }
+        else                            break;
+
+        if(off + len > size  ||  !IS_IN(str[off+1], lo, hi))
+            break;
+        for(i = 2; i < len; i++) {
+            if(!IS_IN(str[off+i], 0x80, 0xbf))
+                break;
+        }
+        if(i < len)
+            break;
+        off += len;
+    }
+
+    return off;
+}
+
+
+/* Get length of the run of chars at the start of `str` which can be copied
+ * verbatim into the string being parsed. */
+static size_t
+json_span_string_chars(const char* str, size_t size, int ignore_ill_utf8)
+{
+    size_t off = 0;
+    size_t n;
+
+    while(1) {
+        off += json_span_plain(str + off, size - off);
+        if(off >= size  ||  IS_ASCII(str[off]))
+            break;
+
+        if(ignore_ill_utf8) {
+            n = 0;
+            while(off + n < size  &&  !IS_ASCII(str[off + n]))
+                n++;
+        } else {
+            n = json_span_utf8(str + off, size - off);
+            if(n == 0)
+                break;
+        }
+        off += n;
+    }
+
+    return off;
+}
+
+/* Check whether `str` begins with the literal ("null", "true" or "false").
+ * The caller has to make sure there are at least `literal_size` bytes.
+ *
+ * The first four bytes are compared as a single word. */
+static inline int
+json_match_literal(const char* str, const char* literal, size_t literal_size)
+{
+    uint32_t str_word;
+    uint32_t literal_word;
+
+    memcpy(&str_word, str, 4);
+    memcpy(&literal_word, literal, 4);
+    return (str_word == literal_word  &&
+            (literal_size == 4  ||  str[4] == literal[4]));
+}
+
+static size_t
+json_literal_automaton(JSON_PARSER* parser, const char* input, size_t size,
+                       JSON_TYPE type, const char* literal, size_t literal_size)
+{
+    size_t off = 0;
+
+    /* Fast path: The whole literal and the char following it are in the
+     * input. (The loop below is then only for literals split between two
+     * blocks of the input, or for reporting an error.) */
+    if(parser->substate == 0  &&  size > literal_size  &&
+       json_match_literal(input, literal, literal_size))
+    {
+        off = literal_size;
+        parser->pos.offset += literal_size;
+        parser->pos.column_number += (unsigned) literal_size;
+        parser->substate = (unsigned) literal_size;
+    }
+
+    /* In this automaton, we use substate as a character count of the literal
+     * we have already seen. */
+    while(parser->substate < literal_size  &&  off < size) {
+        int ch = input[off];
+
+        if(ch != literal[parser->substate]) {
+            json_raise_for_value(parser, JSON_ERR_SYNTAX);
+            return 0;
+        }
+
+        off++;
+        parser->pos.offset++;
+        parser->pos.column_number++;
+        parser->substate++;
+    }
+
+    /* Check the literal is really complete and there is not some unexpected
+     * tail. (If so, we want to raise the problem for whole literal. */
+    if(off < size  &&  !IS_TOKEN_BOUNDARY(input[off])) {
+        memcpy(&parser->pos, &parser->value_pos, sizeof(JSON_INPUT_POS));
+        json_raise(parser, JSON_ERR_SYNTAX);
+    } else if(input == NULL  /* EOF */  ||
+       (off < size  &&  IS_TOKEN_BOUNDARY(input[off]))) {
+        json_process(parser, type, NULL, 0);
+    }
+    return off;
+}
+
+static size_t
+json_number_automaton(JSON_PARSER* parser, const char* input, size_t size)
+{
+    static const unsigned can_see_m_sign        = 0x0001;   /* Mantissa */
+    static const unsigned can_see_m_first_digit = 0x0002;
+    static const unsigned can_see_m_digit       = 0x0004;
+    static const unsigned can_see_f_delimeter   = 0x0010;   /* Fraction */
+    static const unsigned can_see_f_digit       = 0x0020;
+    static const unsigned can_see_e_delim       = 0x0100;   /* Exponent */
+    static const unsigned can_see_e_sign        = 0x0200;
+    static const unsigned can_see_e_digit       = 0x0400;
+    static const unsigned can_see_end           = 0x1000;   /* End of number */
+
+    size_t off = 0;
+    size_t max_len = parser->config.max_number_len;
+    int collect = json_wants_data(parser, JSON_NUMBER);
+
+    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset + size > max_len)
+        size = max_len - (parser->pos.offset - parser->value_pos.offset) + 1;
+
+    if(parser->substate == 0) {
+        parser->substate = can_see_m_sign | can_see_m_first_digit;
+        json_number_reset(parser);
+    }
+
+    while(off < size) {
+        int ch = input[off];
+
+        if((parser->substate & can_see_m_sign)  &&  ch == '-') {    /* '+' not allowed here. */
+            parser->substate = can_see_m_first_digit;
+            parser->num_flags |= NUM_NEGATIVE;
+        } else if((parser->substate & can_see_m_first_digit)  &&  IS_DIGIT(ch)) {
+            parser->substate = can_see_m_digit | can_see_f_delimeter | can_see_e_delim | can_see_end;
+            /* There cannot be any follow-up digit if mantissa begins with zero. */
+            if(ch == '0')
+                parser->substate &= ~can_see_m_digit;
+            json_number_digit(parser, ch, 0);
+        } else if((parser->substate & can_see_m_digit)  &&  IS_DIGIT(ch)) {
+            parser->substate = can_see_m_digit | can_see_f_delimeter | can_see_e_delim | can_see_end;
+            json_number_digit(parser, ch, 0);
+        } else if((parser->substate & can_see_f_delimeter)  &&  ch == '.') {
+            parser->substate = can_see_f_digit;
+            parser->num_flags |= NUM_NOTINTEGER;
+        } else if((parser->substate & can_see_f_digit)  &&  IS_DIGIT(ch)) {
+            parser->substate = can_see_f_digit | can_see_e_delim | can_see_end;
+            json_number_digit(parser, ch, 1);
+        } else if((parser->substate & can_see_e_delim)  &&  (ch == 'e' || ch == 'E')) {
+            parser->substate = can_see_e_sign | can_see_e_digit;
+            parser->num_flags |= NUM_NOTINTEGER;
+        } else if((parser->substate & can_see_e_sign)  &&  (ch == '+' || ch == '-')) {
+            parser->substate = can_see_e_digit;
+            if(ch == '-')
+                parser->num_flags |= NUM_EXPNEGATIVE;
+        } else if((parser->substate & can_see_e_digit)  &&  IS_DIGIT(ch)) {
+            parser->substate = can_see_e_digit | can_see_end;
+            json_number_exp_digit(parser, ch);
+        } else if((parser->substate & can_see_end)  &&  IS_TOKEN_BOUNDARY(ch)) {
+            /* Success. */
+            if(parser->buf_used == 0  ||  !collect) {
+                json_process_number(parser, input, off);
+            } else {
+                if(json_buf_append(parser, input, off) != 0)
+                    return 0;
+                json_process_number(parser, parser->buf, parser->buf_used);
+            }
+            return off;
+        } else {
+            json_raise_for_value(parser, JSON_ERR_SYNTAX);
+            return 0;
+        }
+
+        off++;
+        parser->pos.offset++;
+        parser->pos.column_number++;
+    }
+
+    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset > max_len)
+        json_raise_for_value(parser, JSON_ERR_MAXNUMBERLEN);
+
+    if(input == NULL) {       /* EOF */
+        if(parser->errcode == 0  &&  (parser->substate & can_see_end))
+            json_process_number(parser, parser->buf, parser->buf_used);
+        else
+            json_raise_for_value(parser, JSON_ERR_SYNTAX);
+    } else {
+        if(parser->errcode == 0  &&  collect) {
+            if(json_buf_append(parser, input, off) != 0)
+                return 0;
+        }
+    }
+
+    return off;
+}
+
+static inline unsigned
+json_resolve_xdigit(char ch)
+{
+    if(IS_DIGIT(ch))
+        return ch - '0';
+    else if(IS_IN(ch, 'a', 'f'))
+        return ch - 'a' + 10;
+    else
+        return ch - 'A' + 10;
+}
+
+/* Read the 4 hex digits of the '\uABCD' escape at the start of `str` (i.e.
+ * `str` points to the backslash). Returns zero on success, -1 otherwise. */
+static int
+json_scan_hex4(const char* str, size_t size, uint32_t* p_codepoint)
+{
+    uint32_t codepoint = 0;
+    size_t i;
+
+    if(size < 6  ||  str[0] != '\\'  ||  str[1] != 'u')
+        return -1;
+
+    for(i = 2; i < 6; i++) {
+        if(!IS_XDIGIT(str[i]))
+            return -1;
+        codepoint = (codepoint << 4) | json_resolve_xdigit(str[i]);
+    }
+
+    *p_codepoint = codepoint;
+    return 0;
+}
+
+/* U+fffd (Unicode replacement character), encoded in UTF-8.
+ *
+ * Note we sometimes need to use three, if we meet incorrect "\uABCD" escape
+ * sequence corresponding to an orphan surrogate, due the "best practice" of
+ * replacement character usage recommended in Unicode 10 standard:
+ *
+ * (Every orphan surrogate would be, in UTF-8, encoded as an 3-byte sequence.
+ * The first (leading) byte forms longest good subsequence replaced by single
+ * U+fffd. The two trailing bytes, who cannot really follow in well-formed
+ * UTF-8, then are replaced with U+fffd each too.)
+ */
+static const char fffd[9] = { '\xef', '\xbf', '\xbd', '\xef', '\xbf', '\xbd', '\xef', '\xbf', '\xbd' };
+static const size_t fffd_size = 3;
+
+static int
+json_handle_ill_surrogate(JSON_PARSER* parser, uint32_t codepoint, int ignore, int fix,
+                          int collect)
+{
+    if(ignore  ||  fix) {
+        if(!collect)
+            return 0;
+        if(ignore)
+            return json_buf_append_codepoint(parser, codepoint);
+        return json_buf_append(parser, fffd, 3 * fffd_size);
+    }
+
+    json_raise(parser, JSON_ERR_INVALIDUTF8);
+    return -1;
+}
+
+static size_t
+json_string_automaton(JSON_PARSER* parser, const char* input, size_t size,
+                      JSON_TYPE type)
+{
+    int ignore_ill_utf8;
+    int fix_ill_utf8;
+    int collect = json_wants_data(parser, type);
+    int raw = (parser->config.flags & JSON_RAWSTRINGS);
+    int decode = (collect  &&  !raw);
+    size_t max_len;
+    size_t off = 0;
+
+    if(type == JSON_KEY) {
+        ignore_ill_utf8 = (parser->config.flags & JSON_IGNOREILLUTF8KEY);
+        fix_ill_utf8 = (parser->config.flags & JSON_FIXILLUTF8KEY);
+        max_len = parser->config.max_key_len;
+    } else {
+        ignore_ill_utf8 = (parser->config.flags & JSON_IGNOREILLUTF8VALUE);
+        fix_ill_utf8 = (parser->config.flags & JSON_FIXILLUTF8VALUE);
+        max_len = parser->config.max_string_len;
+    }
+
+    if(max_len > 0)
+        max_len++;  /* +1 for the final quotes. */
+
+    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset + size > max_len)
+        size = max_len - (parser->pos.offset - parser->value_pos.offset) + 1;
+
+    while(off < size) {
+        char ch = input[off];
+        size_t n;
+
+        if(parser->substate == 0) {
+            if(ch == '\"') {
+                /* End of string. */
+                if(raw  &&  collect) {
+                    /* Report the raw string directly from the input if we can. */
+                    size_t len = off;
+                    off++;
+                    parser->pos.offset++;
+                    parser->pos.column_number++;
+                    if(parser->buf_used == 0) {
+                        json_process(parser, type, input, len);
+                    } else {
+                        if(json_buf_append(parser, input, len) != 0)
+                            break;
+                        json_process(parser, type, parser->buf, parser->buf_used);
+                    }
+                    break;
+                }
+                off++;
+                parser->pos.offset++;
+                parser->pos.column_number++;
+                json_process(parser, type, parser->buf, parser->buf_used);
+                break;
+            } else if(IS_CONTROL(ch)) {
+                /* Unescaped control char. */
+                if(ch == '\r' || ch == '\n')
+                    json_raise_for_value(parser, JSON_ERR_UNCLOSEDSTRING);
+                else
+                    json_raise(parser, JSON_ERR_UNESCAPEDCONTROL);
+                break;
+            } else if(ch == '\\') {
+                /* Start of an escape sequence. */
+                parser->substate = '\\';
+                parser->str_has_escapes = 1;
+            } else if((n = json_span_string_chars(input + off, size - off, ignore_ill_utf8)) > 0) {
+                /* ASCII chars or well-formed UTF-8 sequences which need no
+                 * special care.
+                 *
+                 * This is likely the most common case. Use tight loop to
+                 * handle as many chars as possible. */
+                size_t off2 = off + n;
+
+                /* Do we have complete simple string?
+                 * Then we can just process it without using temp. buffer. */
+                if(parser->buf_used + off == 0  &&  off2 < size  &&  input[off2] == '\"') {
+                    parser->pos.offset += off2 + 1;
+                    parser->pos.column_number += off2 + 1;
+                    off = off2 + 1;
+                    json_process(parser, type, input, off2);
+                    break;
+                }
+
+                /* (If nobody wants the string, we only validate it.) */
+                if(decode  &&  json_buf_append(parser, input + off, off2 - off) != 0)
+                    break;
+                parser->pos.offset += off2 - off;
+                parser->pos.column_number += off2 - off;
+                off = off2;
+                continue;
+            } else {
+                /* Should be leading byte of multi-byte UTF-8 encoded character.
+                 *
+                 * Well-Formed UTF-8 Byte Sequences
+                 * (From Unicode Standard 10.0, Table 3-7):
+                 *
+                 * | First Byte  | Second Byte | Third Byte  | Fourth Byte |
+                 * |-------------|-------------|-------------|-------------|
+                 * | 0x00...0x7f |    (ASCII: handled specially above)     |
+                 * | 0xc2...0xdf | 0x80...0xbf |             |             |
+                 * | 0xe0        | 0xa0...0xbf | 0x80...0xbf |             |
+                 * | 0xe1...0xec | 0x80...0xbf | 0x80...0xbf |             |
+                 * | 0xed        | 0x80...0x9f | 0x80...0xbf |             |
+                 * | 0xee...0xef | 0x80...0xbf | 0x80...0xbf |             |
+                 * | 0xf0        | 0x90...0xbf | 0x80...0xbf | 0x80...0xbf |
+                 * | 0xf1...0xf3 | 0x80...0xbf | 0x80...0xbf | 0x80...0xbf |
+                 * | 0xf4        | 0x80...0x8f | 0x80...0xbf | 0x80...0xbf |
+                 *
+                 * Note this table implicitly handles all the ill-formed stuff,
+                 * i.e. code points encoded in an "over-long" way; as well as
+                 * those reserved for UTF-16 surrogates.
+                 */
+                if(IS_IN(ch, 0xc2, 0xdf)) {
+                    parser->substate = 1;
+                } else if((unsigned char) ch == 0xe0) {
+                    parser->substate = 4;
+                } else if(IS_IN(ch, 0xe1, 0xec)) {
+                    parser->substate = 2;
+                } else if((unsigned char) ch == 0xed) {
+                    parser->substate = 5;
+                } else if(IS_IN(ch, 0xee, 0xef)) {
+                    parser->substate = 2;
+                } else if((unsigned char) ch == 0xf0) {
+                    parser->substate = 6;
+                } else if(IS_IN(ch, 0xf1, 0xf3)) {
+                    parser->substate = 3;
+                } else if((unsigned char) ch == 0xf4) {
+                    parser->substate = 7;
+                } else if(fix_ill_utf8) {
+                    if(decode  &&  json_buf_append(parser, fffd, fffd_size) != 0)
+                        break;
+                } else {
+                    json_raise(parser, JSON_ERR_INVALIDUTF8);
+                    break;
+                }
+
+                if(parser->substate != 0) {
+                    if(decode  &&  json_buf_append(parser, &ch, 1) != 0)
+                        break;
+                }
+            }
+        } else if(parser->substate <= 7) {
+            /* Should be trailing UTF-8 byte. */
+            if(parser->substate <= 3  &&  ((unsigned char)(ch) & 0xc0) == 0x80) {
+                parser->substate--;
+            } else if(parser->substate == 4  &&  IS_IN(ch, 0xa0, 0xbf)) {
+                parser->substate = 1;
+            } else if(parser->substate == 5  &&  IS_IN(ch, 0x80, 0x9f)) {
+                parser->substate = 1;
+            } else if(parser->substate == 6  &&  IS_IN(ch, 0x90, 0xbf)) {
+                parser->substate = 2;
+            } else if(parser->substate == 7  &&  IS_IN(ch, 0x80, 0x8f)) {
+                parser->substate = 2;
+            } else if(fix_ill_utf8) {
+                /* From Unicode Standard 10.0, best practice for ill-formed
+                 * UTF-8 sequence:
+                 *
+                 * > Whenever an unconvertible offset is reached during
+                 * > conversion of a code unit sequence:
+                 * >  1. The maximal subpart at that offset should be replaced
+                 * >     by a single U+fffd.
+                 * >  2. The conversion should proceed at the offset immediately
+                 * >     after the maximal subpart.
+                 *
+                 * I.e. we want to emit U+fffd instead of the incorrect sequence
+                 * BEFORE the current offset, because current byte is something
+                 * different then the predecessor expected.
+                 *
+                 * I.e. we have to go back to the previous leading byte
+                 * (including it).
+                 */
+                if(decode) {
+                    while(((unsigned char)(parser->buf[parser->buf_used-1]) & 0xc0) == 0x80)
+                        parser->buf_used--; /* Cancel all the trailing bytes. */
+                    parser->buf_used--;     /* Cancel the leading byte. */
+                    if(json_buf_append(parser, fffd, fffd_size) != 0)
+                        break;
+                }
+
+                /* And now we have to replay the current byte in state == 0
+                 * because it may be ASCII or correct leading byte of the
+                 * following character or something. */
+                parser->substate = 0;
+                continue;
+            } else {
+                json_raise(parser, JSON_ERR_INVALIDUTF8);
+                break;
+            }
+
+            if(decode  &&  json_buf_append(parser, &ch, 1) != 0)
+                break;
+        } else if(parser->substate == '\\') {
+            /* Handle 2nd character of an escape sequence. */
+            if(ch == 'u') {
+                /* Expecting 4 hex digits. */
+                parser->substate = 0xabcd + 4;
+                parser->codepoint[0] = parser->codepoint[1] = 0;
+            } else {
+                switch(ch) {
+                    case '\"':  ch = '\"'; break;
+                    case '\\':  ch = '\\'; break;
+                    case '/':   ch = '/'; break;
+                    case 'b':   ch = '\b'; break;
+                    case 'f':   ch = '\f'; break;
+                    case 'n':   ch = '\n'; break;
+                    case 'r':   ch = '\r'; break;
+                    case 't':   ch = '\t'; break;
+                    default:    json_raise(parser, JSON_ERR_INVALIDESCAPE); return off;
+                }
+
+                if(decode  &&  json_buf_append(parser, &ch, 1) != 0)
+                    break;
+                parser->substate = 0;
+            }
+        } else if(parser->substate > 0xabcd) {
+            /* Handle body of the '\uABCD' style escape.
+             *
+             * This is quite complex because JSON standard allows either
+             * any non-surrogate codepoint <= U+ffff or two long escapes
+             * forming UTF-16 surrogate pair for codepoints > U+ffff.
+             *
+             * Naturally, surrogate codepoints not forming the pair (e.g.
+             * orphan or two hi surrogates) make ill-formed UTF-8 string.
+             */
+            if(!IS_XDIGIT(ch)) {
+                json_raise(parser, JSON_ERR_INVALIDESCAPE);
+                return off;
+            }
+
+            parser->codepoint[1] <<= 4;
+            parser->codepoint[1] |= json_resolve_xdigit(ch);
+            parser->substate--;
+
+            if(parser->substate == 0xabcd) {
+                /* We have completed the long escape. */
+                if(parser->codepoint[0] != 0  &&  !IS_LO_SURROGATE(parser->codepoint[1])) {
+                    /* parser->codepoint[0] is unexpected high surrogate. */
+                    if(json_handle_ill_surrogate(parser, parser->codepoint[0], ignore_ill_utf8, fix_ill_utf8, decode) != 0)
+                        break;
+
+                    /* Propagate below to handle parser->codepoint[1] as if no
+                     * high surrogate precedes. */
+                    parser->codepoint[0] = 0;
+                }
+
+                if(parser->codepoint[0] == 0  &&  IS_LO_SURROGATE(parser->codepoint[1])) {
+                    /* parser->codepoint[1] is unexpected low surrogate. */
+                    if(json_handle_ill_surrogate(parser, parser->codepoint[1], ignore_ill_utf8, fix_ill_utf8, decode) != 0)
+                        break;
+                    parser->substate = 0;
+                } else if(parser->codepoint[0] != 0  &&  IS_LO_SURROGATE(parser->codepoint[1])) {
+                    /* parser->codepoint[0] & [1] form valid surrogate pair. */
+                    uint32_t hi = parser->codepoint[0];
+                    uint32_t lo = parser->codepoint[1];
+                    uint32_t codepoint = 0x10000 + (hi - 0xd800) * 0x400 + (lo - 0xdc00);
+                    if(decode  &&  json_buf_append_codepoint(parser, codepoint) != 0)
+                        break;
+                    parser->substate = 0;
+                } else if(IS_HI_SURROGATE(parser->codepoint[1])) {
+                    /* parser->codepoint[1] is high surrogate. Store it and we
+                     * see later if low surrogate follows. */
+                    parser->codepoint[0] = parser->codepoint[1];
+                    parser->substate = 0xabcd - 2;
+                } else {
+                    /* parser->codepoint[1] is non-surrogate codepoint. */
+                    if(decode  &&  json_buf_append_codepoint(parser, parser->codepoint[1]) != 0)
+                        break;
+                    parser->substate = 0;
+                }
+
+                parser->codepoint[1] = 0;
+            }
+        } else if(parser->substate >= 0xabcd - 2) {
+            /* We are just after high surrogate and expect another long escape,
+             * this time for the low surrogate. */
+            if(parser->substate == 0xabcd - 2  &&  ch == '\\') {
+                parser->substate = 0xabcd - 1;
+            } else if(parser->substate == 0xabcd - 1  &&  ch == 'u') {
+                parser->substate = 0xabcd + 4;
+            } else {
+                if(json_handle_ill_surrogate(parser, parser->codepoint[0], ignore_ill_utf8, fix_ill_utf8, decode) != 0)
+                    break;
+
+                /* Replay the current byte as if no high surrogate precedes. */
+                parser->codepoint[0] = 0;
+                parser->substate = (parser->substate == 0xabcd - 1) ? '\\' : 0;
+                continue;
+            }
+        } else {
+            json_raise(parser, JSON_ERR_INTERNAL);
+            break;
+        }
+
+        off++;
+        parser->pos.offset++;
+        parser->pos.column_number++;
+    }
+
+    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset > max_len)
+        json_raise_for_value(parser, (type == JSON_KEY)
+                    ? JSON_ERR_MAXKEYLEN : JSON_ERR_MAXSTRINGLEN);
+
+    if(input == NULL) {     /* EOF */
+        json_raise_for_value(parser, JSON_ERR_UNCLOSEDSTRING);
+        return off;
+    }
+
+    /* In the raw mode, keep what we have of the unfinished string. */
+    if(raw  &&  collect  &&  parser->errcode == 0  &&  parser->automaton != AUTOMATON_MAIN) {
+        if(json_buf_append(parser, input, off) != 0)
+            return off;
+    }
+
+    if(type == JSON_STRING  &&  (parser->config.flags & JSON_STRINGPARTS)  &&
+            parser->errcode == 0  &&  parser->automaton == AUTOMATON_STRING)
+        json_process_string_part(parser);
+
+    return off;
+}
+
+int
+json_string_has_escapes(const JSON_PARSER* parser)
+{
+    return parser->str_has_escapes;
+}
+
+/* Get length of the maximal subpart of the ill-formed UTF-8 sequence at the
+ * start of `str`, i.e. of what json_string_automaton() replaces with a single
+ * U+fffd. */
+static size_t
+json_ill_utf8_len(const char* str, size_t size)
+{
+    unsigned char ch = (unsigned char) str[0];
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xbf;
+    size_t len;
+    size_t i;
+
+    if(IS_IN(ch, 0xc2, 0xdf)) {
+        len = 2;
+    } else if(ch == 0xe0) {
+        len = 3;
+        lo = 0xa0;
+    } else if(ch == 0xed) {
+        len = 3;
+        hi = 0x9f;
+    } else if(IS_IN(ch, 0xe1, 0xef)) {
+        len = 3;
+    } else if(ch == 0xf0) {
+        len = 4;
+        lo = 0x90;
+    } else if(IS_IN(ch, 0xf1, 0xf3)) {
+        len = 4;
+    } else if(ch == 0xf4) {
+        len = 4;
+        hi = 0x8f;
+    } else {
+        return 1;
+    }
+
+    for(i = 1; i < len  &&  i < size; i++) {
+        if(!IS_IN(str[i], lo, hi))
+            break;
+        lo = 0x80;
+        hi = 0xbf;
+    }
+
+    return i;
+}
+
+size_t
+json_decode_string(JSON_TYPE type, const char* raw, size_t raw_size,
+                   unsigned flags, char* buffer)
+{
+    int fix_ill_utf8;
+    size_t off = 0;
+    size_t len = 0;
+    size_t n;
+
+    if(type == JSON_KEY)
+        fix_ill_utf8 = (flags & JSON_FIXILLUTF8KEY);
+    else
+        fix_ill_utf8 = (flags & JSON_FIXILLUTF8VALUE);
+
+    while(off < raw_size) {
+        uint32_t codepoint;
+        char ch;
+
+        /* Copy verbatim whatever needs no decoding. (The string has already
+         * been validated so unless we are fixing it, we may copy anything
+         * besides the escapes.) */
+        n = json_span_string_chars(raw + off, raw_size - off, !fix_ill_utf8);
+        memcpy(buffer + len, raw + off, n);
+        len += n;
+        off += n;
+        if(off >= raw_size)
+            break;
+
+        ch = raw[off];
+        if(ch == '\\'  &&  off + 1 < raw_size  &&  raw[off+1] != 'u') {
+            switch(raw[off+1]) {
+                case 'b':   ch = '\b'; break;
+                case 'f':   ch = '\f'; break;
+                case 'n':   ch = '\n'; break;
+                case 'r':   ch = '\r'; break;
+                case 't':   ch = '\t'; break;
+                default:    ch = raw[off+1]; break;
+            }
+            buffer[len++] = ch;
+            off += 2;
+        } else if(json_scan_hex4(raw + off, raw_size - off, &codepoint) == 0) {
+            uint32_t lo;
+
+            off += 6;
+            if(IS_HI_SURROGATE(codepoint)  &&
+               json_scan_hex4(raw + off, raw_size - off, &lo) == 0  &&  IS_LO_SURROGATE(lo))
+            {
+                codepoint = 0x10000 + (codepoint - 0xd800) * 0x400 + (lo - 0xdc00);
+                off += 6;
+            } else if(fix_ill_utf8  &&  (IS_HI_SURROGATE(codepoint) || IS_LO_SURROGATE(codepoint))) {
+                memcpy(buffer + len, fffd, 3 * fffd_size);
+                len += 3 * fffd_size;
+                continue;
+            }
+            len += json_encode_utf8(codepoint, buffer + len);
+        } else if(fix_ill_utf8  &&  !IS_ASCII(ch)) {
+            memcpy(buffer + len, fffd, fffd_size);
+            len += fffd_size;
+            off += json_ill_utf8_len(raw + off, raw_size - off);
+        } else {
+            /* Not reachable for strings validated by the parser. */
+            buffer[len++] = ch;
+            off++;
+        }
+    }
+
+    return len;
+}
+
+static size_t
+json_dispatch(JSON_PARSER* parser, const char* input, size_t size)
+{
+    switch(parser->automaton) {
+        case AUTOMATON_NULL:    return json_literal_automaton(parser, input, size, JSON_NULL, "null", 4);
+        case AUTOMATON_FALSE:   return json_literal_automaton(parser, input, size, JSON_FALSE, "false", 5);
+        case AUTOMATON_TRUE:    return json_literal_automaton(parser, input, size, JSON_TRUE, "true", 4);
+        case AUTOMATON_NUMBER:  return json_number_automaton(parser, input, size);
+        case AUTOMATON_STRING:  return json_string_automaton(parser, input, size, JSON_STRING);
+        case AUTOMATON_KEY:     return json_string_automaton(parser, input, size, JSON_KEY);
+    }
+
+    json_raise(parser, JSON_ERR_INTERNAL);
+    return 0;
+}
+
+static void
+json_handle_new_line(JSON_PARSER* parser, char ch)
+{
+    if(ch == '\r') {
+        parser->last_cl_offset = parser->pos.offset;
+        parser->pos.line_number++;
+        parser->pos.column_number = FIRST_COLUMN_NUMBER;
+    } else if(ch == '\n') {
+        if(!(parser->pos.offset == parser->last_cl_offset + 1))
+            parser->pos.line_number++;
+        parser->pos.column_number = FIRST_COLUMN_NUMBER;
+    }
+}
+
+/* Advance the (fully resolved) `pos` to the given `offset` by scanning the
+ * input for new lines. `input` points to the input at `pos->offset`.
+ *
+ * This gives the same result as json_handle_new_line() called for every new
+ * line in the input, but the new lines are only counted: Every '\r' and every
+ * '\n' ends a line, unless the '\n' follows '\r' (CRLF). Only the last new
+ * line then matters for the column. (Note last_cl_offset is the offset just
+ * behind the '\r', so '\n' at that offset belongs to CRLF. We update it only
+ * if the input ends with '\r': Any older value cannot match anymore.) */
+static void
+json_advance_pos(JSON_INPUT_POS* pos, size_t* p_last_cl_offset,
+                 const char* input, size_t offset)
+{
+    size_t base = pos->offset;
+    size_t size = offset - base;
+    size_t n_new_lines = 0;     /* All '\r' and '\n' */
+    size_t n_crlf = 0;          /* '\n' following '\r' */
+    size_t off = 0;
+
+    if(size == 0)
+        return;
+
+#ifdef JSON_SSE2
+    if(size >= 16) {
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lf = _mm_set1_epi8('\n');
+        const __m128i zero = _mm_setzero_si128();
+        __m128i prev = zero;
+
+        while(off + 16 <= size) {
+            /* Each byte lane of the accumulators counts up to 255. */
+            __m128i acc_nl = zero;
+            __m128i acc_crlf = zero;
+            size_t end = off + 16 * 255;
+
+            if(end > size)
+                end = size;
+            while(off + 16 <= end) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(input + off));
+                __m128i x_cr = _mm_cmpeq_epi8(x, cr);
+                __m128i x_lf = _mm_cmpeq_epi8(x, lf);
+                /* Which bytes follow '\r' (the first one the previous block's
+                 * last byte). */
+                __m128i after_cr = _mm_or_si128(_mm_slli_si128(x_cr, 1), _mm_srli_si128(prev, 15));
+
+                acc_nl = _mm_sub_epi8(acc_nl, _mm_or_si128(x_cr, x_lf));
+                acc_crlf = _mm_sub_epi8(acc_crlf, _mm_and_si128(x_lf, after_cr));
+                prev = x_cr;
+                off += 16;
+            }
+
+            acc_nl = _mm_sad_epu8(acc_nl, zero);
+            acc_crlf = _mm_sad_epu8(acc_crlf, zero);
+            n_new_lines += (size_t) _mm_cvtsi128_si32(acc_nl) +
+                           (size_t) _mm_cvtsi128_si32(_mm_srli_si128(acc_nl, 8));
+            n_crlf += (size_t) _mm_cvtsi128_si32(acc_crlf) +
+                      (size_t) _mm_cvtsi128_si32(_mm_srli_si128(acc_crlf, 8));
+        }
+    }
+#endif
+
+    for(; off < size; off++) {
+        if(IS_NEW_LINE(input[off])) {
+            n_new_lines++;
+            if(off > 0  &&  input[off] == '\n'  &&  input[off-1] == '\r')
+                n_crlf++;
+        }
+    }
+
+    /* CRLF may be split between this and the preceding input. */
+    if(input[0] == '\n'  &&  base == *p_last_cl_offset)
+        n_crlf++;
+    if(input[size-1] == '\r')
+        *p_last_cl_offset = offset;
+
+    pos->offset = offset;
+    if(n_new_lines == 0) {
+        pos->column_number += (unsigned) size;
+        return;
+    }
+
+    /* Find the last new line. */
+    off = size;
+#ifdef JSON_SSE2
+    {
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lf = _mm_set1_epi8('\n');
+
+        while(off >= 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(input + off - 16));
+            unsigned mask = (unsigned) _mm_movemask_epi8(
+                        _mm_or_si128(_mm_cmpeq_epi8(x, cr), _mm_cmpeq_epi8(x, lf)));
+
+            if(mask != 0) {
+                off = off - 16 + json_bsr(mask) + 1;
+                break;
+            }
+            off -= 16;
+        }
+    }
+#endif
+    while(!IS_NEW_LINE(input[off-1]))
+        off--;
+
+    pos->line_number += (unsigned) (n_new_lines - n_crlf);
+    pos->column_number = (unsigned) (size - off) + FIRST_COLUMN_NUMBER;
+}
+
+/* With JSON_LAZYPOS, only the offsets are maintained while processing the
+ * input. Resolve the line and column numbers of all the positions which may
+ * get reported by counting the new lines in the input from the `checkpoint`
+ * (i.e. the fully resolved position at the start of `input`).
+ *
+ * This has to be done once per each fed block (the block is not available
+ * later), at least for parser->pos which becomes the next checkpoint. The
+ * other positions are resolved only if they may get reported.
+ *
+ * Positions before the checkpoint have already been resolved by a preceding
+ * call (and they are only copied around since then). */
+static void
+json_resolve_pos(JSON_PARSER* parser, const JSON_INPUT_POS* checkpoint,
+                 size_t checkpoint_last_cl_offset, const char* input)
+{
+    JSON_INPUT_POS* todo[3];
+    JSON_INPUT_POS cursor;
+    size_t last_cl_offset = checkpoint_last_cl_offset;
+    int n = 0;
+    int i, j;
+
+    /* (Zero line number means the position has never been recorded. E.g.
+     * there is no value_pos before the first scalar value. Keep it so.)
+     * The value_pos is needed only if an error may get reported for the value,
+     * i.e. if it has failed or if it continues in the next input. */
+    if(parser->value_pos.line_number != 0  &&  parser->value_pos.offset >= checkpoint->offset  &&
+       (parser->errcode != 0  ||  parser->automaton != AUTOMATON_MAIN))
+    {
+        todo[n++] = &parser->value_pos;
+    }
+    if(parser->pos.offset >= checkpoint->offset)
+        todo[n++] = &parser->pos;
+    /* If the error has not been raised via json_raise_() (e.g. aborted by a
+     * callback), err_pos is not set at all and it has to remain so. */
+    if(parser->errcode != 0  &&  parser->err_pos.line_number != 0  &&
+       parser->err_pos.offset >= checkpoint->offset)
+        todo[n++] = &parser->err_pos;
+
+    /* Sort by the offset so one pass over the input is enough. */
+    for(i = 1; i < n; i++) {
+        JSON_INPUT_POS* tmp = todo[i];
+        for(j = i; j > 0  &&  todo[j-1]->offset > tmp->offset; j--)
+            todo[j] = todo[j-1];
+        todo[j] = tmp;
+    }
+
+    memcpy(&cursor, checkpoint, sizeof(JSON_INPUT_POS));
+    for(i = 0; i < n; i++) {
+        json_advance_pos(&cursor, &last_cl_offset,
+                input + (cursor.offset - checkpoint->offset), todo[i]->offset);
+        todo[i]->line_number = cursor.line_number;
+        todo[i]->column_number = cursor.column_number;
+    }
+
+    /* The next input continues where parser->pos is. */
+    if(n > 0  &&  cursor.offset == parser->pos.offset)
+        parser->last_cl_offset = last_cl_offset;
+}
+
+/* Straight-line scanners of complete simple values.
+ *
+ * When the complete value is available in the input (and it is not spread
+ * over multiple json_feed() calls), these process it at once without any
+ * help of the (resumable, but slower) sub-automata.
+ *
+ * All of them return zero (and do nothing) if the value is anything but
+ * simple and valid: Then the caller has to fall back to the sub-automata,
+ * which also take care about proper error reporting.
+ *
+ * If `at_end` is non-zero, the input is known to end where the document ends,
+ * so a literal or a number may be terminated by the end of the input.
+ */
+static size_t
+json_scan_literal(JSON_PARSER* parser, const char* input, size_t size, int at_end)
+{
+    const char* literal;
+    size_t literal_size;
+    JSON_TYPE type;
+
+    switch(input[0]) {
+        case 'n':   type = JSON_NULL; literal = "null"; literal_size = 4; break;
+        case 'f':   type = JSON_FALSE; literal = "false"; literal_size = 5; break;
+        case 't':   type = JSON_TRUE; literal = "true"; literal_size = 4; break;
+        default:    return 0;
+    }
+
+    if(size < literal_size  ||  !json_match_literal(input, literal, literal_size))
+        return 0;
+    if(size == literal_size ? !at_end : !IS_TOKEN_BOUNDARY(input[literal_size]))
+        return 0;
+
+    memcpy(&parser->value_pos, &parser->pos, sizeof(JSON_INPUT_POS));
+    parser->pos.offset += literal_size;
+    parser->pos.column_number += (unsigned) literal_size;
+    json_process(parser, type, NULL, 0);
+    return literal_size;
+}
+
+static size_t
+json_scan_number(JSON_PARSER* parser, const char* input, size_t size, int at_end)
+{
+    size_t off = 0;
+
+    json_number_reset(parser);
+
+    if(input[off] == '-') {
+        parser->num_flags |= NUM_NEGATIVE;
+        off++;
+    }
+
+    /* Mantissa. (No follow-up digits if it begins with zero.) */
+    if(off < size  &&  input[off] == '0') {
+        off++;
+    } else if(off < size  &&  IS_IN(input[off], '1', '9')) {
+        json_number_digit(parser, input[off], 0);
+        off++;
+        while(off < size  &&  IS_DIGIT(input[off]))
+            json_number_digit(parser, input[off++], 0);
+    } else {
+        return 0;
+    }
+
+    /* Fraction. */
+    if(off < size  &&  input[off] == '.') {
+        parser->num_flags |= NUM_NOTINTEGER;
+        off++;
+        if(off >= size  ||  !IS_DIGIT(input[off]))
+            return 0;
+        while(off < size  &&  IS_DIGIT(input[off]))
+            json_number_digit(parser, input[off++], 1);
+    }
+
+    /* Exponent. */
+    if(off < size  &&  (input[off] == 'e' || input[off] == 'E')) {
+        parser->num_flags |= NUM_NOTINTEGER;
+        off++;
+        if(off < size  &&  (input[off] == '+' || input[off] == '-')) {
+            if(input[off] == '-')
+                parser->num_flags |= NUM_EXPNEGATIVE;
+            off++;
+        }
+        if(off >= size  ||  !IS_DIGIT(input[off]))
+            return 0;
+        while(off < size  &&  IS_DIGIT(input[off]))
+            json_number_exp_digit(parser, input[off++]);
+    }
+
+    if(off == size ? !at_end : !IS_TOKEN_BOUNDARY(input[off]))
+        return 0;
+    if(parser->config.max_number_len != 0  &&  off > parser->config.max_number_len)
+        return 0;
+
+    memcpy(&parser->value_pos, &parser->pos, sizeof(JSON_INPUT_POS));
+    parser->pos.offset += off;
+    parser->pos.column_number += (unsigned) off;
+    json_process_number(parser, input, off);
+    return off;
+}
+
+/* Get length of the escape sequence at the start of `str` if it is valid and
+ * does not form an orphan surrogate; zero otherwise. */
+static size_t
+json_scan_escape(const char* str, size_t size)
+{
+    uint32_t codepoint;
+
+    if(size < 2)
+        return 0;
+    switch(str[1]) {
+        case '\"': case '\\': case '/': case 'b':
+        case 'f': case 'n': case 'r': case 't':
+            return 2;
+    }
+
+    if(json_scan_hex4(str, size, &codepoint) != 0  ||  IS_LO_SURROGATE(codepoint))
+        return 0;
+    if(IS_HI_SURROGATE(codepoint)) {
+        /* It has to be followed by the low surrogate. */
+        if(json_scan_hex4(str + 6, size - 6, &codepoint) != 0  ||  !IS_LO_SURROGATE(codepoint))
+            return 0;
+        return 12;
+    }
+
+    return 6;
+}
+
+static size_t
+json_scan_string(JSON_PARSER* parser, const char* input, size_t size, JSON_TYPE type)
+{
+    int ignore_ill_utf8;
+    int has_escapes = 0;
+    size_t max_len;
+    size_t n;
+
+    if(type == JSON_KEY) {
+        ignore_ill_utf8 = (parser->config.flags & JSON_IGNOREILLUTF8KEY);
+        max_len = parser->config.max_key_len;
+    } else {
+        ignore_ill_utf8 = (parser->config.flags & JSON_IGNOREILLUTF8VALUE);
+        max_len = parser->config.max_string_len;
+    }
+
+    /* Skip the opening quotes. */
+    n = json_span_string_chars(input + 1, size - 1, ignore_ill_utf8);
+
+    /* In the raw mode, we need not decode the escapes, only to validate them. */
+    if(parser->config.flags & JSON_RAWSTRINGS) {
+        while(1 + n < size  &&  input[1 + n] == '\\') {
+            size_t esc_len = json_scan_escape(input + 1 + n, size - 1 - n);
+            if(esc_len == 0)
+                return 0;
+            has_escapes = 1;
+            n += esc_len;
+            n += json_span_string_chars(input + 1 + n, size - 1 - n, ignore_ill_utf8);
+        }
+    }
+
+    if(1 + n >= size  ||  input[1 + n] != '\"')
+        return 0;
+    if(max_len != 0  &&  n > max_len)
+        return 0;
+
+    parser->str_has_escapes = has_escapes;
+    memcpy(&parser->value_pos, &parser->pos, sizeof(JSON_INPUT_POS));
+    parser->pos.offset += n + 2;
+    parser->pos.column_number += (unsigned) (n + 2);
+    json_process(parser, type, input + 1, n);
+    return n + 2;
+}
+
+/* Dispatch to the scanners above, if the main automaton would accept the value
+ * in the current state. */
+static inline size_t
+json_scan_value(JSON_PARSER* parser, const char* input, size_t size, int at_end)
+{
+    char ch = input[0];
+
+    if(ch == '\"') {
+        if(parser->state & CAN_SEE_VALUE)
+            return json_scan_string(parser, input, size, JSON_STRING);
+        if(parser->state & CAN_SEE_KEY)
+            return json_scan_string(parser, input, size, JSON_KEY);
+    } else if(parser->state & CAN_SEE_VALUE) {
+        if(IS_DIGIT(ch)  ||  ch == '-')
+            return json_scan_number(parser, input, size, at_end);
+        if(ch == 'n'  ||  ch == 'f'  ||  ch == 't')
+            return json_scan_literal(parser, input, size, at_end);
+    }
+
+    return 0;
+}
 
-        if(parser->substate == 0) {
-            if(ch == '\"') {
-                /* End of string. */
-                off++;
-                parser->pos.offset++;
-                parser->pos.column_number++;
-                json_process(parser, type, parser->buf, parser->buf_used);
+/* Character classes for the main automaton. */
+#define CC_OTHER                0
+#define CC_BLANK                1   /* ' ', '\t' */
+#define CC_NEWLINE              2   /* '\r', '\n' */
+#define CC_OPENER               3   /* '[', '{' */
+#define CC_CLOSER               4   /* ']', '}' */
+#define CC_COMMA                5
+#define CC_COLON                6
+#define CC_QUOTE                7
+#define CC_LITERAL              8   /* 'n', 'f', 't' */
+#define CC_LETTER               9   /* Any other letter */
+#define CC_NUMBER               10  /* '-', '0' ... '9' */
+#define CC_COUNT                11
+
+#define O_  CC_OTHER
+#define B_  CC_BLANK
+#define NL  CC_NEWLINE
+#define OP  CC_OPENER
+#define CL  CC_CLOSER
+#define CM  CC_COMMA
+#define CO  CC_COLON
+#define QU  CC_QUOTE
+#define LI  CC_LITERAL
+#define AL  CC_LETTER
+#define NU  CC_NUMBER
+static const unsigned char json_char_class[256] = {
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, B_, NL, O_, O_, NL, O_, O_,  /* 0x00 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0x10 */
+    B_, O_, QU, O_, O_, O_, O_, O_, O_, O_, O_, O_, CM, NU, O_, O_,  /* 0x20 */
+    NU, NU, NU, NU, NU, NU, NU, NU, NU, NU, CO, O_, O_, O_, O_, O_,  /* 0x30 */
+    O_, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,  /* 0x40 */
+    AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, OP, O_, CL, O_, O_,  /* 0x50 */
+    O_, AL, AL, AL, AL, AL, LI, AL, AL, AL, AL, AL, AL, AL, LI, AL,  /* 0x60 */
+    AL, AL, AL, AL, LI, AL, AL, AL, AL, AL, AL, OP, O_, CL, O_, O_,  /* 0x70 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0x80 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0x90 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0xa0 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0xb0 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0xc0 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0xd0 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0xe0 */
+    O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_, O_,  /* 0xf0 */
+};
+#undef O_
+#undef B_
+#undef NL
+#undef OP
+#undef CL
+#undef CM
+#undef CO
+#undef QU
+#undef LI
+#undef AL
+#undef NU
+
+/* Actions of the main automaton. */
+#define ACTION_UNEXPECTED       0
+#define ACTION_BLANK            1
+#define ACTION_NEWLINE          2
+#define ACTION_OPEN             3
+#define ACTION_CLOSE            4
+#define ACTION_COMMA            5
+#define ACTION_COLON            6
+#define ACTION_STRING           7   /* (ACTION_STRING ... ACTION_NUMBER start a value) */
+#define ACTION_KEY              8
+#define ACTION_LITERAL          9
+#define ACTION_NUMBER           10
+#define ACTION_BADLITERAL       11
+
+/* The action for each JSON_PARSER::state and character class. (So the main
+ * automaton needs just one lookup per character instead of testing the state
+ * bits against the candidate characters one by one.) */
+#define ACTION_IF(state, bit, action)   (((state) & (bit)) ? (action) : ACTION_UNEXPECTED)
+#define ACTION_ROW(state)                                                   \
+    {                                                                       \
+        ACTION_UNEXPECTED,                              /* CC_OTHER */      \
+        ACTION_BLANK,                                   /* CC_BLANK */      \
+        ACTION_NEWLINE,                                 /* CC_NEWLINE */    \
+        ACTION_IF(state, CAN_SEE_VALUE, ACTION_OPEN),   /* CC_OPENER */     \
+        ACTION_IF(state, CAN_SEE_CLOSER, ACTION_CLOSE), /* CC_CLOSER */     \
+        ACTION_IF(state, CAN_SEE_COMMA, ACTION_COMMA),  /* CC_COMMA */      \
+        ACTION_IF(state, CAN_SEE_COLON, ACTION_COLON),  /* CC_COLON */      \
+        ((state) & CAN_SEE_VALUE) ? ACTION_STRING :     /* CC_QUOTE */      \
+                ACTION_IF(state, CAN_SEE_KEY, ACTION_KEY),                  \
+        ACTION_IF(state, CAN_SEE_VALUE, ACTION_LITERAL),    /* CC_LITERAL */\
+        ACTION_IF(state, CAN_SEE_VALUE, ACTION_BADLITERAL), /* CC_LETTER */ \
+        ACTION_IF(state, CAN_SEE_VALUE, ACTION_NUMBER)      /* CC_NUMBER */ \
+    }
+#define ACTION_ROWS_8(state)                                                \
+    ACTION_ROW((state)+0), ACTION_ROW((state)+1), ACTION_ROW((state)+2),    \
+    ACTION_ROW((state)+3), ACTION_ROW((state)+4), ACTION_ROW((state)+5),    \
+    ACTION_ROW((state)+6), ACTION_ROW((state)+7)
+static const unsigned char json_main_actions[CAN_SEE_MASK + 1][CC_COUNT] = {
+    ACTION_ROWS_8(0x00), ACTION_ROWS_8(0x08), ACTION_ROWS_8(0x10), ACTION_ROWS_8(0x18),
+    ACTION_ROWS_8(0x20), ACTION_ROWS_8(0x28), ACTION_ROWS_8(0x30), ACTION_ROWS_8(0x38)
+};
+#undef ACTION_IF
+#undef ACTION_ROW
+#undef ACTION_ROWS_8
+
+/* Process input in the main automaton. (The main automaton handles everything
+ * outside of the scalar values.)
+ *
+ * Returns count of consumed bytes. It stops at the end of the input, on an
+ * error, or when a sub-automaton has to take over.
+ *
+ * If `is_last` is non-zero, the input is the last (typically the only) block
+ * of the document. Most values then lie complete in the input and they are
+ * handled by the straight-line scanners, without the sub-automata.
+ */
+static size_t
+json_main_automaton(JSON_PARSER* parser, const char* input, size_t size, int is_last)
+{
+    size_t off = 0;
+    unsigned action;
+    char ch;
+
+    while(off < size  &&  parser->errcode == 0  &&  parser->automaton == AUTOMATON_MAIN) {
+        ch = input[off];
+        action = json_main_actions[parser->state][json_char_class[(unsigned char) ch]];
+
+        if(is_last  &&  ACTION_STRING <= action  &&  action <= ACTION_NUMBER) {
+            size_t n = json_scan_value(parser, input+off, size-off, 1);
+
+            if(n > 0) {
+                off += n;
+                continue;
+            }
+        }
+
+        switch(action) {
+            case ACTION_NEWLINE:
+                /* With JSON_LAZYPOS, new lines are just blanks. */
+                if(!(parser->config.flags & JSON_LAZYPOS)) {
+                    off++;
+                    parser->pos.offset++;
+                    json_handle_new_line(parser, ch);
+                    continue;
+                }
+                /* Fall through. */
+            case ACTION_BLANK:
+            {
+                /* Eat the whole run of blanks (typically an indentation of a
+                 * pretty-printed document) at once. New lines are left for
+                 * json_handle_new_line() above, unless the line numbers are
+                 * resolved lazily. (Spanning them here too and counting the
+                 * lines in bulk with json_advance_pos() has been tried: It
+                 * is slower, as a new line is mostly followed by just the
+                 * indentation anyway.) */
+                size_t n = json_span_blanks(input+off, size-off,
+                                    (parser->config.flags & JSON_LAZYPOS));
+
+                off += n;
+                parser->pos.offset += n;
+                parser->pos.column_number += (unsigned) n;
+                continue;
+            }
+
+            case ACTION_OPEN:
+                /* Begin of array or object. */
+                if(parser->config.max_nesting_level != 0  &&
+                   parser->nesting_level >= parser->config.max_nesting_level) {
+                    json_raise(parser, JSON_ERR_MAXNESTINGLEVEL);
+                    return off;
+                }
+
+                if(parser->nesting_level >= parser->nesting_stack_size) {
+                    char* new_nesting_stack;
+                    size_t new_nesting_stack_size = parser->nesting_stack_size * 2;
+
+                    if(new_nesting_stack_size == 0)
+                        new_nesting_stack_size = 32;
+                    new_nesting_stack = (char*) json_realloc(parser->config.allocator,
+                                parser->nesting_stack, new_nesting_stack_size);
+                    if(new_nesting_stack == NULL) {
+                        json_raise(parser, JSON_ERR_OUTOFMEMORY);
+                        return off;
+                    }
+
+                    parser->nesting_stack = new_nesting_stack;
+                    parser->nesting_stack_size = new_nesting_stack_size;
+                }
+                parser->nesting_stack[parser->nesting_level++] = (ch == '[') ? ']' : '}';
+                json_process(parser, (ch == '[') ? JSON_ARRAY_BEG : JSON_OBJECT_BEG, NULL, 0);
                 break;
-            } else if(IS_CONTROL(ch)) {
-                /* Unescaped control char. */
-                if(ch == '\r' || ch == '\n')
-                    json_raise_for_value(parser, JSON_ERR_UNCLOSEDSTRING);
+
+            case ACTION_CLOSE:
+                /* End of array or object. */
+                if(parser->nesting_stack[parser->nesting_level-1] != ch) {
+                    json_raise(parser, JSON_ERR_BADCLOSER);
+                    return off;
+                }
+                parser->nesting_level--;
+                json_process(parser, (ch == ']') ? JSON_ARRAY_END : JSON_OBJECT_END, NULL, 0);
+                break;
+
+            case ACTION_COMMA:
+                if(parser->nesting_stack[parser->nesting_level - 1] == ']')
+                    parser->state = CAN_SEE_VALUE;
                 else
-                    json_raise(parser, JSON_ERR_UNESCAPEDCONTROL);
+                    parser->state = CAN_SEE_KEY;
                 break;
-            } else if(ch == '\\') {
-                /* Start of an escape sequence. */
-                parser->substate = '\\';
-            } else if(IS_ASCII(ch)  ||  ignore_ill_utf8) {
-                /* ASCII char which needs no special care.
-                 *
-                 * This is likely the most common case. Use tight loop to
-                 * handle as many chars as possible. */
-                size_t off2 = off+1;
-                while(off2 < size  &&  IS_ASCII(input[off2])  &&  !IS_CONTROL(input[off2])
-                         &&  input[off2] != '\\'  &&  input[off2] != '\"')
-                    off2++;
 
-                /* Do we have complete simple string?
-                 * Then we can just process it without using temp. buffer. */
-                if(parser->buf_used + off == 0  &&  off2 < size  &&  input[off2] == '\"') {
-                    parser->pos.offset += off2 + 1;
-                    parser->pos.column_number += off2 + 1;
-                    off = off2 + 1;
-                    json_process(parser, type, input, off2);
-                    break;
-                }
+            case ACTION_COLON:
+                parser->state = CAN_SEE_VALUE;
+                break;
 
-                if(json_buf_append(parser, input + off, off2 - off) != 0)
-                    break;
-                parser->pos.offset += off2 - off;
-                parser->pos.column_number += off2 - off;
-                off = off2;
-                continue;
-            } else {
-                /* Should be leading byte of multi-byte UTF-8 encoded character.
-                 *
-                 * Well-Formed UTF-8 Byte Sequences
-                 * (From Unicode Standard 10.0, Table 3-7):
-                 *
-                 * | First Byte  | Second Byte | Third Byte  | Fourth Byte |
-                 * |-------------|-------------|-------------|-------------|
-                 * | 0x00...0x7f |    (ASCII: handled specially above)     |
-                 * | 0xc2...0xdf | 0x80...0xbf |             |             |
-                 * | 0xe0        | 0xa0...0xbf | 0x80...0xbf |             |
-                 * | 0xe1...0xec | 0x80...0xbf | 0x80...0xbf |             |
-                 * | 0xed        | 0x80...0x9f | 0x80...0xbf |             |
-                 * | 0xee...0xef | 0x80...0xbf | 0x80...0xbf |             |
-                 * | 0xf0        | 0x90...0xbf | 0x80...0xbf | 0x80...0xbf |
-                 * | 0xf1...0xf3 | 0x80...0xbf | 0x80...0xbf | 0x80...0xbf |
-                 * | 0xf4        | 0x80...0x8f | 0x80...0xbf | 0x80...0xbf |
-                 *
-                 * Note this table implicitly handles all the ill-formed stuff,
-                 * i.e. code points encoded in an "over-long" way; as well as
-                 * those reserved for UTF-16 surrogates.
-                 */
-                if(IS_IN(ch, 0xc2, 0xdf)) {
-                    parser->substate = 1;
-                } else if((unsigned char) ch == 0xe0) {
-                    parser->substate = 4;
-                } else if(IS_IN(ch, 0xe1, 0xec)) {
-                    parser->substate = 2;
-                } else if((unsigned char) ch == 0xed) {
-                    parser->substate = 5;
-                } else if(IS_IN(ch, 0xee, 0xef)) {
-                    parser->substate = 2;
-                } else if((unsigned char) ch == 0xf0) {
-                    parser->substate = 6;
-                } else if(IS_IN(ch, 0xf1, 0xf3)) {
-                    parser->substate = 3;
-                } else if((unsigned char) ch == 0xf4) {
-                    parser->substate = 7;
-                } else if(fix_ill_utf8) {
-                    if(json_buf_append(parser, fffd, fffd_size) != 0)
-                        break;
-                } else {
-                    json_raise(parser, JSON_ERR_INVALIDUTF8);
-                    break;
+            case ACTION_STRING:
+                json_switch_automaton(parser, AUTOMATON_STRING);
+                break;
+
+            case ACTION_KEY:
+                json_switch_automaton(parser, AUTOMATON_KEY);
+                break;
+
+            case ACTION_LITERAL:
+                /* (The literal automata need to see the literal from its
+                 * beginning, so do not advance.) */
+                switch(ch) {
+                    case 'n':   json_switch_automaton(parser, AUTOMATON_NULL); break;
+                    case 'f':   json_switch_automaton(parser, AUTOMATON_FALSE); break;
+                    default:    json_switch_automaton(parser, AUTOMATON_TRUE); break;
                 }
+                return off;
+
+            case ACTION_NUMBER:
+                json_switch_automaton(parser, AUTOMATON_NUMBER);
+                return off;
+
+            case ACTION_BADLITERAL:
+                json_raise(parser, JSON_ERR_SYNTAX);
+                return off;
+
+            default:
+                json_raise_unexpected(parser);
+                return off;
+        }
+
+        /* Advance to next char. */
+        off++;
+        parser->pos.offset++;
+        parser->pos.column_number++;
+    }
+
+    return off;
+}
+
+static int
+json_feed_(JSON_PARSER* parser, const char* input, size_t size, int is_last,
+           size_t* p_consumed)
+{
+    JSON_INPUT_POS checkpoint;
+    size_t checkpoint_last_cl_offset = 0;
+    size_t off = 0;
+
+    if(parser->config.max_total_len != 0  &&
+       parser->pos.offset + size > parser->config.max_total_len)
+    {
+        /* Update parser->pos to point to the exact place. */
+        while(parser->pos.offset < parser->config.max_total_len) {
+            parser->pos.offset++;
+            parser->pos.column_number++;
+            off++;
+            json_handle_new_line(parser, input[off]);
+        }
+
+        json_raise(parser, JSON_ERR_MAXTOTALLEN);
+    }
+
+    if(p_consumed != NULL)
+        *p_consumed = off;
+    if(parser->errcode != 0)
+        return parser->errcode;
+
+    if(parser->config.flags & JSON_LAZYPOS) {
+        memcpy(&checkpoint, &parser->pos, sizeof(JSON_INPUT_POS));
+        checkpoint_last_cl_offset = parser->last_cl_offset;
+    }
+
+    while(off < size  &&  parser->errcode == 0) {
+        /* If we have active any sub-automaton, let it process the character. */
+        if(parser->automaton != AUTOMATON_MAIN) {
+            off += json_dispatch(parser, input+off, size-off);
+            continue;
+        }
+
+        off += json_main_automaton(parser, input+off, size-off, is_last);
+    }
+
+    if(parser->config.flags & JSON_LAZYPOS)
+        json_resolve_pos(parser, &checkpoint, checkpoint_last_cl_offset, input);
+
+    if(p_consumed != NULL)
+        *p_consumed = off;
+
+    if(parser->errcode == JSON_PAUSE) {
+        /* The parser is consistent after each reported event, so there is
+         * nothing to do but to let the caller resume with the rest. */
+        parser->errcode = 0;
+        return JSON_PAUSE;
+    }
+
+    return parser->errcode;
+}
+
+int
+json_feed(JSON_PARSER* parser, const char* input, size_t size)
+{
+    return json_feed_(parser, input, size, 0, NULL);
+}
+
+int
+json_feed_ex(JSON_PARSER* parser, const char* input, size_t size, size_t* p_consumed)
+{
+    return json_feed_(parser, input, size, 0, p_consumed);
+}
+
+int
+json_feed_last(JSON_PARSER* parser, const char* input, size_t size)
+{
+    return json_feed_(parser, input, size, 1, NULL);
+}
+
+/* Common part of json_fini() and json_reset(). */
+static int
+json_finish(JSON_PARSER* parser, JSON_INPUT_POS* p_pos)
+{
+    /* Some automaton may need some flushing. */
+    if(parser->errcode == 0) {
+        if(parser->automaton != AUTOMATON_MAIN) {
+            parser->pos.offset += json_dispatch(parser, NULL, 0);
+
+            /* There is nothing to resume at the end of the input. */
+            if(parser->errcode == JSON_PAUSE)
+                parser->errcode = 0;
+
+            if(parser->automaton != AUTOMATON_MAIN) {
+                json_raise(parser, JSON_ERR_SYNTAX);
+            }
+        }
+
+        /* The flushed value may still be nested in an unclosed array or
+         * object. */
+        if(parser->errcode == 0  &&
+           (parser->nesting_level != 0  ||  !(parser->state & CAN_SEE_EOF)))
+        {
+            json_raise_unexpected(parser);
+        }
+    }
+
+    if(p_pos != NULL) {
+        memcpy(p_pos, (parser->errcode == 0) ? &parser->pos : &parser->err_pos,
+                sizeof(JSON_INPUT_POS));
+    }
+
+    return parser->errcode;
+}
+
+int
+json_fini(JSON_PARSER* parser, JSON_INPUT_POS* p_pos)
+{
+    int ret;
+
+    ret = json_finish(parser, p_pos);
+
+    json_free(parser->config.allocator, parser->nesting_stack);
+    json_free(parser->config.allocator, parser->buf);
+    json_proj_free(parser->config.allocator, parser->projection);
+    return ret;
+}
+
+int
+json_reset(JSON_PARSER* parser, JSON_INPUT_POS* p_pos)
+{
+    JSON_PARSER saved;
+    size_t max_retained_size = parser->config.max_retained_size;
+    int ret;
+
+    ret = json_finish(parser, p_pos);
+
+    if(max_retained_size != 0) {
+        if(parser->nesting_stack_size > max_retained_size) {
+            json_free(parser->config.allocator, parser->nesting_stack);
+            parser->nesting_stack = NULL;
+            parser->nesting_stack_size = 0;
+        }
+        if(parser->buf_alloced > max_retained_size) {
+            json_free(parser->config.allocator, parser->buf);
+            parser->buf = NULL;
+            parser->buf_alloced = 0;
+        }
+    }
+
+    if(parser->projection != NULL) {
+        parser->projection->all_level = 0;
+        parser->projection->key_pending = 0;
+    }
+
+    /* Keep only what survives the reset. */
+    memcpy(&saved, parser, sizeof(JSON_PARSER));
+    memset(parser, 0, sizeof(JSON_PARSER));
+    memcpy(&parser->callbacks, &saved.callbacks, sizeof(JSON_CALLBACKS));
+    memcpy(&parser->callbacks_ex, &saved.callbacks_ex, sizeof(JSON_CALLBACKS_EX));
+    memcpy(&parser->config, &saved.config, sizeof(JSON_CONFIG));
+    parser->user_data = saved.user_data;
+    parser->nesting_stack = saved.nesting_stack;
+    parser->nesting_stack_size = saved.nesting_stack_size;
+    parser->buf = saved.buf;
+    parser->buf_alloced = saved.buf_alloced;
+    parser->projection = saved.projection;
+
+    json_init_state(parser);
+    return ret;
+}
+
+int
+json_parse(const char* input, size_t size,
+           const JSON_CALLBACKS* callbacks, const JSON_CONFIG* config,
+           void* user_data, JSON_INPUT_POS* p_pos)
+{
+    JSON_PARSER parser;
+    int ret;
+
+    ret = json_init(&parser, callbacks, config, user_data);
+    if(ret != 0)
+        return ret;
+
+    /* We rely on propagation of any error code into json_fini(). */
+    json_feed_last(&parser, input, size);
+
+    return json_fini(&parser, p_pos);
+}
+
+int
+json_parse_ex(const char* input, size_t size,
+              const JSON_CALLBACKS_EX* callbacks, const JSON_CONFIG* config,
+              void* user_data, JSON_INPUT_POS* p_pos)
+{
+    JSON_PARSER parser;
+    int ret;
+
+    ret = json_init_ex(&parser, callbacks, config, user_data);
+    if(ret != 0)
+        return ret;
 
-                if(parser->substate != 0) {
-                    if(json_buf_append(parser, &ch, 1) != 0)
-                        break;
-                }
-            }
-        } else if(parser->substate <= 7) {
-            /* Should be trailing UTF-8 byte. */
-            if(parser->substate <= 3  &&  ((unsigned char)(ch) & 0xc0) == 0x80) {
-                parser->substate--;
-            } else if(parser->substate == 4  &&  IS_IN(ch, 0xa0, 0xbf)) {
-                parser->substate = 1;
-            } else if(parser->substate == 5  &&  IS_IN(ch, 0x80, 0x9f)) {
-                parser->substate = 1;
-            } else if(parser->substate == 6  &&  IS_IN(ch, 0x90, 0xbf)) {
-                parser->substate = 2;
-            } else if(parser->substate == 7  &&  IS_IN(ch, 0x80, 0x8f)) {
-                parser->substate = 2;
-            } else if(fix_ill_utf8) {
-                /* From Unicode Standard 10.0, best practice for ill-formed
-                 * UTF-8 sequence:
-                 *
-                 * > Whenever an unconvertible offset is reached during
-                 * > conversion of a code unit sequence:
-                 * >  1. The maximal subpart at that offset should be replaced
-                 * >     by a single U+fffd.
-                 * >  2. The conversion should proceed at the offset immediately
-                 * >     after the maximal subpart.
-                 *
-                 * I.e. we want to emit U+fffd instead of the incorrect sequence
-                 * BEFORE the current offset, because current byte is something
-                 * different then the predecessor expected.
-                 *
-                 * I.e. we have to go back to the previous leading byte
-                 * (including it).
-                 */
-                while(((unsigned char)(parser->buf[parser->buf_used-1]) & 0xc0) == 0x80)
-                    parser->buf_used--; /* Cancel all the trailing bytes. */
-                parser->buf_used--;     /* Cancel the leading byte. */
-                if(json_buf_append(parser, fffd, fffd_size) != 0)
-                    break;
+    /* We rely on propagation of any error code into json_fini(). */
+    json_feed_last(&parser, input, size);
 
-                /* And now we have to replay the current byte in state == 0
-                 * because it may be ASCII or correct leading byte of the
-                 * following character or something. */
-                parser->substate = 0;
-                continue;
-            } else {
-                json_raise(parser, JSON_ERR_INVALIDUTF8);
-                break;
-            }
+    return json_fini(&parser, p_pos);
+}
 
-            if(json_buf_append(parser, &ch, 1) != 0)
-                break;
-        } else if(parser->substate == '\\') {
-            /* Handle 2nd character of an escape sequence. */
-            if(ch == 'u') {
-                /* Expecting 4 hex digits. */
-                parser->substate = 0xabcd + 4;
-                parser->codepoint[0] = parser->codepoint[1] = 0;
-            } else {
-                switch(ch) {
-                    case '\"':  ch = '\"'; break;
-                    case '\\':  ch = '\\'; break;
-                    case '/':   ch = '/'; break;
-                    case 'b':   ch = '\b'; break;
-                    case 'f':   ch = '\f'; break;
-                    case 'n':   ch = '\n'; break;
-                    case 'r':   ch = '\r'; break;
-                    case 't':   ch = '\t'; break;
-                    default:    json_raise(parser, JSON_ERR_INVALIDESCAPE); return off;
-                }
+int
+json_validate(const char* input, size_t size, const JSON_CONFIG* config,
+              JSON_INPUT_POS* p_pos)
+{
+    static const JSON_CALLBACKS_EX no_callbacks = { NULL };
+    JSON_PARSER parser;
+    int ret;
 
-                if(json_buf_append(parser, &ch, 1) != 0)
-                    break;
-                parser->substate = 0;
-            }
-        } else if(parser->substate > 0xabcd) {
-            /* Handle body of the '\uABCD' style escape.
-             *
-             * This is quite complex because JSON standard allows either
-             * any non-surrogate codepoint <= U+ffff or two long escapes
-             * forming UTF-16 surrogate pair for codepoints > U+ffff.
-             *
-             * Naturally, surrogate codepoints not forming the pair (e.g.
-             * orphan or two hi surrogates) make ill-formed UTF-8 string.
-             */
-            if(!IS_XDIGIT(ch)) {
-                json_raise(parser, JSON_ERR_INVALIDESCAPE);
-                return off;
-            }
+    /* Without any callback, the parser collects no data at all (see
+     * json_wants_data()), so it needs no memory but the nesting stack. */
+    ret = json_init_ex(&parser, &no_callbacks, config, NULL);
+    if(ret != 0)
+        return ret;
 
-            parser->codepoint[1] <<= 4;
-            parser->codepoint[1] |= json_resolve_xdigit(ch);
-            parser->substate--;
+    /* We rely on propagation of any error code into json_fini(). */
+    json_feed_last(&parser, input, size);
 
-            if(parser->substate == 0xabcd) {
-                /* We have completed the long escape. */
-                if(parser->codepoint[0] != 0  &&  !IS_LO_SURROGATE(parser->codepoint[1])) {
-                    /* parser->codepoint[0] is unexpected high surrogate. */
-                    if(json_handle_ill_surrogate(parser, parser->codepoint[0], ignore_ill_utf8, fix_ill_utf8) != 0)
-                        break;
+    return json_fini(&parser, p_pos);
+}
 
-                    /* Propagate below to handle parser->codepoint[1] as if no
-                     * high surrogate precedes. */
-                    parser->codepoint[0] = 0;
-                }
 
-                if(parser->codepoint[0] == 0  &&  IS_LO_SURROGATE(parser->codepoint[1])) {
-                    /* parser->codepoint[1] is unexpected low surrogate. */
-                    if(json_handle_ill_surrogate(parser, parser->codepoint[1], ignore_ill_utf8, fix_ill_utf8) != 0)
-                        break;
-                    parser->substate = 0;
-                } else if(parser->codepoint[0] != 0  &&  IS_LO_SURROGATE(parser->codepoint[1])) {
-                    /* parser->codepoint[0] & [1] form valid surrogate pair. */
-                    uint32_t hi = parser->codepoint[0];
-                    uint32_t lo = parser->codepoint[1];
-                    uint32_t codepoint = 0x10000 + (hi - 0xd800) * 0x400 + (lo - 0xdc00);
-                    if(json_buf_append_codepoint(parser, codepoint) != 0)
-                        break;
-                    parser->substate = 0;
-                } else if(IS_HI_SURROGATE(parser->codepoint[1])) {
-                    /* parser->codepoint[1] is high surrogate. Store it and we
-                     * see later if low surrogate follows. */
-                    parser->codepoint[0] = parser->codepoint[1];
-                    parser->substate = 0xabcd - 2;
-                } else {
-                    /* parser->codepoint[1] is non-surrogate codepoint. */
-                    if(json_buf_append_codepoint(parser, parser->codepoint[1]) != 0)
-                        break;
-                    parser->substate = 0;
-                }
 
-                parser->codepoint[1] = 0;
-            }
-        } else if(parser->substate >= 0xabcd - 2) {
-            /* We are just after high surrogate and expect another long escape,
-             * this time for the low surrogate. */
-            if(parser->substate == 0xabcd - 2  &&  ch == '\\') {
-                parser->substate = 0xabcd - 1;
-            } else if(parser->substate == 0xabcd - 1  &&  ch == 'u') {
-                parser->substate = 0xabcd + 4;
-            } else {
-                if(json_handle_ill_surrogate(parser, parser->codepoint[0], ignore_ill_utf8, fix_ill_utf8) != 0)
-                    break;
+/**************************
+ *** Two-stage parsing ***
+ **************************/
 
-                /* Replay the current byte as if no high surrogate precedes. */
-                parser->codepoint[0] = 0;
-                parser->substate = (parser->substate == 0xabcd - 1) ? '\\' : 0;
-                continue;
-            }
-        } else {
-            json_raise(parser, JSON_ERR_INTERNAL);
-            break;
-        }
+/* json_parse_indexed() works in two stages:
+ *
+ * (1) The input is classified in 64-byte blocks, using the SIMD helpers where
+ *     available, and offsets of all tokens are collected into an index. A
+ *     token here is any structural char ('[', ']', '{', '}', ':', ','), new
+ *     line, opening quote of a string, or the 1st char of any other value,
+ *     as long as it is outside of any string.
+ *
+ * (2) The parser walks the index. Each token is handed to the usual automata,
+ *     so all validation, limits and error reporting work as with json_feed().
+ *     But whenever we know only blanks may follow until the next token, we
+ *     jump over them at once.
+ *
+ * The index is built lazily for windows of JSON_INDEX_WINDOW bytes so the
+ * memory needed does not depend on the input size. (Note the stage (2) never
+ * trusts the index blindly: Whenever it ends up somewhere else then on a
+ * token, e.g. after a number or a literal, it falls back to the per-byte
+ * processing until it meets the next token again.)
+ */
 
-        off++;
-        parser->pos.offset++;
-        parser->pos.column_number++;
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#define JSON_INDEX_WINDOW       (16 * 1024)     /* Must be multiple of 64. */
+
+/* Bit masks describing a 64-byte block of the input. (Bit i corresponds to
+ * i-th byte of the block.) */
+typedef struct JSON_BLOCK_MASKS {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t blank;             /* ' ' or '\t' */
+    uint64_t new_line;          /* '\r' or '\n' */
+    uint64_t structural;        /* '[', ']', '{', '}', ':' or ',' */
+} JSON_BLOCK_MASKS;
+
+/* State carried over from one block to the next one. */
+typedef struct JSON_INDEXER {
+    uint64_t prev_escaped;      /* 1 if 1st byte of the next block is escaped. */
+    uint64_t prev_in_string;    /* All bits set if the next block begins in a string. */
+    uint64_t prev_scalar;       /* 1 if last byte of the block belongs to a scalar. */
+} JSON_INDEXER;
+
+static inline unsigned
+json_ctz64(uint64_t mask)
+{
+#if defined __GNUC__ || defined __clang__
+    return (unsigned) __builtin_ctzll(mask);
+#elif defined _MSC_VER && (defined _M_X64 || defined _M_ARM64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (unsigned) index;
+#else
+    unsigned n = 0;
+
+    if((mask & 0xffffffff) == 0) {
+        mask >>= 32;
+        n += 32;
+    }
+    while(!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+#ifdef JSON_SSE2
+static void
+json_sse2_classify_block(const char* block, JSON_BLOCK_MASKS* masks)
+{
+    int i;
+
+    memset(masks, 0, sizeof(JSON_BLOCK_MASKS));
+
+    for(i = 0; i < 4; i++) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+        /* This maps '[' to '{', and ']' to '}'. */
+        __m128i x20 = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        unsigned shift = 16 * i;
+
+        masks->backslash |= (uint64_t) (unsigned) _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))) << shift;
+        masks->quote |= (uint64_t) (unsigned) _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8('\"'))) << shift;
+        masks->blank |= (uint64_t) (unsigned) _mm_movemask_epi8(_mm_or_si128(
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')))) << shift;
+        masks->new_line |= (uint64_t) (unsigned) _mm_movemask_epi8(_mm_or_si128(
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8('\r')),
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')))) << shift;
+        masks->structural |= (uint64_t) (unsigned) _mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(x20, _mm_set1_epi8('{')),
+                                 _mm_cmpeq_epi8(x20, _mm_set1_epi8('}'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(':')),
+                                 _mm_cmpeq_epi8(x, _mm_set1_epi8(','))))) << shift;
     }
+}
+#endif
 
-    if(max_len != 0  &&  parser->pos.offset - parser->value_pos.offset > max_len)
-        json_raise_for_value(parser, (type == JSON_KEY)
-                    ? JSON_ERR_MAXKEYLEN : JSON_ERR_MAXSTRINGLEN);
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static inline uint64_t
+json_avx2_mask64(__m256i lo, __m256i hi)
+{
+    return (uint64_t) (unsigned) _mm256_movemask_epi8(lo) |
+           ((uint64_t) (unsigned) _mm256_movemask_epi8(hi) << 32);
+}
 
-    if(input == NULL)   /* EOF */
-        json_raise_for_value(parser, JSON_ERR_UNCLOSEDSTRING);
+JSON_TARGET_AVX2 static void
+json_avx2_classify_block(const char* block, JSON_BLOCK_MASKS* masks)
+{
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i lbrace = _mm256_set1_epi8('{');
+    const __m256i rbrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i bit20 = _mm256_set1_epi8(0x20);
+    __m256i lo = _mm256_loadu_si256((const __m256i*) block);
+    __m256i hi = _mm256_loadu_si256((const __m256i*) (block + 32));
+    /* This maps '[' to '{', and ']' to '}'. */
+    __m256i lo20 = _mm256_or_si256(lo, bit20);
+    __m256i hi20 = _mm256_or_si256(hi, bit20);
+
+    masks->backslash = json_avx2_mask64(_mm256_cmpeq_epi8(lo, backslash), _mm256_cmpeq_epi8(hi, backslash));
+    masks->quote = json_avx2_mask64(_mm256_cmpeq_epi8(lo, quote), _mm256_cmpeq_epi8(hi, quote));
+    masks->blank = json_avx2_mask64(
+                _mm256_or_si256(_mm256_cmpeq_epi8(lo, space), _mm256_cmpeq_epi8(lo, tab)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(hi, space), _mm256_cmpeq_epi8(hi, tab)));
+    masks->new_line = json_avx2_mask64(
+                _mm256_or_si256(_mm256_cmpeq_epi8(lo, cr), _mm256_cmpeq_epi8(lo, lf)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(hi, cr), _mm256_cmpeq_epi8(hi, lf)));
+    masks->structural = json_avx2_mask64(
+                _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(lo20, lbrace), _mm256_cmpeq_epi8(lo20, rbrace)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(lo, colon), _mm256_cmpeq_epi8(lo, comma))),
+                _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(hi20, lbrace), _mm256_cmpeq_epi8(hi20, rbrace)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(hi, colon), _mm256_cmpeq_epi8(hi, comma))));
+}
+#endif
 
-    return off;
+static void
+json_classify_block(const char* block, JSON_BLOCK_MASKS* masks)
+{
+#ifdef JSON_AVX2
+    if(json_cpu_has_avx2()) {
+        json_avx2_classify_block(block, masks);
+        return;
+    }
+#endif
+#ifdef JSON_SSE2
+    json_sse2_classify_block(block, masks);
+#else
+    int i;
+
+    memset(masks, 0, sizeof(JSON_BLOCK_MASKS));
+
+    for(i = 0; i < 64; i++) {
+        uint64_t bit = (uint64_t) 1 << i;
+
+        switch(block[i]) {
+            case '\\':  masks->backslash |= bit; break;
+            case '\"':  masks->quote |= bit; break;
+            case ' ':
+            case '\t':  masks->blank |= bit; break;
+            case '\r':
+            case '\n':  masks->new_line |= bit; break;
+            case '[':
+            case ']':
+            case '{':
+            case '}':
+            case ':':
+            case ',':   masks->structural |= bit; break;
+        }
+    }
+#endif
 }
 
+/* Append offsets of all tokens in the block to `index`. Returns the count. */
 static size_t
-json_dispatch(JSON_PARSER* parser, const char* input, size_t size)
+json_index_block(JSON_INDEXER* indexer, const char* block, size_t block_off,
+                 size_t* index)
 {
-    switch(parser->automaton) {
-        case AUTOMATON_NULL:    return json_literal_automaton(parser, input, size, JSON_NULL, "null", 4);
-        case AUTOMATON_FALSE:   return json_literal_automaton(parser, input, size, JSON_FALSE, "false", 5);
-        case AUTOMATON_TRUE:    return json_literal_automaton(parser, input, size, JSON_TRUE, "true", 4);
-        case AUTOMATON_NUMBER:  return json_number_automaton(parser, input, size);
-        case AUTOMATON_STRING:  return json_string_automaton(parser, input, size, JSON_STRING);
-        case AUTOMATON_KEY:     return json_string_automaton(parser, input, size, JSON_KEY);
+    JSON_BLOCK_MASKS masks;
+    uint64_t backslash;
+    uint64_t escaped;
+    uint64_t quote;
+    uint64_t in_string;
+    uint64_t scalar;
+    uint64_t tokens;
+    size_t n = 0;
+
+    json_classify_block(block, &masks);
+
+    /* Find escaped chars. Backslashes are rare so just walk them. (Any
+     * backslash escapes the next byte, unless the backslash itself is
+     * escaped.) */
+    escaped = indexer->prev_escaped;
+    indexer->prev_escaped = 0;
+    backslash = masks.backslash & ~escaped;
+    while(backslash != 0) {
+        unsigned i = json_ctz64(backslash);
+
+        if(i == 63) {
+            indexer->prev_escaped = 1;
+            break;
+        }
+        escaped |= (uint64_t) 1 << (i+1);
+        backslash &= ~((uint64_t) 3 << i);
+    }
+    quote = masks.quote & ~escaped;
+
+    /* Prefix XOR: The bit is set for the opening quote and the string body,
+     * but not for the closing quote. */
+    in_string = quote;
+    in_string ^= in_string << 1;
+    in_string ^= in_string << 2;
+    in_string ^= in_string << 4;
+    in_string ^= in_string << 8;
+    in_string ^= in_string << 16;
+    in_string ^= in_string << 32;
+    in_string ^= indexer->prev_in_string;
+    indexer->prev_in_string = (uint64_t) 0 - (in_string >> 63);
+
+    /* Anything else outside strings is part of a scalar value (or an error);
+     * we need only the 1st byte of each. */
+    scalar = ~(masks.blank | masks.new_line | masks.structural | quote | in_string);
+    tokens = ((masks.structural | masks.new_line) & ~in_string) |
+             (quote & in_string) |
+             (scalar & ~((scalar << 1) | indexer->prev_scalar));
+    indexer->prev_scalar = scalar >> 63;
+
+    while(tokens != 0) {
+        index[n++] = block_off + json_ctz64(tokens);
+        tokens &= tokens - 1;
     }
 
-    json_raise(parser, JSON_ERR_INTERNAL);
-    return 0;
+    return n;
 }
 
-static void
-json_handle_new_line(JSON_PARSER* parser, char ch)
+/* Index next window of the input. Returns count of tokens stored in `index`. */
+static size_t
+json_build_index(JSON_INDEXER* indexer, const char* input, size_t size,
+                 size_t* p_indexed_len, size_t* index)
 {
-    if(ch == '\r') {
-        parser->last_cl_offset = parser->pos.offset;
-        parser->pos.line_number++;
-        parser->pos.column_number = FIRST_COLUMN_NUMBER;
-    } else if(ch == '\n') {
-        if(!(parser->pos.offset == parser->last_cl_offset + 1))
-            parser->pos.line_number++;
-        parser->pos.column_number = FIRST_COLUMN_NUMBER;
+    size_t end = *p_indexed_len + JSON_INDEX_WINDOW;
+    size_t n = 0;
+
+    if(end > size)
+        end = size;
+
+    while(*p_indexed_len < end) {
+        size_t block_off = *p_indexed_len;
+
+        if(block_off + 64 <= size) {
+            n += json_index_block(indexer, input + block_off, block_off, index + n);
+            *p_indexed_len = block_off + 64;
+        } else {
+            /* Pad the incomplete tail block with blanks. */
+            char tail[64];
+
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, input + block_off, size - block_off);
+            n += json_index_block(indexer, tail, block_off, index + n);
+            *p_indexed_len = size;
+        }
     }
+
+    return n;
 }
 
 int
-json_feed(JSON_PARSER* parser, const char* input, size_t size)
+json_parse_indexed(const char* input, size_t size,
+                   const JSON_CALLBACKS* callbacks, const JSON_CONFIG* config,
+                   void* user_data, JSON_INPUT_POS* p_pos)
 {
+    JSON_PARSER parser;
+    JSON_INDEXER indexer;
+    JSON_INPUT_POS checkpoint;
+    size_t checkpoint_last_cl_offset;
+    size_t* index;
+    size_t index_size = 0;
+    size_t index_pos = 0;
+    size_t indexed_len = 0;
     size_t off = 0;
-    char ch;
+    int only_blanks = 0;    /* Only blanks may follow until the next token. */
+    int ret;
 
-    if(parser->config.max_total_len != 0  &&
-       parser->pos.offset + size > parser->config.max_total_len)
+    ret = json_init(&parser, callbacks, config, user_data);
+    if(ret != 0)
+        return ret;
+
+    index = (size_t*) json_malloc(parser.config.allocator, JSON_INDEX_WINDOW * sizeof(size_t));
+    if(index == NULL  ||  (parser.config.max_total_len != 0  &&
+                           size > parser.config.max_total_len))
     {
-        /* Update parser->pos to point to the exact place. */
-        while(parser->pos.offset < parser->config.max_total_len) {
-            parser->pos.offset++;
-            parser->pos.column_number++;
-            off++;
-            json_handle_new_line(parser, input[off]);
+        /* Leave it to json_feed(): It can do without the index, and it also
+         * knows how to report the exceeded limit. */
+        json_free(parser.config.allocator, index);
+        json_feed(&parser, input, size);
+        return json_fini(&parser, p_pos);
+    }
+
+    memset(&indexer, 0, sizeof(JSON_INDEXER));
+    memcpy(&checkpoint, &parser.pos, sizeof(JSON_INPUT_POS));
+    checkpoint_last_cl_offset = parser.last_cl_offset;
+
+    while(off < size  &&  parser.errcode == 0) {
+        size_t next;
+        size_t n;
+
+        /* If we have active any sub-automaton, let it process the value. */
+        if(parser.automaton != AUTOMATON_MAIN) {
+            off += json_dispatch(&parser, input+off, size-off);
+            only_blanks = 0;
+            continue;
+        }
+
+        /* Find the next token. */
+        while(index_pos < index_size  &&  index[index_pos] < off)
+            index_pos++;
+        if(index_pos < index_size) {
+            next = index[index_pos];
+        } else if(indexed_len < size) {
+            index_size = json_build_index(&indexer, input, size, &indexed_len, index);
+            index_pos = 0;
+            continue;
+        } else {
+            next = size;
+        }
+
+        if(off < next) {
+            if(!only_blanks) {
+                off += json_main_automaton(&parser, input+off, 1, 0);
+                continue;
+            }
+
+            parser.pos.offset += next - off;
+            parser.pos.column_number += (unsigned) (next - off);
+            off = next;
+            if(off >= size)
+                break;
+        }
+
+        /* Try to handle the whole value at once. */
+        n = json_scan_value(&parser, input + off, size - off, 1);
+        if(n > 0) {
+            off += n;
+            /* After a string, we know only blanks can follow until the next
+             * token. Not so after a number or a literal. */
+            only_blanks = (input[off-1] == '\"');
+            continue;
         }
 
-        json_raise(parser, JSON_ERR_MAXTOTALLEN);
+        off += json_main_automaton(&parser, input+off, 1, 0);
+        only_blanks = (parser.automaton == AUTOMATON_MAIN);
+    }
+
+    if(parser.config.flags & JSON_LAZYPOS)
+        json_resolve_pos(&parser, &checkpoint, checkpoint_last_cl_offset, input);
+
+    json_free(parser.config.allocator, index);
+    return json_fini(&parser, p_pos);
+}
+
+/* The cursor's callback only records the event and pauses the parser. */
+static int
+json_cursor_callback(JSON_TYPE type, const char* data, size_t size, void* user_data)
+{
+    JSON_CURSOR* cursor = (JSON_CURSOR*) user_data;
+
+    /* With JSON_MULTIDOC, the last value of a document and JSON_DOCUMENT_END
+     * come together (see json_end_document()). */
+    if(cursor->has_event) {
+        cursor->document_end_pending = 1;
+        return JSON_PAUSE;
     }
 
-    while(off < size  &&  parser->errcode == 0) {
-        ch = input[off];
+    cursor->has_event = 1;
+    cursor->type = type;
+    cursor->data = data;
+    cursor->data_size = size;
+    return JSON_PAUSE;
+}
 
-        /* If we have active any sub-automaton, let it process the character. */
-        if(parser->automaton != AUTOMATON_MAIN) {
-            size_t n = json_dispatch(parser, input+off, size-off);
+int
+json_cursor_init(JSON_CURSOR* cursor, const char* input, size_t size,
+                 const JSON_CONFIG* config)
+{
+    static const JSON_CALLBACKS callbacks = { json_cursor_callback };
 
-            if(parser->errcode != 0)
-                return parser->errcode;
+    cursor->input = input;
+    cursor->size = size;
+    cursor->off = 0;
+    cursor->finished = 0;
+    cursor->has_event = 0;
+    cursor->document_end_pending = 0;
 
-            off += n;
-            continue;
-        }
+    return json_init(&cursor->parser, &callbacks, config, (void*) cursor);
+}
 
-        /* Main automaton. */
-        if((parser->state & CAN_SEE_VALUE)  &&  (ch == '[' || ch == '{')) {
-            /* Begin of array or object. */
-            if(parser->config.max_nesting_level != 0  &&
-               parser->nesting_level >= parser->config.max_nesting_level) {
-                json_raise(parser, JSON_ERR_MAXNESTINGLEVEL);
-                break;
-            }
+int
+json_cursor_next(JSON_CURSOR* cursor, JSON_TYPE* p_type,
+                 const char** p_data, size_t* p_data_size)
+{
+    JSON_PARSER* parser = &cursor->parser;
+    size_t n;
+    int ret;
 
-            if(parser->nesting_level >= parser->nesting_stack_size) {
-                char* new_nesting_stack;
-                size_t new_nesting_stack_size = parser->nesting_stack_size * 2;
+    cursor->has_event = 0;
 
-                if(new_nesting_stack_size == 0)
-                    new_nesting_stack_size = 32;
-                new_nesting_stack = (char*) realloc(parser->nesting_stack, new_nesting_stack_size);
-                if(new_nesting_stack == NULL) {
-                    json_raise(parser, JSON_ERR_OUTOFMEMORY);
-                    break;
-                }
+    if(cursor->document_end_pending) {
+        cursor->document_end_pending = 0;
+        json_cursor_callback(JSON_DOCUMENT_END, NULL, 0, (void*) cursor);
+    }
 
-                parser->nesting_stack = new_nesting_stack;
-                parser->nesting_stack_size = new_nesting_stack_size;
-            }
-            parser->nesting_stack[parser->nesting_level++] = (ch == '[') ? ']' : '}';
-            json_process(parser, (ch == '[') ? JSON_ARRAY_BEG : JSON_OBJECT_BEG, NULL, 0);
-        } else if((parser->state & CAN_SEE_CLOSER)  &&  (ch == ']' || ch == '}')) {
-            /* End of array or object. */
-            if(parser->nesting_stack[parser->nesting_level-1] != ch) {
-                json_raise(parser, JSON_ERR_BADCLOSER);
-                break;
-            }
-            parser->nesting_level--;
-            json_process(parser, (ch == ']') ? JSON_ARRAY_END : JSON_OBJECT_END, NULL, 0);
-        } else if((parser->state & CAN_SEE_COMMA)  &&  ch == ',') {
-            if(parser->nesting_stack[parser->nesting_level - 1] == ']')
-                parser->state = CAN_SEE_VALUE;
-            else
-                parser->state = CAN_SEE_KEY;
-        } else if((parser->state & CAN_SEE_COLON)  &&  ch == ':') {
-            parser->state = CAN_SEE_VALUE;
-        } else if((parser->state & CAN_SEE_VALUE)  &&  ch == '"') {
-            json_switch_automaton(parser, AUTOMATON_STRING);
-        } else if((parser->state & CAN_SEE_KEY)  &&  ch == '"') {
-            json_switch_automaton(parser, AUTOMATON_KEY);
-        } else if((parser->state & CAN_SEE_VALUE)  &&
-                  (('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z'))) {
-            switch(ch) {
-                case 'n':   json_switch_automaton(parser, AUTOMATON_NULL); break;
-                case 'f':   json_switch_automaton(parser, AUTOMATON_FALSE); break;
-                case 't':   json_switch_automaton(parser, AUTOMATON_TRUE); break;
-                default:    json_raise(parser, JSON_ERR_SYNTAX); break;
-            }
-            continue;
-        } else if((parser->state & CAN_SEE_VALUE)  &&  (IS_DIGIT(ch) || ch == '-')) {
-            json_switch_automaton(parser, AUTOMATON_NUMBER);
-            continue;
-        } else if(!IS_WHITESPACE(ch)) {
-            json_raise_unexpected(parser);
-            break;
+    while(!cursor->has_event) {
+        if(cursor->off < cursor->size) {
+            /* We have the whole input so the faster scanners can be used. */
+            ret = json_feed_(parser, cursor->input + cursor->off,
+                        cursor->size - cursor->off, 1, &n);
+            cursor->off += n;
+        } else if(!cursor->finished) {
+            /* Flush the last value (if needed) and check the document is
+             * complete. */
+            cursor->finished = 1;
+            ret = json_finish(parser, NULL);
+        } else {
+            ret = parser->errcode;
+            if(ret == 0)
+                return JSON_CURSOR_END;
         }
 
-        /* Advance to next char. */
-        off++;
-        parser->pos.offset++;
-        parser->pos.column_number++;
-        json_handle_new_line(parser, ch);
+        if(ret != 0  &&  ret != JSON_PAUSE) {
+            /* json_finish() may flush the last value and fail right after
+             * that (e.g. " [n"). The event goes first; the error is then
+             * returned by the next call. */
+            if(cursor->has_event)
+                break;
+            return ret;
+        }
     }
 
-    return parser->errcode;
+    if(p_type != NULL)
+        *p_type = cursor->type;
+    if(p_data != NULL)
+        *p_data = cursor->data;
+    if(p_data_size != NULL)
+        *p_data_size = cursor->data_size;
+    return 0;
 }
 
 int
-json_fini(JSON_PARSER* parser, JSON_INPUT_POS* p_pos)
+json_cursor_skip(JSON_CURSOR* cursor)
 {
-    /* Some automaton may need some flushing. */
-    if(parser->errcode == 0) {
-        if(parser->automaton != AUTOMATON_MAIN) {
-            parser->pos.offset += json_dispatch(parser, NULL, 0);
+    JSON_PARSER* parser = &cursor->parser;
 
-            if(parser->automaton != AUTOMATON_MAIN) {
-                json_raise(parser, JSON_ERR_SYNTAX);
-            }
-        } else if(parser->nesting_level != 0  ||  !(parser->state & CAN_SEE_EOF)) {
-            json_raise_unexpected(parser);
-        }
-    }
+    if(!cursor->has_event)
+        return parser->errcode;
 
-    if(p_pos != NULL) {
-        memcpy(p_pos, (parser->errcode == 0) ? &parser->pos : &parser->err_pos,
-                sizeof(JSON_INPUT_POS));
+    switch(cursor->type) {
+        case JSON_KEY:
+            /* The value lives on the current level (or it opens the next one). */
+            parser->skip_level = parser->nesting_level + 1;
+            break;
+
+        case JSON_ARRAY_BEG:
+        case JSON_OBJECT_BEG:
+            /* The array/object is already pushed. */
+            parser->skip_level = parser->nesting_level;
+            break;
+
+        default:
+            return 0;
     }
 
-    free(parser->nesting_stack);
-    free(parser->buf);
-    return parser->errcode;
+    /* Unlike with JSON_SKIP, do not report the closer. */
+    parser->skip_closer = 0;
+    cursor->has_event = 0;
+    return 0;
 }
 
-int
-json_parse(const char* input, size_t size,
-           const JSON_CALLBACKS* callbacks, const JSON_CONFIG* config,
-           void* user_data, JSON_INPUT_POS* p_pos)
+const JSON_NUMBER_INFO*
+json_cursor_number_info(const JSON_CURSOR* cursor)
 {
-    JSON_PARSER parser;
-    int ret;
+    return &cursor->parser.num_info;
+}
 
-    ret = json_init(&parser, callbacks, config, user_data);
-    if(ret != 0)
-        return ret;
+int
+json_cursor_string_has_escapes(const JSON_CURSOR* cursor)
+{
+    return cursor->parser.str_has_escapes;
+}
 
-    /* We rely on propagation of any error code into json_fini(). */
-    json_feed(&parser, input, size);
+int
+json_cursor_fini(JSON_CURSOR* cursor, JSON_INPUT_POS* p_pos)
+{
+    /* Validate also whatever the application has not asked for. */
+    while(json_cursor_next(cursor, NULL, NULL, NULL) == 0)
+        ;
 
-    return json_fini(&parser, p_pos);
+    return json_fini(&cursor->parser, p_pos);
 }
 
 
@@ -1090,243 +5026,1230 @@ json_number_to_uint64(const char* num, size_t num_size)
 }
 
 
-#define MALLOCA_THRESHOLD         256
+int
+json_number_to_double(const char* num, size_t num_size, double* p_result)
+{
+    size_t off = 0;
+    uint64_t w = 0;
+    int q = 0;
+    int is_neg = 0;
+    int is_dropped = 0;
+    int is_inexact = 0;
 
-#ifdef _WIN32
-    #ifndef alloca
-        #define alloca  _alloca
-    #endif
-#endif
+    /* Decompose the number into w * 10^q, w holding as many leading
+     * significant digits as fit in. */
+    if(off < num_size  &&  num[off] == '-') {
+        is_neg = 1;
+        off++;
+    }
 
-static void*
-malloca_set_mark(void* ptr, int mark)
-{
-    if(ptr != NULL) {
-        int* x = (int*)ptr;
-        *x = mark;
-        ptr = (void*)((char*)ptr + sizeof(void*));
+    while(off < num_size  &&  IS_DIGIT(num[off])) {
+        unsigned digit = num[off++] - '0';
+
+        if(!is_dropped  &&  w <= (UINT64_MAX - digit) / 10) {
+            w = w * 10 + digit;
+        } else {
+            is_dropped = 1;
+            if(digit != 0)
+                is_inexact = 1;
+            q++;
+        }
+    }
+
+    if(off < num_size  &&  num[off] == '.') {
+        off++;
+        while(off < num_size  &&  IS_DIGIT(num[off])) {
+            unsigned digit = num[off++] - '0';
+
+            if(!is_dropped  &&  w <= (UINT64_MAX - digit) / 10) {
+                w = w * 10 + digit;
+                q--;
+            } else {
+                is_dropped = 1;
+                if(digit != 0)
+                    is_inexact = 1;
+            }
+        }
     }
-    return ptr;
+
+    if(off < num_size  &&  (num[off] == 'e' || num[off] == 'E')) {
+        int is_exp_neg = 0;
+        int exp = 0;
+
+        off++;
+        if(off < num_size  &&  (num[off] == '+' || num[off] == '-')) {
+            is_exp_neg = (num[off] == '-');
+            off++;
+        }
+        while(off < num_size  &&  IS_DIGIT(num[off])) {
+            /* Anything above this is out of range of double anyway. */
+            if(exp < 100000)
+                exp = exp * 10 + (num[off] - '0');
+            off++;
+        }
+        q += (is_exp_neg ? -exp : exp);
+    }
+
+    *p_result = json_decimal_to_double(w, q, is_neg, is_inexact, num, num_size);
+    return 0;
 }
 
-#define MALLOCA_(size, threshold)                                           \
-    ((size) < (threshold) - sizeof(void*)                                   \
-        ? malloca_set_mark(alloca(size + sizeof(void*)), 0xcccc)            \
-        : malloca_set_mark(malloc(size + sizeof(void*)), 0xdddd))
 
-#define MALLOCA(size)       MALLOCA_((size), MALLOCA_THRESHOLD)
+static const char json_digit_pairs[] =
+    "00010203040506070809" "10111213141516171819"
+    "20212223242526272829" "30313233343536373839"
+    "40414243444546474849" "50515253545556575859"
+    "60616263646566676869" "70717273747576777879"
+    "80818283848586878889" "90919293949596979899";
 
-#define FREEA(ptr)                                                          \
-    do {                                                                    \
-        if((ptr) != NULL) {                                                 \
-            int* x = (int*)((char*)(ptr) - sizeof(void*));                  \
-            if(*x == 0xdddd)                                                \
-                free(x);                                                    \
-        }                                                                   \
-    } while(0)
+static inline size_t
+json_count_digits(uint64_t u64)
+{
+    size_t n = 1;
 
-int
-json_number_to_double(const char* num, size_t num_size, double* p_result)
+    while(u64 >= 10000) {
+        u64 /= 10000;
+        n += 4;
+    }
+    if(u64 >= 10)
+        n++;
+    if(u64 >= 100)
+        n++;
+    if(u64 >= 1000)
+        n++;
+    return n;
+}
+
+/* Write the digits of the number, two at a time, backwards from `end`.
+ * (The caller has to make sure there is enough space before `end`.) */
+static inline void
+json_write_digits(char* end, uint64_t u64)
 {
-    struct lconv* lc;
-    size_t dp_len;
-    char* dp;
-    char* buffer;
+    uint32_t u32;
 
-    /* Unfortunately, AFAIK, there is no reasonably easy portable way how to
-     * construct float or double by hand.
-     *
-     * The closest to that ideal is likely strtod() function (mandated by
-     * the C89/90 standard, so hopefully, it is practically everywhere).
-     *
-     * However strtod() has (for us) two strong disadvantages we have to deal
-     * with.
-     *
-     * (1) It expects the string is terminated by '\0' which we do not have
-     *     here.
-     *
-     * (2) Instead of decimal period '.', it may expect other character as
-     *     specified by the current locale.
-     *
-     *     That is an issue on its own since, on some platforms a locale is
-     *     an attribute of thread; on other platforms it is a an attribute
-     *     of process. Some platforms even have some hybrid solution.
-     *
-     *     This means, we (as a library) cannot afford changing the locale to
-     *     "C", even temporarily, as we could easily break multi-threaded
-     *     applications.
-     *
-     * Instead, we create the new string in a temp. buffer following those
-     * requirements.
-     */
+    while(u64 > UINT32_MAX) {
+        unsigned i = (unsigned) (u64 % 100) * 2;
+        u64 /= 100;
+        end -= 2;
+        memcpy(end, json_digit_pairs + i, 2);
+    }
 
-    lc = localeconv();
-    dp_len = strlen(lc->decimal_point);
+    /* The rest fits into 32 bits and so in the cheaper arithmetic. */
+    u32 = (uint32_t) u64;
+    while(u32 >= 100) {
+        unsigned i = (u32 % 100) * 2;
+        u32 /= 100;
+        end -= 2;
+        memcpy(end, json_digit_pairs + i, 2);
+    }
 
-    buffer = (char*) MALLOCA(num_size + dp_len + 1);
-    if(buffer == NULL)
-        return JSON_ERR_OUTOFMEMORY;
+    if(u32 >= 10) {
+        end -= 2;
+        memcpy(end, json_digit_pairs + u32 * 2, 2);
+    } else {
+        *(--end) = '0' + (char) u32;
+    }
+}
 
-    memcpy(buffer, num, num_size);
-    buffer[num_size] = '\0';
+size_t
+json_format_int32(char* buffer, int32_t i32)
+{
+    return json_format_int64(buffer, i32);
+}
 
-    if((dp_len != 1 || lc->decimal_point[0] != '.')  &&  (dp = strchr(buffer, '.')) != NULL) {
-        size_t before_dp_len = (dp - buffer);
-        size_t after_dp_len = num_size - before_dp_len - 1;
+size_t
+json_format_uint32(char* buffer, uint32_t u32)
+{
+    return json_format_uint64(buffer, u32);
+}
 
-        if(dp_len == 1) {
-            buffer[before_dp_len] = lc->decimal_point[0];
-        } else {
-            /* Some exotic locales may use more than one char as the decimal point. */
-            memmove(buffer + before_dp_len + dp_len, buffer + before_dp_len + 1, after_dp_len + 1);
-            memcpy(buffer + before_dp_len, lc->decimal_point, dp_len);
-        }
+size_t
+json_format_int64(char* buffer, int64_t i64)
+{
+    if(i64 < 0) {
+        /* (Unsigned negation is fine even for INT64_MIN.) */
+        buffer[0] = '-';
+        return 1 + json_format_uint64(buffer + 1, (uint64_t) 0 - (uint64_t) i64);
     }
 
-    *p_result = strtod(buffer, NULL);
-
-    FREEA(buffer);
-    return 0;
+    return json_format_uint64(buffer, (uint64_t) i64);
 }
 
+size_t
+json_format_uint64(char* buffer, uint64_t u64)
+{
+    size_t n = json_count_digits(u64);
+
+    json_write_digits(buffer + n, u64);
+    return n;
+}
 
 int
 json_dump_int32(int32_t i32, JSON_DUMP_CALLBACK write_func, void* user_data)
 {
-    return json_dump_int64(i32, write_func, user_data);
+    char buffer[JSON_FORMAT_BUFSIZE];
+    size_t n;
+
+    n = json_format_int32(buffer, i32);
+    return write_func(buffer, n, user_data);
 }
 
 int
 json_dump_uint32(uint32_t u32, JSON_DUMP_CALLBACK write_func, void* user_data)
 {
-    return json_dump_uint64(u32, write_func, user_data);
+    char buffer[JSON_FORMAT_BUFSIZE];
+    size_t n;
+
+    n = json_format_uint32(buffer, u32);
+    return write_func(buffer, n, user_data);
 }
 
 int
 json_dump_int64(int64_t i64, JSON_DUMP_CALLBACK write_func, void* user_data)
 {
-    char buffer[32];
-    size_t off = sizeof(buffer);
-    int is_neg = (i64 < 0);
-
-    if(i64 != 0) {
-        while(i64 != 0) {
-            buffer[--off] = '0' + ABS(i64 % 10);
-            i64 /= 10;
-        }
-
-        if(is_neg)
-            buffer[--off] = '-';
-    } else {
-        buffer[--off] = '0';
-    }
+    char buffer[JSON_FORMAT_BUFSIZE];
+    size_t n;
 
-    return write_func(buffer + off, sizeof(buffer) - off, user_data);
+    n = json_format_int64(buffer, i64);
+    return write_func(buffer, n, user_data);
 }
 
 int
 json_dump_uint64(uint64_t u64, JSON_DUMP_CALLBACK write_func, void* user_data)
 {
-    char buffer[32];
-    size_t off = sizeof(buffer);
-
-    if(u64 != 0) {
-        while(u64 != 0) {
-            buffer[--off] = '0' + (u64 % 10);
-            u64 /= 10;
-        }
-    } else {
-        buffer[--off] = '0';
-    }
+    char buffer[JSON_FORMAT_BUFSIZE];
+    size_t n;
 
-    return write_func(buffer + off, sizeof(buffer) - off, user_data);
+    n = json_format_uint64(buffer, u64);
+    return write_func(buffer, n, user_data);
 }
 
-int
-json_dump_double(double dbl, JSON_DUMP_CALLBACK write_func, void* user_data)
+/* Shortest representation of a double (or float) which reads back as the
+ * same value, using the Ryu algorithm: From the binary value and the interval
+ * of all real numbers rounding to it, we compute the decimal interval (with
+ * the help of 125-bit approximations of powers of 5), and then remove as many
+ * trailing digits as possible while staying within it.
+ *
+ * See Ulf Adams: Ryu: Fast Float-to-String Conversion (PLDI 2018)
+ * <https://github.com/ulfjack/ryu>
+ */
+
+#define RYU_POW5_INV_BITCOUNT   125
+#define RYU_POW5_BITCOUNT       125
+
+/* floor(2^(pow5bits(i) - 1 + RYU_POW5_INV_BITCOUNT) / 5^i) + 1, as { low, high }. */
+static const uint64_t json_ryu_pow5_inv[342][2] = {
+    { 0x0000000000000001, 0x2000000000000000 },
+    { 0x999999999999999a, 0x1999999999999999 },
+    { 0x47ae147ae147ae15, 0x147ae147ae147ae1 },
+    { 0x6c8b4395810624de, 0x10624dd2f1a9fbe7 },
+    { 0x7a786c226809d496, 0x1a36e2eb1c432ca5 },
+    { 0x61f9f01b866e43ab, 0x14f8b588e368f084 },
+    { 0xb4c7f34938583622, 0x10c6f7a0b5ed8d36 },
+    { 0x87a6520ec08d236a, 0x1ad7f29abcaf4857 },
+    { 0x9fb841a566d74f88, 0x15798ee2308c39df },
+    { 0xe62d01511f12a607, 0x112e0be826d694b2 },
+    { 0xd6ae6881cb5109a4, 0x1b7cdfd9d7bdbab7 },
+    { 0xdef1ed34a2a73aea, 0x15fd7fe17964955f },
+    { 0x7f27f0f6e885c8bb, 0x119799812dea1119 },
+    { 0x650cb4be40d60df8, 0x1c25c268497681c2 },
+    { 0xea70909833de7193, 0x16849b86a12b9b01 },
+    { 0x21f3a6e0297ec143, 0x1203af9ee756159b },
+    { 0x6985d7cd0f313537, 0x1cd2b297d889bc2b },
+    { 0x2137dfd73f5a90f9, 0x170ef54646d49689 },
+    { 0xe75fe645cc4873fa, 0x12725dd1d243aba0 },
+    { 0xa5663d3c7a0d865d, 0x1d83c94fb6d2ac34 },
+    { 0x511e976394d79eb1, 0x179ca10c9242235d },
+    { 0xda7edf82dd794bc1, 0x12e3b40a0e9b4f7d },
+    { 0x2a6498d1625bac68, 0x1e392010175ee596 },
+    { 0xeeb6e0a781e2f053, 0x182db34012b25144 },
+    { 0x58924d52ce4f26a9, 0x1357c299a88ea76a },
+    { 0x27507bb7b07ea441, 0x1ef2d0f5da7dd8aa },
+    { 0x52a6c95fc0655034, 0x18c240c4aecb13bb },
+    { 0x0eebd44c99eaa690, 0x13ce9a36f23c0fc9 },
+    { 0xb17953adc3110a80, 0x1fb0f6be50601941 },
+    { 0xc12ddc8b02740867, 0x195a5efea6b34767 },
+    { 0x3424b06f3529a052, 0x14484bfeebc29f86 },
+    { 0x901d59f290ee19db, 0x1039d66589687f9e },
+    { 0x4cfbc31db4b0295f, 0x19f623d5a8a73297 },
+    { 0x3d9635b15d59bab2, 0x14c4e977ba1f5bac },
+    { 0x97ab5e277de16228, 0x109d8792fb4c4956 },
+    { 0xf2abc9d8c9689d0d, 0x1a95a5b7f87a0ef0 },
+    { 0x5bbca17a3aba173e, 0x154484932d2e725a },
+    { 0xafca1ac82efb45cb, 0x11039d428a8b8eae },
+    { 0xb2dcf7a6b1920945, 0x1b38fb9daa78e44a },
+    { 0xf57d92ebc141a104, 0x15c72fb1552d836e },
+    { 0xc46475896767b403, 0x116c262777579c58 },
+    { 0x6d6d88dbd8a5ecd2, 0x1be03d0bf225c6f4 },
+    { 0x8abe071646eb23db, 0x164cfda3281e38c3 },
+    { 0x6efe6c11d255b649, 0x11d7314f534b609c },
+    { 0xb197134fb6ef8a0e, 0x1c8b821885456760 },
+    { 0x27ac0f72f8bfa1a5, 0x16d601ad376ab91a },
+    { 0xb95672c260994e1e, 0x1244ce242c5560e1 },
+    { 0xf5571e03cdc21695, 0x1d3ae36d13bbce35 },
+    { 0x2aac18030b01abab, 0x17624f8a762fd82b },
+    { 0xbbbce0026f348956, 0x12b50c6ec4f31355 },
+    { 0x92c7ccd0b1eda889, 0x1dee7a4ad4b81eef },
+    { 0xdbd30a408e57ba07, 0x17f1fb6f10934bf2 },
+    { 0x7ca8d50071dfc806, 0x1327fc58da0f6ff5 },
+    { 0xfaa7bb33e9660cd6, 0x1ea6608e29b24cbb },
+    { 0x9552fc298784d711, 0x18851a0b548ea3c9 },
+    { 0xaaa8c9bad2d0ac0e, 0x139dae6f76d88307 },
+    { 0xdddadc5e1e1aace3, 0x1f62b0b257c0d1a5 },
+    { 0x7e48b04b4b488a4f, 0x191bc08eac9a4151 },
+    { 0xcb6d59d5d5d3a1d9, 0x141633a556e1cdda },
+    { 0x3c577b1177dc817b, 0x1011c2eaabe7d7e2 },
+    { 0xc6f25e825960cf2a, 0x19b604aaaca62636 },
+    { 0x6bf518684780a5bb, 0x14919d5556eb51c5 },
+    { 0x232a79ed06008496, 0x10747ddddf22a7d1 },
+    { 0xd1dd8fe1a3340756, 0x1a53fc9631d10c81 },
+    { 0xa7e4731ae8f66c45, 0x150ffd44f4a73d34 },
+    { 0x531d28e253f8569e, 0x10d9976a5d52975d },
+    { 0xeb61db03b98d5762, 0x1af5bf109550f22e },
+    { 0xbc4e48cfc7a445e8, 0x159165a6ddda5b58 },
+    { 0x6371d3d96c836b20, 0x11411e1f17e1e2ad },
+    { 0x9f1c8628ad9f11cd, 0x1b9b6364f3030448 },
+    { 0xe5b06b53be18db0b, 0x1615e91d8f359d06 },
+    { 0xeaf3890fcb4715a2, 0x11ab20e472914a6b },
+    { 0x44b8db4c7871bc37, 0x1c45016d841baa46 },
+    { 0x03c715d6c6c1635f, 0x169d9abe03495505 },
+    { 0x3638de456bcde919, 0x1217aefe69077737 },
+    { 0x56c163a2461641c1, 0x1cf2b1970e725858 },
+    { 0xdf011c81d1ab67ce, 0x17288e1271f51379 },
+    { 0x7f3416ce4155eca5, 0x1286d80ec190dc61 },
+    { 0x6520247d3556476e, 0x1da48ce468e7c702 },
+    { 0xea801d30f7783925, 0x17b6d71d20b96c01 },
+    { 0xbb99b0f3f92cfa84, 0x12f8ac174d612334 },
+    { 0x5f5c4e532847f739, 0x1e5aacf215683854 },
+    { 0x7f7d0b75b9d32c2e, 0x18488a5b44536043 },
+    { 0x9930d5f7c7dc2358, 0x136d3b7c36a919cf },
+    { 0x8eb4898c72f9d226, 0x1f152bf9f10e8fb2 },
+    { 0x722a07a38f2e41b8, 0x18ddbcc7f40ba628 },
+    { 0xc1bb394fa5be9afa, 0x13e497065cd61e86 },
+    { 0x9c5ec2190930f7f6, 0x1fd424d6faf030d7 },
+    { 0x49e56814075a5ff8, 0x197683df2f268d79 },
+    { 0x6e51201005e1e660, 0x145ecfe5bf520ac7 },
+    { 0xf1da800cd181851a, 0x104bd984990e6f05 },
+    { 0x4fc400148268d4f5, 0x1a12f5a0f4e3e4d6 },
+    { 0xd96999aa01ed772b, 0x14dbf7b3f71cb711 },
+    { 0xadee1488018ac5bc, 0x10aff95cc5b09274 },
+    { 0x497ceda668de092c, 0x1ab328946f80ea54 },
+    { 0x3aca57b853e4d424, 0x155c2076bf9a5510 },
+    { 0x623b7960431d7683, 0x1116805effaeaa73 },
+    { 0x9d2bf566d1c8bd9e, 0x1b5733cb32b110b8 },
+    { 0x7dbcc452416d647f, 0x15df5ca28ef40d60 },
+    { 0xcafd69db678ab6cc, 0x117f7d4ed8c33de6 },
+    { 0xab2f0fc572778adf, 0x1bff2ee48e052fd7 },
+    { 0x88f273045b92d580, 0x1665bf1d3e6a8cac },
+    { 0xd3f528d049424466, 0x11eaff4a98553d56 },
+    { 0xb988414d4203a0a3, 0x1cab3210f3bb9557 },
+    { 0x6139cdd76802e6e9, 0x16ef5b40c2fc7779 },
+    { 0xe761717920025254, 0x125915cd68c9f92d },
+    { 0xa568b58e999d5086, 0x1d5b561574765b7c },
+    { 0x5120913ee14aa6d2, 0x177c44ddf6c515fd },
+    { 0xa74d40ff1aa21f0e, 0x12c9d0b1923744ca },
+    { 0x0baece64f769cb4a, 0x1e0fb44f50586e11 },
+    { 0x3c8bd850c5ee3c3b, 0x180c903f7379f1a7 },
+    { 0xca0979da37f1c9c9, 0x133d4032c2c7f485 },
+    { 0xa9a8c2f6bfe942db, 0x1ec866b79e0cba6f },
+    { 0x2153cf2bccba9be3, 0x18a0522c7e709526 },
+    { 0x1aa9728970954982, 0x13b374f06526ddb8 },
+    { 0xf775840f1a88759d, 0x1f8587e7083e2f8c },
+    { 0x5f9136727ba05e17, 0x19379fec0698260a },
+    { 0x1940f85b9619e4df, 0x142c7ff0054684d5 },
+    { 0xe100c6afab47ea4c, 0x1023998cd1053710 },
+    { 0xce67a44c453fdd47, 0x19d28f47b4d524e7 },
+    { 0xd852e9d69dccb106, 0x14a8729fc3ddb71f },
+    { 0x79dbee454b0a2738, 0x1086c219697e2c19 },
+    { 0x295fe3a211a9d859, 0x1a71368f0f30468f },
+    { 0xbab31c81a7bb137a, 0x15275ed8d8f36ba5 },
+    { 0x6228e39aec95a92f, 0x10ec4be0ad8f8951 },
+    { 0x9d0e38f7e0ef7517, 0x1b13ac9aaf4c0ee8 },
+    { 0xb0d82d931a592a79, 0x15a956e225d67253 },
+    { 0x8d79be0f4847552e, 0x11544581b7dec1dc },
+    { 0x158f967eda0bbb7c, 0x1bba08cf8c979c94 },
+    { 0x77a611ff14d62f97, 0x162e6d72d6dfb076 },
+    { 0xf951a7ff43de8c79, 0x11bebdf578b2f391 },
+    { 0xc21c3ffed2fdad8e, 0x1c6463225ab7ec1c },
+    { 0x01b0333242648ad8, 0x16b6b5b5155ff017 },
+    { 0x0159c28e9b83a246, 0x122bc490dde659ac },
+    { 0xcef604175f3903a3, 0x1d12d41afca3c2ac },
+    { 0x725e69ac4c2d9c83, 0x17424348ca1c9bbd },
+    { 0xf5185489d68ae39c, 0x129b69070816e2fd },
+    { 0xee8d540fbdab05c6, 0x1dc574d80cf16b2f },
+    { 0xbed77672fe226b05, 0x17d12a4670c1228c },
+    { 0xff12c528cb4ebc04, 0x130dbb6b8d674ed6 },
+    { 0xcb513b74787df9a0, 0x1e7c5f127bd87e24 },
+    { 0x090dc929f9fe614d, 0x18637f41fcad31b7 },
+    { 0xa0d7d42194cb810a, 0x1382cc34ca2427c5 },
+    { 0x67bfb9cf5478ce77, 0x1f37ad21436d0c6f },
+    { 0x1fcc94a5dd2d71f9, 0x18f9574dcf8a7059 },
+    { 0x7fd6dd517dbdf4c7, 0x13faac3e3fa1f37a },
+    { 0xffbe2ee8c92fee0b, 0x1ff779fd329cb8c3 },
+    { 0x6631bf20a0f324d6, 0x1992c7fdc216fa36 },
+    { 0xb827cc1a1a5c1d78, 0x14756ccb01abfb5e },
+    { 0x935309ae7b7ce460, 0x105df0a267bcc918 },
+    { 0x1eeb42b0c594a099, 0x1a2fe76a3f9474f4 },
+    { 0xe58902270476e6e1, 0x14f31f8832dd2a5c },
+    { 0xb7a0ce859d2bebe7, 0x10c27fa028b0eeb0 },
+    { 0x59014a6f61dfdfd8, 0x1ad0cc33744e4ab4 },
+    { 0xe0cdd525e7e64cad, 0x1573d68f903ea229 },
+    { 0x4d7177518651d6f1, 0x11297872d9cbb4ee },
+    { 0x7be8bee8d6e957e8, 0x1b758d848fac54b0 },
+    { 0xfcba3253df211320, 0x15f7a46a0c89dd59 },
+    { 0x63c8284318e74280, 0x1192e9ee706e4aae },
+    { 0x060d0d3827d86a66, 0x1c1e43171a4a1117 },
+    { 0x6b3da42cecad21eb, 0x167e9c127b6e7412 },
+    { 0x88fe1cf0bd574e56, 0x11fee341fc585cdb },
+    { 0x419694b462254a23, 0x1ccb0536608d615f },
+    { 0x67abaa29e81dd4e9, 0x1708d0f84d3de77f },
+    { 0xb95621bb2017dd87, 0x126d73f9d764b932 },
+    { 0xc223692b668c95a5, 0x1d7becc2f23ac1ea },
+    { 0xce82ba891ed6de1d, 0x179657025b6234bb },
+    { 0xa53562074bdf1818, 0x12deac01e2b4f6fc },
+    { 0x3b889cd87964f359, 0x1e3113363787f194 },
+    { 0xfc6d4a46c783f5e1, 0x18274291c6065adc },
+    { 0x30576e9f06032b1a, 0x13529ba7d19eaf17 },
+    { 0x1a257dcb3cd1de90, 0x1eea92a61c311825 },
+    { 0x481dfe3c30a7e540, 0x18bba884e35a79b7 },
+    { 0xd34b31c9c0865100, 0x13c9539d82aec7c5 },
+    { 0x5211e942cda3b4cd, 0x1fa885c8d117a609 },
+    { 0x74db21023e1c90a4, 0x19539e3a40dfb807 },
+    { 0xf715b401cb4a0d50, 0x1442e4fb67196005 },
+    { 0xf8de299b09080aa7, 0x103583fc527ab337 },
+    { 0x8e304291a80cddd7, 0x19ef3993b72ab859 },
+    { 0x3e8d020e200a4b13, 0x14bf6142f8eef9e1 },
+    { 0x653d9b3e80083c0f, 0x10991a9bfa58c7e7 },
+    { 0x6ec8f864000d2ce4, 0x1a8e90f9908e0ca5 },
+    { 0x8bd3f9e999a423ea, 0x153eda614071a3b7 },
+    { 0x3ca994bae1501cbb, 0x10ff151a99f482f9 },
+    { 0xc775bac49bb3612b, 0x1b31bb5dc320d18e },
+    { 0xd2c4956a16291a89, 0x15c162b168e70e0b },
+    { 0xdbd0778811ba7ba1, 0x11678227871f3e6f },
+    { 0x2c80bf401c5d929b, 0x1bd8d03f3e9863e6 },
+    { 0xbd33cc3349e47549, 0x16470cff6546b651 },
+    { 0xca8fd68f6e505dd4, 0x11d270cc51055ea7 },
+    { 0x4419574be3b3c953, 0x1c83e7ad4e6efdd9 },
+    { 0x0347790982f63aa9, 0x16cfec8aa52597e1 },
+    { 0xcf6c60d468c4fbba, 0x123ff06eea847980 },
+    { 0xe57a34870e07f92a, 0x1d331a4b10d3f59a },
+    { 0x512e906c0b399422, 0x175c1508da432ae2 },
+    { 0xda8ba6bcd5c7a9b5, 0x12b010d3e1cf5581 },
+    { 0x90df712e22d90f87, 0x1de6815302e5559c },
+    { 0xda4c5a8b4f140c6c, 0x17eb9aa8cf1dde16 },
+    { 0xaea37ba2a5a9a38a, 0x1322e220a5b17e78 },
+    { 0x7dd25f6aa2a905a9, 0x1e9e369aa2b59727 },
+    { 0x97db7f888220d154, 0x187e92154ef7ac1f },
+    { 0x797c6606ce80a777, 0x139874ddd8c6234c },
+    { 0x8f2d700ae4010bf1, 0x1f5a549627a36bad },
+    { 0x0c2459a25000d65a, 0x191510781fb5efbe },
+    { 0x701d1481d99a4515, 0x1410d9f9b2f7f2fe },
+    { 0xc017439b147b6a77, 0x100d7b2e28c65bfe },
+    { 0xccf205c4ed9243f2, 0x19af2b7d0e0a2cca },
+    { 0x0a5b37d0be0e9cc2, 0x148c22ca71a1bd6f },
+    { 0x0848f973cb3ee3ce, 0x10701bd527b4978c },
+    { 0xda0e5bec78649fb0, 0x1a4cf9550c5425ac },
+    { 0x7b3eaff060507fc0, 0x150a6110d6a9b7bd },
+    { 0x95cbbff380406633, 0x10d51a73deee2c97 },
+    { 0xefac665266cd7052, 0x1aee90b964b04758 },
+    { 0x2623850eb8a459db, 0x158ba6fab6f36c47 },
+    { 0x1e82d0d893b6ae49, 0x113c85955f29236c },
+    { 0xfd9e1af41f8ab075, 0x1b9408eefea838ac },
+    { 0x97b1af29b2d559f7, 0x16100725988693bd },
+    { 0xac8e25baf5777b2c, 0x11a66c1e139edc97 },
+    { 0x7a7d092b2258c513, 0x1c3d79c9b8fe2dbf },
+    { 0x61fda0ef4ead6a76, 0x169794a160cb57cc },
+    { 0xe7fe1a590bbdeec5, 0x1212dd4de7091309 },
+    { 0xa6635d5b45fcb13a, 0x1ceafbafd80e84dc },
+    { 0x851c4aaf6b308dc8, 0x172262f3133ed0b0 },
+    { 0xd0e36ef2bc26d7d4, 0x1281e8c275cbda26 },
+    { 0xb49f17eac6a48c86, 0x1d9ca79d894629d7 },
+    { 0x2a18dfef0550706b, 0x17b08617a104ee46 },
+    { 0x54e0b3259dd9f389, 0x12f39e794d9d8b6b },
+    { 0x87cdeb6f62f65274, 0x1e5297287c2f4578 },
+    { 0xd30b22bf825ea85d, 0x18421286c9bf6ac6 },
+    { 0x0f3c1bcc684bb9e4, 0x13680ed23aff889f },
+    { 0x18602c7a4079296d, 0x1f0ce4839198da98 },
+    { 0x46b356c833942124, 0x18d71d360e13e213 },
+    { 0x388f78a029434db6, 0x13df4a91a4dcb4dc },
+    { 0x5a7f2766a86baf8a, 0x1fcbaa82a1612160 },
+    { 0x153285ebb9efbfa2, 0x196fbb9bb44db44d },
+    { 0xaa8ed189618c994e, 0x145962e2f6a4903d },
+    { 0xeed8a7a11ad6e10c, 0x1047824f2bb6d9ca },
+    { 0x7e27729b5e249b45, 0x1a0c03b1df8af611 },
+    { 0xfe85f549181d4904, 0x14d6695b193bf80d },
+    { 0xcb9e5dd4134aa0d0, 0x10ab877c142ff9a4 },
+    { 0xdf63c9535211014d, 0x1aac0bf9b9e65c3a },
+    { 0x191ca10f74da6771, 0x15566ffafb1eb02f },
+    { 0xadb080d92a4852c1, 0x1111f32f2f4bc025 },
+    { 0x15e7348eaa0d5134, 0x1b4feb7eb212cd09 },
+    { 0xab1f5d3eee710dc4, 0x15d98932280f0a6d },
+    { 0xbc1917658b8da49d, 0x117ad428200c0857 },
+    { 0x2cf4f23c127c3a94, 0x1bf7b9d9cce00d59 },
+    { 0xf0c3f4fcdb969543, 0x165fc7e170b33de0 },
+    { 0x5a365d9716121103, 0x11e6398126f5cb1a },
+    { 0x9056fc24f01ce804, 0x1ca38f350b22de90 },
+    { 0xd9df301d8ce3ecd0, 0x16e93f5da2824ba6 },
+    { 0xe17f59b13d8323da, 0x125432b14ecea2eb },
+    { 0x68cbc2b52f38395c, 0x1d53844ee47dd179 },
+    { 0x53d6355dbf602de3, 0x177603725064a794 },
+    { 0xa9782ab165e68b1c, 0x12c4cf8ea6b6ec76 },
+    { 0x0f26aab56fd744fa, 0x1e07b27dd78b13f1 },
+    { 0x3f52222abfdf6a62, 0x18062864ac6f4327 },
+    { 0x65db4e88997f884e, 0x1338205089f29c1f },
+    { 0x6fc54a7428cc0d4a, 0x1ec033b40fea9365 },
+    { 0x596aa1f68709a43b, 0x1899c2f673220f84 },
+    { 0xadeee7f86c07b696, 0x13ae3591f5b4d936 },
+    { 0x497e3ff3e00c5756, 0x1f7d228322baf524 },
+    { 0xd464fff64cd6ac45, 0x1930e868e89590e9 },
+    { 0x4383fff83d7889d1, 0x14272053ed4473ee },
+    { 0xcf9cccc69793a174, 0x101f4d0ff1038ff1 },
+    { 0x7f6147a425b90252, 0x19cbae7fe805b31c },
+    { 0xcc4dd2e9b7c7350f, 0x14a2f1ffecd15c16 },
+    { 0x3d0b0f215fd290d9, 0x10825b3323dab012 },
+    { 0x61ab4b689950e7c1, 0x1a6a2b85062ab350 },
+    { 0x4e22a2ba1440b967, 0x1521bc6a6b555c40 },
+    { 0x0b4ee894dd009453, 0x10e7c9eebc4449cd },
+    { 0x1217da87c800ed51, 0x1b0c764ac6d3a948 },
+    { 0xdb46486ca000bdda, 0x15a391d56bdc876c },
+    { 0x490506bd4ccd64af, 0x114fa7ddefe39f8a },
+    { 0xa8080ac87ae23ab1, 0x1bb2a62fe638ff43 },
+    { 0x5339a239fbe82ef4, 0x162884f31e93ff69 },
+    { 0x75c7b4fb2fecf25d, 0x11ba03f5b20fff87 },
+    { 0x22d92191e647ea2e, 0x1c5cd322b67fff3f },
+    { 0xb57a8141850654f2, 0x16b0a8e891ffff65 },
+    { 0xc4620101373843f5, 0x1226ed86db3332b7 },
+    { 0x3a366801f1f39fee, 0x1d0b15a491eb8459 },
+    { 0xfb5eb99b27f6198b, 0x173c115074bc69e0 },
+    { 0x2f7efae2865e7ad6, 0x129674405d6387e7 },
+    { 0xe597f7d0d6fd9156, 0x1dbd86cd6238d971 },
+    { 0x8479930d78cadaab, 0x17cad23de82d7ac1 },
+    { 0xd06142712d6f1556, 0x1308a831868ac89a },
+    { 0x4d686a4eaf182222, 0x1e74404f3daada91 },
+    { 0xa453883ef279b4e8, 0x185d003f6488aeda },
+    { 0xe9dc6cff28615d87, 0x137d99cc506d58ae },
+    { 0xa960ae650d6895a4, 0x1f2f5c7a1a488de4 },
+    { 0xbab3beb73ded4483, 0x18f2b061aea07183 },
+    { 0x2ef6322c318a9d36, 0x13f559e7bee6c136 },
+    { 0xe4bd1d13827761f0, 0x1feef63f97d79b89 },
+    { 0x83ca7da9352c4e5a, 0x198bf832dfdfafa1 },
+    { 0x9ca1fe20f756a515, 0x146ff9c24cb2f2e7 },
+    { 0x4a1b31b3f9121daa, 0x1059949b708f28b9 },
+    { 0x435eb5ecc1b695dd, 0x1a28edc580e50df5 },
+    { 0x35e55e57015ede4a, 0x14ed8b04671da4c4 },
+    { 0xc4b77eac0118b1d5, 0x10be08d0527e1d69 },
+    { 0xa12597799b5ab622, 0x1ac9a7b3b7302f0f },
+    { 0x4db7ac6149155e81, 0x156e1fc2f8f358d9 },
+    { 0xd7c6238107444b9b, 0x1124e63593f5e0ad },
+    { 0x593d059b3ed3ac2b, 0x1b6e3d2286563449 },
+    { 0xe0fd9e15cbdc89bc, 0x15f1ca820511c36d },
+    { 0xb3fe18116fe3a163, 0x118e3b9b37416924 },
+    { 0x866359b57fd29bd1, 0x1c16c5c525357507 },
+    { 0xd1e91491330ee30e, 0x16789e3750f790d2 },
+    { 0x74ba76da8f3f1c0b, 0x11fa182c40c60d75 },
+    { 0xedf72490e531c678, 0x1cc359e067a348bb },
+    { 0x8b2c1d40b75b052d, 0x1702ae4d1fb5d3c9 },
+    { 0x6f567dcd5f7c0424, 0x12688b70e62b0fd4 },
+    { 0x7ef0c94898c66d06, 0x1d74124e3d11b2ed },
+    { 0x98c0a106e09ebd9f, 0x17900ea4fda7c257 },
+    { 0x470080d24d4bcae6, 0x12d9a550caec9b79 },
+    { 0xd800ce1d487944a2, 0x1e29088144adc58e },
+    { 0x1333d8176d2dd082, 0x1820d39a9d57d13f },
+    { 0xa8f646792424a6ce, 0x134d76154aaca765 },
+    { 0x74bd3d8ea03aa47d, 0x1ee25688777aa56f },
+    { 0x5d64313ee6955064, 0x18b51206c5fbb78c },
+    { 0x4ab68dcbebaaa6b7, 0x13c40e6bd1962c70 },
+    { 0x1124161312aaa457, 0x1fa01712e8f0471a },
+    { 0xda8344dc0eeee9df, 0x194cdf4253f36c14 },
+    { 0xe2029d7cd8bf2180, 0x143d7f6843292343 },
+    { 0x4e687dfd7a328133, 0x103132b9cf541c36 },
+    { 0x4a40c9959050ceb8, 0x19e851294bb9c6bd },
+    { 0x0833d477a6a70bc6, 0x14b9da876fc7d231 },
+    { 0xa02976c61eec096b, 0x1094aed2bfd30e8d },
+    { 0x004257a364acdbdf, 0x1a877e1dffb81749 },
+    { 0xcd01dfb5ea23e319, 0x153931b1996012a0 },
+    { 0x70ce4c91881cb5ae, 0x10fa8e27ade6754d },
+    { 0x1ae3adb5a69455e2, 0x1b2a7d0c4970bbaf },
+    { 0x7be957c4854377e8, 0x15bb973d078d62f2 },
+    { 0xc987796a0435f987, 0x1162df64060ab58e },
+    { 0x75a58f1006bcc271, 0x1bd1656cd67788e4 },
+    { 0xf7b7a5a66bca3527, 0x16411df0ab92d3e9 },
+    { 0x5fc61e1ebca1c41f, 0x11cdb18d560f0fee },
+    { 0xffa363646102d365, 0x1c7c4f4889b1b316 },
+    { 0x32e91c504d9bdc51, 0x16c9d906d48e28df },
+    { 0x8f20e37371497d0e, 0x123b140576d820b2 },
+    { 0x7e9b0585820f2e7c, 0x1d2b533bf159cdea },
+    { 0xcbaf379e01a5beca, 0x1755dc2ff447d7ee },
+    { 0x0958f94b348498a1, 0x12ab168cc36cacbf },
+};
+
+/* 5^i, shifted to have exactly RYU_POW5_BITCOUNT bits, as { low, high }. */
+static const uint64_t json_ryu_pow5[326][2] = {
+    { 0x0000000000000000, 0x1000000000000000 },
+    { 0x0000000000000000, 0x1400000000000000 },
+    { 0x0000000000000000, 0x1900000000000000 },
+    { 0x0000000000000000, 0x1f40000000000000 },
+    { 0x0000000000000000, 0x1388000000000000 },
+    { 0x0000000000000000, 0x186a000000000000 },
+    { 0x0000000000000000, 0x1e84800000000000 },
+    { 0x0000000000000000, 0x1312d00000000000 },
+    { 0x0000000000000000, 0x17d7840000000000 },
+    { 0x0000000000000000, 0x1dcd650000000000 },
+    { 0x0000000000000000, 0x12a05f2000000000 },
+    { 0x0000000000000000, 0x174876e800000000 },
+    { 0x0000000000000000, 0x1d1a94a200000000 },
+    { 0x0000000000000000, 0x12309ce540000000 },
+    { 0x0000000000000000, 0x16bcc41e90000000 },
+    { 0x0000000000000000, 0x1c6bf52634000000 },
+    { 0x0000000000000000, 0x11c37937e0800000 },
+    { 0x0000000000000000, 0x16345785d8a00000 },
+    { 0x0000000000000000, 0x1bc16d674ec80000 },
+    { 0x0000000000000000, 0x1158e460913d0000 },
+    { 0x0000000000000000, 0x15af1d78b58c4000 },
+    { 0x0000000000000000, 0x1b1ae4d6e2ef5000 },
+    { 0x0000000000000000, 0x10f0cf064dd59200 },
+    { 0x0000000000000000, 0x152d02c7e14af680 },
+    { 0x0000000000000000, 0x1a784379d99db420 },
+    { 0x0000000000000000, 0x108b2a2c28029094 },
+    { 0x0000000000000000, 0x14adf4b7320334b9 },
+    { 0x4000000000000000, 0x19d971e4fe8401e7 },
+    { 0x8800000000000000, 0x1027e72f1f128130 },
+    { 0xaa00000000000000, 0x1431e0fae6d7217c },
+    { 0xd480000000000000, 0x193e5939a08ce9db },
+    { 0xc9a0000000000000, 0x1f8def8808b02452 },
+    { 0xbe04000000000000, 0x13b8b5b5056e16b3 },
+    { 0xad85000000000000, 0x18a6e32246c99c60 },
+    { 0xd8e6400000000000, 0x1ed09bead87c0378 },
+    { 0x878fe80000000000, 0x13426172c74d822b },
+    { 0x6973e20000000000, 0x1812f9cf7920e2b6 },
+    { 0x03d0da8000000000, 0x1e17b84357691b64 },
+    { 0x8262889000000000, 0x12ced32a16a1b11e },
+    { 0x22fb2ab400000000, 0x178287f49c4a1d66 },
+    { 0xabb9f56100000000, 0x1d6329f1c35ca4bf },
+    { 0xcb54395ca0000000, 0x125dfa371a19e6f7 },
+    { 0xbe2947b3c8000000, 0x16f578c4e0a060b5 },
+    { 0x2db399a0ba000000, 0x1cb2d6f618c878e3 },
+    { 0xfc90400474400000, 0x11efc659cf7d4b8d },
+    { 0x7bb4500591500000, 0x166bb7f0435c9e71 },
+    { 0xdaa16406f5a40000, 0x1c06a5ec5433c60d },
+    { 0xa8a4de8459868000, 0x118427b3b4a05bc8 },
+    { 0xd2ce16256fe82000, 0x15e531a0a1c872ba },
+    { 0x87819baecbe22800, 0x1b5e7e08ca3a8f69 },
+    { 0xf4b1014d3f6d5900, 0x111b0ec57e6499a1 },
+    { 0x71dd41a08f48af40, 0x1561d276ddfdc00a },
+    { 0x0e549208b31adb10, 0x1aba4714957d300d },
+    { 0x28f4db456ff0c8ea, 0x10b46c6cdd6e3e08 },
+    { 0x33321216cbecfb24, 0x14e1878814c9cd8a },
+    { 0xbffe969c7ee839ed, 0x1a19e96a19fc40ec },
+    { 0xf7ff1e21cf512434, 0x105031e2503da893 },
+    { 0xf5fee5aa43256d41, 0x14643e5ae44d12b8 },
+    { 0x337e9f14d3eec892, 0x197d4df19d605767 },
+    { 0x005e46da08ea7ab6, 0x1fdca16e04b86d41 },
+    { 0xa03aec4845928cb2, 0x13e9e4e4c2f34448 },
+    { 0xc849a75a56f72fde, 0x18e45e1df3b0155a },
+    { 0x7a5c1130ecb4fbd6, 0x1f1d75a5709c1ab1 },
+    { 0xec798abe93f11d65, 0x13726987666190ae },
+    { 0xa797ed6e38ed64bf, 0x184f03e93ff9f4da },
+    { 0x517de8c9c728bdef, 0x1e62c4e38ff87211 },
+    { 0xd2eeb17e1c7976b5, 0x12fdbb0e39fb474a },
+    { 0x87aa5ddda397d462, 0x17bd29d1c87a191d },
+    { 0xe994f5550c7dc97b, 0x1dac74463a989f64 },
+    { 0x11fd195527ce9ded, 0x128bc8abe49f639f },
+    { 0xd67c5faa71c24568, 0x172ebad6ddc73c86 },
+    { 0x8c1b77950e32d6c2, 0x1cfa698c95390ba8 },
+    { 0x57912abd28dfc639, 0x121c81f7dd43a749 },
+    { 0xad75756c7317b7c8, 0x16a3a275d494911b },
+    { 0x98d2d2c78fdda5ba, 0x1c4c8b1349b9b562 },
+    { 0x9f83c3bcb9ea8794, 0x11afd6ec0e14115d },
+    { 0x0764b4abe8652979, 0x161bcca7119915b5 },
+    { 0x493de1d6e27e73d7, 0x1ba2bfd0d5ff5b22 },
+    { 0x6dc6ad264d8f0866, 0x1145b7e285bf98f5 },
+    { 0xc938586fe0f2ca80, 0x159725db272f7f32 },
+    { 0x7b866e8bd92f7d20, 0x1afcef51f0fb5eff },
+    { 0xad34051767bdae34, 0x10de1593369d1b5f },
+    { 0x9881065d41ad19c1, 0x15159af804446237 },
+    { 0x7ea147f492186032, 0x1a5b01b605557ac5 },
+    { 0x6f24ccf8db4f3c1f, 0x1078e111c3556cbb },
+    { 0x4aee003712230b27, 0x14971956342ac7ea },
+    { 0xdda98044d6abcdf0, 0x19bcdfabc13579e4 },
+    { 0x0a89f02b062b60b6, 0x10160bcb58c16c2f },
+    { 0xcd2c6c35c7b638e4, 0x141b8ebe2ef1c73a },
+    { 0x8077874339a3c71d, 0x1922726dbaae3909 },
+    { 0xe0956914080cb8e4, 0x1f6b0f092959c74b },
+    { 0x6c5d61ac8507f38e, 0x13a2e965b9d81c8f },
+    { 0x4774ba17a649f072, 0x188ba3bf284e23b3 },
+    { 0x1951e89d8fdc6c8f, 0x1eae8caef261aca0 },
+    { 0x0fd3316279e9c3d9, 0x132d17ed577d0be4 },
+    { 0x13c7fdbb186434cf, 0x17f85de8ad5c4edd },
+    { 0x58b9fd29de7d4203, 0x1df67562d8b36294 },
+    { 0xb7743e3a2b0e4942, 0x12ba095dc7701d9c },
+    { 0xe5514dc8b5d1db92, 0x17688bb5394c2503 },
+    { 0xdea5a13ae3465277, 0x1d42aea2879f2e44 },
+    { 0x0b2784c4ce0bf38a, 0x1249ad2594c37ceb },
+    { 0xcdf165f6018ef06d, 0x16dc186ef9f45c25 },
+    { 0x416dbf7381f2ac88, 0x1c931e8ab871732f },
+    { 0x88e497a83137abd5, 0x11dbf316b346e7fd },
+    { 0xeb1dbd923d8596ca, 0x1652efdc6018a1fc },
+    { 0x25e52cf6cce6fc7d, 0x1be7abd3781eca7c },
+    { 0x97af3c1a40105dce, 0x1170cb642b133e8d },
+    { 0xfd9b0b20d0147542, 0x15ccfe3d35d80e30 },
+    { 0x3d01cde904199292, 0x1b403dcc834e11bd },
+    { 0x462120b1a28ffb9b, 0x1108269fd210cb16 },
+    { 0xd7a968de0b33fa82, 0x154a3047c694fddb },
+    { 0xcd93c3158e00f923, 0x1a9cbc59b83a3d52 },
+    { 0xc07c59ed78c09bb6, 0x10a1f5b813246653 },
+    { 0xb09b7068d6f0c2a3, 0x14ca732617ed7fe8 },
+    { 0xdcc24c830cacf34c, 0x19fd0fef9de8dfe2 },
+    { 0xc9f96fd1e7ec180f, 0x103e29f5c2b18bed },
+    { 0x3c77cbc661e71e13, 0x144db473335deee9 },
+    { 0x8b95beb7fa60e598, 0x1961219000356aa3 },
+    { 0x6e7b2e65f8f91efe, 0x1fb969f40042c54c },
+    { 0xc50cfcffbb9bb35f, 0x13d3e2388029bb4f },
+    { 0xb6503c3faa82a037, 0x18c8dac6a0342a23 },
+    { 0xa3e44b4f95234844, 0x1efb1178484134ac },
+    { 0xe66eaf11bd360d2b, 0x135ceaeb2d28c0eb },
+    { 0xe00a5ad62c839075, 0x183425a5f872f126 },
+    { 0x980cf18bb7a47493, 0x1e412f0f768fad70 },
+    { 0x5f0816f752c6c8dc, 0x12e8bd69aa19cc66 },
+    { 0xf6ca1cb527787b13, 0x17a2ecc414a03f7f },
+    { 0xf47ca3e2715699d7, 0x1d8ba7f519c84f5f },
+    { 0xf8cde66d86d62026, 0x127748f9301d319b },
+    { 0xf7016008e88ba830, 0x17151b377c247e02 },
+    { 0xb4c1b80b22ae923c, 0x1cda62055b2d9d83 },
+    { 0x50f91306f5ad1b65, 0x12087d4358fc8272 },
+    { 0xe53757c8b318623f, 0x168a9c942f3ba30e },
+    { 0x9e852dbadfde7acf, 0x1c2d43b93b0a8bd2 },
+    { 0xa3133c94cbeb0cc1, 0x119c4a53c4e69763 },
+    { 0x8bd80bb9fee5cff1, 0x16035ce8b6203d3c },
+    { 0xaece0ea87e9f43ee, 0x1b843422e3a84c8b },
+    { 0x4d40c9294f238a75, 0x1132a095ce492fd7 },
+    { 0x2090fb73a2ec6d12, 0x157f48bb41db7bcd },
+    { 0x68b53a508ba78856, 0x1adf1aea12525ac0 },
+    { 0x417144725748b536, 0x10cb70d24b7378b8 },
+    { 0x51cd958eed1ae283, 0x14fe4d06de5056e6 },
+    { 0xe640faf2a8619b24, 0x1a3de04895e46c9f },
+    { 0xefe89cd7a93d00f7, 0x1066ac2d5daec3e3 },
+    { 0xebe2c40d938c4134, 0x14805738b51a74dc },
+    { 0x26db7510f86f5181, 0x19a06d06e2611214 },
+    { 0x9849292a9b4592f1, 0x100444244d7cab4c },
+    { 0xbe5b73754216f7ad, 0x1405552d60dbd61f },
+    { 0xadf25052929cb598, 0x1906aa78b912cba7 },
+    { 0x996ee4673743e2ff, 0x1f485516e7577e91 },
+    { 0xffe54ec0828a6ddf, 0x138d352e5096af1a },
+    { 0xbfdea270a32d0957, 0x18708279e4bc5ae1 },
+    { 0x2fd64b0ccbf84bad, 0x1e8ca3185deb719a },
+    { 0x5de5eee7ff7b2f4c, 0x1317e5ef3ab32700 },
+    { 0x755f6aa1ff59fb1f, 0x17dddf6b095ff0c0 },
+    { 0x92b7454a7f3079e7, 0x1dd55745cbb7ecf0 },
+    { 0x5bb28b4e8f7e4c30, 0x12a5568b9f52f416 },
+    { 0xf29f2e22335ddf3c, 0x174eac2e8727b11b },
+    { 0xef46f9aac035570b, 0x1d22573a28f19d62 },
+    { 0xd58c5c0ab8215667, 0x123576845997025d },
+    { 0x4aef730d6629ac01, 0x16c2d4256ffcc2f5 },
+    { 0x9dab4fd0bfb41701, 0x1c73892ecbfbf3b2 },
+    { 0xa28b11e277d08e60, 0x11c835bd3f7d784f },
+    { 0x8b2dd65b15c4b1f9, 0x163a432c8f5cd663 },
+    { 0x6df94bf1db35de77, 0x1bc8d3f7b3340bfc },
+    { 0xc4bbcf772901ab0a, 0x115d847ad000877d },
+    { 0x35eac354f34215cd, 0x15b4e5998400a95d },
+    { 0x8365742a30129b40, 0x1b221effe500d3b4 },
+    { 0xd21f689a5e0ba108, 0x10f5535fef208450 },
+    { 0x06a742c0f58e894a, 0x1532a837eae8a565 },
+    { 0x4851137132f22b9d, 0x1a7f5245e5a2cebe },
+    { 0xed32ac26bfd75b42, 0x108f936baf85c136 },
+    { 0xa87f57306fcd3212, 0x14b378469b673184 },
+    { 0xd29f2cfc8bc07e97, 0x19e056584240fde5 },
+    { 0xa3a37c1dd7584f1e, 0x102c35f729689eaf },
+    { 0x8c8c5b254d2e62e6, 0x14374374f3c2c65b },
+    { 0x6faf71eea079fb9f, 0x1945145230b377f2 },
+    { 0x0b9b4e6a48987a87, 0x1f965966bce055ef },
+    { 0x674111026d5f4c94, 0x13bdf7e0360c35b5 },
+    { 0xc111554308b71fba, 0x18ad75d8438f4322 },
+    { 0x7155aa93cae4e7a8, 0x1ed8d34e547313eb },
+    { 0x26d58a9c5ecf10c9, 0x13478410f4c7ec73 },
+    { 0xf08aed437682d4fb, 0x1819651531f9e78f },
+    { 0xecada89454238a3a, 0x1e1fbe5a7e786173 },
+    { 0x73ec895cb4963664, 0x12d3d6f88f0b3ce8 },
+    { 0x90e7abb3e1bbc3fd, 0x1788ccb6b2ce0c22 },
+    { 0x352196a0da2ab4fd, 0x1d6affe45f818f2b },
+    { 0x0134fe24885ab11e, 0x1262dfeebbb0f97b },
+    { 0xc1823dadaa715d65, 0x16fb97ea6a9d37d9 },
+    { 0x31e2cd19150db4bf, 0x1cba7de5054485d0 },
+    { 0x1f2dc02fad2890f7, 0x11f48eaf234ad3a2 },
+    { 0xa6f9303b9872b535, 0x1671b25aec1d888a },
+    { 0x50b77c4a7e8f6282, 0x1c0e1ef1a724eaad },
+    { 0x5272adae8f199d91, 0x1188d357087712ac },
+    { 0x670f591a32e004f6, 0x15eb082cca94d757 },
+    { 0x40d32f60bf980633, 0x1b65ca37fd3a0d2d },
+    { 0x4883fd9c77bf03e0, 0x111f9e62fe44483c },
+    { 0x5aa4fd0395aec4d8, 0x156785fbbdd55a4b },
+    { 0x314e3c447b1a760e, 0x1ac1677aad4ab0de },
+    { 0xded0e5aaccf089c9, 0x10b8e0acac4eae8a },
+    { 0x96851f15802cac3b, 0x14e718d7d7625a2d },
+    { 0xfc2666dae037d74a, 0x1a20df0dcd3af0b8 },
+    { 0x9d980048cc22e68e, 0x10548b68a044d673 },
+    { 0x84fe005aff2ba032, 0x1469ae42c8560c10 },
+    { 0xa63d8071bef6883e, 0x198419d37a6b8f14 },
+    { 0xcfcce08e2eb42a4e, 0x1fe52048590672d9 },
+    { 0x21e00c58dd309a70, 0x13ef342d37a407c8 },
+    { 0x2a580f6f147cc10d, 0x18eb0138858d09ba },
+    { 0xb4ee134ad99bf150, 0x1f25c186a6f04c28 },
+    { 0x7114cc0ec80176d2, 0x137798f428562f99 },
+    { 0xcd59ff127a01d486, 0x18557f31326bbb7f },
+    { 0xc0b07ed7188249a8, 0x1e6adefd7f06aa5f },
+    { 0xd86e4f466f516e09, 0x1302cb5e6f642a7b },
+    { 0xce89e3180b25c98b, 0x17c37e360b3d351a },
+    { 0x822c5bde0def3bee, 0x1db45dc38e0c8261 },
+    { 0xf15bb96ac8b58575, 0x1290ba9a38c7d17c },
+    { 0x2db2a7c57ae2e6d2, 0x1734e940c6f9c5dc },
+    { 0x391f51b6d99ba086, 0x1d022390f8b83753 },
+    { 0x03b3931248014454, 0x1221563a9b732294 },
+    { 0x04a077d6da019569, 0x16a9abc9424feb39 },
+    { 0x45c895cc9081fac3, 0x1c5416bb92e3e607 },
+    { 0x8b9d5d9fda513cba, 0x11b48e353bce6fc4 },
+    { 0xae84b507d0e58be8, 0x1621b1c28ac20bb5 },
+    { 0x1a25e249c51eeee3, 0x1baa1e332d728ea3 },
+    { 0xf057ad6e1b33554d, 0x114a52dffc679925 },
+    { 0x6c6d98c9a2002aa1, 0x159ce797fb817f6f },
+    { 0x4788fefc0a803549, 0x1b04217dfa61df4b },
+    { 0x0cb59f5d8690214e, 0x10e294eebc7d2b8f },
+    { 0xcfe30734e83429a1, 0x151b3a2a6b9c7672 },
+    { 0x83dbc9022241340a, 0x1a6208b50683940f },
+    { 0xb2695da15568c086, 0x107d457124123c89 },
+    { 0x1f03b509aac2f0a7, 0x149c96cd6d16cbac },
+    { 0x26c4a24c1573acd1, 0x19c3bc80c85c7e97 },
+    { 0x783ae56f8d684c03, 0x101a55d07d39cf1e },
+    { 0x16499ecb70c25f03, 0x1420eb449c8842e6 },
+    { 0x9bdc067e4cf2f6c4, 0x19292615c3aa539f },
+    { 0x82d3081de02fb476, 0x1f736f9b3494e887 },
+    { 0xb1c3e512ac1dd0c9, 0x13a825c100dd1154 },
+    { 0xde34de57572544fc, 0x18922f31411455a9 },
+    { 0x55c215ed2cee963b, 0x1eb6bafd91596b14 },
+    { 0xb5994db43c151de5, 0x133234de7ad7e2ec },
+    { 0xe2ffa1214b1a655e, 0x17fec216198ddba7 },
+    { 0xdbbf89699de0feb6, 0x1dfe729b9ff15291 },
+    { 0x2957b5e202ac9f31, 0x12bf07a143f6d39b },
+    { 0xf3ada35a8357c6fe, 0x176ec98994f48881 },
+    { 0x70990c31242db8bd, 0x1d4a7bebfa31aaa2 },
+    { 0x865fa79eb69c9376, 0x124e8d737c5f0aa5 },
+    { 0xe7f791866443b854, 0x16e230d05b76cd4e },
+    { 0xa1f575e7fd54a669, 0x1c9abd04725480a2 },
+    { 0xa53969b0fe54e801, 0x11e0b622c774d065 },
+    { 0x0e87c41d3dea2202, 0x1658e3ab7952047f },
+    { 0xd229b5248d64aa82, 0x1bef1c9657a6859e },
+    { 0x435a1136d85eea91, 0x117571ddf6c81383 },
+    { 0x143095848e76a536, 0x15d2ce55747a1864 },
+    { 0x193cbae5b2144e83, 0x1b4781ead1989e7d },
+    { 0x2fc5f4cf8f4cb112, 0x110cb132c2ff630e },
+    { 0xbbb77203731fdd56, 0x154fdd7f73bf3bd1 },
+    { 0x2aa54e844fe7d4ac, 0x1aa3d4df50af0ac6 },
+    { 0xdaa75112b1f0e4eb, 0x10a6650b926d66bb },
+    { 0xd15125575e6d1e26, 0x14cffe4e7708c06a },
+    { 0x85a56ead360865b0, 0x1a03fde214caf085 },
+    { 0x7387652c41c53f8e, 0x10427ead4cfed653 },
+    { 0x50693e7752368f71, 0x14531e58a03e8be8 },
+    { 0x64838e1526c4334e, 0x1967e5eec84e2ee2 },
+    { 0xfda4719a70754022, 0x1fc1df6a7a61ba9a },
+    { 0xde86c70086494815, 0x13d92ba28c7d14a0 },
+    { 0x162878c0a7db9a1a, 0x18cf768b2f9c59c9 },
+    { 0x5bb296f0d1d280a1, 0x1f03542dfb83703b },
+    { 0x194f9e5683239064, 0x1362149cbd322625 },
+    { 0x5fa385ec23ec747e, 0x183a99c3ec7eafae },
+    { 0xf78c67672ce7919d, 0x1e494034e79e5b99 },
+    { 0x3ab7c0a07c10bb02, 0x12edc82110c2f940 },
+    { 0x4965b0c89b14e9c3, 0x17a93a2954f3b790 },
+    { 0x5bbf1cfac1da2433, 0x1d9388b3aa30a574 },
+    { 0xb957721cb92856a0, 0x127c35704a5e6768 },
+    { 0xe7ad4ea3e7726c48, 0x171b42cc5cf60142 },
+    { 0xa198a24ce14f075a, 0x1ce2137f74338193 },
+    { 0x44ff65700cd16498, 0x120d4c2fa8a030fc },
+    { 0x563f3ecc1005bdbe, 0x16909f3b92c83d3b },
+    { 0x2bcf0e7f14072d2e, 0x1c34c70a777a4c8a },
+    { 0x5b61690f6c847c3d, 0x11a0fc668aac6fd6 },
+    { 0xf239c35347a59b4c, 0x16093b802d578bcb },
+    { 0xeec83428198f021f, 0x1b8b8a6038ad6ebe },
+    { 0x553d20990ff96153, 0x1137367c236c6537 },
+    { 0x2a8c68bf53f7b9a8, 0x1585041b2c477e85 },
+    { 0x752f82ef28f5a812, 0x1ae64521f7595e26 },
+    { 0x093db1d57999890b, 0x10cfeb353a97dad8 },
+    { 0x0b8d1e4ad7ffeb4e, 0x1503e602893dd18e },
+    { 0x8e7065dd8dffe622, 0x1a44df832b8d45f1 },
+    { 0xf9063faa78bfefd5, 0x106b0bb1fb384bb6 },
+    { 0xb747cf9516efebca, 0x1485ce9e7a065ea4 },
+    { 0xe519c37a5cabe6bd, 0x19a742461887f64d },
+    { 0xaf301a2c79eb7036, 0x1008896bcf54f9f0 },
+    { 0xdafc20b798664c43, 0x140aabc6c32a386c },
+    { 0x11bb28e57e7fdf54, 0x190d56b873f4c688 },
+    { 0x1629f31ede1fd72a, 0x1f50ac6690f1f82a },
+    { 0x4dda37f34ad3e67a, 0x13926bc01a973b1a },
+    { 0xe150c5f01d88e019, 0x187706b0213d09e0 },
+    { 0x19a4f76c24eb181f, 0x1e94c85c298c4c59 },
+    { 0xb0071aa39712ef13, 0x131cfd3999f7afb7 },
+    { 0x9c08e14c7cd7aad8, 0x17e43c8800759ba5 },
+    { 0x030b199f9c0d958e, 0x1ddd4baa0093028f },
+    { 0x61e6f003c1887d79, 0x12aa4f4a405be199 },
+    { 0xba60ac04b1ea9cd7, 0x1754e31cd072d9ff },
+    { 0xa8f8d705de65440d, 0x1d2a1be4048f907f },
+    { 0xc99b8663aaff4a88, 0x123a516e82d9ba4f },
+    { 0xbc0267fc95bf1d2a, 0x16c8e5ca239028e3 },
+    { 0xab0301fbbb2ee474, 0x1c7b1f3cac74331c },
+    { 0xeae1e13d54fd4ec9, 0x11ccf385ebc89ff1 },
+    { 0x659a598caa3ca27b, 0x1640306766bac7ee },
+    { 0xff00efefd4cbcb1a, 0x1bd03c81406979e9 },
+    { 0x3f6095f5e4ff5ef0, 0x116225d0c841ec32 },
+    { 0xcf38bb735e3f36ac, 0x15baaf44fa52673e },
+    { 0x8306ea5035cf0457, 0x1b295b1638e7010e },
+    { 0x11e4527221a162b6, 0x10f9d8ede39060a9 },
+    { 0x565d670eaa09bb64, 0x15384f295c7478d3 },
+    { 0x2bf4c0d2548c2a3d, 0x1a8662f3b3919708 },
+    { 0x1b78f88374d79a66, 0x1093fdd8503afe65 },
+    { 0x625736a4520d8100, 0x14b8fd4e6449bdfe },
+    { 0xfaed044d6690e140, 0x19e73ca1fd5c2d7d },
+    { 0xbcd422b0601a8cc8, 0x103085e53e599c6e },
+    { 0x6c092b5c78212ffa, 0x143ca75e8df0038a },
+    { 0x070b763396297bf8, 0x194bd136316c046d },
+    { 0x48ce53c07bb3daf6, 0x1f9ec583bdc70588 },
+    { 0x2d80f4584d5068da, 0x13c33b72569c6375 },
+    { 0x78e1316e60a48310, 0x18b40a4eec437c52 },
+};
+
+/* Count of bits of 5^e (for e >= 1; returns 1 for e == 0). */
+static inline int
+json_ryu_pow5bits(int e)
 {
-    static const char fmt[] = "%.16lg";
-    static const size_t extra_bytes = 2;    /* Space reserved for ".0" */
-    struct lconv* lc;
-    int n;
-    char local_buffer[64];
-    size_t capacity = sizeof(local_buffer) - extra_bytes;
-    char* buffer = local_buffer;
-    char* new_buffer;
-    char* dp;
-    int ret;
+    return (int) (((uint32_t) e * 1217359) >> 19) + 1;
+}
 
-    while(1) {
-        n = snprintf(buffer, capacity, fmt, dbl);
-        if(n >= 0  &&  (size_t)n < capacity)
-            break;
+/* floor(log10(2^e)) */
+static inline int
+json_ryu_log10_pow2(int e)
+{
+    return (int) (((uint32_t) e * 78913) >> 18);
+}
 
-        /* If the buffer is insufficient, old snprintf() implementations
-         * only report the buffer is too small and don't tell how large
-         * the buffer has to be. So lets grow the buffer until it is large
-         * enough. */
-        if(n < 0)
-            capacity *= 2;
-        else
-            capacity = n + 1;
+/* floor(log10(5^e)) */
+static inline int
+json_ryu_log10_pow5(int e)
+{
+    return (int) (((uint32_t) e * 732923) >> 20);
+}
 
-        /* Make the terrain safe for realloc(). */
-        if(buffer == local_buffer)
-            buffer = NULL;
+static inline int
+json_ryu_is_multiple_of_pow5(uint64_t value, int p)
+{
+    int count = 0;
 
-        new_buffer = (char *) realloc(buffer, capacity + extra_bytes);
-        if(new_buffer == NULL) {
-            free(buffer);
-            return JSON_ERR_OUTOFMEMORY;
-        }
-        buffer = new_buffer;
+    while(value % 5 == 0) {
+        value /= 5;
+        count++;
     }
+    return (count >= p);
+}
 
-    /* Similar pain as above for strtod(). We need to fight with snprintf() and
-     * undo the locale-dependent stuff. */
-    lc = localeconv();
+static inline int
+json_ryu_is_multiple_of_pow2(uint64_t value, int p)
+{
+    return ((value & (((uint64_t) 1 << p) - 1)) == 0);
+}
 
-    /* Remove all potential locale-provided thousand separators. */
-    if(lc->thousands_sep != NULL  &&  lc->thousands_sep[0]) {
-        char* sep = lc->thousands_sep;
-        size_t sep_len = strlen(sep);
-        char* ptr = buffer;
+/* (m * mul) >> j, where mul is the 128-bit { low, high } and 64 < j < 128. */
+static inline uint64_t
+json_ryu_mul_shift(uint64_t m, const uint64_t* mul, int j)
+{
+    uint64_t hi0, lo0;
+    uint64_t hi1, lo1;
+    uint64_t sum;
+
+    json_mul64(m, mul[0], &hi0, &lo0);
+    json_mul64(m, mul[1], &hi1, &lo1);
+    sum = hi0 + lo1;
+    if(sum < hi0)
+        hi1++;
+    return (hi1 << (128 - j)) | (sum >> (j - 64));
+}
 
-        while(1) {
-            ptr = strstr(ptr, sep);
-            if(ptr == NULL)
-                break;
+/* Find the shortest decimal `digits * 10^(*p_exp10)` inside the interval of
+ * numbers which round to the binary value m2 * 2^e2.
+ *
+ * The caller passes the value already multiplied by 4 (i.e. e2 is lowered by
+ * 2) so the interval bounds are integers too. The lower bound is closer if
+ * m2 is a power of 2 (except for the smallest exponent): `mm_shift` is zero
+ * then. */
+static uint64_t
+json_ryu(uint64_t m2, int e2, int mm_shift, int* p_exp10)
+{
+    int accept_bounds = ((m2 & 1) == 0);    /* Round half to even. */
+    uint64_t mv = 4 * m2;
+    uint64_t vr, vp, vm;
+    int e10;
+    int vm_is_trailing_zeros = 0;
+    int vr_is_trailing_zeros = 0;
+    int removed = 0;
+    unsigned last_removed_digit = 0;
+    uint64_t output;
+
+    /* Compute the interval bounds (and the value itself) in the decimal
+     * base, with some more digits than needed. */
+    if(e2 >= 0) {
+        int q = json_ryu_log10_pow2(e2) - (e2 > 3);
+        int k = RYU_POW5_INV_BITCOUNT + json_ryu_pow5bits(q) - 1;
+        int j = -e2 + q + k;
+
+        e10 = q;
+        vr = json_ryu_mul_shift(mv, json_ryu_pow5_inv[q], j);
+        vp = json_ryu_mul_shift(mv + 2, json_ryu_pow5_inv[q], j);
+        vm = json_ryu_mul_shift(mv - 1 - mm_shift, json_ryu_pow5_inv[q], j);
+
+        if(q <= 21) {
+            /* Only one of mp, mv and mm can be a multiple of 5, if any. */
+            if(mv % 5 == 0)
+                vr_is_trailing_zeros = json_ryu_is_multiple_of_pow5(mv, q);
+            else if(accept_bounds)
+                vm_is_trailing_zeros = json_ryu_is_multiple_of_pow5(mv - 1 - mm_shift, q);
+            else
+                vp -= json_ryu_is_multiple_of_pow5(mv + 2, q);
+        }
+    } else {
+        int q = json_ryu_log10_pow5(-e2) - (-e2 > 1);
+        int i = -e2 - q;
+        int k = json_ryu_pow5bits(i) - RYU_POW5_BITCOUNT;
+        int j = q - k;
+
+        e10 = q + e2;
+        vr = json_ryu_mul_shift(mv, json_ryu_pow5[i], j);
+        vp = json_ryu_mul_shift(mv + 2, json_ryu_pow5[i], j);
+        vm = json_ryu_mul_shift(mv - 1 - mm_shift, json_ryu_pow5[i], j);
+
+        if(q <= 1) {
+            /* mv = 4 * m2 has always at least two trailing zero bits; mm has
+             * one iff mm_shift == 1; mp has always one. */
+            vr_is_trailing_zeros = 1;
+            if(accept_bounds)
+                vm_is_trailing_zeros = (mm_shift == 1);
+            else
+                vp--;
+        } else if(q < 63) {
+            vr_is_trailing_zeros = json_ryu_is_multiple_of_pow2(mv, q);
+        }
+    }
 
-            memmove(ptr, ptr + sep_len, n - (ptr - buffer));
-            n -= sep_len;
+    /* Remove the digits while vp and vm still differ. */
+    if(vm_is_trailing_zeros  ||  vr_is_trailing_zeros) {
+        /* General case (rare). */
+        while(vp / 10 > vm / 10) {
+            vm_is_trailing_zeros &= (vm % 10 == 0);
+            vr_is_trailing_zeros &= (last_removed_digit == 0);
+            last_removed_digit = (unsigned) (vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if(vm_is_trailing_zeros) {
+            while(vm % 10 == 0) {
+                vr_is_trailing_zeros &= (last_removed_digit == 0);
+                last_removed_digit = (unsigned) (vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if(vr_is_trailing_zeros  &&  last_removed_digit == 5  &&  vr % 2 == 0) {
+            /* Exactly .5: Round to even. */
+            last_removed_digit = 4;
         }
+        output = vr + ((vr == vm  &&  (!accept_bounds || !vm_is_trailing_zeros))  ||
+                       last_removed_digit >= 5);
+    } else {
+        /* Common case. */
+        int round_up = 0;
+
+        if(vp / 100 > vm / 100) {
+            round_up = (vr % 100 >= 50);
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while(vp / 10 > vm / 10) {
+            round_up = (vr % 10 >= 5);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm  ||  round_up);
     }
 
-    /* Replace the locale-provided decimal point with '.'. */
-    dp = strchr(buffer, lc->decimal_point[0]);
-    if(dp != NULL) {
-        *dp = '.';
-    } else if(strchr(buffer, 'e') == NULL) {
-        /* There is no decimal point present and also no 'e', i.e. it's not
-         * in the scientific notation, i.e. it looks too much as an integer
-         * if we ever re-read the value back.
-         *
-         * For the sake of consistency, let's make sure that, if we ever
-         * re-read the string again, we shall map it to double again, by
-         * appending the decimal point.
-         *
-         * We may do this safely: We reserved few bytes in the buffer exactly
-         * for this purpose.
-         */
-        memcpy(buffer + n, ".0", 2);
-        n += 2;
+    *p_exp10 = e10 + removed;
+    return output;
+}
+
+/* Write digits * 10^exp10 into the buffer (which has to be large enough for
+ * 17 digits and all the decorations). Returns the length.
+ *
+ * Numbers of a reasonable magnitude are written in the fixed notation (with
+ * ".0" appended if needed, so the number is recognized as a floating point
+ * number when read back), others in the scientific one. */
+static size_t
+json_format_decimal(char* buffer, int is_neg, uint64_t digits, int exp10)
+{
+    char tmp[20];
+    size_t n_digits;
+    size_t off = 0;
+    int x;      /* Exponent in the scientific notation. */
+    size_t i;
+
+    n_digits = json_count_digits(digits);
+    json_write_digits(tmp + n_digits, digits);
+    x = exp10 + (int) n_digits - 1;
+
+    if(is_neg)
+        buffer[off++] = '-';
+
+    if(0 <= x  &&  x < 16) {
+        if(n_digits <= (size_t) x + 1) {
+            memcpy(buffer + off, tmp, n_digits);
+            off += n_digits;
+            for(i = n_digits; i < (size_t) x + 1; i++)
+                buffer[off++] = '0';
+            buffer[off++] = '.';
+            buffer[off++] = '0';
+        } else {
+            memcpy(buffer + off, tmp, x + 1);
+            off += x + 1;
+            buffer[off++] = '.';
+            memcpy(buffer + off, tmp + x + 1, n_digits - x - 1);
+            off += n_digits - x - 1;
+        }
+    } else if(-4 <= x  &&  x < 0) {
+        buffer[off++] = '0';
+        buffer[off++] = '.';
+        for(i = 1; i < (size_t) -x; i++)
+            buffer[off++] = '0';
+        memcpy(buffer + off, tmp, n_digits);
+        off += n_digits;
+    } else {
+        buffer[off++] = tmp[0];
+        if(n_digits > 1) {
+            buffer[off++] = '.';
+            memcpy(buffer + off, tmp + 1, n_digits - 1);
+            off += n_digits - 1;
+        }
+        buffer[off++] = 'e';
+        if(x < 0) {
+            buffer[off++] = '-';
+            x = -x;
+        } else {
+            buffer[off++] = '+';
+        }
+        if(x >= 100)
+            buffer[off++] = '0' + (char) (x / 100);
+        if(x >= 10)
+            buffer[off++] = '0' + (char) (x / 10 % 10);
+        buffer[off++] = '0' + (char) (x % 10);
     }
 
-    ret = write_func(buffer, n, user_data);
+    return off;
+}
 
-    if(buffer != local_buffer)
-        free(buffer);
-    return ret;
+/* Infinity and NaN have no representation in JSON. We write them as C does
+ * (and as we always did). */
+static size_t
+json_format_nonfinite(char* buffer, int is_neg, int is_nan)
+{
+    size_t off = 0;
+
+    if(is_neg)
+        buffer[off++] = '-';
+    memcpy(buffer + off, (is_nan ? "nan" : "inf"), 3);
+    return off + 3;
+}
+
+size_t
+json_format_double(char* buffer, double dbl)
+{
+    uint64_t bits;
+    uint64_t mantissa;
+    unsigned exponent;
+    int is_neg;
+    uint64_t digits;
+    int exp10;
+
+    memcpy(&bits, &dbl, sizeof(double));
+    mantissa = bits & DBL_MANTISSA_MASK;
+    exponent = (unsigned) ((bits >> DBL_MANTISSA_BITS) & DBL_EXP_INF);
+    is_neg = (int) (bits >> 63);
+
+    if(exponent == DBL_EXP_INF)
+        return json_format_nonfinite(buffer, is_neg, (mantissa != 0));
+    if(exponent == 0  &&  mantissa == 0)
+        return json_format_decimal(buffer, is_neg, 0, 0);
+
+    if(exponent == 0)
+        digits = json_ryu(mantissa, 1 - DBL_EXP_BIAS - DBL_MANTISSA_BITS - 2,
+                          1, &exp10);
+    else
+        digits = json_ryu(((uint64_t) 1 << DBL_MANTISSA_BITS) | mantissa,
+                          (int) exponent - DBL_EXP_BIAS - DBL_MANTISSA_BITS - 2,
+                          (mantissa != 0  ||  exponent <= 1), &exp10);
+    return json_format_decimal(buffer, is_neg, digits, exp10);
+}
+
+#define FLT_MANTISSA_BITS       23
+#define FLT_EXP_BIAS            127
+#define FLT_EXP_INF             0xff
+#define FLT_MANTISSA_MASK       (((uint32_t) 1 << FLT_MANTISSA_BITS) - 1)
+
+size_t
+json_format_float(char* buffer, float flt)
+{
+    uint32_t bits;
+    uint32_t mantissa;
+    unsigned exponent;
+    int is_neg;
+    uint64_t digits;
+    int exp10;
+
+    memcpy(&bits, &flt, sizeof(float));
+    mantissa = bits & FLT_MANTISSA_MASK;
+    exponent = (unsigned) ((bits >> FLT_MANTISSA_BITS) & FLT_EXP_INF);
+    is_neg = (int) (bits >> 31);
+
+    if(exponent == FLT_EXP_INF)
+        return json_format_nonfinite(buffer, is_neg, (mantissa != 0));
+    if(exponent == 0  &&  mantissa == 0)
+        return json_format_decimal(buffer, is_neg, 0, 0);
+
+    if(exponent == 0)
+        digits = json_ryu(mantissa, 1 - FLT_EXP_BIAS - FLT_MANTISSA_BITS - 2,
+                          1, &exp10);
+    else
+        digits = json_ryu(((uint64_t) 1 << FLT_MANTISSA_BITS) | mantissa,
+                          (int) exponent - FLT_EXP_BIAS - FLT_MANTISSA_BITS - 2,
+                          (mantissa != 0  ||  exponent <= 1), &exp10);
+    return json_format_decimal(buffer, is_neg, digits, exp10);
+}
+
+int
+json_dump_double(double dbl, JSON_DUMP_CALLBACK write_func, void* user_data)
+{
+    char buffer[JSON_FORMAT_BUFSIZE];
+    size_t n;
+
+    n = json_format_double(buffer, dbl);
+    return write_func(buffer, n, user_data);
+}
+
+int
+json_dump_float(float flt, JSON_DUMP_CALLBACK write_func, void* user_data)
+{
+    char buffer[JSON_FORMAT_BUFSIZE];
+    size_t n;
+
+    n = json_format_float(buffer, flt);
+    return write_func(buffer, n, user_data);
 }
 
 static void
@@ -49,7 +49,9 @@ typedef enum JSON_TYPE {
     JSON_ARRAY_BEG,
     JSON_ARRAY_END,
     JSON_OBJECT_BEG,
-    JSON_OBJECT_END
+    JSON_OBJECT_END,
+    JSON_STRING_PART, /* Leading part of a string value (see JSON_STRINGPARTS). */
+    JSON_DOCUMENT_END /* End of a top-level value (see JSON_MULTIDOC). */
 } JSON_TYPE;
 
 
@@ -78,6 +80,7 @@ typedef enum JSON_TYPE {
 #define JSON_ERR_UNESCAPEDCONTROL       (-21)   /* Unescaped control character (in a string) */
 #define JSON_ERR_INVALIDESCAPE          (-22)   /* Invalid/unknown escape sequence (in a string) */
 #define JSON_ERR_INVALIDUTF8            (-23)   /* Invalid UTF-8 (in a string) */
+#define JSON_ERR_BADPOINTER             (-24)   /* Invalid JSON pointer (see json_set_projection()) */
 
 
 /* Bits for JSON_CONFIG::flags.
@@ -98,6 +101,80 @@ typedef enum JSON_TYPE {
 #define JSON_IGNOREILLUTF8VALUE     0x0400  /* Ignore ill-formed UTF-8 (for string values). */
 #define JSON_FIXILLUTF8VALUE        0x0800  /* Replace ill-formed UTF-8 char with replacement char (for string values). */
 
+/* Track only the offset while parsing. Line and column numbers (as reported
+ * by json_fini()) are then derived only once per json_feed() call by
+ * counting the new lines in the fed block. The reported positions are the
+ * same as without the flag but this is faster for large blocks, especially
+ * with pretty-printed input. */
+#define JSON_LAZYPOS                0x1000
+
+/* Do not accumulate string values spanning over multiple json_feed() calls.
+ * Instead, whatever is decoded when the end of the fed block is reached, is
+ * reported as JSON_STRING_PART. The final JSON_STRING then carries only the
+ * remaining tail of the string (which may be empty).
+ *
+ * Hence the memory needed for the string is bounded by the size of the fed
+ * blocks. (Note max_string_len still limits the complete string. Keys are
+ * always reported whole.) */
+#define JSON_STRINGPARTS            0x2000
+
+/* Accept a stream of top-level values (e.g. NDJSON) instead of a single one.
+ * The values may be separated by any whitespace (or by nothing at all, if
+ * they cannot be confused with each other, e.g. "[1][2]").
+ *
+ * Completion of each top-level value is reported as JSON_DOCUMENT_END. Limits
+ * JSON_CONFIG::max_total_values and the allowed root types apply to each
+ * document on its own; JSON_CONFIG::max_total_len limits the whole stream
+ * (so set it to zero for streams of unbounded length).
+ *
+ * An empty stream (whitespace only) is valid. */
+#define JSON_MULTIDOC               0x4000
+
+/* Report strings (and keys) raw, i.e. as they are in the input between the
+ * quotes, with any escape sequences left intact. The strings are still fully
+ * validated but they are not decoded, so typically no copy is made at all.
+ * Use json_string_has_escapes() to find out whether the string needs any
+ * decoding and json_decode_string() to decode it when it does.
+ *
+ * Ill-formed UTF-8 is left as it is too, even with JSON_FIXILLUTF8KEY or
+ * JSON_FIXILLUTF8VALUE (json_decode_string() then does the replacement). With
+ * JSON_STRINGPARTS, the parts are raw as well and an escape sequence may be
+ * split between two parts. Note json_set_projection() matches raw keys too.
+ *
+ * The DOM parser ignores this flag. */
+#define JSON_RAWSTRINGS             0x8000
+
+/* Decode each number into JSON_NUMBER_INFO (i.e. its class and the value) as
+ * it is validated, so that json_number_info() can be used in the callback for
+ * JSON_NUMBER. Without this flag, only the number string is reported and no
+ * time is spent on the conversion.
+ *
+ * It is implied by JSON_CALLBACKS_EX::on_number_info. The DOM parser always
+ * uses it. */
+#define JSON_NUMBERINFO             0x10000
+
+
+
+/* Custom memory allocator (see JSON_CONFIG::allocator).
+ *
+ * The functions have the same semantics as malloc(), realloc() and free(),
+ * with the member ctx passed as the last argument.
+ *
+ * It is the very same type as VALUE_ALLOCATOR in value.h, so one structure
+ * can serve both the parser and the values the DOM parser creates. (It is
+ * defined here as well so that json.h does not depend on value.h.)
+ */
+#ifndef VALUE_ALLOCATOR_DEFINED
+#define VALUE_ALLOCATOR_DEFINED
+typedef struct VALUE_ALLOCATOR {
+    void* (*alloc_func)(size_t /*size*/, void* /*ctx*/);
+    void* (*realloc_func)(void* /*ptr*/, size_t /*size*/, void* /*ctx*/);
+    void (*free_func)(void* /*ptr*/, void* /*ctx*/);
+    void* ctx;
+} VALUE_ALLOCATOR;
+#endif
+
+typedef VALUE_ALLOCATOR JSON_ALLOCATOR;
 
 
 /* Parser options, passed into json_init().
@@ -112,6 +189,12 @@ typedef struct JSON_CONFIG {
     size_t max_key_len;         /* zero means no limit; default: 512 */
     unsigned max_nesting_level; /* zero means no limit; default: 512 */
     unsigned flags;             /* default: 0 */
+    size_t max_retained_size;   /* zero means no limit; default: 0 (see json_reset()) */
+
+    /* Allocator for all memory the parser needs; NULL means malloc() & co.
+     * The parser keeps just the pointer, so the structure has to live until
+     * json_fini(). Default: NULL */
+    const JSON_ALLOCATOR* allocator;
 } JSON_CONFIG;
 
 
@@ -132,9 +215,9 @@ typedef struct JSON_INPUT_POS {
 typedef struct JSON_CALLBACKS {
     /* Data processing callback. For now (and maybe forever) the only callback.
      *
-     * Note that `data` and `data_size` are set only for JSON_KEY, JSON_STRING
-     * and JSON_NUMBER. (For the other types the callback always gets NULL and
-     * 0).
+     * Note that `data` and `data_size` are set only for JSON_KEY, JSON_STRING,
+     * JSON_STRING_PART and JSON_NUMBER. (For the other types the callback
+     * always gets NULL and 0).
      *
      * Inside an object, the application is guaranteed to get keys and their
      * corresponding values in the alternating fashion (i.e. in the order
@@ -143,16 +226,118 @@ typedef struct JSON_CALLBACKS {
      * Application can abort the parsing operation by returning a non-zero.
      * Note the non-zero return value of the callback is propagated to
      * json_feed() and json_fini().
+     *
+     * The only exceptions are JSON_SKIP and JSON_PAUSE (see below).
      */
     int (*process)(JSON_TYPE /*type*/, const char* /*data*/,
                    size_t /*data_size*/, void* /*user_data*/);
 } JSON_CALLBACKS;
 
 
+/* Special return value of the callbacks: The application is not interested in
+ * what follows.
+ *
+ *  - If returned for JSON_KEY, the value of the key is skipped.
+ *  - If returned for JSON_ARRAY_BEG or JSON_OBJECT_BEG, all the contents of the
+ *    array or object are skipped. (JSON_ARRAY_END or JSON_OBJECT_END is still
+ *    reported.)
+ *  - For any other type, it is the same as zero.
+ *
+ * The skipped data are still validated, but not reported in any way (and not
+ * counted into JSON_CONFIG::max_total_values).
+ */
+#define JSON_SKIP                   1000
+
+/* Special return value of the callbacks: The application cannot take more
+ * data right now (e.g. its queue is full).
+ *
+ * The event is still processed as if zero has been returned, but then
+ * json_feed_ex() (or json_feed()) stops right after the input which produced
+ * it and returns JSON_PAUSE. The application may then resume the parsing any
+ * time later by feeding the rest of the input (i.e. all the bytes which
+ * json_feed_ex() has not consumed).
+ *
+ * It makes sense only with json_feed_ex(), which reports the count of the
+ * consumed bytes. (Note the count may be zero: e.g. a number or a literal can
+ * be reported only once the next byte is seen.)
+ *
+ * For JSON_KEY with a projection active (see json_set_projection()), the
+ * pause takes place only after the value of the key is reported too.
+ */
+#define JSON_PAUSE                  1001
+
+
+/* Decoded value of a number (see JSON_NUMBERINFO).
+ *
+ * The class is the first of the types below the number fits in, in the same
+ * sense as json_analyze_number() says; so e.g. JSON_NUMBER_UINT32 means it is
+ * too big for int32_t. Numbers with a fraction or an exponent part are always
+ * JSON_NUMBER_DOUBLE.
+ *
+ * The value is stored in the union member corresponding to the class.
+ */
+typedef enum JSON_NUMBER_CLASS {
+    JSON_NUMBER_INT32 = 0,
+    JSON_NUMBER_UINT32,
+    JSON_NUMBER_INT64,
+    JSON_NUMBER_UINT64,
+    JSON_NUMBER_DOUBLE
+} JSON_NUMBER_CLASS;
+
+typedef struct JSON_NUMBER_INFO {
+    JSON_NUMBER_CLASS num_class;
+    union {
+        int32_t i32;
+        uint32_t u32;
+        int64_t i64;
+        uint64_t u64;
+        double d;
+    } value;
+} JSON_NUMBER_INFO;
+
+
+/* Alternative to JSON_CALLBACKS, with a dedicated callback for each type.
+ * (Use json_init_ex() or json_parse_ex() with it.)
+ *
+ * Any callback may be NULL if the application is not interested in the given
+ * type. The parser then also skips some work, e.g. it does not collect text
+ * of numbers if `on_number` is NULL. (The input is still fully validated.)
+ *
+ * `on_string_part` is used only with JSON_STRINGPARTS, and `on_document_end`
+ * only with JSON_MULTIDOC.
+ *
+ * If `on_number_info` is set, it is called instead of `on_number`, with the
+ * decoded number in `info` (as if JSON_NUMBERINFO is used).
+ *
+ * All the callbacks can abort the parsing operation by returning a non-zero,
+ * as JSON_CALLBACKS::process() can.
+ */
+typedef struct JSON_CALLBACKS_EX {
+    int (*on_null)(void* /*user_data*/);
+    int (*on_bool)(int /*value*/, void* /*user_data*/);
+    int (*on_number)(const char* /*data*/, size_t /*data_size*/, void* /*user_data*/);
+    int (*on_string)(const char* /*data*/, size_t /*data_size*/, void* /*user_data*/);
+    int (*on_string_part)(const char* /*data*/, size_t /*data_size*/, void* /*user_data*/);
+    int (*on_key)(const char* /*data*/, size_t /*data_size*/, void* /*user_data*/);
+    int (*on_begin_array)(void* /*user_data*/);
+    int (*on_end_array)(void* /*user_data*/);
+    int (*on_begin_object)(void* /*user_data*/);
+    int (*on_end_object)(void* /*user_data*/);
+    int (*on_document_end)(void* /*user_data*/);
+    int (*on_number_info)(const char* /*data*/, size_t /*data_size*/,
+                          const JSON_NUMBER_INFO* /*info*/, void* /*user_data*/);
+} JSON_CALLBACKS_EX;
+
+
+
+
+struct JSON_PROJECTION;
+
 /* Internal parser state. Use pointer to this structure as an opaque handle.
  */
 typedef struct JSON_PARSER {
     JSON_CALLBACKS callbacks;
+    JSON_CALLBACKS_EX callbacks_ex;     /* Used if callbacks.process is NULL. */
     JSON_CONFIG config;
     void* user_data;
 
@@ -173,12 +358,25 @@ typedef struct JSON_PARSER {
     unsigned substate;
 
     uint32_t codepoint[2];
+    int str_has_escapes;    /* See json_string_has_escapes() */
 
     char* buf;
     size_t buf_used;
     size_t buf_alloced;
 
     size_t last_cl_offset;  /* Offset of most recently seen '\r' */
+
+    size_t skip_level;      /* Non-zero when skipping (see JSON_SKIP) */
+    int skip_closer;        /* Report the closer which ends the skipping */
+
+    struct JSON_PROJECTION* projection;     /* See json_set_projection() */
+
+    /* The number being parsed (see json_number_info()). */
+    uint64_t num_mantissa;  /* Leading significant digits */
+    int num_exp_adjust;     /* Decimal exponent of num_mantissa (w/o the explicit one) */
+    unsigned num_exp;       /* The explicit exponent (saturated) */
+    unsigned num_flags;
+    JSON_NUMBER_INFO num_info;
 } JSON_PARSER;
 
 
@@ -198,6 +396,64 @@ int json_init(JSON_PARSER* parser,
               const JSON_CONFIG* config,
               void* user_data);
 
+/* Same as json_init() but with the per-type callbacks.
+ */
+int json_init_ex(JSON_PARSER* parser,
+                 const JSON_CALLBACKS_EX* callbacks,
+                 const JSON_CONFIG* config,
+                 void* user_data);
+
+/* Report only the values on the given JSON pointers (RFC 6901, same syntax
+ * as json_ptr_get() uses), together with the arrays and objects (and keys)
+ * leading to them. Anything else is only validated and skipped as with
+ * JSON_SKIP.
+ *
+ * This has to be called after json_init() and before the first json_feed().
+ *
+ * Note the negative array indexes and "-" (as allowed by json_ptr_get()) never
+ * match anything: We do not know the array size in advance.
+ *
+ * Returns zero on success, JSON_ERR_BADPOINTER if any pointer is malformed, or
+ * JSON_ERR_OUTOFMEMORY.
+ */
+int json_set_projection(JSON_PARSER* parser, const char* const* pointers,
+                        size_t n_pointers);
+
+/* Get the decoded value of the number just being reported.
+ *
+ * This is valid only with JSON_NUMBERINFO, and only inside the callback for
+ * JSON_NUMBER. (JSON_CALLBACKS::process does not get the parser, so it has to
+ * be reached via `user_data`; e.g. the DOM parser does so. With per-type
+ * callbacks, JSON_CALLBACKS_EX::on_number_info is more convenient.)
+ */
+const JSON_NUMBER_INFO* json_number_info(const JSON_PARSER* parser);
+
+/* Find out whether the string (or key) just being reported contains any
+ * escape sequences. This is valid only inside the callback for JSON_STRING
+ * or JSON_KEY.
+ *
+ * It is mainly useful with JSON_RAWSTRINGS: If it returns zero, the raw string
+ * is the same as the decoded one (unless it contains ill-formed UTF-8 and
+ * JSON_FIXILLUTF8KEY or JSON_FIXILLUTF8VALUE is used).
+ */
+int json_string_has_escapes(const JSON_PARSER* parser);
+
+/* Decode a raw string (or key) as reported with JSON_RAWSTRINGS.
+ *
+ * `type` is JSON_STRING or JSON_KEY and `flags` are the JSON_CONFIG::flags
+ * the string has been parsed with, so that ill-formed UTF-8 is treated in the
+ * same way as the parser would without JSON_RAWSTRINGS.
+ *
+ * The decoded string is never longer than the raw one, unless ill-formed
+ * UTF-8 is to be fixed. So `buffer` has to be able to hold `raw_size` bytes,
+ * or `3 * raw_size` bytes if JSON_FIXILLUTF8KEY (for keys) or
+ * JSON_FIXILLUTF8VALUE (for string values) is used.
+ *
+ * Returns the length of the decoded string. (The string is not terminated.)
+ */
+size_t json_decode_string(JSON_TYPE type, const char* raw, size_t raw_size,
+                          unsigned flags, char* buffer);
+
 /* Feed the parser with more input.
  *
  * Returns zero on success.
@@ -208,6 +464,24 @@ int json_init(JSON_PARSER* parser,
  */
 int json_feed(JSON_PARSER* parser, const char* input, size_t size);
 
+/* Same as json_feed() but it also reports in `p_consumed` (if not NULL) the
+ * count of bytes consumed from the input.
+ *
+ * Unless a callback has paused the parsing by returning JSON_PAUSE, the whole
+ * input is consumed on success. On JSON_PAUSE, the application should later
+ * call json_feed_ex() again with the remaining (not consumed) part of the
+ * input before feeding any further one.
+ */
+int json_feed_ex(JSON_PARSER* parser, const char* input, size_t size, size_t* p_consumed);
+
+/* Same as json_feed() but the caller also promises no more input follows,
+ * i.e. only json_fini() is called afterwards.
+ *
+ * Knowing the complete values lie in the input, the parser can handle them
+ * faster. (json_parse() and json_dom_parse() use this.)
+ */
+int json_feed_last(JSON_PARSER* parser, const char* input, size_t size);
+
 /* Finish parsing of the document (note it can still call some callbacks); and
  * release any resources held by the parser.
  *
@@ -225,6 +499,19 @@ int json_feed(JSON_PARSER* parser, const char* input, size_t size);
  */
 int json_fini(JSON_PARSER* parser, JSON_INPUT_POS* p_pos);
 
+/* Same as json_fini() but instead of releasing the resources, make the parser
+ * ready for another document, with the same callbacks, configuration,
+ * `user_data` and projection (if any), as if it has been just initialized.
+ *
+ * The buffers the parser has allocated so far are retained so parsing of many
+ * small documents does not need to allocate anything. Only buffers bigger than
+ * JSON_CONFIG::max_retained_size (if not zero) are released so that a single
+ * huge document does not keep a lot of memory allocated for good.
+ *
+ * Note json_fini() still has to be called once the parser is not needed.
+ */
+int json_reset(JSON_PARSER* parser, JSON_INPUT_POS* p_pos);
+
 
 /* Simple wrapper function for json_init() + json_feed() + json_fini(), usable
  * when the provided input contains complete JSON document.
@@ -233,6 +520,121 @@ int json_parse(const char* input, size_t size,
                const JSON_CALLBACKS* callbacks, const JSON_CONFIG* config,
                void* user_data, JSON_INPUT_POS* p_pos);
 
+/* Same as json_parse() but with the per-type callbacks.
+ */
+int json_parse_ex(const char* input, size_t size,
+                  const JSON_CALLBACKS_EX* callbacks, const JSON_CONFIG* config,
+                  void* user_data, JSON_INPUT_POS* p_pos);
+
+/* Drop-in replacement of json_parse(), optimized for bigger documents.
+ *
+ * It first builds an index of structural characters and value starts in the
+ * input (using SIMD instructions if available) and then it walks the index,
+ * skipping the whitespace in between at once.
+ *
+ * The callbacks are called exactly as by json_parse(); and also all the
+ * limits, errors and reported positions are the same.
+ */
+int json_parse_indexed(const char* input, size_t size,
+               const JSON_CALLBACKS* callbacks, const JSON_CONFIG* config,
+               void* user_data, JSON_INPUT_POS* p_pos);
+
+
+/* Only check the input is a valid JSON document, i.e. that json_parse() would
+ * succeed with it.
+ *
+ * All the limits in `config` (may be NULL) apply, and the returned error code
+ * and the position are the same as json_parse() would provide. But no data
+ * are decoded (e.g. escape sequences in strings) and no memory but the
+ * nesting stack of arrays and objects is allocated.
+ */
+int json_validate(const char* input, size_t size, const JSON_CONFIG* config,
+                  JSON_INPUT_POS* p_pos);
+
+
+/* Pull parser.
+ *
+ * Instead of calling the callbacks, the cursor hands the events out one by one
+ * as the application asks for them with json_cursor_next(). This may be more
+ * convenient e.g. for recursive-descent consumers decoding the data directly
+ * into their own structures.
+ *
+ * The cursor works over a complete input in a single buffer. It is built on
+ * the same parser as json_parse(), so all the validation, limits, errors and
+ * reported positions are the same. (It uses JSON_PAUSE internally.)
+ *
+ * Do not access the structure directly, and do not move it in memory after
+ * json_cursor_init().
+ */
+typedef struct JSON_CURSOR {
+    JSON_PARSER parser;
+    const char* input;
+    size_t size;
+    size_t off;
+    int finished;
+    int document_end_pending;
+
+    /* The current event. */
+    int has_event;
+    JSON_TYPE type;
+    const char* data;
+    size_t data_size;
+} JSON_CURSOR;
+
+/* Returned by json_cursor_next() when there is no more event. */
+#define JSON_CURSOR_END             1
+
+/* Initialize the cursor over the given input.
+ *
+ * `config` may be NULL to use the defaults. The buffer has to stay valid and
+ * unchanged until json_cursor_fini().
+ */
+int json_cursor_init(JSON_CURSOR* cursor, const char* input, size_t size,
+                     const JSON_CONFIG* config);
+
+/* Get the next event.
+ *
+ * Returns zero and fills `p_type`, `p_data` and `p_data_size` (any of them
+ * may be NULL) the same way as JSON_CALLBACKS::process() gets them. The data
+ * are valid only until the next call of any json_cursor_XXX() function.
+ *
+ * Returns JSON_CURSOR_END if the whole input has been successfully parsed, or
+ * an error code if the input is invalid (see json_cursor_fini() for position
+ * of the error). Once it fails, it keeps failing with the same error.
+ */
+int json_cursor_next(JSON_CURSOR* cursor, JSON_TYPE* p_type,
+                     const char** p_data, size_t* p_data_size);
+
+/* Skip the value the most recent event belongs to: If the event is JSON_KEY,
+ * its value is skipped; for JSON_ARRAY_BEG or JSON_OBJECT_BEG, the rest of
+ * the array or object including its closer is skipped. For any other event,
+ * it does nothing.
+ *
+ * The skipped data are only validated (as with JSON_SKIP), not decoded nor
+ * reported; the skipping happens as a part of the next json_cursor_next().
+ */
+int json_cursor_skip(JSON_CURSOR* cursor);
+
+/* Get the decoded value of a number the most recent JSON_NUMBER event is
+ * about (see json_number_info()). This is valid only if the cursor has been
+ * initialized with JSON_NUMBERINFO.
+ */
+const JSON_NUMBER_INFO* json_cursor_number_info(const JSON_CURSOR* cursor);
+
+/* Find out whether the string or key the most recent JSON_STRING or JSON_KEY
+ * event is about contains any escape sequences (see json_string_has_escapes()).
+ */
+int json_cursor_string_has_escapes(const JSON_CURSOR* cursor);
+
+/* Release any resources held by the cursor.
+ *
+ * Any rest of the input the application has not asked for is still validated,
+ * so the function returns zero if the whole input is valid, or an error code
+ * otherwise (the same as json_parse() would). If `p_pos` is not NULL, it is
+ * filled as by json_fini().
+ */
+int json_cursor_fini(JSON_CURSOR* cursor, JSON_INPUT_POS* p_pos);
+
 
 /* Converts error code to human readable error message
  */
@@ -264,8 +666,9 @@ void json_analyze_number(const char* num, size_t num_size,
  * Note the conversion to any of the integer types is undefined unless
  * json_analyze_number() says it's fine.
  *
- * Also note that json_number_to_double() can fail with JSON_ERR_OUTOFMEMORY.
- * Hence its prototype differs.
+ * json_number_to_double() is correctly rounded and it does not depend on the
+ * current locale. (Its prototype differs for historic reasons: It used to be
+ * able to fail with JSON_ERR_OUTOFMEMORY. Now it always succeeds.)
  */
 int32_t json_number_to_int32(const char* num, size_t num_size);
 uint32_t json_number_to_uint32(const char* num, size_t num_size);
@@ -282,6 +685,12 @@ typedef int (*JSON_DUMP_CALLBACK)(const char* /*str*/, size_t /*size*/, void* /*
  * string which needs no additional Unicode validation. The function "only"
  * handles proper escaping of control characters.
  *
+ * json_dump_double() and json_dump_float() write the shortest number which
+ * reads back as the same double (or float), independently on the current
+ * locale. Numbers without fraction and exponent get ".0" appended so they
+ * are not mistaken for integers. (Note infinity and NaN have no valid JSON
+ * representation; these are written as "inf", "-inf" and "nan".)
+ *
  * The provided writer callback must write all the data provided to it and
  * return zero to indicate success, or non-zero to indicate an error and abort
  * the operation.
@@ -297,8 +706,24 @@ int json_dump_uint32(uint32_t u32, JSON_DUMP_CALLBACK write_func, void* user_dat
 int json_dump_int64(int64_t i64, JSON_DUMP_CALLBACK write_func, void* user_data);
 int json_dump_uint64(uint64_t u64, JSON_DUMP_CALLBACK write_func, void* user_data);
 int json_dump_double(double dbl, JSON_DUMP_CALLBACK write_func, void* user_data);
+int json_dump_float(float flt, JSON_DUMP_CALLBACK write_func, void* user_data);
 int json_dump_string(const char* str, size_t size, JSON_DUMP_CALLBACK write_func, void* user_data);
 
+/* Same as the json_dump_*() functions for numbers above, but these write into
+ * the caller-provided buffer (of at least JSON_FORMAT_BUFSIZE bytes) and
+ * return the count of bytes written. (The output is not zero-terminated.)
+ *
+ * This allows the application to batch many numbers into a single write.
+ */
+#define JSON_FORMAT_BUFSIZE         32
+
+size_t json_format_int32(char* buffer, int32_t i32);
+size_t json_format_uint32(char* buffer, uint32_t u32);
+size_t json_format_int64(char* buffer, int64_t i64);
+size_t json_format_uint64(char* buffer, uint64_t u64);
+size_t json_format_double(char* buffer, double dbl);
+size_t json_format_float(char* buffer, float flt);
+
 
 #ifdef __cplusplus
 }  /* extern "C" { */
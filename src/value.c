@@ -33,9 +33,22 @@
 #define HAS_REDCOLOR    0x10    /* only for VALUE_STRING (when used as RBTREE::key) */
 #define HAS_ORDERLIST   0x10    /* only for VALUE_DICT */
 #define HAS_CUSTOMCMP   0x20    /* only for VALUE_DICT */
+#define HAS_ALLOCATOR   0x40    /* only with IS_MALLOCED */
 #define IS_MALLOCED     0x80
 
 
+/* When a custom allocator is used, the malloc'ed payload is preceded with
+ * this header, so that value_fini() knows how to release it. The union
+ * keeps the payload aligned for any type we store in it. */
+typedef union ALLOC_HEADER_tag ALLOC_HEADER;
+union ALLOC_HEADER_tag {
+    const VALUE_ALLOCATOR* allocator;
+    void* align_ptr;
+    uint64_t align_u64;
+    double align_double;
+};
+
+
 typedef struct ARRAY_tag ARRAY;
 struct ARRAY_tag {
     VALUE* value_buf;
@@ -96,7 +109,33 @@ struct DICT_tag {
 
 
 static void*
-value_init_ex(VALUE* v, VALUE_TYPE type, size_t size, size_t align)
+value_malloc(const VALUE_ALLOCATOR* allocator, size_t size)
+{
+    if(allocator != NULL)
+        return allocator->alloc_func(size, allocator->ctx);
+    return malloc(size);
+}
+
+static void*
+value_realloc(const VALUE_ALLOCATOR* allocator, void* ptr, size_t size)
+{
+    if(allocator != NULL)
+        return allocator->realloc_func(ptr, size, allocator->ctx);
+    return realloc(ptr, size);
+}
+
+static void
+value_free(const VALUE_ALLOCATOR* allocator, void* ptr)
+{
+    if(allocator != NULL)
+        allocator->free_func(ptr, allocator->ctx);
+    else
+        free(ptr);
+}
+
+static void*
+value_init_ex(VALUE* v, VALUE_TYPE type, size_t size, size_t align,
+              const VALUE_ALLOCATOR* allocator)
 {
     v->data[0] = (uint8_t) type;
 
@@ -105,11 +144,26 @@ value_init_ex(VALUE* v, VALUE_TYPE type, size_t size, size_t align)
     } else {
         void* buf;
 
-        v->data[0] |= IS_MALLOCED;
-        buf = malloc(size);
-        if(buf == NULL) {
-            v->data[0] = (uint8_t) VALUE_NULL;
-            return NULL;
+        if(allocator != NULL) {
+            ALLOC_HEADER* hdr;
+
+            hdr = (ALLOC_HEADER*) value_malloc(allocator, sizeof(ALLOC_HEADER) + size);
+            if(hdr == NULL) {
+                v->data[0] = (uint8_t) VALUE_NULL;
+                return NULL;
+            }
+
+            hdr->allocator = allocator;
+            buf = (void*) (hdr + 1);
+            v->data[0] |= IS_MALLOCED | HAS_ALLOCATOR;
+        } else {
+            buf = malloc(size);
+            if(buf == NULL) {
+                v->data[0] = (uint8_t) VALUE_NULL;
+                return NULL;
+            }
+
+            v->data[0] |= IS_MALLOCED;
         }
 
         *((void**) &v->data[sizeof(void*)]) = buf;
@@ -120,7 +174,7 @@ value_init_ex(VALUE* v, VALUE_TYPE type, size_t size, size_t align)
 static void*
 value_init(VALUE* v, VALUE_TYPE type, size_t size)
 {
-    return value_init_ex(v, type, size, 1);
+    return value_init_ex(v, type, size, 1, NULL);
 }
 
 static int
@@ -159,6 +213,15 @@ value_payload(VALUE* v)
  *** Generic info ***
  ********************/
 
+const VALUE_ALLOCATOR*
+value_allocator(const VALUE* v)
+{
+    if(v == NULL  ||  (v->data[0] & (IS_MALLOCED | HAS_ALLOCATOR)) != (IS_MALLOCED | HAS_ALLOCATOR))
+        return NULL;
+
+    return ((ALLOC_HEADER*) value_payload((VALUE*) v) - 1)->allocator;
+}
+
 VALUE_TYPE
 value_type(const VALUE* v)
 {
@@ -237,8 +300,13 @@ value_path_ex(VALUE* root, const char* path, int allow_build)
     const char* token_beg = path;
     const char* token_end;
     VALUE* v = root;
+    const VALUE_ALLOCATOR* allocator = NULL;
 
     while(1) {
+        /* Any container we have to build inherits allocator of its parent. */
+        if(!value_is_new(v))
+            allocator = value_allocator(v);
+
         while(*token_beg == '/')
             token_beg++;
 
@@ -271,7 +339,7 @@ value_path_ex(VALUE* root, const char* path, int allow_build)
                 return NULL;
 
             if(allow_build  &&  value_is_new(v)) {
-                if(value_init_array(v) != 0)
+                if(value_init_array_alloc(v, allocator) != 0)
                     return NULL;
             }
 
@@ -293,7 +361,7 @@ value_path_ex(VALUE* root, const char* path, int allow_build)
         } else if(token_end - token_beg > 0) {
             if(allow_build) {
                 if(value_is_new(v)) {
-                    if(value_init_dict(v) != 0)
+                    if(value_init_dict_alloc(v, NULL, 0, allocator) != 0)
                         return NULL;
                 }
                 v = value_dict_get_or_add_(v, token_beg, token_end - token_beg);
@@ -407,6 +475,13 @@ value_init_double(VALUE* v, double d)
 
 int
 value_init_string_(VALUE* v, const char* str, size_t len)
+{
+    return value_init_string_alloc(v, str, len, NULL);
+}
+
+int
+value_init_string_alloc(VALUE* v, const char* str, size_t len,
+                        const VALUE_ALLOCATOR* allocator)
 {
     uint8_t* payload;
     size_t tmplen;
@@ -423,7 +498,7 @@ value_init_string_(VALUE* v, const char* str, size_t len)
     }
     off++;
 
-    payload = value_init(v, VALUE_STRING, off + len + 1);
+    payload = value_init_ex(v, VALUE_STRING, off + len + 1, 1, allocator);
     if(payload == NULL)
         return -1;
 
@@ -448,13 +523,19 @@ value_init_string(VALUE* v, const char* str)
 
 int
 value_init_array(VALUE* v)
+{
+    return value_init_array_alloc(v, NULL);
+}
+
+int
+value_init_array_alloc(VALUE* v, const VALUE_ALLOCATOR* allocator)
 {
     uint8_t* payload;
 
     if(v == NULL)
         return -1;
 
-    payload = value_init_ex(v, VALUE_ARRAY, sizeof(ARRAY), sizeof(void*));
+    payload = value_init_ex(v, VALUE_ARRAY, sizeof(ARRAY), sizeof(void*), allocator);
     if(payload == NULL)
         return -1;
     memset(payload, 0, sizeof(ARRAY));
@@ -472,6 +553,14 @@ int
 value_init_dict_ex(VALUE* v,
                    int (*custom_cmp_func)(const char*, size_t, const char*, size_t),
                    unsigned flags)
+{
+    return value_init_dict_alloc(v, custom_cmp_func, flags, NULL);
+}
+
+int
+value_init_dict_alloc(VALUE* v,
+                      int (*custom_cmp_func)(const char*, size_t, const char*, size_t),
+                      unsigned flags, const VALUE_ALLOCATOR* allocator)
 {
     uint8_t* payload;
     size_t payload_size;
@@ -484,7 +573,7 @@ value_init_dict_ex(VALUE* v,
     else
         payload_size = OFFSETOF(DICT, order_head);
 
-    payload = value_init_ex(v, VALUE_DICT, payload_size, sizeof(void*));
+    payload = value_init_ex(v, VALUE_DICT, payload_size, sizeof(void*), allocator);
     if(payload == NULL)
         return -1;
     memset(payload, 0, payload_size);
@@ -512,8 +601,12 @@ value_fini(VALUE* v)
     if(value_type(v) == VALUE_DICT)
         value_dict_clean(v);
 
-    if(v->data[0] & 0x80)
+    if(v->data[0] & HAS_ALLOCATOR) {
+        ALLOC_HEADER* hdr = (ALLOC_HEADER*) value_payload(v) - 1;
+        value_free(hdr->allocator, hdr);
+    } else if(v->data[0] & IS_MALLOCED) {
         free(value_payload(v));
+    }
 
     v->data[0] = VALUE_NULL;
 }
@@ -759,11 +852,11 @@ value_array_payload(VALUE* v)
 }
 
 static int
-value_array_realloc(ARRAY* a, size_t alloc)
+value_array_realloc(const VALUE_ALLOCATOR* allocator, ARRAY* a, size_t alloc)
 {
     VALUE* value_buf;
 
-    value_buf = (VALUE*) realloc(a->value_buf, alloc * sizeof(VALUE));
+    value_buf = (VALUE*) value_realloc(allocator, a->value_buf, alloc * sizeof(VALUE));
     if(value_buf == NULL)
         return -1;
 
@@ -820,7 +913,8 @@ value_array_insert(VALUE* v, size_t index)
         return NULL;
 
     if(a->size >= a->alloc) {
-        if(value_array_realloc(a, value_array_good_alloc_size(a->alloc + 1)) != 0)
+        if(value_array_realloc(value_allocator(v), a,
+                    value_array_good_alloc_size(a->alloc + 1)) != 0)
             return NULL;
     }
 
@@ -858,7 +952,7 @@ value_array_remove_range(VALUE* v, size_t index, size_t count)
     a->size -= count;
 
     if(a->size < a->alloc / 4)
-        value_array_realloc(a, value_array_good_alloc_size(a->size * 2));
+        value_array_realloc(value_allocator(v), a, value_array_good_alloc_size(a->size * 2));
 
     return 0;
 }
@@ -875,7 +969,7 @@ value_array_clean(VALUE* v)
     for(i = 0; i < a->size; i++)
         value_fini(&a->value_buf[i]);
 
-    free(a->value_buf);
+    value_free(value_allocator(v), a->value_buf);
     memset(a, 0, sizeof(ARRAY));
 }
 
@@ -1159,9 +1253,10 @@ value_dict_get_or_add_(VALUE* v, const char* key, size_t key_len)
 {
     DICT* d = value_dict_payload((VALUE*) v);
     RBTREE* node = (d != NULL) ? d->root : NULL;
+    const VALUE_ALLOCATOR* allocator;
     RBTREE* path[RBTREE_MAX_HEIGHT];
     int path_len = 0;
-    int cmp;
+    int cmp = 0;
 
     if(d == NULL)
         return NULL;
@@ -1181,12 +1276,13 @@ value_dict_get_or_add_(VALUE* v, const char* key, size_t key_len)
     }
 
     /* Add new node into the tree. */
-    node = (RBTREE*) malloc((v->data[0] & HAS_ORDERLIST) ?
+    allocator = value_allocator(v);
+    node = (RBTREE*) value_malloc(allocator, (v->data[0] & HAS_ORDERLIST) ?
                 sizeof(RBTREE) : OFFSETOF(RBTREE, order_prev));
     if(node == NULL)
         return NULL;
-    if(value_init_string_(&node->key, key, key_len) != 0) {
-        free(node);
+    if(value_init_string_alloc(&node->key, key, key_len, allocator) != 0) {
+        value_free(allocator, node);
         return NULL;
     }
     value_init_new(&node->value);
@@ -1435,7 +1531,7 @@ value_dict_remove_(VALUE* v, const char* key, size_t key_len)
     }
     value_fini(&node->key);
     value_fini(&node->value);
-    free(node);
+    value_free(value_allocator(v), node);
     d->size--;
 
     return 0;
@@ -1513,7 +1609,7 @@ value_dict_clean(VALUE* v)
 
         value_fini(&node->key);
         value_fini(&node->value);
-        free(node);
+        value_free(value_allocator(v), node);
 
         stack_size += value_dict_leftmost_path(stack + stack_size, right);
     }
@@ -63,6 +63,33 @@ typedef enum VALUE_TYPE {
 } VALUE_TYPE;
 
 
+/* Custom memory allocator.
+ *
+ * By default, any memory the values need is allocated with malloc(),
+ * realloc() and free(). The initializers value_init_XXX_alloc() below allow
+ * to use an application-provided allocator instead. The allocator then serves
+ * all memory held by the value: for a string its buffer; for an array or a
+ * dictionary also its internal buffers and nodes, and the dictionary keys.
+ * Containers created by value_build_path() inherit the allocator of their
+ * parent; value_fini() releases everything through the same allocator.
+ *
+ * The functions have the same semantics as malloc(), realloc() and free(),
+ * with the member ctx passed as the last argument.
+ *
+ * Note the VALUE only remembers a pointer to the VALUE_ALLOCATOR structure,
+ * so the structure has to outlive all values using it.
+ */
+#ifndef VALUE_ALLOCATOR_DEFINED
+#define VALUE_ALLOCATOR_DEFINED
+typedef struct VALUE_ALLOCATOR {
+    void* (*alloc_func)(size_t /*size*/, void* /*ctx*/);
+    void* (*realloc_func)(void* /*ptr*/, size_t /*size*/, void* /*ctx*/);
+    void (*free_func)(void* /*ptr*/, void* /*ctx*/);
+    void* ctx;
+} VALUE_ALLOCATOR;
+#endif
+
+
 /* Free any resources the value holds.
  * For ARRAY and DICT it is recursive.
  */
@@ -99,6 +126,14 @@ int value_is_compatible(const VALUE* v, VALUE_TYPE type);
  */
 int value_is_new(const VALUE* v);
 
+/* Get the custom allocator the value has been initialized with, or NULL if
+ * it uses malloc() & co.
+ *
+ * Note that short strings which fit into the VALUE structure itself need no
+ * memory at all, so for them NULL is returned too.
+ */
+const VALUE_ALLOCATOR* value_allocator(const VALUE* v);
+
 /* Simple recursive getter, capable to get a value dwelling deep in the
  * hierarchy formed by nested arrays and dictionaries.
  *
@@ -248,10 +283,15 @@ double value_double(const VALUE* v);
  * The function value_init_string() is equivalent to calling directly
  * value_init_string_(str, strlen(str)).
  *
+ * The function value_init_string_alloc() is the same as value_init_string_()
+ * but it uses the given allocator (may be NULL) for the string buffer.
+ *
  * The parameter str is allowed to be NULL (then the functions behave the same
  * way as if it is points to an empty string).
  */
 int value_init_string_(VALUE* v, const char* str, size_t len);
+int value_init_string_alloc(VALUE* v, const char* str, size_t len,
+                            const VALUE_ALLOCATOR* allocator);
 int value_init_string(VALUE* v, const char* str);
 
 /* Get pointer to the internal buffer holding the string. The caller may assume
@@ -281,8 +321,12 @@ size_t value_string_length(const VALUE* v);
  * Hence, consider all VALUE* pointers invalid after modifying the array.
  * That includes the return values of value_array_get(), value_array_get_all(),
  * but also preceding calls of value_array_append() and value_array_insert().
+ *
+ * value_init_array_alloc() additionally allows to specify custom allocator
+ * (may be NULL) used for the internal array buffer.
  */
 int value_init_array(VALUE* v);
+int value_init_array_alloc(VALUE* v, const VALUE_ALLOCATOR* allocator);
 
 /* Get count of items in the array.
  */
@@ -339,12 +383,19 @@ void value_array_clean(VALUE* v);
  *
  * value_init_dict_ex() allows to specify custom comparer function (may be NULL)
  * or flags changing the default behavior of the dictionary.
+ *
+ * value_init_dict_alloc() additionally allows to specify custom allocator
+ * (may be NULL).
  */
 int value_init_dict(VALUE* v);
 int value_init_dict_ex(VALUE* v,
                        int (*custom_cmp_func)(const char* /*key1*/, size_t /*len1*/,
                                               const char* /*key2*/, size_t /*len2*/),
                        unsigned flags);
+int value_init_dict_alloc(VALUE* v,
+                          int (*custom_cmp_func)(const char* /*key1*/, size_t /*len1*/,
+                                                 const char* /*key2*/, size_t /*len2*/),
+                          unsigned flags, const VALUE_ALLOCATOR* allocator);
 
 /* Get flags of the dictionary.
  */
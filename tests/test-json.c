@@ -26,6 +26,7 @@
 #include "acutest.h"
 #include "json.h"
 #include "json-dom.h"
+#include "json-parallel.h"
 #include "json-ptr.h"
 #include "value.h"
 
@@ -163,19 +164,13 @@ parse_(const char* input, size_t size, const JSON_CONFIG* config,
     int err2;
     JSON_INPUT_POS pos2;
 
-    /* Config to disable all limitations. */
-    static const JSON_CONFIG config_no_limit = {
-        0,  /* max_total_len */
-        0,  /* max_total_values */
-        0,  /* max_number_len */
-        0,  /* max_string_len */
-        0,  /* max_key_len */
-        0,  /* max_nesting_level */
-        0   /* flags */
-    };
+    JSON_CONFIG config_no_limit;
 
-    if(config == NULL)
+    if(config == NULL) {
+        /* Config to disable all limitations. */
+        memset(&config_no_limit, 0, sizeof(JSON_CONFIG));
         config = &config_no_limit;
+    }
 
     err1 = json_dom_parse(input, size, config, dom_flags, &root1, &pos1);
     err2 = parse_byte_by_byte(input, size, config, dom_flags, &root2, &pos2);
@@ -217,6 +212,61 @@ parse(const char* input, const JSON_CONFIG* config, unsigned dom_flags,
     return parse_(input, strlen(input), config, dom_flags, p_root, p_pos);
 }
 
+/* For testing the SAX-like interface, we record all the events (and the final
+ * result) as a text, so that output of two parser runs can easily be compared.
+ */
+typedef struct EVENT_LOG {
+    char* buf;
+    size_t size;
+    size_t alloced;
+} EVENT_LOG;
+
+static void
+event_log_append(EVENT_LOG* log, const char* data, size_t size)
+{
+    if(log->size + size > log->alloced) {
+        log->alloced = (log->size + size) * 2;
+        log->buf = (char*) realloc(log->buf, log->alloced);
+    }
+    if(size > 0)
+        memcpy(log->buf + log->size, data, size);
+    log->size += size;
+}
+
+static int
+event_log_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    EVENT_LOG* log = (EVENT_LOG*) userdata;
+    char tmp[32];
+
+    sprintf(tmp, "%d:", (int) type);
+    event_log_append(log, tmp, strlen(tmp));
+    event_log_append(log, data, size);
+    event_log_append(log, "\n", 1);
+    return 0;
+}
+
+static void
+event_log_result(EVENT_LOG* log, int err, const JSON_INPUT_POS* pos)
+{
+    char tmp[128];
+
+    sprintf(tmp, "err=%d offset=%u line=%u column=%u", err,
+            (unsigned) pos->offset, pos->line_number, pos->column_number);
+    event_log_append(log, tmp, strlen(tmp));
+}
+
+static void
+event_log_cmp(EVENT_LOG* log1, EVENT_LOG* log2)
+{
+    if(!TEST_CHECK(log1->size == log2->size  &&
+                   memcmp(log1->buf, log2->buf, log1->size) == 0))
+    {
+        TEST_MSG("Expected: %.*s", (int) (log1->size < 200 ? log1->size : 200), log1->buf);
+        TEST_MSG("Produced: %.*s", (int) (log2->size < 200 ? log2->size : 200), log2->buf);
+    }
+}
+
 
 /******************
  *** Unit Tests ***
@@ -271,6 +321,151 @@ test_pos_tracking(void)
     TEST_CHECK(pos.offset == 12);
     TEST_CHECK(pos.line_number == 3);
     TEST_CHECK(pos.column_number == 4);
+
+    /* Long runs of blanks (longer then any SIMD block). */
+    parse("\t                                                  \t\n"
+          "                                       \t      \t    x", NULL, 0, NULL, &pos);
+    TEST_CHECK(pos.offset == 104);
+    TEST_CHECK(pos.line_number == 2);
+    TEST_CHECK(pos.column_number == 52);
+
+    /* Long runs of blanks mixed with all kinds of new lines. */
+    parse("[\r\n                    \r\r\n\n"
+          "                              \n\r   x", NULL, 0, NULL, &pos);
+    TEST_CHECK(pos.offset == 62);
+    TEST_CHECK(pos.line_number == 7);
+    TEST_CHECK(pos.column_number == 4);
+}
+
+static int
+pos_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    (void) type;
+    (void) data;
+    (void) size;
+    (void) userdata;
+    return 0;
+}
+
+/* Feed the input into the SAX-like parser byte by byte. */
+static int
+parse_bytewise(const char* input, const JSON_CONFIG* config, JSON_INPUT_POS* p_pos)
+{
+    JSON_CALLBACKS callbacks = { pos_callback };
+    JSON_PARSER parser;
+    size_t off, size = strlen(input);
+
+    json_init(&parser, &callbacks, config, NULL);
+    for(off = 0; off < size; off++) {
+        if(json_feed(&parser, input + off, 1) != 0)
+            break;
+    }
+    return json_fini(&parser, p_pos);
+}
+
+static void
+test_pos_tracking_lazy(void)
+{
+    static const char* inputs[] = {
+        "",
+        "\r\n\n\r\r\n   ",
+        "[\r\n  1,\r\n  2\r\n]\r\n",
+        "{\n    \"a\": [ true, false, null ],\n\t\"b\": \"xyz\"\n}\n",
+        "[\n  1,\n  2x\n]",
+        "[\r\n  tru\r\n]",
+        "[\n  \"unclosed\n\"]",
+        "\n\n   \"foo\"   \n   \"bar\"",
+        "{\n  \"a\": 1,\n  \"b\": {\n    \"c\": [\n      \"long string, much longer than any SIMD block\",\r\n"
+            "      \"another long string, much longer than any SIMD block\"\r\n    ]\n  }\n}\r",
+        "[\n                                                                \r\n"
+            "                                                                \n\r"
+            "                                                                ] ]",
+        NULL
+    };
+    static const char* root_inputs[] = {
+        "  [1]",
+        "\n\r\n  { \"a\": 1 }",
+        "  \n  42",
+        "\r\n\r\n\"foo\"",
+        "\n  null",
+        NULL
+    };
+    static const char* new_lines[] = { "\r\n", "\n", "\r", "  \t" };
+    char long_input[8192];
+    JSON_CONFIG config;
+    JSON_INPUT_POS pos, lazy_pos;
+    int i, err, lazy_err;
+    size_t n;
+
+    json_default_config(&config);
+    config.flags |= JSON_LAZYPOS;
+
+    for(i = 0; inputs[i] != NULL; i++) {
+        TEST_CASE_("input #%d", i);
+        err = parse(inputs[i], NULL, 0, NULL, &pos);
+        lazy_err = parse(inputs[i], &config, 0, NULL, &lazy_pos);
+        TEST_CHECK(lazy_err == err);
+        TEST_CHECK(lazy_pos.offset == pos.offset);
+        TEST_CHECK(lazy_pos.line_number == pos.line_number);
+        TEST_CHECK(lazy_pos.column_number == pos.column_number);
+
+        config.flags &= ~JSON_LAZYPOS;
+        err = parse_bytewise(inputs[i], &config, &pos);
+        config.flags |= JSON_LAZYPOS;
+        lazy_err = parse_bytewise(inputs[i], &config, &lazy_pos);
+        TEST_CHECK(lazy_err == err);
+        TEST_CHECK(lazy_pos.offset == pos.offset);
+        TEST_CHECK(lazy_pos.line_number == pos.line_number);
+        TEST_CHECK(lazy_pos.column_number == pos.column_number);
+    }
+    TEST_CASE(NULL);
+
+    /* Long runs of new lines (more than the new line counting handles in
+     * one go). */
+    TEST_CASE("long input");
+    n = 0;
+    long_input[n++] = '[';
+    for(i = 0; n < sizeof(long_input) - 16; i++) {
+        strcpy(long_input + n, new_lines[(i * 7) % 4]);
+        n += strlen(long_input + n);
+    }
+    strcpy(long_input + n, "1 x");
+    err = parse(long_input, NULL, 0, NULL, &pos);
+    lazy_err = parse(long_input, &config, 0, NULL, &lazy_pos);
+    TEST_CHECK(err == JSON_ERR_EXPECTEDCOMMAORCLOSER);
+    TEST_CHECK(lazy_err == err);
+    TEST_CHECK(lazy_pos.offset == pos.offset);
+    TEST_CHECK(lazy_pos.line_number == pos.line_number);
+    TEST_CHECK(lazy_pos.column_number == pos.column_number);
+    TEST_CASE(NULL);
+
+    /* Root type errors are reported at the value position, which may not be
+     * recorded at all. (Fed in small blocks, it must not get resolved by an
+     * earlier block.) */
+    for(i = 0; root_inputs[i] != NULL; i++) {
+        TEST_CASE_("root input #%d", i);
+        config.flags = JSON_NOVECTORROOT | JSON_NOSCALARROOT;
+        err = parse_bytewise(root_inputs[i], &config, &pos);
+        config.flags |= JSON_LAZYPOS;
+        lazy_err = parse_bytewise(root_inputs[i], &config, &lazy_pos);
+        TEST_CHECK(err == JSON_ERR_BADROOTTYPE);
+        TEST_CHECK(lazy_err == err);
+        TEST_CHECK(lazy_pos.offset == pos.offset);
+        TEST_CHECK(lazy_pos.line_number == pos.line_number);
+        TEST_CHECK(lazy_pos.column_number == pos.column_number);
+    }
+    TEST_CASE(NULL);
+
+    /* Error raised before any processing of the block. */
+    config.flags = JSON_LAZYPOS;
+    config.max_total_len = 10;
+    lazy_err = parse("[ 1, 2, 3, 4, 5 ]", &config, 0, NULL, &lazy_pos);
+    config.flags &= ~JSON_LAZYPOS;
+    err = parse("[ 1, 2, 3, 4, 5 ]", &config, 0, NULL, &pos);
+    TEST_CHECK(lazy_err == err);
+    TEST_CHECK(lazy_pos.offset == pos.offset);
+    TEST_CHECK(lazy_pos.line_number == pos.line_number);
+    TEST_CHECK(lazy_pos.column_number == pos.column_number);
 }
 
 static void
@@ -468,6 +663,95 @@ test_number(void)
     value_fini(&root);
 }
 
+/* Compare with what the utility functions say about the number string. */
+static int
+number_info_ex_callback(const char* data, size_t data_size,
+                        const JSON_NUMBER_INFO* info, void* user_data)
+{
+    int is_int32, is_uint32, is_int64, is_uint64;
+
+    (void) user_data;
+
+    json_analyze_number(data, data_size, &is_int32, &is_uint32, &is_int64, &is_uint64);
+    if(is_int32) {
+        TEST_CHECK(info->num_class == JSON_NUMBER_INT32);
+        TEST_CHECK(info->value.i32 == json_number_to_int32(data, data_size));
+    } else if(is_uint32) {
+        TEST_CHECK(info->num_class == JSON_NUMBER_UINT32);
+        TEST_CHECK(info->value.u32 == json_number_to_uint32(data, data_size));
+    } else if(is_int64) {
+        TEST_CHECK(info->num_class == JSON_NUMBER_INT64);
+        TEST_CHECK(info->value.i64 == json_number_to_int64(data, data_size));
+    } else if(is_uint64) {
+        TEST_CHECK(info->num_class == JSON_NUMBER_UINT64);
+        TEST_CHECK(info->value.u64 == json_number_to_uint64(data, data_size));
+    } else {
+        double d;
+
+        json_number_to_double(data, data_size, &d);
+        TEST_CHECK(info->num_class == JSON_NUMBER_DOUBLE);
+        TEST_CHECK(memcmp(&info->value.d, &d, sizeof(double)) == 0);
+    }
+    TEST_MSG("number: %.*s", (int) data_size, data);
+    return 0;
+}
+
+static int
+number_info_callback(JSON_TYPE type, const char* data, size_t data_size, void* user_data)
+{
+    JSON_PARSER* parser = (JSON_PARSER*) user_data;
+
+    if(type != JSON_NUMBER)
+        return 0;
+    return number_info_ex_callback(data, data_size, json_number_info(parser), NULL);
+}
+
+static void
+test_number_info(void)
+{
+    static const char* inputs[] = {
+        "0", "-0", "1", "-1", "2147483647", "-2147483648", "2147483648",
+        "-2147483649", "4294967295", "4294967296", "9223372036854775807",
+        "-9223372036854775808", "9223372036854775808", "-9223372036854775809",
+        "18446744073709551615", "18446744073709551616", "100000000000000000000",
+        "0.0", "-0.0", "1.0", "1e2", "1E+2", "-1e-2", "0.1", "123.456e-7",
+        "9007199254740993", "9007199254740993.0", "1e22", "1e23", "1e-22",
+        "1e-23", "0.000000000000000000000000000001", "1.7976931348623157e308",
+        "2e308", "4.9e-324", "2e-400", "123456789012345678901234567890e-10",
+        "[ 1, -2.5, 3e1, 18446744073709551615 ]"
+    };
+    JSON_CALLBACKS callbacks = { number_info_callback };
+    JSON_CALLBACKS_EX callbacks_ex;
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    size_t i, off, n;
+
+    json_default_config(&config);
+    config.flags |= JSON_NUMBERINFO;
+    memset(&callbacks_ex, 0, sizeof(JSON_CALLBACKS_EX));
+    callbacks_ex.on_number_info = number_info_ex_callback;
+
+    for(i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        TEST_CASE(inputs[i]);
+        n = strlen(inputs[i]);
+
+        /* The whole input at once. */
+        TEST_CHECK(json_init(&parser, &callbacks, &config, &parser) == 0);
+        json_feed_last(&parser, inputs[i], n);
+        TEST_CHECK(json_fini(&parser, NULL) == 0);
+
+        /* Byte by byte. */
+        TEST_CHECK(json_init(&parser, &callbacks, &config, &parser) == 0);
+        for(off = 0; off < n; off++)
+            json_feed(&parser, inputs[i] + off, 1);
+        TEST_CHECK(json_fini(&parser, NULL) == 0);
+
+        /* Per-type callbacks get the info directly (without the flag). */
+        TEST_CHECK(json_parse_ex(inputs[i], n, &callbacks_ex, NULL, NULL, NULL) == 0);
+    }
+    TEST_CASE(NULL);
+}
+
 static void
 test_string(void)
 {
@@ -491,6 +775,23 @@ test_string(void)
     TEST_CHECK(value_type(&root) == VALUE_STRING);
     TEST_CHECK(strcmp(value_string(&root), "foo\nbar") == 0);
     value_fini(&root);
+
+    /* Long strings (longer then any SIMD block). */
+    err = parse("\"The quick brown fox jumps over the lazy dog. The quick brown fox.\"",
+                NULL, 0, &root, NULL);
+    TEST_CHECK(err == JSON_ERR_SUCCESS);
+    TEST_CHECK(strcmp(value_string(&root), "The quick brown fox jumps over the lazy dog. The quick brown fox.") == 0);
+    value_fini(&root);
+
+    err = parse("\"The quick brown fox jumps over the lazy dog.\\tThe quick brown fox \\\"jumps\\\".\"",
+                NULL, 0, &root, NULL);
+    TEST_CHECK(err == JSON_ERR_SUCCESS);
+    TEST_CHECK(strcmp(value_string(&root), "The quick brown fox jumps over the lazy dog.\tThe quick brown fox \"jumps\".") == 0);
+    value_fini(&root);
+
+    err = parse("\"The quick brown fox jumps over the lazy dog.\x01 The quick brown fox.\"",
+                NULL, 0, &root, NULL);
+    TEST_CHECK(err == JSON_ERR_UNESCAPEDCONTROL);
 }
 
 static void
@@ -605,6 +906,33 @@ test_string_utf8(void)
         { "low surrogate 1", "\"\xed\xb0\x80\"", NULL, "\xed\xb0\x80", "\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd" },    /* U+dc00 */
         { "low surrogate 2", "\"\xed\xbf\xbf\"", NULL, "\xed\xbf\xbf", "\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd" },    /* U+dfff */
 
+        /* Longer text (longer then any SIMD block). */
+        { "long kosme",
+          "\"\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98\x80\"",
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98\x80",
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98\x80",
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98\x80" },
+        { "long incomplete",
+          "\"\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98 foo\"",
+          NULL,
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98 foo",
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xef\xbf\xbd foo" },
+        { "long surrogate",
+          "\"\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xed\xa0\x80 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5\"",
+          NULL,
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xed\xa0\x80 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5",
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 "
+          "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5" },
+
         { 0 }
     };
 
@@ -725,6 +1053,109 @@ test_string_unicode_escape(void)
     }
 }
 
+/* Glues JSON_STRING_PART events with the final JSON_STRING, so the log looks
+ * as if the string has been reported whole. */
+typedef struct STRING_PARTS_LOG {
+    EVENT_LOG log;
+    int in_string;
+    unsigned n_parts;
+} STRING_PARTS_LOG;
+
+static int
+string_parts_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    STRING_PARTS_LOG* parts = (STRING_PARTS_LOG*) userdata;
+    char tmp[32];
+
+    if(type == JSON_STRING_PART  ||  (type == JSON_STRING && parts->in_string)) {
+        if(!parts->in_string) {
+            sprintf(tmp, "%d:", (int) JSON_STRING);
+            event_log_append(&parts->log, tmp, strlen(tmp));
+        }
+        event_log_append(&parts->log, data, size);
+
+        if(type == JSON_STRING) {
+            event_log_append(&parts->log, "\n", 1);
+            parts->in_string = 0;
+        } else {
+            parts->in_string = 1;
+            parts->n_parts++;
+        }
+        return 0;
+    }
+
+    return event_log_callback(type, data, size, &parts->log);
+}
+
+static void
+test_string_parts(void)
+{
+    static const char input[] =
+        "[ \"Lorem ipsum dolor sit amet, consectetur adipiscing elit.\", "
+        "{ \"long key, which is never split into parts\": "
+        "\"\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xf0\x9f\x98\x80 \\n\\t \\u0041 \\ud83d\\ude00 \\\"quoted\\\" "
+        "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 \xed\xa0\x80 \xce\\u0041 \\ud800x\" }, \"\", \"x\" ]";
+    static const size_t chunk_sizes[] = { 1, 2, 3, 5, 7, 16, sizeof(input) };
+    JSON_CALLBACKS callbacks = { string_parts_callback };
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    STRING_PARTS_LOG expected;
+    STRING_PARTS_LOG parts;
+    size_t size = strlen(input);
+    size_t off, n;
+    int err;
+    int i;
+
+    memset(&expected, 0, sizeof(STRING_PARTS_LOG));
+    memset(&parts, 0, sizeof(STRING_PARTS_LOG));
+
+    json_default_config(&config);
+    config.flags |= JSON_FIXILLUTF8VALUE;
+    err = json_parse(input, size, &callbacks, &config, &expected, &pos);
+    event_log_result(&expected.log, err, &pos);
+    TEST_CHECK(err == 0);
+
+    config.flags |= JSON_STRINGPARTS;
+    for(i = 0; i < (int) (sizeof(chunk_sizes) / sizeof(chunk_sizes[0])); i++) {
+        TEST_CASE_("chunk size %u", (unsigned) chunk_sizes[i]);
+
+        parts.log.size = 0;
+        parts.n_parts = 0;
+        json_init(&parser, &callbacks, &config, &parts);
+        for(off = 0; off < size; off += n) {
+            n = (size - off < chunk_sizes[i]) ? size - off : chunk_sizes[i];
+            if(json_feed(&parser, input + off, n) != 0)
+                break;
+        }
+        err = json_fini(&parser, &pos);
+        event_log_result(&parts.log, err, &pos);
+
+        event_log_cmp(&expected.log, &parts.log);
+        if(chunk_sizes[i] < 16)
+            TEST_CHECK(parts.n_parts > 0);
+        else if(chunk_sizes[i] == sizeof(input))
+            TEST_CHECK(parts.n_parts == 0);
+    }
+    TEST_CASE(NULL);
+
+    /* The checks for the string as a whole must apply before any part is
+     * reported. */
+    config.flags |= JSON_NOSTRINGASROOT;
+    parts.log.size = 0;
+    parts.n_parts = 0;
+    json_init(&parser, &callbacks, &config, &parts);
+    json_feed(&parser, "  \"foo", 6);
+    json_feed(&parser, "bar\"", 4);
+    err = json_fini(&parser, &pos);
+    TEST_CHECK(err == JSON_ERR_BADROOTTYPE);
+    TEST_CHECK(pos.offset == 2);
+    TEST_CHECK(parts.n_parts == 0);
+
+    free(expected.log.buf);
+    free(parts.log.buf);
+}
+
 static void
 test_array(void)
 {
@@ -1079,6 +1510,18 @@ test_err_syntax(void)
     TEST_CHECK(pos.offset == 1);
     TEST_CHECK(pos.line_number == 1);
     TEST_CHECK(pos.column_number == 2);
+
+    err = parse("[ \xb2 ]", NULL, 0, NULL, &pos);
+    TEST_CHECK(err == JSON_ERR_EXPECTEDVALUEORCLOSER);
+    TEST_CHECK(pos.offset == 2);
+    TEST_CHECK(pos.line_number == 1);
+    TEST_CHECK(pos.column_number == 3);
+
+    err = parse("[ 1 Z ]", NULL, 0, NULL, &pos);
+    TEST_CHECK(err == JSON_ERR_EXPECTEDCOMMAORCLOSER);
+    TEST_CHECK(pos.offset == 4);
+    TEST_CHECK(pos.line_number == 1);
+    TEST_CHECK(pos.column_number == 5);
 }
 
 static void
@@ -1244,129 +1687,1751 @@ test_json_checker(void)
 }
 
 
-static char dump_buffer[16 * 256];
+/* Inputs for comparing the various ways to call the SAX-like parser. */
+static const char* sax_vector[] = {
+    "",
+    "null",
+    "true",
+    "nul",
+    "123",
+    "-",
+    "1.",
+    "1e+5",
+    "\"foo\"",
+    "\"a\\nb\"",
+    "  [ 1, 2.5e3, -0, true, false, null, \"foo\" ]  ",
+    "{ \"a\": { \"b\": [ {}, [] ] }, \"c\" : \"\\\"\\\\\\\"\" }",
+    "[\r\n\t\"x\",\r\n\t\"y\\u0041\\ud83d\\ude00\"\r\n]\n",
+    "[ \"\\\\\" , \"\\\\\\\\\", \"[{\\\",:}]\" ]",
+    "\"\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5\"",
+    "[ 1 2 ]",
+    "[ 1, ]",
+    "[ 12a ]",
+    "[ truex, false ]",
+    "[true,false,null]",
+    "[ nulL, true ]",
+    "[ fals ]",
+    "[ 1+2 ]",
+    "{ \"a\" 1 }",
+    "{ \"a\": 1 ] ",
+    "[ \"abc\"def ]",
+    "[ \"abc\n\" ]",
+    "[ \\\"abc ]",
+    "[ 1, 2 ] x",
+    "[ @ ]",
+    "[ \xb2 ]",
+    "{ \"a\" \xc3\xa9 }",
+    "{ \"a\": 1 Z }",
+    "[ \"unclosed ",
+    "[ 1",
+    "[ null",
+    "{ \"a\": 1",
+    NULL
+};
+
+/* A way to drive the SAX-like parser through the whole input, recording the
+ * events into the log (as event_log_callback() does). */
+typedef int (*SAX_DRIVER)(const char* input, size_t size, const JSON_CONFIG* config,
+                          void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos);
 
 static int
-test_dump_callback(const char* data, size_t size, void* userdata)
+sax_parse(const char* input, size_t size, const JSON_CONFIG* config,
+          void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
 {
-    size_t* n = (size_t*) userdata;
-
-    if(!TEST_CHECK(*n + size <= sizeof(dump_buffer)))
-        return -1;
+    JSON_CALLBACKS callbacks = { event_log_callback };
 
-    memcpy(dump_buffer + *n, data, size);
-    *n += size;
-    return 0;
+    (void) driver_data;
+    return json_parse(input, size, &callbacks, config, log, p_pos);
 }
 
-static void
-test_dump(void)
+/* Both drivers have to see the same events and the same result. Returns the
+ * result of the 1st one. */
+static int
+sax_cmp(const char* input, size_t size, const JSON_CONFIG* config,
+        SAX_DRIVER driver1, SAX_DRIVER driver2, void* driver_data)
 {
-    static const char expected[] = {
-        "[\n"
-        "\t{\n"
-        "\t\t\"name\": \"Alice\",\n"
-        "\t\t\"age\": 23,\n"
-        "\t\t\"height\": 168.5\n"
-        "\t},\n"
-        "\t{\n"
-        "\t\t\"name\": \"Bob\",\n"
-        "\t\t\"age\": 54,\n"
-        "\t\t\"height\": 182.0\n"
-        "\t}\n"
-        "]"
-    };
+    JSON_INPUT_POS pos;
+    EVENT_LOG log1 = { 0 };
+    EVENT_LOG log2 = { 0 };
+    int err1, err2;
 
-    size_t n = 0;
-    VALUE root;
-    VALUE* alice;
-    VALUE* bob;
-    VALUE* name;
-    VALUE* age;
-    VALUE* height;
-    int err;
+    err1 = driver1(input, size, config, driver_data, &log1, &pos);
+    event_log_result(&log1, err1, &pos);
 
-    value_init_array(&root);
+    err2 = driver2(input, size, config, driver_data, &log2, &pos);
+    event_log_result(&log2, err2, &pos);
 
-    alice = value_array_append(&root);
-    value_init_dict_ex(alice, NULL, VALUE_DICT_MAINTAINORDER);
-    name = value_dict_add(alice, "name");
-    value_init_string(name, "Alice");
-    age = value_dict_add(alice, "age");
-    value_init_uint32(age, 23);
-    height = value_dict_add(alice, "height");
-    value_init_float(height, 168.5);
+    event_log_cmp(&log1, &log2);
+    free(log1.buf);
+    free(log2.buf);
+    return err1;
+}
 
-    bob = value_array_append(&root);
-    value_init_dict_ex(bob, NULL, VALUE_DICT_MAINTAINORDER);
-    name = value_dict_add(bob, "name");
-    value_init_string(name, "Bob");
-    age = value_dict_add(bob, "age");
-    value_init_uint32(age, 54);
-    height = value_dict_add(bob, "height");
-    value_init_float(height, 182.0);
+/* Compare the drivers on all of the sax_vector. */
+static void
+sax_vector_cmp(const char* variant, const JSON_CONFIG* config,
+               SAX_DRIVER driver1, SAX_DRIVER driver2, void* driver_data)
+{
+    int i;
 
-    err = json_dom_dump(&root, test_dump_callback, (void*) &n, 0, JSON_DOM_DUMP_PREFERDICTORDER);
-    if(TEST_CHECK(err == 0)) {
-        /* Parse it back and compare it with what we expect. */
-        VALUE a, b;
-        TEST_CHECK(json_dom_parse(dump_buffer, n, NULL, JSON_DOM_MAINTAINDICTORDER, &a, NULL) == 0);
-        TEST_CHECK(json_dom_parse(expected, strlen(expected), NULL, JSON_DOM_MAINTAINDICTORDER, &b, NULL) == 0);
-        deep_value_cmp(&a, &b);
-        value_fini(&a);
-        value_fini(&b);
+    for(i = 0; sax_vector[i] != NULL; i++) {
+        if(variant != NULL)
+            TEST_CASE_("%s (%s)", sax_vector[i], variant);
+        else
+            TEST_CASE(sax_vector[i]);
+        sax_cmp(sax_vector[i], strlen(sax_vector[i]), config, driver1, driver2, driver_data);
     }
-
-    value_fini(&root);
 }
 
-static void
-test_pointer(void)
+static int
+sax_feed_bytes(const char* input, size_t size, const JSON_CONFIG* config,
+               void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
 {
-    static const char input[] =
-            "{\n"
-                "\"foo\": [\"bar\", \"baz\"],\n"
-                "\"\": 0,\n"
-                "\"a/b\": 1,\n"
-                "\"c%d\": 2,\n"
-                "\"e^f\": 3,\n"
-                "\"g|h\": 4,\n"
-                "\"i\\\\j\": 5,\n"
-                "\"k\\\"l\": 6,\n"
-                "\" \": 7,\n"
-                "\"m~n\": 8\n"
-            "}\n";
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_PARSER parser;
+    size_t off;
 
-    VALUE root;
-    VALUE* v;
+    (void) driver_data;
+    json_init(&parser, &callbacks, config, log);
+    for(off = 0; off < size; off++) {
+        if(json_feed(&parser, input + off, 1) != 0)
+            break;
+    }
+    return json_fini(&parser, p_pos);
+}
 
-    TEST_CHECK(json_dom_parse(input, strlen(input), NULL, 0, &root, NULL) == 0);
+static int
+sax_feed_whole(const char* input, size_t size, const JSON_CONFIG* config,
+               void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_PARSER parser;
 
-    TEST_CHECK(json_ptr_get(&root, "") == &root);
+    (void) driver_data;
+    json_init(&parser, &callbacks, config, log);
+    json_feed(&parser, input, size);
+    return json_fini(&parser, p_pos);
+}
 
-    v = json_ptr_get(&root, "/foo");
-    TEST_CHECK(value_type(v) == VALUE_ARRAY);
-    TEST_CHECK(value_array_size(v) == 2);
-    TEST_CHECK(strcmp(value_string(value_array_get(v, 0)), "bar") == 0);
-    TEST_CHECK(strcmp(value_string(value_array_get(v, 1)), "baz") == 0);
+static void
+test_parse_whole(void)
+{
+    /* json_parse() sees the whole input. Compare it with the streaming. */
+    sax_vector_cmp(NULL, NULL, sax_feed_bytes, sax_parse, NULL);
 
-    v = json_ptr_get(&root, "/foo/0");
-    TEST_CHECK(strcmp(value_string(v), "bar") == 0);
+    /* Whole input in a single json_feed(). */
+    sax_vector_cmp("single feed", NULL, sax_feed_bytes, sax_feed_whole, NULL);
+}
 
-    v = json_ptr_get(&root, "/foo/1");
-    TEST_CHECK(strcmp(value_string(v), "baz") == 0);
+/* JSON_CALLBACKS_EX which record the same log as event_log_callback(). */
+static int
+ex_on_null(void* userdata)
+{
+    return event_log_callback(JSON_NULL, NULL, 0, userdata);
+}
 
-    v = json_ptr_get(&root, "/foo/-2");
-    TEST_CHECK(strcmp(value_string(v), "bar") == 0);
+static int
+ex_on_bool(int value, void* userdata)
+{
+    return event_log_callback(value ? JSON_TRUE : JSON_FALSE, NULL, 0, userdata);
+}
 
-    v = json_ptr_get(&root, "/foo/-1");
-    TEST_CHECK(strcmp(value_string(v), "baz") == 0);
+static int
+ex_on_number(const char* data, size_t size, void* userdata)
+{
+    return event_log_callback(JSON_NUMBER, data, size, userdata);
+}
 
-    v = json_ptr_get(&root, "/");
-    TEST_CHECK(value_int32(v) == 0);
+static int
+ex_on_string(const char* data, size_t size, void* userdata)
+{
+    return event_log_callback(JSON_STRING, data, size, userdata);
+}
 
-    v = json_ptr_get(&root, "/a~1b");
-    TEST_CHECK(value_int32(v) == 1);
+static int
+ex_on_key(const char* data, size_t size, void* userdata)
+{
+    return event_log_callback(JSON_KEY, data, size, userdata);
+}
+
+static int
+ex_on_begin_array(void* userdata)
+{
+    return event_log_callback(JSON_ARRAY_BEG, NULL, 0, userdata);
+}
+
+static int
+ex_on_end_array(void* userdata)
+{
+    return event_log_callback(JSON_ARRAY_END, NULL, 0, userdata);
+}
+
+static int
+ex_on_begin_object(void* userdata)
+{
+    return event_log_callback(JSON_OBJECT_BEG, NULL, 0, userdata);
+}
+
+static int
+ex_on_end_object(void* userdata)
+{
+    return event_log_callback(JSON_OBJECT_END, NULL, 0, userdata);
+}
+
+static int
+keys_only_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    if(type == JSON_KEY)
+        return event_log_callback(type, data, size, userdata);
+    return 0;
+}
+
+static int
+sax_parse_ex(const char* input, size_t size, const JSON_CONFIG* config,
+             void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    return json_parse_ex(input, size, (const JSON_CALLBACKS_EX*) driver_data, config, log, p_pos);
+}
+
+static void
+test_callbacks_ex(void)
+{
+    static const char big_input[] =
+        "{ \"a\": 123456789, \"b\": [ 1.5e10, -0.25, \"long string \\\" with escape\" ],\n"
+        "  \"c\": { \"d\": null, \"e\": true, \"f\": false }, \"\\u0067\": \"\xce\xba\xe1\xbd\xb9\" }";
+    JSON_CALLBACKS keys_only_callbacks = { keys_only_callback };
+    JSON_CALLBACKS_EX callbacks_ex;
+    JSON_CALLBACKS_EX keys_only_callbacks_ex;
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    EVENT_LOG log1 = { 0 };
+    EVENT_LOG log2 = { 0 };
+    size_t off, size;
+    int err;
+
+    memset(&callbacks_ex, 0, sizeof(JSON_CALLBACKS_EX));
+    callbacks_ex.on_null = ex_on_null;
+    callbacks_ex.on_bool = ex_on_bool;
+    callbacks_ex.on_number = ex_on_number;
+    callbacks_ex.on_string = ex_on_string;
+    callbacks_ex.on_key = ex_on_key;
+    callbacks_ex.on_begin_array = ex_on_begin_array;
+    callbacks_ex.on_end_array = ex_on_end_array;
+    callbacks_ex.on_begin_object = ex_on_begin_object;
+    callbacks_ex.on_end_object = ex_on_end_object;
+    memset(&keys_only_callbacks_ex, 0, sizeof(JSON_CALLBACKS_EX));
+
+    sax_vector_cmp(NULL, NULL, sax_parse, sax_parse_ex, &callbacks_ex);
+
+    /* Only keys are wanted. Values are not collected but still validated. */
+    keys_only_callbacks_ex.on_key = ex_on_key;
+    size = strlen(big_input);
+    TEST_CASE("keys only");
+
+    log1.size = 0;
+    err = json_parse(big_input, size, &keys_only_callbacks, NULL, &log1, &pos);
+    event_log_result(&log1, err, &pos);
+    TEST_CHECK(err == 0);
+
+    log2.size = 0;
+    json_init_ex(&parser, &keys_only_callbacks_ex, NULL, &log2);
+    for(off = 0; off < size; off++) {
+        if(json_feed(&parser, big_input + off, 1) != 0)
+            break;
+    }
+    err = json_fini(&parser, &pos);
+    event_log_result(&log2, err, &pos);
+    event_log_cmp(&log1, &log2);
+
+    log2.size = 0;
+    err = json_parse_ex("{ \"a\": [ 12x ] }", 15, &keys_only_callbacks_ex, NULL, &log2, &pos);
+    TEST_CHECK(err == JSON_ERR_SYNTAX);
+    TEST_CASE(NULL);
+
+    free(log1.buf);
+    free(log2.buf);
+}
+
+static int
+skip_key_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    event_log_callback(type, data, size, userdata);
+    if(type == JSON_KEY  &&  size == 4  &&  memcmp(data, "skip", 4) == 0)
+        return JSON_SKIP;
+    return 0;
+}
+
+static int
+skip_array_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    event_log_callback(type, data, size, userdata);
+    return (type == JSON_ARRAY_BEG) ? JSON_SKIP : 0;
+}
+
+static void
+test_skip(void)
+{
+    static const struct {
+        const char* input;
+        int (*callback)(JSON_TYPE, const char*, size_t, void*);
+        const char* expected;
+    } vector[] = {
+        { "{ \"a\": 1, \"skip\": { \"x\": [1, 2, \"\\u0041\"], \"y\": null }, "
+          "\"b\": [ \"keep\", { \"skip\": \"str\" }, 3 ], \"skip\": 42, \"c\": true }",
+          skip_key_callback,
+          "8:\n5:a\n3:1\n5:skip\n5:b\n6:\n4:keep\n8:\n5:skip\n9:\n3:3\n7:\n5:skip\n5:c\n2:\n9:\n"
+          "err=0 offset=118 line=1 column=119" },
+        { "{ \"a\": [1, {\"b\": 2}, \"\\u00e9\"], \"c\": [], \"d\": [[[]]], \"e\": 5 }",
+          skip_array_callback,
+          "8:\n5:a\n6:\n7:\n5:c\n6:\n7:\n5:d\n6:\n7:\n5:e\n3:5\n9:\n"
+          "err=0 offset=62 line=1 column=63" },
+        { "[ 1, 2 ]",
+          skip_array_callback,
+          "6:\n7:\nerr=0 offset=8 line=1 column=9" },
+        /* Skipped data are still validated. */
+        { "{ \"skip\": [ 1, 2x ] }",
+          skip_key_callback,
+          "8:\n5:skip\nerr=-4 offset=15 line=1 column=16" },
+        { "{ \"skip\": \"\\ud800\" }",
+          skip_key_callback,
+          "8:\n5:skip\nerr=-23 offset=17 line=1 column=18" },
+        { 0 }
+    };
+
+    JSON_CALLBACKS callbacks;
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    EVENT_LOG log1 = { 0 };
+    EVENT_LOG log2 = { 0 };
+    size_t off, size;
+    int err;
+    int i;
+
+    for(i = 0; vector[i].input != NULL; i++) {
+        TEST_CASE(vector[i].input);
+        callbacks.process = vector[i].callback;
+        size = strlen(vector[i].input);
+
+        log1.size = 0;
+        err = json_parse(vector[i].input, size, &callbacks, NULL, &log1, &pos);
+        event_log_result(&log1, err, &pos);
+        if(!TEST_CHECK(log1.size == strlen(vector[i].expected)  &&
+                       memcmp(log1.buf, vector[i].expected, log1.size) == 0))
+        {
+            TEST_MSG("Expected: %s", vector[i].expected);
+            TEST_MSG("Produced: %.*s", (int) log1.size, log1.buf);
+        }
+
+        log2.size = 0;
+        json_init(&parser, &callbacks, NULL, &log2);
+        for(off = 0; off < size; off++) {
+            if(json_feed(&parser, vector[i].input + off, 1) != 0)
+                break;
+        }
+        err = json_fini(&parser, &pos);
+        event_log_result(&log2, err, &pos);
+        event_log_cmp(&log1, &log2);
+    }
+
+    free(log1.buf);
+    free(log2.buf);
+}
+
+static int
+projection_parse(const char* input, const char* const* pointers, size_t n_pointers,
+                 size_t chunk_size, unsigned flags, STRING_PARTS_LOG* parts)
+{
+    JSON_CALLBACKS callbacks = { string_parts_callback };
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    size_t size = strlen(input);
+    size_t off, n;
+    int err;
+
+    json_default_config(&config);
+    config.flags |= flags;
+
+    parts->log.size = 0;
+    parts->n_parts = 0;
+    json_init(&parser, &callbacks, &config, parts);
+    err = json_set_projection(&parser, pointers, n_pointers);
+    if(err != 0) {
+        json_fini(&parser, NULL);
+        return err;
+    }
+
+    for(off = 0; off < size; off += n) {
+        n = (size - off < chunk_size) ? size - off : chunk_size;
+        if(json_feed(&parser, input + off, n) != 0)
+            break;
+    }
+    err = json_fini(&parser, &pos);
+    event_log_result(&parts->log, err, &pos);
+    return err;
+}
+
+static void
+test_projection(void)
+{
+    static const char input[] =
+        "{ \"a\": { \"p\": [1, 2] }, \"z\": \"not wanted\", \"b\": { \"c\": \"yes\", \"d\": \"no\" }, "
+        "\"d\": [ \"zero\", { \"q\": 1 }, \"two\" ], \"e\": { \"x\": { \"/y\": true, \"w\": 0 } }, "
+        "\"f\": [ 1 ], \"g\": 5, \"h\": [ [ \"long string in array\", 1 ], [ 2, \"long string in array\" ] ] }";
+    static const char* const pointers[] = {
+        "/a", "/b/c", "/d/1", "/e/x/~1y", "/f/-0", "/g/x", "/h/1/1", "/nonexistent"
+    };
+    static const char expected[] =
+        "8:\n5:a\n8:\n5:p\n6:\n3:1\n3:2\n7:\n9:\n"
+        "5:b\n8:\n5:c\n4:yes\n9:\n"
+        "5:d\n6:\n8:\n5:q\n3:1\n9:\n7:\n"
+        "5:e\n8:\n5:x\n8:\n5:/y\n2:\n9:\n9:\n"
+        "5:f\n6:\n7:\n"
+        "5:h\n6:\n6:\n4:long string in array\n7:\n7:\n"
+        "9:\n";
+    static const size_t chunk_sizes[] = { 1, 3, 16, sizeof(input) };
+    static const char* const root_pointer[] = { "" };
+    static const char* const bad_pointer[] = { "/a/~2" };
+    STRING_PARTS_LOG parts;
+    char buffer[512];
+    int err;
+    int i;
+
+    memset(&parts, 0, sizeof(STRING_PARTS_LOG));
+
+    for(i = 0; i < (int) (sizeof(chunk_sizes) / sizeof(chunk_sizes[0])); i++) {
+        TEST_CASE_("chunk size %u", (unsigned) chunk_sizes[i]);
+        err = projection_parse(input, pointers, sizeof(pointers) / sizeof(pointers[0]),
+                chunk_sizes[i], 0, &parts);
+        TEST_CHECK(err == 0);
+        sprintf(buffer, "%serr=0 offset=%u line=1 column=%u", expected,
+                (unsigned) strlen(input), (unsigned) strlen(input) + 1);
+        if(!TEST_CHECK(parts.log.size == strlen(buffer)  &&
+                       memcmp(parts.log.buf, buffer, parts.log.size) == 0))
+        {
+            TEST_MSG("Expected: %s", buffer);
+            TEST_MSG("Produced: %.*s", (int) parts.log.size, parts.log.buf);
+        }
+
+        /* With string parts, only the wanted strings are reported. */
+        err = projection_parse(input, pointers, sizeof(pointers) / sizeof(pointers[0]),
+                chunk_sizes[i], JSON_STRINGPARTS, &parts);
+        TEST_CHECK(err == 0);
+        TEST_CHECK(parts.log.size == strlen(buffer)  &&
+                   memcmp(parts.log.buf, buffer, parts.log.size) == 0);
+    }
+    TEST_CASE(NULL);
+
+    /* Empty pointer refers to the whole document. */
+    err = projection_parse(input, root_pointer, 1, 7, 0, &parts);
+    TEST_CHECK(err == 0);
+    TEST_CHECK(parts.n_parts == 0);
+    TEST_CHECK(parts.log.size > strlen(expected));
+
+    /* No pointer: Nothing is reported but the input is still validated. */
+    err = projection_parse(input, NULL, 0, 7, 0, &parts);
+    TEST_CHECK(err == 0);
+    err = projection_parse("{ \"a\": 1, \"b\": [ 1, 2x ] }", pointers, 1, 7, 0, &parts);
+    TEST_CHECK(err == JSON_ERR_SYNTAX);
+
+    err = projection_parse(input, bad_pointer, 1, 7, 0, &parts);
+    TEST_CHECK(err == JSON_ERR_BADPOINTER);
+
+    free(parts.log.buf);
+}
+
+static int
+sax_parse_indexed(const char* input, size_t size, const JSON_CONFIG* config,
+                  void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    JSON_CALLBACKS callbacks = { event_log_callback };
+
+    (void) driver_data;
+    return json_parse_indexed(input, size, &callbacks, config, log, p_pos);
+}
+
+static void
+test_parse_indexed(void)
+{
+    char* big;
+    size_t big_size;
+    int i;
+
+    sax_vector_cmp(NULL, NULL, sax_parse, sax_parse_indexed, NULL);
+
+    /* Something big enough to need more index windows. */
+    TEST_CASE("big document");
+    big = (char*) malloc(4000 * 64);
+    big_size = 0;
+    for(i = 0; i < 4000; i++) {
+        const char* item = (i % 3 == 0) ? ",\n    { \"id\": 1234, \"tag\": \"\\\"\\\\\" }"
+                                        : ",\r\n    { \"id\": 5678, \"name\": \"a b c\" }";
+        memcpy(big + big_size, item, strlen(item));
+        big_size += strlen(item);
+    }
+    big[0] = '[';   /* Replace the leading comma. */
+    memcpy(big + big_size, "\n]\n", 3);
+    big_size += 3;
+
+    TEST_CHECK(sax_cmp(big, big_size, NULL, sax_parse, sax_parse_indexed, NULL) == 0);
+
+    free(big);
+}
+
+typedef struct RESET_DRIVER_DATA {
+    JSON_PARSER parser;     /* Reused for all the inputs. */
+    int byte_by_byte;
+} RESET_DRIVER_DATA;
+
+static int
+sax_feed_reset(const char* input, size_t size, const JSON_CONFIG* config,
+               void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    RESET_DRIVER_DATA* data = (RESET_DRIVER_DATA*) driver_data;
+    size_t off;
+
+    (void) config;
+    data->parser.user_data = log;
+    if(!data->byte_by_byte) {
+        json_feed(&data->parser, input, size);
+    } else {
+        for(off = 0; off < size; off++) {
+            if(json_feed(&data->parser, input + off, 1) != 0)
+                break;
+        }
+    }
+    return json_reset(&data->parser, p_pos);
+}
+
+static void
+test_reset(void)
+{
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    JSON_DOM_PARSER dom_parser;
+    RESET_DRIVER_DATA reset_data;
+    EVENT_LOG log = { 0 };
+    VALUE root1, root2;
+    char big[2000];
+    size_t size;
+    int err1, err2;
+    int i;
+
+    /* One parser for all the inputs, including the failing ones, has to
+     * behave the same as a new parser for each of them. */
+    json_init(&reset_data.parser, &callbacks, NULL, NULL);
+    for(reset_data.byte_by_byte = 0; reset_data.byte_by_byte < 2; reset_data.byte_by_byte++) {
+        sax_vector_cmp(reset_data.byte_by_byte ? "byte by byte" : NULL, NULL,
+                       sax_parse, sax_feed_reset, &reset_data);
+    }
+    json_fini(&reset_data.parser, NULL);
+
+    TEST_CASE("dom");
+    json_dom_init(&dom_parser, NULL, 0);
+    for(i = 0; sax_vector[i] != NULL; i++) {
+        size = strlen(sax_vector[i]);
+        err1 = json_dom_parse(sax_vector[i], size, NULL, 0, &root1, NULL);
+        json_dom_feed(&dom_parser, sax_vector[i], size);
+        err2 = json_dom_reset(&dom_parser, &root2, NULL);
+        TEST_CHECK(err1 == err2);
+        deep_value_cmp(&root1, &root2);
+        value_fini(&root1);
+        value_fini(&root2);
+    }
+    json_dom_fini(&dom_parser, &root2, NULL);
+
+    /* Small buffers are retained, big ones are not. */
+    TEST_CASE("max_retained_size");
+    json_default_config(&config);
+    config.max_retained_size = 1024;
+    json_init(&parser, &callbacks, &config, &log);
+    json_feed(&parser, "[[\"abc", 6);
+    json_feed(&parser, "def\"]]", 6);
+    TEST_CHECK(json_reset(&parser, NULL) == 0);
+    TEST_CHECK(parser.buf != NULL);
+    TEST_CHECK(parser.nesting_stack != NULL);
+
+    big[0] = '\"';
+    memset(big + 1, 'x', sizeof(big) - 2);
+    big[sizeof(big) - 1] = '\"';
+    json_feed(&parser, big, sizeof(big) - 1);
+    json_feed(&parser, big + sizeof(big) - 1, 1);
+    TEST_CHECK(json_reset(&parser, NULL) == 0);
+    TEST_CHECK(parser.buf == NULL);
+    json_fini(&parser, NULL);
+
+    free(log.buf);
+}
+
+typedef struct COUNTING_ALLOCATOR {
+    size_t n_alloced;   /* Count of all allocations. */
+    size_t n_live;      /* Count of blocks not yet freed. */
+} COUNTING_ALLOCATOR;
+
+static void*
+counting_alloc(size_t size, void* ctx)
+{
+    COUNTING_ALLOCATOR* counter = (COUNTING_ALLOCATOR*) ctx;
+    void* ptr = malloc(size);
+
+    if(ptr != NULL) {
+        counter->n_alloced++;
+        counter->n_live++;
+    }
+    return ptr;
+}
+
+static void*
+counting_realloc(void* ptr, size_t size, void* ctx)
+{
+    COUNTING_ALLOCATOR* counter = (COUNTING_ALLOCATOR*) ctx;
+    void* new_ptr = realloc(ptr, size);
+
+    if(new_ptr != NULL  &&  ptr == NULL) {
+        counter->n_alloced++;
+        counter->n_live++;
+    }
+    return new_ptr;
+}
+
+static void
+counting_free(void* ptr, void* ctx)
+{
+    COUNTING_ALLOCATOR* counter = (COUNTING_ALLOCATOR*) ctx;
+
+    if(ptr != NULL)
+        counter->n_live--;
+    free(ptr);
+}
+
+static void
+test_allocator(void)
+{
+    static const char* pointers[] = { "/some long key of an object/1" };
+    COUNTING_ALLOCATOR counter = { 0, 0 };
+    VALUE_ALLOCATOR allocator = { counting_alloc, counting_realloc, counting_free, &counter };
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    JSON_DOM_PARSER dom_parser;
+    EVENT_LOG log = { 0 };
+    VALUE root1, root2;
+    VALUE* v;
+    char input[512];
+    size_t size = 0;
+    int i, err;
+
+    /* Nested deeper than the initial nesting stack, with long strings. */
+    for(i = 0; i < 40; i++)
+        input[size++] = '[';
+    size += sprintf(input + size, "{ \"some long key of an object\": "
+                    "[ \"some long string value\", { \"x\": 1 } ] }");
+    for(i = 0; i < 40; i++)
+        input[size++] = ']';
+
+    TEST_CASE("parser");
+    json_default_config(&config);
+    config.allocator = &allocator;
+    err = json_init(&parser, &callbacks, &config, &log);
+    TEST_CHECK(err == 0);
+    err = json_set_projection(&parser, pointers, 1);
+    TEST_CHECK(err == 0);
+    for(i = 0; i < (int) size; i++)
+        json_feed(&parser, input + i, 1);
+    err = json_fini(&parser, NULL);
+    TEST_CHECK(err == 0);
+    TEST_CHECK(counter.n_alloced > 0);
+    TEST_CHECK(counter.n_live == 0);
+    free(log.buf);
+
+    TEST_CASE("dom");
+    counter.n_alloced = 0;
+    json_dom_parse(input, size, NULL, 0, &root1, NULL);
+    json_dom_init(&dom_parser, &config, JSON_DOM_MAINTAINDICTORDER);
+    json_dom_feed(&dom_parser, input, size);
+    err = json_dom_fini(&dom_parser, &root2, NULL);
+    TEST_CHECK(err == 0);
+    deep_value_cmp(&root1, &root2);
+    TEST_CHECK(value_allocator(&root1) == NULL);
+    TEST_CHECK(value_allocator(&root2) == &allocator);
+    v = value_path(&root2, "[0]/[0]/[0]");
+    TEST_CHECK(value_allocator(v) == &allocator);
+    TEST_CHECK(counter.n_alloced > 0);
+    TEST_CHECK(counter.n_live > 0);
+    value_fini(&root1);
+    value_fini(&root2);
+    TEST_CHECK(counter.n_live == 0);
+
+    TEST_CASE("dom error");
+    json_dom_init(&dom_parser, &config, 0);
+    json_dom_feed(&dom_parser, input, size - 1);
+    err = json_dom_fini(&dom_parser, &root2, NULL);
+    TEST_CHECK(err != 0);
+    TEST_CHECK(counter.n_live == 0);
+
+    TEST_CASE("value_build_path()");
+    counter.n_alloced = 0;
+    value_init_dict_alloc(&root1, NULL, 0, &allocator);
+    v = value_build_path(&root1, "some long key of an object/[]/x");
+    TEST_CHECK(v != NULL);
+    value_init_string_alloc(v, "some long string value", 22, &allocator);
+    TEST_CHECK(value_allocator(value_path(&root1, "some long key of an object")) == &allocator);
+    TEST_CHECK(value_allocator(value_path(&root1, "some long key of an object/[0]")) == &allocator);
+    TEST_CHECK(value_allocator(v) == &allocator);
+    value_fini(&root1);
+    TEST_CHECK(counter.n_alloced > 0);
+    TEST_CHECK(counter.n_live == 0);
+}
+
+static int
+pause_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    event_log_callback(type, data, size, userdata);
+    return JSON_PAUSE;
+}
+
+typedef struct PAUSE_DRIVER_DATA {
+    size_t block_size;
+    const char* const* pointers;    /* Projection (if any). */
+    size_t n_pointers;
+} PAUSE_DRIVER_DATA;
+
+static void
+pause_driver_init(JSON_PARSER* parser, const JSON_CALLBACKS* callbacks,
+                  const JSON_CONFIG* config, const PAUSE_DRIVER_DATA* data, EVENT_LOG* log)
+{
+    json_init(parser, callbacks, config, log);
+    if(data->n_pointers > 0)
+        json_set_projection(parser, data->pointers, data->n_pointers);
+}
+
+static int
+sax_feed_blocks(const char* input, size_t size, const JSON_CONFIG* config,
+                void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    PAUSE_DRIVER_DATA* data = (PAUSE_DRIVER_DATA*) driver_data;
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_PARSER parser;
+    size_t beg, end;
+
+    pause_driver_init(&parser, &callbacks, config, data, log);
+    for(beg = 0; beg < size; beg = end) {
+        end = (size - beg > data->block_size) ? beg + data->block_size : size;
+        if(json_feed(&parser, input + beg, end - beg) != 0)
+            break;
+    }
+    return json_fini(&parser, p_pos);
+}
+
+/* As sax_feed_blocks() but pause after every single event and resume with
+ * the rest of the block. */
+static int
+sax_feed_blocks_paused(const char* input, size_t size, const JSON_CONFIG* config,
+                       void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    PAUSE_DRIVER_DATA* data = (PAUSE_DRIVER_DATA*) driver_data;
+    JSON_CALLBACKS callbacks = { pause_callback };
+    JSON_PARSER parser;
+    size_t beg, end, off, n;
+    int err = 0;
+
+    pause_driver_init(&parser, &callbacks, config, data, log);
+    for(beg = 0; beg < size  &&  err == 0; beg = end) {
+        end = (size - beg > data->block_size) ? beg + data->block_size : size;
+        off = beg;
+        do {
+            err = json_feed_ex(&parser, input + off, end - off, &n);
+            off += n;
+        } while(err == JSON_PAUSE);
+        if(err == 0)
+            TEST_CHECK(off == end);
+    }
+    return json_fini(&parser, p_pos);
+}
+
+static void
+test_pause(void)
+{
+    static const char* const pointers[] = { "/a", "/2" };
+    static const size_t block_sizes[] = { 1, 3, (size_t) -1 };
+    PAUSE_DRIVER_DATA data;
+    JSON_CONFIG config;
+    char variant_name[64];
+    int i, variant;
+
+    /* Pausing after every single event and resuming with the rest of the
+     * block has to make no difference. */
+    for(variant = 0; variant < 3; variant++) {
+        json_default_config(&config);
+        data.pointers = NULL;
+        data.n_pointers = 0;
+        if(variant == 1)
+            config.flags |= JSON_MULTIDOC;
+        if(variant == 2) {
+            config.flags |= JSON_STRINGPARTS;
+            data.pointers = pointers;
+            data.n_pointers = 2;
+        }
+
+        for(i = 0; i < (int) (sizeof(block_sizes) / sizeof(block_sizes[0])); i++) {
+            data.block_size = block_sizes[i];
+            sprintf(variant_name, "variant %d, block size %d", variant, (int) block_sizes[i]);
+            sax_vector_cmp(variant_name, &config, sax_feed_blocks, sax_feed_blocks_paused, &data);
+        }
+    }
+}
+
+static void
+cursor_log_event(EVENT_LOG* log, JSON_TYPE type, const char* data, size_t size)
+{
+    event_log_callback(type, data, size, (void*) log);
+}
+
+static int
+sax_cursor(const char* input, size_t size, const JSON_CONFIG* config,
+           void* driver_data, EVENT_LOG* log, JSON_INPUT_POS* p_pos)
+{
+    JSON_CURSOR cursor;
+    JSON_TYPE type;
+    const char* data;
+    size_t data_size;
+    int err;
+
+    (void) driver_data;
+    json_cursor_init(&cursor, input, size, config);
+    while((err = json_cursor_next(&cursor, &type, &data, &data_size)) == 0)
+        cursor_log_event(log, type, data, data_size);
+    TEST_CHECK(err == JSON_CURSOR_END  ||  err < 0);
+    TEST_CHECK(json_cursor_next(&cursor, NULL, NULL, NULL) == err);
+    return json_cursor_fini(&cursor, p_pos);
+}
+
+static void
+test_cursor(void)
+{
+    JSON_CONFIG config;
+    JSON_CURSOR cursor;
+    JSON_INPUT_POS pos;
+    JSON_TYPE type;
+    const char* data;
+    const char* input;
+    EVENT_LOG log1 = { 0 };
+    EVENT_LOG log2 = { 0 };
+    size_t size;
+    int err, i, variant;
+
+    /* The cursor has to see the same events and errors as the callbacks. */
+    for(variant = 0; variant < 3; variant++) {
+        static const char* const variant_names[] = { NULL, "multidoc", "lazy pos" };
+
+        json_default_config(&config);
+        if(variant == 1)
+            config.flags |= JSON_MULTIDOC;
+        if(variant == 2)
+            config.flags |= JSON_LAZYPOS;
+        sax_vector_cmp(variant_names[variant], &config, sax_parse, sax_cursor, NULL);
+    }
+
+    TEST_CASE("skip");
+    input = "{ \"a\": 1, \"skip\": { \"x\": [1, 2, \"\\u0041\"], \"y\": null }, "
+            "\"b\": [ \"keep\", { \"skip\": \"str\" }, 3 ], \"c\": [[1], [2]], \"d\": true }";
+    log2.size = 0;
+    json_cursor_init(&cursor, input, strlen(input), NULL);
+    i = 0;  /* Set after the key "c". */
+    while((err = json_cursor_next(&cursor, &type, &data, &size)) == 0) {
+        cursor_log_event(&log2, type, data, size);
+        if((type == JSON_KEY  &&  size == 4  &&  memcmp(data, "skip", 4) == 0)  ||
+           (type == JSON_ARRAY_BEG  &&  i))
+            json_cursor_skip(&cursor);
+        i = (type == JSON_KEY  &&  size == 1  &&  data[0] == 'c');
+    }
+    err = json_cursor_fini(&cursor, &pos);
+    event_log_result(&log2, err, &pos);
+    log1.size = 0;
+    input = "8:\n5:a\n3:1\n5:skip\n5:b\n6:\n4:keep\n8:\n5:skip\n9:\n3:3\n7:\n"
+            "5:c\n6:\n5:d\n2:\n9:\nerr=0 offset=123 line=1 column=124";
+    event_log_append(&log1, input, strlen(input));
+    event_log_cmp(&log1, &log2);
+
+    /* Skipped data are still validated. */
+    TEST_CASE("skip error");
+    input = "{ \"skip\": [ 1, 2x ] }";
+    json_cursor_init(&cursor, input, strlen(input), NULL);
+    TEST_CHECK(json_cursor_next(&cursor, &type, NULL, NULL) == 0  &&  type == JSON_OBJECT_BEG);
+    TEST_CHECK(json_cursor_next(&cursor, &type, NULL, NULL) == 0  &&  type == JSON_KEY);
+    json_cursor_skip(&cursor);
+    TEST_CHECK(json_cursor_next(&cursor, NULL, NULL, NULL) == JSON_ERR_SYNTAX);
+    TEST_CHECK(json_cursor_fini(&cursor, &pos) == JSON_ERR_SYNTAX);
+    TEST_CHECK(pos.offset == 15);
+
+    /* The final event comes before the error raised in the same step. */
+    TEST_CASE("event and error at end");
+    input = " [n";
+    json_cursor_init(&cursor, input, strlen(input), NULL);
+    TEST_CHECK(json_cursor_next(&cursor, &type, NULL, NULL) == 0  &&  type == JSON_ARRAY_BEG);
+    TEST_CHECK(json_cursor_next(&cursor, &type, NULL, NULL) == 0  &&  type == JSON_NULL);
+    TEST_CHECK(json_cursor_next(&cursor, NULL, NULL, NULL) == JSON_ERR_EXPECTEDCOMMAORCLOSER);
+    TEST_CHECK(json_cursor_next(&cursor, NULL, NULL, NULL) == JSON_ERR_EXPECTEDCOMMAORCLOSER);
+    TEST_CHECK(json_cursor_fini(&cursor, &pos) == JSON_ERR_EXPECTEDCOMMAORCLOSER);
+    TEST_CHECK(pos.offset == 3);
+
+    /* Stopping early still validates the rest. */
+    TEST_CASE("early stop");
+    input = "[ 1, 2 ] x";
+    json_cursor_init(&cursor, input, strlen(input), NULL);
+    TEST_CHECK(json_cursor_next(&cursor, NULL, NULL, NULL) == 0);
+    TEST_CHECK(json_cursor_fini(&cursor, &pos) == JSON_ERR_EXPECTEDEOF);
+    TEST_CHECK(pos.offset == 9);
+
+    TEST_CASE("number info");
+    input = "[ 42, -2.5 ]";
+    json_default_config(&config);
+    config.flags |= JSON_NUMBERINFO;
+    json_cursor_init(&cursor, input, strlen(input), &config);
+    json_cursor_next(&cursor, NULL, NULL, NULL);
+    TEST_CHECK(json_cursor_next(&cursor, &type, NULL, NULL) == 0  &&  type == JSON_NUMBER);
+    TEST_CHECK(json_cursor_number_info(&cursor)->num_class == JSON_NUMBER_INT32);
+    TEST_CHECK(json_cursor_number_info(&cursor)->value.i32 == 42);
+    TEST_CHECK(json_cursor_next(&cursor, &type, NULL, NULL) == 0  &&  type == JSON_NUMBER);
+    TEST_CHECK(json_cursor_number_info(&cursor)->num_class == JSON_NUMBER_DOUBLE);
+    TEST_CHECK(json_cursor_number_info(&cursor)->value.d == -2.5);
+    TEST_CHECK(json_cursor_fini(&cursor, NULL) == 0);
+
+    free(log1.buf);
+    free(log2.buf);
+}
+
+static void
+test_validate(void)
+{
+    static const char* extra_vector[] = {
+        "\"a\\u00e9\\ud83d\\ude00\\n\\\"\"",
+        "[ \"\\ud800\", \"\\udc00x\", \"\\ud800\\u0041\" ]",
+        "[ \"\xc3\x28\", \"\xe2\x82\" ]",
+        "{ \"k\\u0041\": \"\xe2\x82\xac\", \"\xff\": 1 }",
+        "[ \"long string with \\\" escapes\" ] ",
+        "[ 123456789012345678901234567890, 1.5e300, -0.0 ]",
+        NULL
+    };
+    const char** vectors[2] = { sax_vector, extra_vector };
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    COUNTING_ALLOCATOR counter = { 0, 0 };
+    JSON_ALLOCATOR allocator = { counting_alloc, counting_realloc, counting_free, &counter };
+    JSON_CONFIG config;
+    JSON_INPUT_POS pos1, pos2;
+    EVENT_LOG log = { 0 };
+    const char* input;
+    int err1, err2;
+    int i, j, variant;
+
+    /* The same errors and positions as with json_parse(). */
+    for(variant = 0; variant < 4; variant++) {
+        json_default_config(&config);
+        switch(variant) {
+            case 1:  config.flags |= JSON_FIXILLUTF8VALUE | JSON_IGNOREILLUTF8KEY; break;
+            case 2:  config.max_string_len = 4; config.max_number_len = 8; break;
+            case 3:  config.max_total_values = 3; config.flags |= JSON_NOSCALARROOT; break;
+            default: break;
+        }
+
+        for(i = 0; i < 2; i++) {
+            for(j = 0; vectors[i][j] != NULL; j++) {
+                input = vectors[i][j];
+                TEST_CASE_("%s (variant %d)", input, variant);
+                log.size = 0;
+                err1 = json_parse(input, strlen(input), &callbacks, &config, &log, &pos1);
+                err2 = json_validate(input, strlen(input), &config, &pos2);
+                TEST_CHECK(err1 == err2);
+                TEST_MSG("json_parse(): %d, json_validate(): %d", err1, err2);
+                TEST_CHECK(memcmp(&pos1, &pos2, sizeof(JSON_INPUT_POS)) == 0);
+            }
+        }
+    }
+
+    /* Nothing but the nesting stack is allocated. */
+    TEST_CASE("allocations");
+    json_default_config(&config);
+    config.allocator = &allocator;
+    config.flags |= JSON_FIXILLUTF8VALUE;
+    for(i = 0; extra_vector[i] != NULL; i++) {
+        counter.n_alloced = 0;
+        json_validate(extra_vector[i], strlen(extra_vector[i]), &config, NULL);
+        TEST_CHECK(counter.n_alloced == (extra_vector[i][0] == '\"' ? 0 : 1));
+        TEST_CHECK(counter.n_live == 0);
+    }
+
+    free(log.buf);
+}
+
+typedef struct RAW_STRINGS_LOG {
+    EVENT_LOG log;
+    JSON_PARSER* parser;
+    unsigned flags;
+    unsigned n_escaped;
+} RAW_STRINGS_LOG;
+
+static int
+raw_strings_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    RAW_STRINGS_LOG* raw = (RAW_STRINGS_LOG*) userdata;
+    char* buffer;
+    size_t n;
+
+    if(type != JSON_STRING  &&  type != JSON_KEY)
+        return event_log_callback(type, data, size, &raw->log);
+
+    /* Log the decoded string so we can compare with the normal mode. */
+    buffer = (char*) malloc(3 * size + 1);
+    n = json_decode_string(type, data, size, raw->flags, buffer);
+    if(json_string_has_escapes(raw->parser)) {
+        raw->n_escaped++;
+    } else if(!(raw->flags & (JSON_FIXILLUTF8KEY | JSON_FIXILLUTF8VALUE))) {
+        TEST_CHECK(n == size  &&  memcmp(buffer, data, size) == 0);
+    }
+    event_log_callback(type, buffer, n, &raw->log);
+    free(buffer);
+    return 0;
+}
+
+static void
+test_raw_strings(void)
+{
+    static const char* vector[] = {
+        "[ \"plain\", \"a\\u00e9\\ud83d\\ude00\\n\\\"\\\\\\/\\b\\f\\r\\t\", \"\" ]",
+        "{ \"k\\u0041\": \"\xe2\x82\xac\", \"\xff\": [ \"\\ud800\", \"\\udc00x\", "
+                "\"\\ud800\\u0041\", \"\\ud800\\ud800\\udc00\" ] }",
+        "[ \"\xc3\x28\", \"\xe2\x82\", \"\xf0\x9f\x98\", \"\xed\xa0\x80\", \"x\x80y\" ]",
+        "\"root \\\"string\\\" with a long tail of plain chars\"",
+        NULL
+    };
+    static const unsigned flags[] = {
+        0,
+        JSON_FIXILLUTF8VALUE | JSON_IGNOREILLUTF8KEY,
+        JSON_IGNOREILLUTF8VALUE | JSON_FIXILLUTF8KEY
+    };
+    static const size_t chunk_sizes[] = { 1, 3, 7, 0 };
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_CALLBACKS raw_callbacks = { raw_strings_callback };
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    EVENT_LOG expected = { 0 };
+    RAW_STRINGS_LOG raw;
+    const char* input;
+    size_t size, off, n, chunk_size;
+    int err;
+    int i, j, k;
+
+    memset(&raw, 0, sizeof(RAW_STRINGS_LOG));
+
+    /* Decoding the raw strings gives the same as the normal mode. */
+    for(i = 0; vector[i] != NULL; i++) {
+        input = vector[i];
+        size = strlen(input);
+
+        for(j = 0; j < (int) (sizeof(flags) / sizeof(flags[0])); j++) {
+            json_default_config(&config);
+            config.flags |= flags[j];
+            expected.size = 0;
+            err = json_parse(input, size, &callbacks, &config, &expected, &pos);
+            event_log_result(&expected, err, &pos);
+
+            config.flags |= JSON_RAWSTRINGS;
+            for(k = 0; k < (int) (sizeof(chunk_sizes) / sizeof(chunk_sizes[0])); k++) {
+                chunk_size = (chunk_sizes[k] != 0) ? chunk_sizes[k] : size;
+                TEST_CASE_("%s (flags 0x%x, chunk size %u)", input, flags[j], (unsigned) chunk_size);
+
+                raw.log.size = 0;
+                raw.parser = &parser;
+                raw.flags = config.flags;
+                json_init(&parser, &raw_callbacks, &config, &raw);
+                if(chunk_sizes[k] == 0) {
+                    /* Whole input at once takes the fast path. */
+                    json_feed_last(&parser, input, size);
+                } else {
+                    for(off = 0; off < size; off += n) {
+                        n = (size - off < chunk_size) ? size - off : chunk_size;
+                        if(json_feed(&parser, input + off, n) != 0)
+                            break;
+                    }
+                }
+                err = json_fini(&parser, &pos);
+                event_log_result(&raw.log, err, &pos);
+                event_log_cmp(&expected, &raw.log);
+            }
+        }
+    }
+    TEST_CASE(NULL);
+
+    /* The strings are reported as they are in the input. */
+    TEST_CASE("raw data");
+    input = "{ \"a\\nb\": \"x\\u0041\", \"c\": \"d\" }";
+    json_default_config(&config);
+    config.flags |= JSON_RAWSTRINGS;
+    raw.parser = &parser;
+    raw.flags = config.flags;
+    raw.n_escaped = 0;
+    expected.size = 0;
+    json_init(&parser, &callbacks, &config, &expected);
+    json_feed_last(&parser, input, strlen(input));
+    err = json_fini(&parser, &pos);
+    TEST_CHECK(err == 0);
+    event_log_append(&expected, "", 1);
+    TEST_CHECK(strcmp(expected.buf, "8:\n5:a\\nb\n4:x\\u0041\n5:c\n4:d\n9:\n") == 0);
+    TEST_MSG("Produced: %s", expected.buf);
+
+    raw.log.size = 0;
+    json_init(&parser, &raw_callbacks, &config, &raw);
+    json_feed(&parser, input, strlen(input));
+    json_fini(&parser, &pos);
+    TEST_CHECK(raw.n_escaped == 2);
+
+    free(expected.buf);
+    free(raw.log.buf);
+}
+
+static void
+test_multidoc(void)
+{
+    static const struct {
+        const char* input;
+        const char* expected;
+    } vector[] = {
+        { "1 [2]\n{\"a\":3}\n",
+          "3:1\n11:\n6:\n3:2\n7:\n11:\n8:\n5:a\n3:3\n9:\n11:\n"
+          "err=0 offset=14 line=3 column=1" },
+        { "[1][2]\"x\"null",
+          "6:\n3:1\n7:\n11:\n6:\n3:2\n7:\n11:\n4:x\n11:\n0:\n11:\n"
+          "err=0 offset=13 line=1 column=14" },
+        { "",
+          "err=0 offset=0 line=1 column=1" },
+        { " \r\n\t\n",
+          "err=0 offset=5 line=3 column=1" },
+        { "1 ]",
+          "3:1\n11:\nerr=-7 offset=2 line=1 column=3" },
+        { "{} [1,",
+          "8:\n9:\n11:\n6:\n3:1\nerr=-7 offset=6 line=1 column=7" },
+        { 0 }
+    };
+
+    JSON_CONFIG config;
+    JSON_CALLBACKS callbacks = { event_log_callback };
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    EVENT_LOG log1 = { 0 };
+    EVENT_LOG log2 = { 0 };
+    size_t off, size;
+    int err;
+    int i;
+
+    json_default_config(&config);
+    config.flags |= JSON_MULTIDOC;
+
+    for(i = 0; vector[i].input != NULL; i++) {
+        TEST_CASE(vector[i].input);
+        size = strlen(vector[i].input);
+
+        log1.size = 0;
+        err = json_parse(vector[i].input, size, &callbacks, &config, &log1, &pos);
+        event_log_result(&log1, err, &pos);
+        if(!TEST_CHECK(log1.size == strlen(vector[i].expected)  &&
+                       memcmp(log1.buf, vector[i].expected, log1.size) == 0))
+        {
+            TEST_MSG("Expected: %s", vector[i].expected);
+            TEST_MSG("Produced: %.*s", (int) log1.size, log1.buf);
+        }
+
+        log2.size = 0;
+        json_init(&parser, &callbacks, &config, &log2);
+        for(off = 0; off < size; off++) {
+            if(json_feed(&parser, vector[i].input + off, 1) != 0)
+                break;
+        }
+        err = json_fini(&parser, &pos);
+        event_log_result(&log2, err, &pos);
+        event_log_cmp(&log1, &log2);
+
+        log2.size = 0;
+        err = json_parse_indexed(vector[i].input, size, &callbacks, &config, &log2, &pos);
+        event_log_result(&log2, err, &pos);
+        event_log_cmp(&log1, &log2);
+    }
+
+    /* The limits apply to each document on its own. */
+    TEST_CASE("limits");
+    config.max_total_values = 2;
+    config.flags |= JSON_NONUMBERASROOT;
+    TEST_CHECK(json_parse("[1] [2] [3]", 11, &callbacks, &config, &log1, NULL) == 0);
+    TEST_CHECK(json_parse("[1] [2, 3]", 10, &callbacks, &config, &log1, NULL) == JSON_ERR_MAXTOTALVALUES);
+    TEST_CHECK(json_parse("[1] 2", 5, &callbacks, &config, &log1, NULL) == JSON_ERR_BADROOTTYPE);
+
+    /* Without the flag, the 2nd document is an error. */
+    TEST_CASE("no flag");
+    TEST_CHECK(json_parse("1 2", 3, &callbacks, NULL, &log1, NULL) == JSON_ERR_EXPECTEDEOF);
+
+    free(log1.buf);
+    free(log2.buf);
+}
+
+static int
+multidoc_dom_callback(VALUE* root, void* user_data)
+{
+    VALUE* docs = (VALUE*) user_data;
+    VALUE* v;
+
+    if(value_array_size(docs) >= 3) {
+        value_fini(root);
+        return -1234;
+    }
+
+    v = value_array_append(docs);
+    if(v == NULL)
+        return JSON_ERR_OUTOFMEMORY;
+    memcpy(v, root, sizeof(VALUE));
+    return 0;
+}
+
+static void
+test_multidoc_dom(void)
+{
+    static const char input[] = "{ \"a\": [1, 2] }\n\"foo\"\n42\n";
+    JSON_DOM_PARSER dom_parser;
+    VALUE docs;
+    VALUE root;
+    int err;
+
+    value_init_array(&docs);
+    err = json_dom_init_multidoc(&dom_parser, NULL, 0, multidoc_dom_callback, &docs);
+    TEST_CHECK(err == 0);
+    err = json_dom_feed(&dom_parser, input, strlen(input));
+    TEST_CHECK(err == 0);
+    err = json_dom_fini(&dom_parser, &root, NULL);
+    TEST_CHECK(err == 0);
+    TEST_CHECK(value_type(&root) == VALUE_NULL);
+
+    TEST_CHECK(value_array_size(&docs) == 3);
+    TEST_CHECK(value_type(value_array_get(&docs, 0)) == VALUE_DICT);
+    TEST_CHECK(value_array_size(value_path(value_array_get(&docs, 0), "a")) == 2);
+    TEST_CHECK(strcmp(value_string(value_array_get(&docs, 1)), "foo") == 0);
+    TEST_CHECK(value_int32(value_array_get(&docs, 2)) == 42);
+
+    /* Error returned by the callback aborts the parsing. */
+    err = json_dom_init_multidoc(&dom_parser, NULL, 0, multidoc_dom_callback, &docs);
+    TEST_CHECK(err == 0);
+    err = json_dom_feed(&dom_parser, "[1] [2", 6);
+    TEST_CHECK(err == -1234);
+    err = json_dom_fini(&dom_parser, &root, NULL);
+    TEST_CHECK(err == -1234);
+    TEST_CHECK(value_type(&root) == VALUE_NULL);
+
+    value_fini(&docs);
+}
+
+static int
+collect_doc_callback(VALUE* root, void* user_data)
+{
+    VALUE* v = value_array_append((VALUE*) user_data);
+
+    if(v == NULL)
+        return JSON_ERR_OUTOFMEMORY;
+    memcpy(v, root, sizeof(VALUE));
+    return 0;
+}
+
+static int
+collect_ndjson_serial(const char* input, size_t size, VALUE* docs, JSON_INPUT_POS* p_pos)
+{
+    JSON_DOM_PARSER dom_parser;
+    VALUE root;
+
+    json_dom_init_multidoc(&dom_parser, NULL, 0, collect_doc_callback, docs);
+    json_dom_feed(&dom_parser, input, size);
+    return json_dom_fini(&dom_parser, &root, p_pos);
+}
+
+static int
+fail_third_doc_callback(VALUE* root, void* user_data)
+{
+    VALUE* docs = (VALUE*) user_data;
+
+    if(value_array_size(docs) == 2) {
+        value_fini(root);
+        return -1234;
+    }
+    return collect_doc_callback(root, user_data);
+}
+
+static void
+test_ndjson_parallel(void)
+{
+    static const char* lines[] = {
+        "{ \"id\": 1, \"name\": \"foo\", \"tags\": [\"a\", \"b\"] }\n",
+        "{\"id\":2,\"value\":3.25,\"ok\":true}\r\n",
+        "\n",
+        "[1, 2, {\"id\": 3}]\n",
+        "\"line with \\\"escapes\\\" \\u00e9\"\n"
+    };
+    JSON_INPUT_POS pos1, pos2;
+    VALUE docs1, docs2;
+    char* input;
+    size_t size = 0;
+    size_t bad_off;
+    int err1, err2;
+    int i, n;
+
+    /* Big enough for many chunks. */
+    input = (char*) malloc(60000 * 64);
+    for(i = 0; i < 60000; i++) {
+        const char* line = lines[i % (sizeof(lines) / sizeof(lines[0]))];
+        memcpy(input + size, line, strlen(line));
+        size += strlen(line);
+    }
+
+    value_init_array(&docs1);
+    err1 = collect_ndjson_serial(input, size, &docs1, &pos1);
+    TEST_CHECK(err1 == 0);
+
+    TEST_CASE("in order");
+    value_init_array(&docs2);
+    err2 = json_ndjson_parse_parallel(input, size, NULL, 0, 4, 0,
+                collect_doc_callback, &docs2, &pos2);
+    TEST_CHECK(err2 == 0);
+    TEST_CHECK(pos1.offset == pos2.offset);
+    TEST_CHECK(pos1.line_number == pos2.line_number);
+    TEST_CHECK(pos1.column_number == pos2.column_number);
+    deep_value_cmp(&docs1, &docs2);
+    value_fini(&docs2);
+
+    TEST_CASE("as completed");
+    value_init_array(&docs2);
+    err2 = json_ndjson_parse_parallel(input, size, NULL, 0, 4, JSON_NDJSON_ASCOMPLETED,
+                collect_doc_callback, &docs2, &pos2);
+    TEST_CHECK(err2 == 0);
+    TEST_CHECK(value_array_size(&docs1) == value_array_size(&docs2));
+    value_fini(&docs2);
+
+    /* Break a line in the middle of the input. */
+    bad_off = size / 2;
+    while(input[bad_off] != '{')
+        bad_off++;
+    input[bad_off] = '}';
+
+    value_fini(&docs1);
+    value_init_array(&docs1);
+    err1 = collect_ndjson_serial(input, size, &docs1, &pos1);
+    TEST_CHECK(err1 == JSON_ERR_EXPECTEDVALUE);
+
+    for(n = 0; n < 2; n++) {
+        TEST_CASE(n == 0 ? "error, in order" : "error, as completed");
+        value_init_array(&docs2);
+        err2 = json_ndjson_parse_parallel(input, size, NULL, 0, 4,
+                (n == 0 ? 0 : JSON_NDJSON_ASCOMPLETED), collect_doc_callback, &docs2, &pos2);
+        TEST_CHECK(err2 == err1);
+        TEST_CHECK(pos1.offset == pos2.offset);
+        TEST_CHECK(pos1.line_number == pos2.line_number);
+        TEST_CHECK(pos1.column_number == pos2.column_number);
+        TEST_MSG("Expected: offset=%u line=%u column=%u", (unsigned) pos1.offset,
+                 pos1.line_number, pos1.column_number);
+        TEST_MSG("Produced: offset=%u line=%u column=%u", (unsigned) pos2.offset,
+                 pos2.line_number, pos2.column_number);
+        if(n == 0)
+            deep_value_cmp(&docs1, &docs2);
+        value_fini(&docs2);
+    }
+
+    for(n = 0; n < 2; n++) {
+        TEST_CASE(n == 0 ? "callback failure, in order" : "callback failure, as completed");
+        value_init_array(&docs2);
+        err2 = json_ndjson_parse_parallel(input, size, NULL, 0, 4,
+                    (n == 0 ? 0 : JSON_NDJSON_ASCOMPLETED), fail_third_doc_callback, &docs2, &pos2);
+        TEST_CHECK(err2 == -1234);
+        TEST_CHECK(pos2.line_number == 0);
+        TEST_CHECK(value_array_size(&docs2) == 2);
+        value_fini(&docs2);
+    }
+
+    value_fini(&docs1);
+    free(input);
+}
+
+static void
+test_array_parallel(void)
+{
+    static const char* items[] = {
+        "{ \"id\": 1, \"name\": \"foo\", \"tags\": [\"a\", \"b\"] }",
+        "{\"id\":2,\"value\":3.25,\"nested\":[{\"x\":1},\r\n{\"y\":2}]}",
+        "{ \"tricky\": \"}, {\\\"}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {\" }",
+        "\n  { }"
+    };
+    static const struct {
+        const char* name;
+        const char* item;
+    } flat[] = {
+        { "numbers", "12345.5" },
+        { "strings", "\"a, \\\"b\\\", c\"" },
+        { "arrays", "[1, [2, 3], []]" },
+        { "objects", "{ \"id\": 1, \"a\": [{}, {\"b\": \"x\"}], \"c\": {\"d\": null} }" },
+        { 0 }
+    };
+    JSON_INPUT_POS pos1, pos2;
+    JSON_CONFIG config;
+    VALUE root1, root2;
+    char* input;
+    size_t size;
+    size_t bad_off;
+    int err1, err2;
+    int i, j;
+
+    json_default_config(&config);
+    config.max_total_len = 0;
+    input = (char*) malloc(40000 * 64 + 16);
+
+    /* Commas in the strings and in the nested arrays which look like the
+     * separators. (The guess fails and we get the serial parser.) */
+    size = 0;
+    input[size++] = '[';
+    for(i = 0; i < 40000; i++) {
+        const char* item = items[i % (sizeof(items) / sizeof(items[0]))];
+        if(i > 0)
+            input[size++] = ',';
+        memcpy(input + size, item, strlen(item));
+        size += strlen(item);
+    }
+    memcpy(input + size, "\n]\n", 3);
+    size += 3;
+
+    TEST_CASE("tricky");
+    err1 = json_dom_parse(input, size, &config, 0, &root1, &pos1);
+    err2 = json_dom_parse_array_parallel(input, size, &config, 0, 4, &root2, &pos2);
+    TEST_CHECK(err1 == 0);
+    TEST_CHECK(err2 == 0);
+    TEST_CHECK(pos1.offset == pos2.offset);
+    TEST_CHECK(pos1.line_number == pos2.line_number);
+    TEST_CHECK(pos1.column_number == pos2.column_number);
+    deep_value_cmp(&root1, &root2);
+    value_fini(&root1);
+    value_fini(&root2);
+
+    /* Errors are reported as by the serial parser. */
+    TEST_CASE("error");
+    bad_off = size * 3 / 4;
+    while(input[bad_off] != ':')
+        bad_off++;
+    input[bad_off] = ',';
+    err1 = json_dom_parse(input, size, &config, 0, &root1, &pos1);
+    err2 = json_dom_parse_array_parallel(input, size, &config, 0, 4, &root2, &pos2);
+    TEST_CHECK(err1 == JSON_ERR_EXPECTEDCOLON);
+    TEST_CHECK(err2 == err1);
+    TEST_CHECK(pos1.offset == pos2.offset);
+    TEST_CHECK(pos1.line_number == pos2.line_number);
+    TEST_CHECK(pos1.column_number == pos2.column_number);
+    TEST_CHECK(value_type(&root2) == VALUE_NULL);
+
+    TEST_CASE("limits");
+    input[bad_off] = ':';
+    config.max_total_values = 100000;
+    err2 = json_dom_parse_array_parallel(input, size, &config, 0, 4, &root2, &pos2);
+    TEST_CHECK(err2 == JSON_ERR_MAXTOTALVALUES);
+    config.max_total_values = 0;
+
+    /* A segment without any element must not pass as an empty array. The
+     * long string makes the segment boundaries land on the commas. */
+    config.max_string_len = 0;
+    for(j = 0; j < 2; j++) {
+        size_t len = (j == 0) ? 70000 : 131066;
+
+        TEST_CASE((j == 0) ? "trailing comma" : "double comma");
+        size = 0;
+        memcpy(input + size, "[0,\"", 4);
+        size += 4;
+        memset(input + size, 'x', len);
+        size += len;
+        memcpy(input + size, (j == 0) ? "\",]" : "\",,1]", (j == 0) ? 3 : 5);
+        size += (j == 0) ? 3 : 5;
+        err1 = json_dom_parse(input, size, &config, 0, &root1, &pos1);
+        err2 = json_dom_parse_array_parallel(input, size, &config, 0, 4, &root2, &pos2);
+        TEST_CHECK(err1 != 0);
+        TEST_CHECK(err2 == err1);
+        TEST_CHECK(pos1.offset == pos2.offset);
+        TEST_CHECK(value_type(&root2) == VALUE_NULL);
+        value_fini(&root2);
+    }
+    json_default_config(&config);
+    config.max_total_len = 0;
+
+    for(j = 0; flat[j].name != NULL; j++) {
+        TEST_CASE(flat[j].name);
+        size = 0;
+        input[size++] = '[';
+        for(i = 0; i < 40000; i++) {
+            if(i > 0)
+                input[size++] = ',';
+            memcpy(input + size, flat[j].item, strlen(flat[j].item));
+            size += strlen(flat[j].item);
+        }
+        input[size++] = ']';
+
+        err1 = json_dom_parse(input, size, &config, 0, &root1, &pos1);
+        err2 = json_dom_parse_array_parallel(input, size, &config, 0, 4, &root2, &pos2);
+        TEST_CHECK(err1 == 0);
+        TEST_CHECK(err2 == 0);
+        TEST_CHECK(pos1.offset == pos2.offset);
+        TEST_CHECK(pos1.column_number == pos2.column_number);
+        deep_value_cmp(&root1, &root2);
+        value_fini(&root1);
+        value_fini(&root2);
+    }
+
+    free(input);
+}
+
+static char dump_buffer[16 * 256];
+
+static int
+test_dump_callback(const char* data, size_t size, void* userdata)
+{
+    size_t* n = (size_t*) userdata;
+
+    if(!TEST_CHECK(*n + size <= sizeof(dump_buffer)))
+        return -1;
+
+    memcpy(dump_buffer + *n, data, size);
+    *n += size;
+    return 0;
+}
+
+static void
+test_dump(void)
+{
+    static const char expected[] = {
+        "[\n"
+        "\t{\n"
+        "\t\t\"name\": \"Alice\",\n"
+        "\t\t\"age\": 23,\n"
+        "\t\t\"height\": 168.5\n"
+        "\t},\n"
+        "\t{\n"
+        "\t\t\"name\": \"Bob\",\n"
+        "\t\t\"age\": 54,\n"
+        "\t\t\"height\": 182.0\n"
+        "\t}\n"
+        "]"
+    };
+
+    size_t n = 0;
+    VALUE root;
+    VALUE* alice;
+    VALUE* bob;
+    VALUE* name;
+    VALUE* age;
+    VALUE* height;
+    int err;
+
+    value_init_array(&root);
+
+    alice = value_array_append(&root);
+    value_init_dict_ex(alice, NULL, VALUE_DICT_MAINTAINORDER);
+    name = value_dict_add(alice, "name");
+    value_init_string(name, "Alice");
+    age = value_dict_add(alice, "age");
+    value_init_uint32(age, 23);
+    height = value_dict_add(alice, "height");
+    value_init_float(height, 168.5);
+
+    bob = value_array_append(&root);
+    value_init_dict_ex(bob, NULL, VALUE_DICT_MAINTAINORDER);
+    name = value_dict_add(bob, "name");
+    value_init_string(name, "Bob");
+    age = value_dict_add(bob, "age");
+    value_init_uint32(age, 54);
+    height = value_dict_add(bob, "height");
+    value_init_float(height, 182.0);
+
+    err = json_dom_dump(&root, test_dump_callback, (void*) &n, 0, JSON_DOM_DUMP_PREFERDICTORDER);
+    if(TEST_CHECK(err == 0)) {
+        /* Parse it back and compare it with what we expect. */
+        VALUE a, b;
+        TEST_CHECK(json_dom_parse(dump_buffer, n, NULL, JSON_DOM_MAINTAINDICTORDER, &a, NULL) == 0);
+        TEST_CHECK(json_dom_parse(expected, strlen(expected), NULL, JSON_DOM_MAINTAINDICTORDER, &b, NULL) == 0);
+        deep_value_cmp(&a, &b);
+        value_fini(&a);
+        value_fini(&b);
+    }
+
+    value_fini(&root);
+}
+
+static void
+test_dump_double(void)
+{
+    static const struct {
+        double dbl;
+        const char* expected;
+    } cases[] = {
+        { 0.0,                      "0.0" },
+        { -0.0,                     "-0.0" },
+        { 1.0,                      "1.0" },
+        { 0.1,                      "0.1" },
+        { -2.5,                     "-2.5" },
+        { 0.3,                      "0.3" },
+        { 1e15,                     "1000000000000000.0" },
+        { 1e16,                     "1e+16" },
+        { 1e-4,                     "0.0001" },
+        { 1.5e-7,                   "1.5e-7" },
+        { 5e-324,                   "5e-324" },
+        { 1.7976931348623157e308,   "1.7976931348623157e+308" },
+        { 123456.789,               "123456.789" }
+    };
+    static const struct {
+        float flt;
+        const char* expected;
+    } float_cases[] = {
+        { 0.1f,                     "0.1" },
+        { 168.5f,                   "168.5" },
+        { 3.14159f,                 "3.14159" },
+        { 1e-45f,                   "1e-45" },
+        { 16777216.0f,              "16777216.0" }
+    };
+    uint64_t x = 88172645463325252;
+    uint64_t bits;
+    double d, d2;
+    size_t n;
+    int i;
+
+    for(i = 0; i < (int) (sizeof(cases) / sizeof(cases[0])); i++) {
+        TEST_CASE(cases[i].expected);
+        n = 0;
+        TEST_CHECK(json_dump_double(cases[i].dbl, test_dump_callback, (void*) &n) == 0);
+        TEST_CHECK(n == strlen(cases[i].expected)  &&
+                   memcmp(dump_buffer, cases[i].expected, n) == 0);
+        TEST_MSG("Produced: %.*s", (int) n, dump_buffer);
+    }
+
+    for(i = 0; i < (int) (sizeof(float_cases) / sizeof(float_cases[0])); i++) {
+        TEST_CASE(float_cases[i].expected);
+        n = 0;
+        TEST_CHECK(json_dump_float(float_cases[i].flt, test_dump_callback, (void*) &n) == 0);
+        TEST_CHECK(n == strlen(float_cases[i].expected)  &&
+                   memcmp(dump_buffer, float_cases[i].expected, n) == 0);
+        TEST_MSG("Produced: %.*s", (int) n, dump_buffer);
+    }
+    TEST_CASE(NULL);
+
+    /* Whatever we write has to read back as the same double. */
+    for(i = 0; i < 100000; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        bits = x;
+        if(((bits >> 52) & 0x7ff) == 0x7ff)
+            continue;   /* Infinity or NaN. */
+        memcpy(&d, &bits, sizeof(double));
+
+        n = 0;
+        json_dump_double(d, test_dump_callback, (void*) &n);
+        json_number_to_double(dump_buffer, n, &d2);
+        if(!TEST_CHECK(memcmp(&d, &d2, sizeof(double)) == 0)) {
+            TEST_MSG("Written:  %.*s", (int) n, dump_buffer);
+            break;
+        }
+    }
+}
+
+static void
+test_format_int(void)
+{
+    char buffer[JSON_FORMAT_BUFSIZE];
+    char expected[32];
+    uint64_t u64 = 1;
+    size_t n;
+    int i;
+
+    n = json_format_int32(buffer, 0);
+    TEST_CHECK(n == 1  &&  memcmp(buffer, "0", 1) == 0);
+    n = json_format_int32(buffer, INT32_MIN);
+    TEST_CHECK(n == 11  &&  memcmp(buffer, "-2147483648", 11) == 0);
+    n = json_format_uint32(buffer, UINT32_MAX);
+    TEST_CHECK(n == 10  &&  memcmp(buffer, "4294967295", 10) == 0);
+    n = json_format_int64(buffer, INT64_MIN);
+    TEST_CHECK(n == 20  &&  memcmp(buffer, "-9223372036854775808", 20) == 0);
+    n = json_format_int64(buffer, INT64_MAX);
+    TEST_CHECK(n == 19  &&  memcmp(buffer, "9223372036854775807", 19) == 0);
+    n = json_format_uint64(buffer, UINT64_MAX);
+    TEST_CHECK(n == 20  &&  memcmp(buffer, "18446744073709551615", 20) == 0);
+
+    /* All the counts of digits, and the values around them. */
+    for(i = 0; i < 20; i++) {
+        uint64_t values[3];
+        int j;
+
+        values[0] = u64 - 1;
+        values[1] = u64;
+        values[2] = u64 + 1;
+        for(j = 0; j < 3; j++) {
+            snprintf(expected, sizeof(expected), "%llu", (unsigned long long) values[j]);
+            n = json_format_uint64(buffer, values[j]);
+            if(!TEST_CHECK(n == strlen(expected)  &&  memcmp(buffer, expected, n) == 0))
+                TEST_MSG("Expected: %s; produced: %.*s", expected, (int) n, buffer);
+
+            if(values[j] == 0  ||  values[j] > INT64_MAX)
+                continue;
+            snprintf(expected, sizeof(expected), "-%llu", (unsigned long long) values[j]);
+            n = json_format_int64(buffer, -(int64_t) values[j]);
+            if(!TEST_CHECK(n == strlen(expected)  &&  memcmp(buffer, expected, n) == 0))
+                TEST_MSG("Expected: %s; produced: %.*s", expected, (int) n, buffer);
+        }
+        u64 *= 10;
+    }
+}
+
+static void
+test_pointer(void)
+{
+    static const char input[] =
+            "{\n"
+                "\"foo\": [\"bar\", \"baz\"],\n"
+                "\"\": 0,\n"
+                "\"a/b\": 1,\n"
+                "\"c%d\": 2,\n"
+                "\"e^f\": 3,\n"
+                "\"g|h\": 4,\n"
+                "\"i\\\\j\": 5,\n"
+                "\"k\\\"l\": 6,\n"
+                "\" \": 7,\n"
+                "\"m~n\": 8\n"
+            "}\n";
+
+    VALUE root;
+    VALUE* v;
+
+    TEST_CHECK(json_dom_parse(input, strlen(input), NULL, 0, &root, NULL) == 0);
+
+    TEST_CHECK(json_ptr_get(&root, "") == &root);
+
+    v = json_ptr_get(&root, "/foo");
+    TEST_CHECK(value_type(v) == VALUE_ARRAY);
+    TEST_CHECK(value_array_size(v) == 2);
+    TEST_CHECK(strcmp(value_string(value_array_get(v, 0)), "bar") == 0);
+    TEST_CHECK(strcmp(value_string(value_array_get(v, 1)), "baz") == 0);
+
+    v = json_ptr_get(&root, "/foo/0");
+    TEST_CHECK(strcmp(value_string(v), "bar") == 0);
+
+    v = json_ptr_get(&root, "/foo/1");
+    TEST_CHECK(strcmp(value_string(v), "baz") == 0);
+
+    v = json_ptr_get(&root, "/foo/-2");
+    TEST_CHECK(strcmp(value_string(v), "bar") == 0);
+
+    v = json_ptr_get(&root, "/foo/-1");
+    TEST_CHECK(strcmp(value_string(v), "baz") == 0);
+
+    v = json_ptr_get(&root, "/");
+    TEST_CHECK(value_int32(v) == 0);
+
+    v = json_ptr_get(&root, "/a~1b");
+    TEST_CHECK(value_int32(v) == 1);
 
     v = json_ptr_get(&root, "/c%d");
     TEST_CHECK(value_int32(v) == 2);
@@ -1461,6 +3526,65 @@ test_crazy_double(void)
     TEST_CHECK(value_double(&root) < 1.0001 * 2.2250738585072014e-308);
 }
 
+static void
+test_double_round_trip(void)
+{
+    static const struct {
+        const char* str;
+        double expected;
+    } cases[] = {
+        { "9007199254740993.0",         9007199254740992.0 },   /* 2^53 + 1: Tie, round to even. */
+        { "9007199254740995.0",         9007199254740996.0 },   /* Tie, round to even. */
+        { "9007199254740993.0000000000000000000000001", 9007199254740994.0 },
+        { "2.2250738585072011e-308",    2.2250738585072011e-308 },
+        { "2.2250738585072014e-308",    2.2250738585072014e-308 },  /* DBL_MIN */
+        { "4.9406564584124654e-324",    4.9406564584124654e-324 },  /* Smallest subnormal. */
+        { "2.4703282292062327e-324",    0.0 },
+        { "2.4703282292062328e-324",    4.9406564584124654e-324 },
+        { "1.7976931348623157e308",     1.7976931348623157e308 },   /* DBL_MAX */
+        { "0.1",                        0.1 },
+        { "-0.0",                       -0.0 },
+        { "1e-400",                     0.0 },
+        { "7.3177701707893310e+15",     7.3177701707893310e+15 },
+        { "3.4e38",                     3.4e38 }
+    };
+    char buffer[64];
+    uint64_t x = 88172645463325252;
+    uint64_t bits;
+    double d;
+    int i;
+
+    for(i = 0; i < (int) (sizeof(cases) / sizeof(cases[0])); i++) {
+        TEST_CASE(cases[i].str);
+        TEST_CHECK(json_number_to_double(cases[i].str, strlen(cases[i].str), &d) == 0);
+        TEST_CHECK(memcmp(&d, &cases[i].expected, sizeof(double)) == 0);
+        TEST_MSG("Expected: %.17g", cases[i].expected);
+        TEST_MSG("Produced: %.17g", d);
+    }
+    TEST_CASE(NULL);
+
+    /* Any double printed with 17 significant digits has to parse back to
+     * itself. */
+    for(i = 0; i < 100000; i++) {
+        double d2;
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        bits = x;
+        if(((bits >> 52) & 0x7ff) == 0x7ff)
+            continue;   /* Infinity or NaN. */
+        memcpy(&d, &bits, sizeof(double));
+
+        snprintf(buffer, sizeof(buffer), "%.17g", d);
+        json_number_to_double(buffer, strlen(buffer), &d2);
+        if(!TEST_CHECK(memcmp(&d, &d2, sizeof(double)) == 0)) {
+            TEST_MSG("Input:    %s", buffer);
+            break;
+        }
+    }
+}
+
 static void
 test_issue2(void)
 {
@@ -1522,13 +3646,16 @@ test_issue3(void)
 
 TEST_LIST = {
     { "pos-tracking",               test_pos_tracking },
+    { "pos-tracking-lazy",          test_pos_tracking_lazy },
     { "null",                       test_null },
     { "bool",                       test_bool },
     { "number",                     test_number },
+    { "number-info",                test_number_info },
     { "string",                     test_string },
     { "string-c-escape",            test_string_c_escape },
     { "string-utf8",                test_string_utf8 },
     { "string-unicode-escape",      test_string_unicode_escape },
+    { "string-parts",               test_string_parts },
     { "array",                      test_array },
     { "object",                     test_object },
     { "combined",                   test_combined },
@@ -1543,9 +3670,27 @@ TEST_LIST = {
     { "err-bad-root-type",          test_err_bad_root_type },
     { "err-syntax",                 test_err_syntax },
     { "json-checker",               test_json_checker },
+    { "parse-whole",                test_parse_whole },
+    { "callbacks-ex",               test_callbacks_ex },
+    { "skip",                       test_skip },
+    { "projection",                 test_projection },
+    { "parse-indexed",              test_parse_indexed },
+    { "reset",                      test_reset },
+    { "allocator",                  test_allocator },
+    { "pause",                      test_pause },
+    { "cursor",                     test_cursor },
+    { "validate",                   test_validate },
+    { "raw-strings",                test_raw_strings },
+    { "multidoc",                   test_multidoc },
+    { "multidoc-dom",               test_multidoc_dom },
+    { "ndjson-parallel",            test_ndjson_parallel },
+    { "array-parallel",             test_array_parallel },
     { "dump",                       test_dump },
+    { "dump-double",                test_dump_double },
+    { "format-int",                 test_format_int },
     { "pointer",                    test_pointer },
     { "crazy-double",               test_crazy_double },
+    { "double-round-trip",          test_double_round_trip },
     { "bug-issue2",                 test_issue2 },
     { "bug-issue3",                 test_issue3 },
     { 0 }
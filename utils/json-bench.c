@@ -0,0 +1,329 @@
+/*
+ * CentiJSON
+ * <http://github.com/mity/centijson>
+ *
+ * Copyright (c) 2018 Martin Mitas
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "cmdline.h"
+#include "json.h"
+#include "json-err.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #define HAVE_PERF_EVENTS    1
+#endif
+
+
+static const char* input_path = NULL;
+static size_t gen_size = 16;        /* In MB */
+static size_t block_size = 65536;
+static int repeat = 5;
+static const char* argv0;
+
+
+static void
+print_usage(void)
+{
+    printf("Usage: %s [OPTION]... [FILE]\n", argv0);
+    printf("Measure speed of the SAX-like parser.\n");
+    printf("If no FILE is given, a document with mixed content is generated.\n");
+    printf("  -s, --size=NUM         %s\n", "Size of the generated document in MB (default: 16)");
+    printf("  -b, --block-size=NUM   %s\n", "Feed the input in blocks of NUM bytes (default: 65536);");
+    printf("                         %s\n", "zero means json_parse() on the whole input");
+    printf("  -r, --repeat=NUM       %s\n", "Parse the input NUM times (default: 5)");
+    printf("  -h, --help             %s\n", "Display this help and exit");
+
+    printf("\n");
+    printf("On Linux, branches and branch misses are counted too (if the kernel and\n");
+    printf("the hardware allow it).\n");
+
+    exit(EXIT_SUCCESS);
+}
+
+static const CMDLINE_OPTION cmdline_options[] = {
+    { 's',  "size",         's', CMDLINE_OPTFLAG_REQUIREDARG },
+    { 'b',  "block-size",   'b', CMDLINE_OPTFLAG_REQUIREDARG },
+    { 'r',  "repeat",       'r', CMDLINE_OPTFLAG_REQUIREDARG },
+    { 'h',  "help",         'h', 0 },
+    { 0 }
+};
+
+static int
+cmdline_callback(int id, const char* arg, void* userdata)
+{
+    (void) userdata;
+
+    switch(id) {
+        /* Options */
+        case 's':       gen_size = (size_t) atol(arg); break;
+        case 'b':       block_size = (size_t) atol(arg); break;
+        case 'r':       repeat = atoi(arg); break;
+        case 'h':       print_usage(); break;
+
+        /* Non-option arguments */
+        case 0:
+            if(input_path) {
+                fprintf(stderr, "Too many arguments. Only one input file can be specified.\n");
+                fprintf(stderr, "Use --help for more info.\n");
+                exit(1);
+            }
+            input_path = arg;
+            break;
+
+        /* Errors */
+        case CMDLINE_OPTID_UNKNOWN:
+            fprintf(stderr, "Unrecognized command line option '%s'.", arg);
+            exit(EXIT_FAILURE);
+        case CMDLINE_OPTID_MISSINGARG:
+            fprintf(stderr, "The command line option '%s' requires an argument.", arg);
+            exit(EXIT_FAILURE);
+        case CMDLINE_OPTID_BOGUSARG:
+            fprintf(stderr, "The command line option '%s' does not expect an argument.", arg);
+            exit(EXIT_FAILURE);
+    }
+
+    return 0;
+}
+
+
+#ifdef HAVE_PERF_EVENTS
+static int
+perf_open(unsigned long long config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+
+static char*
+read_file(const char* path, size_t* p_size)
+{
+    FILE* in;
+    char* buffer = NULL;
+    size_t size = 0;
+    size_t alloced = 0;
+    size_t n;
+
+    in = fopen(path, "rb");
+    if(in == NULL) {
+        fprintf(stderr, "Cannot open %s.\n", path);
+        return NULL;
+    }
+
+    while(1) {
+        if(size == alloced) {
+            char* new_buffer;
+
+            alloced = (alloced > 0) ? alloced * 2 : 65536;
+            new_buffer = (char*) realloc(buffer, alloced);
+            if(new_buffer == NULL) {
+                fprintf(stderr, "Out of memory.\n");
+                free(buffer);
+                fclose(in);
+                return NULL;
+            }
+            buffer = new_buffer;
+        }
+
+        n = fread(buffer + size, 1, alloced - size, in);
+        if(n == 0)
+            break;
+        size += n;
+    }
+
+    fclose(in);
+    *p_size = size;
+    return buffer;
+}
+
+/* Generate an array of records mixing all kinds of the values, with some
+ * indentation. */
+static char*
+generate(size_t size, size_t* p_size)
+{
+    static const char* literals[] = { "true", "false", "null" };
+    char* buffer;
+    size_t off = 0;
+    unsigned i;
+
+    buffer = (char*) malloc(size + 512);
+    if(buffer == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        return NULL;
+    }
+
+    buffer[off++] = '[';
+    for(i = 0; off < size; i++) {
+        off += sprintf(buffer + off,
+                "%s\n  { \"id\": %u, \"name\": \"item \\\"%u\\\"\", \"price\": %u.%02u, "
+                "\"tags\": [ \"a\", \"bc\", \"def\" ], \"active\": %s, \"parent\": %s,\n"
+                "    \"flags\": [ %s, %s, %s ], \"ratio\": -%ue-%u, \"nested\": { \"x\": [ [], {} ] } }",
+                (i > 0 ? "," : ""), i, i * 7, i % 1000, i % 100,
+                literals[i % 2], literals[(i % 3 == 0) ? 2 : 0],
+                literals[i % 3], literals[(i + 1) % 3], literals[(i + 2) % 3],
+                i % 10, i % 5);
+    }
+    buffer[off++] = '\n';
+    buffer[off++] = ']';
+
+    *p_size = off;
+    return buffer;
+}
+
+
+static int
+process_callback(JSON_TYPE type, const char* data, size_t size, void* userdata)
+{
+    size_t* p_count = (size_t*) userdata;
+
+    (void) type;
+    (void) data;
+    (void) size;
+    (*p_count)++;
+    return 0;
+}
+
+static int
+parse(const char* input, size_t size, size_t* p_count)
+{
+    static const JSON_CALLBACKS callbacks = { process_callback };
+    JSON_CONFIG config;
+    JSON_PARSER parser;
+    JSON_INPUT_POS pos;
+    size_t off, n;
+    int ret;
+
+    json_default_config(&config);
+    config.max_total_len = 0;
+    config.max_total_values = 0;
+
+    if(block_size == 0) {
+        ret = json_parse(input, size, &callbacks, &config, p_count, &pos);
+    } else {
+        ret = json_init(&parser, &callbacks, &config, p_count);
+        if(ret != 0)
+            return ret;
+        for(off = 0; off < size; off += n) {
+            n = (size - off < block_size) ? size - off : block_size;
+            if(json_feed(&parser, input + off, n) != 0)
+                break;
+        }
+        ret = json_fini(&parser, &pos);
+    }
+
+    if(ret != 0)
+        json_err(ret, &pos);
+    return ret;
+}
+
+int
+main(int argc, char** argv)
+{
+    char* input;
+    size_t size;
+    size_t count = 0;
+    clock_t t0, t1;
+    double secs;
+    int perf_fd[2] = { -1, -1 };    /* Branches, branch misses. */
+    int ret = 0;
+    int i;
+
+    argv0 = argv[0];
+
+    cmdline_read(cmdline_options, argc, argv, cmdline_callback, NULL);
+
+    if(input_path != NULL)
+        input = read_file(input_path, &size);
+    else
+        input = generate(gen_size * 1024 * 1024, &size);
+    if(input == NULL)
+        exit(EXIT_FAILURE);
+
+#ifdef HAVE_PERF_EVENTS
+    perf_fd[0] = perf_open(PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+    perf_fd[1] = perf_open(PERF_COUNT_HW_BRANCH_MISSES);
+    for(i = 0; i < 2; i++) {
+        if(perf_fd[i] >= 0) {
+            ioctl(perf_fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+
+    t0 = clock();
+    for(i = 0; i < repeat; i++) {
+        ret = parse(input, size, &count);
+        if(ret != 0)
+            break;
+    }
+    t1 = clock();
+
+    if(ret == 0  &&  repeat > 0) {
+        secs = (double) (t1 - t0) / CLOCKS_PER_SEC;
+        printf("Input size:     %lu bytes\n", (unsigned long) size);
+        printf("Values:         %lu\n", (unsigned long) (count / repeat));
+        printf("Time per parse: %.3f ms\n", secs * 1000.0 / repeat);
+        if(secs > 0.0)
+            printf("Throughput:     %.1f MB/s\n", ((double) size * repeat) / (secs * 1024.0 * 1024.0));
+    }
+
+#ifdef HAVE_PERF_EVENTS
+    for(i = 0; i < 2; i++) {
+        static const char* names[2] = { "Branches:      ", "Branch misses: " };
+        long long n;
+
+        if(perf_fd[i] < 0) {
+            if(ret == 0  &&  repeat > 0)
+                printf("%s (not available)\n", names[i]);
+            continue;
+        }
+
+        ioctl(perf_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        if(ret == 0  &&  repeat > 0  &&  read(perf_fd[i], &n, sizeof(n)) == sizeof(n)) {
+            printf("%s %.3f per 1000 bytes\n", names[i],
+                   (double) n * 1000.0 / ((double) size * repeat));
+        }
+        close(perf_fd[i]);
+    }
+#endif
+
+    free(input);
+    return (ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}